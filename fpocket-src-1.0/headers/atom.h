@@ -39,6 +39,7 @@
 #include <ctype.h>
 
 #include "utils.h"
+#include "volume.h"
 
 // --------------------------------MACROS------------------------------------ */
 
@@ -56,7 +57,7 @@ typedef struct s_atm
     float x, y, z ;		/* Coords */
     char name[5],		/* Atom name */
          type[7],		/* Atom type */
-         chain[2],		/* Chain name */
+         chain[5],		/* Chain name (up to 4 characters in mmCIF) */
          symbol[3],		/* Chemical symbol of the atom */
          res_name[8];		/* Atom residue name */
 
@@ -36,14 +36,46 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "fpocket.h"
 #include "fpout.h"
 #include "rpdb.h"
 #include "atom.h"
 #include "fparams.h"
+#include "neighbor.h"
+
+#define M_CHECK_BIG_NVERT 50000		/* Alpha spheres of the large pocket */
+#define M_CHECK_BIG_NATM 20000		/* Atoms they contact (at random) */
+#define M_CHECK_BIG_STACK 262144	/* Stack of the thread running the test */
 
 int check_qhull(void) ;
+int check_qhull_threads(void) ;
+int check_vvertices_update(void) ;
+int check_vvertices_cache(void) ;
+int check_vvertices_part(void) ;
+int check_vtest(void) ;
+int check_delaunay(void) ;
+int check_keep_mem(void) ;
+int check_ml_clust(void) ;
+int check_refine(void) ;
+int check_pockets_table(void) ;
+int check_desc_threads(void) ;
+int check_vert_desc(void) ;
+int check_vgrid(void) ;
+int check_exact_volume(void) ;
+int check_big_pocket(void) ;
+int check_nindex(void) ;
+int check_rpdb(void) ;
+int check_rcif(void) ;
+int check_rpdb_gz(void) ;
+int check_wpdb(void) ;
+int check_fpbin(void) ;
+int check_fpocket_baseline(void) ;
+int check_fpocket_threads(void) ;
 int check_fparams(void) ;
 int check_fpocket (void );
 int check_is_valid_element(void) ;
@@ -46,5 +46,6 @@
 /* ------------------------------PROTOTYPES---------------------------------- */
 
 void pck_ml_clust(c_lst_pockets *pockets, s_fparams *params);
+void pck_ml_clust_naive(c_lst_pockets *pockets, s_fparams *params);
 
 #endif
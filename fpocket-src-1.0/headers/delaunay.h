@@ -0,0 +1,71 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_DELAUNAY
+#define DH_DELAUNAY
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../src/qhull/qvoronoi.h"
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+/* Engines computing the Delaunay tetrahedra (see set_delaunay_engine) */
+#define M_DELAUNAY_QHULL 0
+#define M_DELAUNAY_NATIVE 1
+
+#define M_DELAUNAY_SUCCESS 0
+#define M_DELAUNAY_FLAT 1		/* Less than 4 non coplanar points */
+#define M_DELAUNAY_LOST 2		/* Point location failed */
+
+#define M_DT_INF -1				/* Index of the point at infinity */
+#define M_DT_DEAD -2			/* First point of a free tetrahedron */
+#define M_DT_HILBERT_BITS 16	/* Bits per axis of the Hilbert curve */
+#define M_DT_BRIO_MIN 64		/* Size of the first (smallest) BRIO round */
+#define M_DT_EXACT_BUF 131072	/* Size of the exact arithmetic buffer */
+
+/* -----------------------------PROTOTYPES------------------------------------*/
+
+int run_delaunay_mem(double *xyz, int numpoints, qvoronoi_begin_fct fbegin,
+					 qvoronoi_vert_fct fvert, void *data) ;
+void get_dt_center(const double *a, const double *b, const double *c,
+				   const double *d, double *center) ;
+
+#endif
@@ -40,6 +40,9 @@
 #include <stdlib.h>
 #include <time.h>
 #include <ctype.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 #include "voronoi.h"
 #include "voronoi_lst.h"
@@ -47,6 +50,19 @@
 #include "aa.h"
 #include "utils.h"
 
+/* ---------------------------------MACROS---------------------------------- */
+
+/* Pockets with less vertices are handled by a single scan of all pairs */
+#define M_DESC_GRID_MIN_VERT 128
+
+/* Grid of the apolar spheres of a pocket: width added to the cells (rounding
+ * errors), and maximum number of cells per sphere */
+#define M_DESC_CELL_MARGIN 0.01
+#define M_DESC_CELLS_PER_SPHERE 8
+
+/* Margin on the bound of the maximum distance between two spheres */
+#define M_DESC_DST_MARGIN 0.001
+
 /* --------------------------------STRUCTURES---------------------------------*/
 
 typedef struct s_desc 
@@ -90,6 +106,8 @@ s_desc* allocate_s_desc(void) ;
 void reset_desc(s_desc *desc) ;
 
 void set_descriptors(s_atm **tatoms, int natoms, s_vvertice **tvert, int nvert, s_desc *desc) ;
+void set_vert_descriptors(s_vvertice **tvert, int nvert, s_desc *desc) ;
+void set_vert_descriptors_naive(s_vvertice **tvert, int nvert, s_desc *desc) ;
 
 int get_vert_apolar_density(s_vvertice **tvert, int nvert, s_vvertice *vert) ;
 void set_atom_based_descriptors(s_atm **atoms, int natoms, s_desc *desc) ;
@@ -43,8 +43,11 @@
 #include <ctype.h>
 #include <limits.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 #include "utils.h"
+#include "delaunay.h"
+#include "volume.h"
 #include "memhandler.h"
 
 /* ----------------------------- PUBLIC MACROS ------------------------------ */
@@ -87,6 +90,34 @@
  * an alpha sphere to be apolar 3 */
 #define M__MIN_APOL_NEIGH_DEFAULT 3
 
+/* Number of worker processes used to handle a list of pdb 1 */
+#define M_NB_WORKERS 1
+
+/* Number of threads used for the tesselation, 1 for a single qhull run 1 */
+#define M_NB_THREADS 1
+
+/* Number of threads used for the descriptors of the pockets */
+#define M_NB_DESC_THREADS 1
+
+/* Seed of the random number generator, -1 to use the time */
+#define M_RAND_SEED -1
+
+/* Multiple linkage clustering: merge in the order of the list of pockets (as
+ * the original algorithm), or merge connected components */
+#define M_MLCLUST_ORDER 0
+#define M_MLCLUST_GRAPH 1
+
+/* Refine clustering: merge in the order of the list of pockets (as the
+ * original algorithm), or merge until no barycenters are close */
+#define M_REFINE_ORDER 0
+#define M_REFINE_FIXPOINT 1
+
+/* Output of the pockets: one pqr and one pdb file per pocket in the pockets
+ * directory (as the original programm), or all of them in a single packed
+ * file with an index (X_out/X_pockets.pack) */
+#define M_OUT_FILES 0
+#define M_OUT_PACK 1
+
 /* Parameters flags */
 #define M_PAR_PDB_FILE 'f'
 #define M_PAR_PDB_LIST 'F'
@@ -101,6 +132,17 @@
 #define M_PAR_MIN_POCK_NB_ASPH 'i'
 #define M_PAR_REFINE_DIST 'r'
 #define M_PAR_REFINE_MIN_NAPOL_AS 'p'
+#define M_PAR_NB_WORKERS 'w'
+#define M_PAR_VERT_CACHE 'c'
+#define M_PAR_NB_THREADS 't'
+#define M_PAR_DELAUNAY 'T'
+#define M_PAR_ML_CLUST 'l'
+#define M_PAR_REFINE_MODE 'R'
+#define M_PAR_DESC_THREADS 'j'
+#define M_PAR_RAND_SEED 'S'
+#define M_PAR_VOLUME 'V'
+#define M_PAR_OUT_LAYOUT 'O'
+#define M_PAR_OUT_BIN 'B'
 
 #define M_FP_USAGE "\n\
 ***** USAGE (fpocket) *****\n\
@@ -129,6 +171,39 @@ Pocket finding on a pdb - list of pdb - file(s):             \n\
 \t-b (integer): Space approximation for the basic method     \n\
 \t              of the volume calculation. Not used by       \n\
 \t              default (Monte Carlo approximation is)       \n\
+\t-w (integer): Number of worker processes used to handle    \n\
+\t              a list of pdb given with -F.              (1)\n\
+\t-t (integer): Number of threads used for the tesselation.  \n\
+\t              If > 1, space is split in overlapping boxes  \n\
+\t              (for very large structures), and spheres are \n\
+\t              clustered in another order than with a single\n\
+\t              qhull run, so pockets may differ.         (1)\n\
+\t-T (string) : Engine used for the tesselation: qhull or    \n\
+\t              native (incremental Delaunay).        (qhull)\n\
+\t-l (string) : Single linkage merge: order (pockets merged  \n\
+\t              in the order of the list) or graph (groups   \n\
+\t              of close pockets, order independent). (order)\n\
+\t-R (string) : Barycenter merge: order (pockets merged in   \n\
+\t              the order of the list) or fixpoint (merged   \n\
+\t              until no barycenters are close).      (order)\n\
+\t-V (string) : Engine used for the volumes: grid (spheres   \n\
+\t              rasterised on a grid, voxel size set by -v   \n\
+\t              or -b), exact (analytic, power diagram) or   \n\
+\t              mc (Monte Carlo / -b sampling)         (grid)\n\
+\t-j (integer): Number of threads used for the descriptors   \n\
+\t              of the pockets.                           (1)\n\
+\t-S (integer): Seed of the random numbers (volumes). Same   \n\
+\t              output from one run to another if given.     \n\
+\t              Seeded using the time by default.            \n\
+\t-O (string) : Output of each pocket: files (pqr and pdb    \n\
+\t              files in X_out/pockets) or pack (a single    \n\
+\t              indexed file X_out/X_pockets.pack)    (files)\n\
+\t-B (int)    : 1 to write also the pockets in a binary      \n\
+\t              columnar file X_out/X_pockets.fpb, read by   \n\
+\t              fpbin.c/.h                                (0)\n\
+\t-c (string) : Directory used to cache alpha spheres, so    \n\
+\t              runs on the same structure with the same     \n\
+\t              -m, -M and -A skip the tesselation.    (none)\n\
 \nSee the manual (man fpocket), or the full documentation for\n\
 more information.\n\
 ***************************\n"
@@ -143,8 +218,20 @@ more information.\n\
 typedef struct s_fparams
 {
 	char pdb_path[M_MAX_PDB_NAME_LEN] ;	/* The pdb file */
+	char pdb_lst_path[M_MAX_PDB_NAME_LEN] ;	/* The list of pdb, if any */
 	char **pdb_lst ;
-	int npdb ;
+	char cache_dir[M_MAX_PDB_NAME_LEN] ;	/* Alpha sphere cache, if any */
+	int npdb,
+		nworkers,			/* Number of processes handling the list of pdb */
+		nthreads,			/* Number of threads for the tesselation */
+		delaunay,			/* Tesselation engine (M_DELAUNAY_QHULL...) */
+		ml_clust,			/* Single linkage merge (M_MLCLUST_ORDER...) */
+		refine_mode,		/* Barycenter merge (M_REFINE_ORDER...) */
+		desc_threads,		/* Number of threads for the descriptors */
+		rand_seed,			/* Seed of the generator, -1 if none */
+		volume,				/* Volume engine (M_VOLUME_MC...) */
+		out_layout,			/* Output of the pockets (M_OUT_FILES...) */
+		out_bin ;			/* 1 to write the binary result (.fpb) */
 	
 	int min_apol_neigh,		 /* Min number of apolar neighbours for an a-sphere 
 								to be an apolar a-sphere */
@@ -182,6 +269,17 @@ int parse_basic_vol_div(char *str, s_fparams *p)  ;
 int parse_refine_dist(char *str, s_fparams *p)  ;
 int parse_refine_minaap(char *str, s_fparams *p)  ;
 int parse_min_pock_nb_asph(char *str, s_fparams *p) ;
+int parse_nb_workers(char *str, s_fparams *p) ;
+int parse_cache_dir(char *str, s_fparams *p) ;
+int parse_nb_threads(char *str, s_fparams *p) ;
+int parse_delaunay_engine(char *str, s_fparams *p) ;
+int parse_ml_clust_mode(char *str, s_fparams *p) ;
+int parse_refine_mode(char *str, s_fparams *p) ;
+int parse_desc_threads(char *str, s_fparams *p) ;
+int parse_rand_seed(char *str, s_fparams *p) ;
+int parse_volume_engine(char *str, s_fparams *p) ;
+int parse_out_layout(char *str, s_fparams *p) ;
+int parse_out_bin(char *str, s_fparams *p) ;
 
 int is_fpocket_opt(const char opt) ;
 
@@ -0,0 +1,89 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_FPBATCH
+#define DH_FPBATCH
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "fparams.h"
+#include "fpmain.h"
+#include "voronoi.h"
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+/* State of a pdb of the batch */
+#define M_BATCH_TODO 0
+#define M_BATCH_RUNNING 1
+#define M_BATCH_DONE 2
+#define M_BATCH_FAILED 3
+#define M_BATCH_CRASHED 4
+
+/* Extension added to the pdb list file name for the summary manifest */
+#define M_BATCH_SUMMARY_EXT ".summary"
+
+/* --------------------------- PUBLIC STRUCTURES -----------------------------*/
+
+/* One pdb of the batch. Stored in memory shared by all workers. */
+typedef struct s_batch_job
+{
+	int state,		/* One of M_BATCH_* */
+		result,		/* Value returned by process_pdb */
+		worker ;	/* pid of the worker that handled the pdb */
+
+	long fsize,		/* Size of the pdb file, -1 if it can't be read */
+		 rss ;		/* Resident memory of the worker after the pdb (kB) */
+	double time ;	/* Wall time spent on the pdb (s) */
+
+} s_batch_job ;
+
+/* ------------------------------PROTOTYPES-----------------------------------*/
+
+int process_pdb_batch(s_fparams *params) ;
+double get_wall_time(void) ;
+long get_current_rss(void) ;
+
+#endif
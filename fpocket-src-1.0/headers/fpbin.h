@@ -0,0 +1,150 @@
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_FPBIN
+#define DH_FPBIN
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* -------------------------------- MACROS ---------------------------------- */
+
+/* Binary columnar result of fpocket (X_out/X_pockets.fpb, see
+ * write_pockets_bin). Layout, in the byte order of the writer:
+ *
+ *	s_fpb_header				 magic, version, counts, size of the file
+ *	s_fpb_col[ncols]			 directory: name, type, width, rows, offset
+ *	column data					 nrows*width values per column, each column
+ *								 starting at a multiple of M_FPB_ALIGN
+ *
+ * Pockets are rows of the pock_* and desc_* columns. Alpha spheres (sph_*) and
+ * atoms contacted (pock_atoms) of pocket i are rows ptr[i] to ptr[i+1]-1 of
+ * their table (CSR), ptr being pock_sph_ptr and pock_atm_ptr. pock_atoms and
+ * sph_atoms are rows of the atom table (atm_*), atoms being stored once. */
+
+#define M_FPB_MAGIC "FPOCKBIN"
+#define M_FPB_VERSION 1
+#define M_FPB_BYTE_ORDER 0x01020304u
+#define M_FPB_ALIGN 8
+#define M_FPB_NAME_LEN 32
+
+/* Types of the columns */
+#define M_FPB_F32 1
+#define M_FPB_I32 2
+#define M_FPB_CHAR 3	/* width characters per row, NUL padded */
+
+/* Columns of the pocket table */
+#define M_FPB_POCK_ID "pock_id"				/* i32, number of the pocket */
+#define M_FPB_POCK_SCORE "pock_score"		/* f32 */
+#define M_FPB_POCK_CENTER "pock_center"		/* f32 x 3, barycenter */
+#define M_FPB_POCK_NAPOL "pock_nb_apol_asph"	/* i32 */
+#define M_FPB_POCK_SPH_PTR "pock_sph_ptr"	/* i32, npockets+1 rows */
+#define M_FPB_POCK_ATM_PTR "pock_atm_ptr"	/* i32, npockets+1 rows */
+#define M_FPB_POCK_ATOMS "pock_atoms"		/* i32, rows of the atom table */
+/* Descriptors (s_desc): desc_<field>, f32 or i32, desc_aa_compo is i32 x 20 */
+
+/* Columns of the alpha sphere table */
+#define M_FPB_SPH_CENTER "sph_center"		/* f32 x 3 */
+#define M_FPB_SPH_RADIUS "sph_radius"		/* f32 */
+#define M_FPB_SPH_POLAR "sph_polar"			/* i32, 0 if apolar, 1 if polar */
+#define M_FPB_SPH_ATOMS "sph_atoms"			/* i32 x 4, rows of the atom table */
+
+/* Columns of the atom table */
+#define M_FPB_ATM_ID "atm_id"				/* i32 */
+#define M_FPB_ATM_CENTER "atm_center"		/* f32 x 3 */
+#define M_FPB_ATM_NAME "atm_name"			/* char x 5 */
+#define M_FPB_ATM_RES_NAME "atm_res_name"	/* char x 8 */
+#define M_FPB_ATM_CHAIN "atm_chain"			/* char x 5 */
+#define M_FPB_ATM_RES_ID "atm_res_id"		/* i32 */
+#define M_FPB_ATM_INSERT "atm_insert"		/* char x 1 */
+#define M_FPB_ATM_SYMBOL "atm_symbol"		/* char x 3 */
+
+/* --------------------------- PUBLIC STRUCTURES ---------------------------- */
+
+typedef struct s_fpb_header
+{
+	char magic[8] ;			/* M_FPB_MAGIC, not NUL terminated */
+	uint32_t version,		/* M_FPB_VERSION */
+			 byte_order,	/* M_FPB_BYTE_ORDER as written */
+			 ncols,			/* Number of columns */
+			 npockets,		/* Rows of the pocket table */
+			 nspheres,		/* Rows of the alpha sphere table */
+			 natoms,		/* Rows of the atom table */
+			 nmembers,		/* Rows of pock_atoms */
+			 reserved ;
+	uint64_t size ;			/* Size of the file */
+
+} s_fpb_header ;
+
+typedef struct s_fpb_col
+{
+	char name[M_FPB_NAME_LEN] ;	/* NUL terminated */
+	uint32_t type,				/* M_FPB_F32, M_FPB_I32 or M_FPB_CHAR */
+			 width ;			/* Values per row */
+	uint64_t nrows,
+			 offset ;			/* From the start of the file */
+
+} s_fpb_col ;
+
+/* A result file opened (mapped) by fpb_open. Columns are read in place. */
+typedef struct s_fpb
+{
+	const char *data ;			/* The file */
+	size_t size ;
+
+	const s_fpb_header *header ;
+	const s_fpb_col *cols ;
+
+} s_fpb ;
+
+/* ------------------------------ PUBLIC FUNCTIONS ---------------------------*/
+
+s_fpb* fpb_open(const char *path) ;
+void fpb_close(s_fpb *fpb) ;
+
+const s_fpb_col* fpb_col(const s_fpb *fpb, const char *name) ;
+const float* fpb_f32(const s_fpb *fpb, const char *name, int *width) ;
+const int32_t* fpb_i32(const s_fpb *fpb, const char *name, int *width) ;
+const char* fpb_chars(const s_fpb *fpb, const char *name, int *width) ;
+
+int fpb_pocket_atoms(const s_fpb *fpb, int pocket, const int32_t **atoms) ;
+int fpb_pocket_spheres(const s_fpb *fpb, int pocket, int *first) ;
+
+#endif
@@ -48,10 +48,11 @@
 #include "fpout.h"
 
 #include "memhandler.h"
+#include "fpbatch.h"
 
 /* ------------------------------PROTOTYPES-----------------------------------*/
 
 
-void process_pdb(char *pdbname, s_fparams *params) ;
+int process_pdb(char *pdbname, s_fparams *params) ;
 
 #endif
@@ -44,6 +44,7 @@
 
 #include "rpdb.h"
 #include "voronoi.h"
+#include "vcache.h"
 
 #include "pocket.h"
 #include "psorting.h"
@@ -57,5 +58,8 @@
 /* ------------------------------PROTOTYPES-----------------------------------*/
 
 c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params) ;
+c_lst_pockets* update_pocket_search(c_lst_pockets *pockets, s_pdb *old,
+									s_pdb *pdb, s_fparams *params) ;
+c_lst_pockets* search_pocket_vert(s_lst_vvertice *lvert, s_fparams *params) ;
 
 #endif
@@ -41,6 +41,9 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "pocket.h"
 #include "utils.h"
@@ -51,6 +54,6 @@
 
 /* -----------------------------PROTOTYPES------------------------------------*/
 
-void write_out_fpocket(c_lst_pockets *pockets, s_pdb *pdb, char *pdbname) ;
+int write_out_fpocket(c_lst_pockets *pockets, s_pdb *pdb, char *pdbname, int layout, int bin) ;
 
 #endif
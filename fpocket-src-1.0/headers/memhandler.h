@@ -41,6 +41,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <pthread.h>
 
 
 /* -------------------------------MACROS--------------------------------------*/
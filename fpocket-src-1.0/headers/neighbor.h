@@ -40,6 +40,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <math.h>
 
 #include "voronoi.h"
 #include "atom.h"
@@ -53,34 +54,94 @@
 #define M_INTERFACE_SEARCH 1
 #define M_NO_INTERFACE_SEARCH 0
 
+/* Elements looked for in a s_nindex: M_ATOM_TYPE, M_VERTICE_TYPE (see sort.h)
+ * or both */
+#define M_NINDEX_ALL -1
+
+/* No more than ~8 cells per element in a s_nindex */
+#define M_NINDEX_CELLS_PER_ELEM 8
+
+/* Margin added to the search radius when choosing the cells to look at,
+ * for rounding errors */
+#define M_NINDEX_MARGIN 1e-3
+
 /* -------------------------- PUBLIC STRUCTURES ------------------------------*/
 
+/**
+	Spatial index of atoms and vertices: elements are sorted by cell of a
+	uniform grid, atoms of a cell first, then its vertices (see alloc_nindex).
+*/
+typedef struct s_nindex
+{
+	s_vect_elem *elem ;	/* Atoms and vertices sorted by cell */
+	float *xyz ;		/* Coordinates of the elements, same order */
+	int *cstart ;		/* First atom and first vertice of each cell
+						   (2*ncell + 1) */
+
+	int n,				/* Number of elements */
+		natm,			/* Number of atoms */
+		nvert,			/* Number of vertices */
+		nx, ny, nz ;	/* Number of cells in each dimension */
+
+	float xmin, ymin, zmin,
+		  cs ;			/* Size of the cells */
+
+} s_nindex ;
+
 /* -------------------------------PROTOTYPES--------------------------------- */
 
-s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
-			  float dist_crit, int *nneigh) ;
+s_nindex* alloc_nindex(s_atm **atoms, int natoms, s_vvertice **pvert, int nvert,
+					   float cs) ;
+void free_nindex(s_nindex *ind) ;
+
+int get_nindex_neigh(s_nindex *ind, float x, float y, float z, float dcrit,
+					 int type, int **res, int *nmax) ;
+int is_nindex_neigh(s_nindex *ind, float x, float y, float z, float dcrit,
+					int type) ;
+int get_nindex_knearest(s_nindex *ind, float x, float y, float z, int k,
+						int type, int *res, float *rdist) ;
+int* get_nindex_batch_neigh(s_nindex *ind, float *xyz, int nq, float dcrit,
+							int type, int *nneigh) ;
 
-s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms,
-                              s_vvertice **pvert, int nvert,
-                              float vdist_crit, int interface_search, int *nneigh) ;
+s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+						  float dcrit, int *nneigh) ;
 
-s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
-				s_vvertice **pvert, int nvert,
-				float dist_crit, int *nneigh) ;
+s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+							  float vdcrit, int interface_search, int *nneigh) ;
 
-float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
-				 s_vvertice **pvert, int nvert,
-				 float dist_crit) ;
+s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+								float dcrit, int *nneigh) ;
 
-float count_atm_prop_vert_neigh (s_atm **lig, int nlig,
-				 s_vvertice **pvert, int nvert,
-				 float dist_crit) ;
+float count_pocket_lig_vert_ovlp(s_nindex *lind, s_vvertice **pvert, int nvert,
+								 float dcrit) ;
 
+float count_atm_prop_vert_neigh(s_nindex *lind, s_vvertice **pvert, int nvert,
+								float dcrit) ;
 
 int count_vert_neigh_P(s_vvertice **pvert, int nvert,
                        s_vvertice **pvert_all, int nvert_all,
                        float dcrit) ;
 
-int count_vert_neigh(s_vsort *lsort, s_vvertice **pvert, int nvert,float dcrit);
+int count_vert_neigh(s_nindex *ind, s_vvertice **pvert, int nvert, float dcrit) ;
+
+s_atm** get_mol_atm_neigh_naive(s_atm **atoms, int natoms, s_atm **all, int nall,
+								float dist_crit, int *nneigh) ;
+
+s_atm** get_mol_ctd_atm_neigh_naive(s_atm **atoms, int natoms,
+									s_vvertice **pvert, int nvert,
+									float vdist_crit, int interface_search,
+									int *nneigh) ;
+
+s_vvertice** get_mol_vert_neigh_naive(s_atm **atoms, int natoms,
+									  s_vvertice **pvert, int nvert,
+									  float dist_crit, int *nneigh) ;
+
+float count_pocket_lig_vert_ovlp_naive(s_atm **lig, int nlig,
+									   s_vvertice **pvert, int nvert,
+									   float dist_crit) ;
+
+float count_atm_prop_vert_neigh_naive(s_atm **lig, int nlig,
+									  s_vvertice **pvert, int nvert,
+									  float dist_crit) ;
 
 #endif
@@ -41,15 +41,23 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "utils.h"
 
+/* --------------------------------MACROS-------------------------------------*/
+
+/* Size of the symbol table: 26 first letters, 26 second letters or none */
+#define M_PTE_NKEY (26*27)
+
 
 /* ---------------------------PROTOTYPES--------------------------------------*/
 
 float pte_get_vdw_ray(const char *symbol) ;
 float pte_get_mass(const char *symbol) ;
 float pte_get_enegativity(const char *symbol) ;
+int pte_get_index(const char *symbol) ;
+int pte_get_properties(const char *symbol, float *mass, float *ray, float *eneg) ;
 int is_valid_element(const char *str, int ignore_case) ;
 
 #endif
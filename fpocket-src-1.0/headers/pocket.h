@@ -43,6 +43,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "voronoi_lst.h"
 #include "pscoring.h"
@@ -54,6 +55,29 @@
 
 /* ---------------------- PUBLIC STRUCTURES ----------------------------------*/
 
+/* Pockets stored as arrays (CSR), built by clusterPockets: the vertices of
+ * row i are vert[vstart[i]] ... vert[vstart[i+1]-1]. When two pockets are
+ * merged, the rows of the second one are chained after the rows of the first
+ * one (rnext), the first row holding the counts of the whole pocket, and
+ * set_pockets_table makes each pocket a single row again. */
+typedef struct s_ptable
+{
+	s_vvertice **vert ;		/* Vertices of all pockets, pocket by pocket */
+	int *vstart,			/* First vertex of each row (np + 1) */
+		*rnext,				/* Next row of the same pocket, -1 if none */
+		*rlast ;			/* Last row of the pocket (first rows only) */
+
+	float *bx, *by, *bz,	/* Barycenters */
+		  *score ;			/* Scores */
+	int *nvert,				/* Number of vertices */
+		*napol,				/* Number of apolar / polar vertices */
+		*npol ;
+
+	int np,
+		nv ;
+
+} s_ptable ;
+
 typedef struct s_pocket
 {
     s_desc *pdesc ;
@@ -68,7 +92,10 @@ typedef struct s_pocket
     int rank,				/* Rank of the pocket */
 	size,
 	nAlphaApol,			/* Number of apolar alpha spheres*/
-	nAlphaPol ;			/* Number of polar alpha spheres */
+	nAlphaPol,			/* Number of polar alpha spheres */
+	prow ;				/* Row in ptab, -1 if none */
+
+    s_ptable *ptab ;		/* Pockets as arrays, NULL if not built */
 
 } s_pocket ; 
 
@@ -89,6 +116,7 @@ typedef struct c_lst_pockets
 	size_t n_pockets ;
 
 	s_lst_vvertice *vertices ;
+	s_ptable *ptab ;		/* Pockets as arrays, NULL if not built */
 
 } c_lst_pockets ;
 
@@ -98,17 +126,19 @@ typedef struct c_lst_pockets
 
 /* CLUSTERING FUNCTIONS */
 c_lst_pockets *clusterPockets(s_lst_vvertice *lvvert, s_fparams *params);
-int updateIds(s_lst_vvertice *lvvert, int i, int *vNb, int resid,int curPocket,c_lst_pockets *pockets, s_fparams *params);
 void addStats(int resid, int size, int **stats,int *lenStats);
 
 /* DESCRIPTOR FUNCTIONS */
 void set_pockets_descriptors(c_lst_pockets *pockets) ;
+void set_pockets_desc_threads(int nthreads) ;
 void set_normalized_descriptors(c_lst_pockets *pockets) ;
 void set_pockets_bary(c_lst_pockets *pockets) ;
 s_atm** get_pocket_contacted_atms(s_pocket *pocket, int *natoms) ;
 int count_pocket_contacted_atms(s_pocket *pocket) ;
 s_vvertice** get_pocket_pvertices(s_pocket *pocket) ;
 
+s_vvertice** get_pocket_vert_array(s_pocket *pocket, int *nvert, int *tofree) ;
+
 float set_pocket_mtvolume(s_pocket *pocket, int niter) ;
 float set_pocket_volume(s_pocket *pocket, int discret) ;
 
@@ -118,6 +148,8 @@ s_pocket* alloc_pocket(void) ;
 c_lst_pockets *c_lst_pockets_alloc(void);
 node_pocket *node_pocket_alloc(s_pocket *pocket);
 void c_lst_pocket_free(c_lst_pockets *lst);
+s_ptable* set_pockets_table(c_lst_pockets *pockets) ;
+void free_pockets_table(c_lst_pockets *pockets) ;
 
 node_pocket *c_lst_pockets_add_first(c_lst_pockets *lst, s_pocket *pocket);
 node_pocket *c_lst_pockets_add_last(c_lst_pockets *lst,s_pocket *pocket,int cur_n_apol, int cur_n_pol);
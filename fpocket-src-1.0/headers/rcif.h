@@ -0,0 +1,115 @@
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_RCIF
+#define DH_RCIF
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "rpdb.h"
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+/* Columns of the _atom_site loop used to fill the atoms (ST_rcif_fields) */
+#define M_RCIF_GROUP       0
+#define M_RCIF_ID          1
+#define M_RCIF_SYMBOL      2
+#define M_RCIF_LABEL_ATOM  3
+#define M_RCIF_AUTH_ATOM   4
+#define M_RCIF_ALT         5
+#define M_RCIF_LABEL_COMP  6
+#define M_RCIF_AUTH_COMP   7
+#define M_RCIF_LABEL_ASYM  8
+#define M_RCIF_AUTH_ASYM   9
+#define M_RCIF_LABEL_SEQ  10
+#define M_RCIF_AUTH_SEQ   11
+#define M_RCIF_INS        12
+#define M_RCIF_X          13
+#define M_RCIF_Y          14
+#define M_RCIF_Z          15
+#define M_RCIF_OCC        16
+#define M_RCIF_BFACTOR    17
+#define M_RCIF_CHARGE     18
+#define M_RCIF_MODEL      19
+#define M_RCIF_NFIELD     20
+
+/* Other column of _atom_site, and column of another category */
+#define M_RCIF_OTHER      -1
+#define M_RCIF_NOT_ATOM   -2
+
+/* Parser state: out of a loop, reading the names or the values of a loop */
+#define M_RCIF_NONE 0
+#define M_RCIF_HEAD 1
+#define M_RCIF_DATA 2
+
+/* Size of a short _atom_site row, to guess the number of atoms of a file:
+ * too many atoms are allocated rather than grown, the atoms not read are
+ * never touched (calloc) */
+#define M_RCIF_ROW_LEN 64
+
+/* Blank, tested on the characters of all values: most of them are above ' ' */
+#define M_RCIF_SPACE(c) ((unsigned char) (c) <= ' ' \
+						 && ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r'))
+
+/* Reserved words and names (rcif_word) */
+#define M_RCIF_WORD_DATA 1
+#define M_RCIF_WORD_LOOP 2
+#define M_RCIF_WORD_NAME 3
+
+/* First character of a reserved word (data_, loop_) or of a name */
+#define M_RCIF_RESERVED(c) ((c) == '_' || (c) == 'd' || (c) == 'D' || (c) == 'l' \
+							|| (c) == 'L')
+
+/* --------------------------- PUBLIC STRUCTURES -----------------------------*/
+
+/* A value of the file: characters in the file, not null terminated */
+typedef struct s_rcif_tok
+{
+	const char *s ;
+	int len,
+		quoted ;	/* 1 for a quoted string or text field */
+
+} s_rcif_tok ;
+
+/* ------------------------------ PUBLIC FUNCTIONS ---------------------------*/
+
+int rcif_is_cif(const char *buf, size_t len) ;
+void rcif_parse(s_pdb *pdb, const char *buf, size_t len, const char *ligan,
+				const int keep_lig) ;
+
+#endif
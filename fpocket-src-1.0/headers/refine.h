@@ -45,6 +45,7 @@
 #include "calc.h"
 #include "pocket.h"
 #include "fparams.h"
+#include "memhandler.h"
 
 
 /* -------------------------- PUBLIC STRUCTURES ------------------------------*/
@@ -53,6 +54,7 @@
 /* --------------------------PROTOTYPES---------------------------------------*/
 
 void refinePockets(c_lst_pockets *pockets, s_fparams *params);
+void refinePockets_naive(c_lst_pockets *pockets, s_fparams *params);
 void reIndexPockets(c_lst_pockets *pockets);
 void dropSmallNpolarPockets(c_lst_pockets *pockets, s_fparams *params);
 void drop_tiny(c_lst_pockets *pockets) ;
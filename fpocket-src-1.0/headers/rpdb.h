@@ -36,6 +36,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <zlib.h>
+#ifdef M_USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "atom.h"
 #include "pertable.h"
@@ -59,13 +71,36 @@
 #define M_PDB_END     8
 #define M_PDB_UNKNOWN 9
 
+/* Initial size of the buffer of a file that can't be mapped */
+#define M_RPDB_READ_CHUNK 65536
+
+/* Compressed files, found from their first bytes */
+#define M_RPDB_GZIP(b) ((unsigned char) (b)[0] == 0x1f && (unsigned char) (b)[1] == 0x8b)
+#define M_RPDB_ZSTD(b) ((unsigned char) (b)[0] == 0x28 && (unsigned char) (b)[1] == 0xb5 \
+						&& (unsigned char) (b)[2] == 0x2f && (unsigned char) (b)[3] == 0xfd)
+
+/* Kind of the atoms read by rpdb_parse */
+#define M_RPDB_ATM 0
+#define M_RPDB_HET 1
+#define M_RPDB_LIG 2
+
+/* Perfect hash of the HETATM kept: 3 characters of the resname -> slot */
+#define M_RPDB_HET_BITS 9
+#define M_RPDB_HET_NSLOT (1 << M_RPDB_HET_BITS)
+#define M_RPDB_HET_MULT 0xE3783A1Bu
+#define M_RPDB_HET_USED 0x01000000u
+#define M_RPDB_HET_KEY(r) (((uint32_t) (unsigned char) (r)[0] << 16) \
+						 | ((uint32_t) (unsigned char) (r)[1] << 8) \
+						 | (uint32_t) (unsigned char) (r)[2])
+#define M_RPDB_HET_HASH(k) ((uint32_t) ((k)*M_RPDB_HET_MULT) >> (32 - M_RPDB_HET_BITS))
+
 /*
  * API functions start here
  */
 
 typedef struct s_pdb
 {
-    FILE *fpdb ;
+    FILE *fpdb ;		/* Only used by rpdb_open_naive/rpdb_read_naive */
 
     s_atm *latoms ;     /* The list of atoms: contains all atoms! */
 
@@ -75,7 +110,8 @@ typedef struct s_pdb
 
     int natoms,			/* Number of atoms */
             nhetatm,		/* Number of HETATM */
-            natm_lig ;		/* Number of ligand atoms */
+            natm_lig,		/* Number of ligand atoms */
+            nguess ;		/* Number of atoms with a guessed element */
 
     float A, B, C, 			/* Side lengths of the unit cell */
           alpha, beta, gamma ;	/* Angle between B and C, A and C, A and C */
@@ -85,10 +121,39 @@ typedef struct s_pdb
 } s_pdb ;
 
 
+/* Atoms read by a parser (rpdb_parse, rcif_parse), before being stored in a
+ * s_pdb by rpdb_store_atoms */
+typedef struct s_rpdb_atoms
+{
+    s_atm *atoms ;	/* Atoms read, the list grows geometrically */
+    char *kind ;	/* M_RPDB_ATM, M_RPDB_HET or M_RPDB_LIG for each atom */
+
+    int n,			/* Number of atoms read */
+        nmax,		/* Size of the list */
+        nhet,		/* Number of HETATM kept */
+        nlig,		/* Number of ligand atoms */
+        nguess ;	/* Number of atoms with a guessed element */
+
+} s_rpdb_atoms ;
+
+
 /* ------------------------------ PUBLIC FUNCTIONS ---------------------------*/
 
 s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig) ;
 void rpdb_read(s_pdb *pdb, const char *ligan, const int keep_lig) ;
+s_pdb* rpdb_open_naive(char *fpath, const char *ligan, const int keep_lig) ;
+void rpdb_read_naive(s_pdb *pdb, const char *ligan, const int keep_lig) ;
+int rpdb_is_kept_hetatm(const char *resb) ;
+
+void rpdb_init_atoms(s_rpdb_atoms *ra, int nmax) ;
+s_atm* rpdb_new_atom(s_rpdb_atoms *ra, int kind) ;
+int rpdb_atom_kind(int hetatm, const char *resb, const char *ligan, const int keep_lig) ;
+void rpdb_set_element(s_atm *atom, int *nguess) ;
+void rpdb_store_atoms(s_pdb *pdb, s_rpdb_atoms *ra) ;
+
+void rpdb_col_str(const char *line, int len, int beg, int end, char *dest) ;
+int rpdb_col_int(const char *line, int len, int beg, int end) ;
+float rpdb_col_float(const char *line, int len, int beg, int end) ;
 
 void rpdb_extract_atm_resname(char *pdb_line, char *res_name) ;
 
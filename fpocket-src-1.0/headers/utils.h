@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <limits.h>
 #include <time.h>
@@ -59,6 +60,8 @@
 #define M_SIGN 1
 #define M_NO_SIGN 0
 
+#define M_IDSET_MIN_SIZE 64		/* Smallest table of a set of ids */
+
 
 #ifdef MD_USE_GSL	/* GSL */
 
@@ -79,6 +82,18 @@ typedef struct tab_str
 
 } tab_str ; 
 
+/* Set of ids: open addressing table, slots stamped with the generation of
+ * the set (see alloc_idset) */
+typedef struct s_idset
+{
+	int *keys ;
+	unsigned int *stamp,
+				 gen ;
+	int size,				/* Size of the table (power of 2) */
+		n ;					/* Number of values */
+
+} s_idset ;
+
 
 /* ------------------------------- PROTOTYPES ------------------------------- */
 
@@ -94,14 +109,26 @@ void print_tab_str(tab_str* strings) ;
 int in_tab(int *tab, int size, int val) ;
 int index_of(int *tab, int size, int val)  ;
 
+s_idset* alloc_idset(int nmax) ;
+void reset_idset(s_idset *s) ;
+int add_idset(s_idset *s, int val) ;
+int in_idset(s_idset *s, int val) ;
+void free_idset(s_idset *s) ;
+
 
 void remove_ext(char *str) ;
 void remove_path(char *str) ;
+void remove_pdb_ext(char *str) ;
+int compressed_ext_len(const char *str) ;
 void extract_ext(char *str, char *dest) ;
 void extract_path(char *str, char *dest) ;
 
 void start_rand_generator(void) ;
 float rand_uniform(float min, float max) ;
+void set_rand_seed(int seed) ;
+unsigned int get_rand_seed(void) ;
+void set_thread_rand_seed(unsigned int seed) ;
+void unset_thread_rand(void) ;
 
 FILE* fopen_pdb_check_case(char *name, const char *mode)  ;
 
@@ -0,0 +1,77 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_VBENCH
+#define DH_VBENCH
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "voronoi.h"
+#include "vtest.h"
+#include "rpdb.h"
+#include "fparams.h"
+#include "pocket.h"
+#include "refine.h"
+#include "cluster.h"
+#include "fpocket.h"
+#include "neighbor.h"
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+#define M_VBENCH_NREP 20		/* Default number of repetitions */
+#define M_VBENCH_NSYNTH 500000	/* Number of synthetic candidates */
+#define M_VBENCH_BOX 200.0		/* Size of the synthetic box */
+#define M_VBENCH_NEIGH_D 4.0	/* Interface distance (as dpocket) */
+#define M_VBENCH_OVLP_D 3.0		/* Vertice overlap distance (as tpocket) */
+#define M_VBENCH_BIG_NVERT 50000	/* Alpha spheres of the large pocket */
+#define M_VBENCH_BIG_NATM 20000		/* Atoms they contact (at random) */
+
+/* --------------------------- PUBLIC STRUCTURES -----------------------------*/
+
+/* Candidate vertices: centers and indexes of the 4 contacting atoms */
+typedef struct s_vbench
+{
+	float *xyz ;
+	int *nb,
+		n ;
+
+} s_vbench ;
+
+#endif
@@ -0,0 +1,102 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_VCACHE
+#define DH_VCACHE
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "voronoi.h"
+#include "rpdb.h"
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+#define M_VCACHE_MAGIC "FPVC"
+#define M_VCACHE_VERSION 4
+#define M_VCACHE_EXT ".fpv"
+
+/* Max length of the path of a cache file */
+#define M_VCACHE_PATH_LEN 512
+
+/* --------------------------- PUBLIC STRUCTURES -----------------------------*/
+
+/* Header of a cache file, followed by n_h_tr ints (h_tr) and nvert
+ * s_vcache_vert. */
+typedef struct s_vcache_header
+{
+	char magic[4] ;
+	int version ;
+	uint64_t key ;		/* Hash of the atoms and alpha sphere parameters */
+
+	int natoms,
+		n_h_tr,
+		nvert,
+		qhullSize ;
+
+} s_vcache_header ;
+
+/* A vertice as stored in the cache. Atoms are given by their index in the
+ * pdb atom list. */
+typedef struct s_vcache_vert
+{
+	float x, y, z,
+		  ray ;
+
+	int id,
+		qhullId,
+		type,
+		vneigh[4],
+		neigh[4] ;
+
+} s_vcache_vert ;
+
+/* -----------------------------PROTOTYPES------------------------------------*/
+
+uint64_t get_vvertices_key(s_pdb *pdb, int min_apol_neigh, float asph_min_size,
+						   float asph_max_size, int variant) ;
+s_lst_vvertice* read_vvertices_cache(const char *dir, s_pdb *pdb, uint64_t key) ;
+int write_vvertices_cache(const char *dir, s_pdb *pdb, uint64_t key,
+						  s_lst_vvertice *lvvert) ;
+
+#endif
@@ -0,0 +1,92 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_VOLUME
+#define DH_VOLUME
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "memhandler.h"
+
+/* --------------------------------MACROS-------------------------------------*/
+
+/* Engines computing the volume of unions of spheres (see set_volume_engine) */
+#define M_VOLUME_MC 0			/* Monte Carlo / regular sampling of a box */
+#define M_VOLUME_GRID 1			/* Spheres rasterised in a bitset grid */
+#define M_VOLUME_EXACT 2		/* Analytic, on the power diagram */
+
+#define M_VGRID_NOBJ 2			/* Maximum number of objects in a grid */
+#define M_VGRID_VOXELS_PER_ITER 8	/* Voxels of the box per Monte Carlo iteration */
+#define M_VGRID_MIN_STEP 0.1	/* Smallest voxel size (A) */
+#define M_VGRID_MAX_VOXELS 67108864	/* Largest grid (8 Mb per object) */
+#define M_VEXACT_EPS 1e-9		/* Tolerance of the power cells (x radius) */
+
+/* --------------------------------STRUCTURES---------------------------------*/
+
+/* Grid of voxels, each object (union of spheres) being a bitset over the
+ * voxels: one bit per voxel, rows along x stored in nw 64 bit words */
+typedef struct s_vgrid
+{
+	uint64_t *bits[M_VGRID_NOBJ] ;
+
+	float min[3],			/* Corner of the first voxel */
+		  step ;			/* Size of a voxel */
+
+	int n[3],				/* Number of voxels along x, y and z */
+		nw,					/* Number of words per row */
+		nobj ;
+
+	size_t nword ;			/* Number of words per object */
+
+} s_vgrid ;
+
+/* -----------------------------PROTOTYPES------------------------------------*/
+
+void set_volume_engine(int engine) ;
+int get_volume_engine(void) ;
+
+void set_spheres_bbox(float *xyzr, int n, float *bmin, float *bmax, int extend) ;
+s_vgrid* alloc_vgrid(float *bmin, float *bmax, int niter, int idiscret, int nobj) ;
+void add_vgrid_spheres(s_vgrid *g, int obj, float *xyzr, int n) ;
+void get_vgrid_volumes(s_vgrid *g, float *vol, float *vunion, float *voverlap) ;
+void free_vgrid(s_vgrid *g) ;
+
+float get_spheres_volume(float *xyzr, int n, int niter, int idiscret) ;
+float get_spheres_volume_exact(float *xyzr, int n) ;
+
+#endif
@@ -40,11 +40,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "rpdb.h"
 #include "writepdb.h"
 #include "calc.h"
 #include "utils.h"
+#include "vtest.h"
+#include "delaunay.h"
+#include "volume.h"
 #include "../src/qhull/qvoronoi.h"
 
 #include "memhandler.h"
@@ -60,6 +64,25 @@
 #define M_PREC_TOLERANCE 1e-4
 
 #define M_BUFSIZE 1e7
+
+/* The array of vertices read from qhull starts with 1/M_VERT_ALLOC_RATIO of
+ * the qhull vertices (at least M_VERT_ALLOC_MIN), and doubles when full */
+#define M_VERT_ALLOC_RATIO 8
+#define M_VERT_ALLOC_MIN 64
+
+/* Local re-tesselation (update_vvertices): atoms at less than 2 times the
+ * max alpha sphere size + this margin from a changed atom are tesselated */
+#define M_VUPDATE_MARGIN 1.0
+/* Distance under which a point is considered to touch an alpha sphere */
+#define M_VUPDATE_TOLERANCE 1e-3
+/* Minimum number of atoms for a local tesselation */
+#define M_VUPDATE_MIN_ATOMS 5
+
+/* Partitioned tesselation (load_vvertices_part): width of the halo added to
+ * each box is 2 times the max alpha sphere size + this margin */
+#define M_VPART_MARGIN 1.0
+/* Number of boxes per thread */
+#define M_VPART_BOX_PER_THREAD 4
 /* --------------------------------STRUCTURES-------------------------------- */
 
 typedef struct s_vvertice 
@@ -92,9 +115,8 @@ typedef struct s_lst_vvertice
         
 	int *h_tr;
 	int n_h_tr;
-	int *tr,
-		nvert,
-		qhullSize ;
+	int nvert,
+		qhullSize ;	/* Number of vertices given by qhull (kept or not) */
 
 } s_lst_vvertice ;
 
@@ -102,10 +124,20 @@ typedef struct s_lst_vvertice
 
 s_lst_vvertice* load_vvertices(s_pdb *pdb, int min_apol_neigh, 
 				float ashape_min_size, float ashape_max_size) ;
+s_lst_vvertice* load_vvertices_part(s_pdb *pdb, int min_apol_neigh,
+									float asph_min_size, float asph_max_size,
+									int nthreads) ;
+s_lst_vvertice* update_vvertices(s_lst_vvertice *lvvert, s_pdb *old, s_pdb *pdb,
+								 int min_apol_neigh, float asph_min_size,
+								 float asph_max_size) ;
 float testVvertice(float xyz[3], int curNbIdx[4], s_atm *atoms, 
 				   float min_asph_size, float max_asph_size, 
 				   s_lst_vvertice *lvvert);
 
+int get_vert_idx(s_lst_vvertice *lvvert, int qhullId) ;
+void set_delaunay_engine(int engine) ;
+int get_delaunay_engine(void) ;
+void set_vvertices_keep_mem(int keep) ;
 void set_barycenter(s_vvertice *v) ;
 int is_in_lst_vert(s_vvertice **lst_vert, int nb_vert, int v_id) ;
 int is_in_lst_vert_p(s_vvertice **lst_vert, int nb_vert, s_vvertice *vert);
@@ -0,0 +1,89 @@
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+#ifndef DH_VTEST
+#define DH_VTEST
+
+/* ------------------------------INCLUDES-------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define M_VTEST_X86
+#endif
+
+/* --------------------------------MACROS-------------------------------------*/
+
+/* Number of candidate vertices tested at once */
+#define M_VTEST_BATCH 256
+
+/* Implementations of the batch test */
+#define M_VTEST_AUTO -1
+#define M_VTEST_SCALAR 0
+#define M_VTEST_SSE 1
+#define M_VTEST_AVX2 2
+
+/* --------------------------- PUBLIC STRUCTURES -----------------------------*/
+
+/* A batch of candidate alpha spheres (voronoi vertices), stored as packed
+ * arrays: the center of each candidate, and coordinates and
+ * electronegativity of its 4 contacting atoms. */
+typedef struct s_vtest_batch
+{
+	int n ;		/* Number of candidates in the batch */
+
+	float cx[M_VTEST_BATCH],
+		  cy[M_VTEST_BATCH],
+		  cz[M_VTEST_BATCH],
+		  ax[4][M_VTEST_BATCH],
+		  ay[4][M_VTEST_BATCH],
+		  az[4][M_VTEST_BATCH],
+		  en[4][M_VTEST_BATCH] ;
+
+	/* Results: radius (-1 if the candidate is rejected) and number of
+	 * apolar contacting atoms */
+	float ray[M_VTEST_BATCH] ;
+	int napol[M_VTEST_BATCH] ;
+
+} s_vtest_batch ;
+
+/* -----------------------------PROTOTYPES------------------------------------*/
+
+void vtest_batch(s_vtest_batch *b, float min_asph_size, float max_asph_size) ;
+int vtest_set_impl(int impl) ;
+const char* vtest_get_impl_name(void) ;
+
+#endif
@@ -39,6 +39,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include "utils.h"
 
 /* ----------------------------- PUBLIC MACROS ------------------------------ */
@@ -37,9 +37,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+/* ------------------------------- MACROS ----------------------------------- */
+
+#define M_WPDB_BUF_LEN 262144	/* Buffer of the output files (fopen_out) */
+#define M_WPDB_LINE_LEN 512		/* Largest record written (huge numbers) */
 
 /* -------------------------- PUBLIC FUNCTIONS ------------------------------ */
 
+FILE* fopen_out(const char *path) ;
+int fclose_out(FILE *f) ;
+
 void write_pdb_atom_line(FILE *f, const char rec_name[], int id, const char atom_name[], 
 						 char alt_loc, const char res_name[], const char chain[], 
 						 int res_id, const char insert, float x, float y, float z, float occ, 
@@ -48,4 +58,12 @@ void write_pqr_atom_line(FILE *f, const char *rec_name, int id, const char *atom
 						 char alt_loc, const char *res_name, const char *chain, 
 						 int res_id, const char insert, float x, float y, float z, float charge, 
 						 float radius);
+void write_pdb_atom_line_naive(FILE *f, const char rec_name[], int id, const char atom_name[], 
+						 char alt_loc, const char res_name[], const char chain[], 
+						 int res_id, const char insert, float x, float y, float z, float occ, 
+						 float bfactor,	const char *symbol, int charge)  ;
+void write_pqr_atom_line_naive(FILE *f, const char *rec_name, int id, const char *atom_name, 
+						 char alt_loc, const char *res_name, const char *chain, 
+						 int res_id, const char insert, float x, float y, float z, float charge, 
+						 float radius);
 #endif
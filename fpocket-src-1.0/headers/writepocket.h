@@ -38,22 +38,34 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "voronoi.h"
 #include "pocket.h"
 #include "writepdb.h"
 #include "utils.h"
+#include "fpbin.h"
+
+/* -------------------------------- MACROS ---------------------------------- */
+
+/* First line of a packed output file (write_pockets_pack) */
+#define M_PACK_MAGIC "FPOCKET_PACK"
+#define M_PACK_VERSION 1
 
 /* ------------------------- PUBLIC STRUCTURES ------------------------------ */
 
 /* -----------------------------PROTOTYPES----------------------------------- */
 
-void write_pockets_single_pdb(const char out[], s_pdb *pdb, c_lst_pockets *pockets)  ;
-void write_pockets_single_pqr(const char out[], c_lst_pockets *pockets);
+int write_pockets_single_pdb(const char out[], s_pdb *pdb, c_lst_pockets *pockets)  ;
+int write_pockets_single_pqr(const char out[], c_lst_pockets *pockets);
 
 void write_each_pocket(const char out_path[], c_lst_pockets *pockets) ;
 void write_pocket_pdb(const char out[], s_pocket *pocket) ;
 void write_pocket_pqr(const char out[], s_pocket *pocket) ;
+void print_pocket_pdb(FILE *f, s_pocket *pocket) ;
+void print_pocket_pqr(FILE *f, s_pocket *pocket) ;
+int write_pockets_pack(const char out[], c_lst_pockets *pockets) ;
+int write_pockets_bin(const char out[], s_pdb *pdb, c_lst_pockets *pockets) ;
 
 void write_pdb_atoms(FILE *f, s_atm *atoms, int natoms) ;
 
@@ -21,6 +21,8 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-07	     get_mol_volume_ptr: exact engine (see volume.c)
+##	17-11-06	     get_mol_volume_ptr: grid engine (see volume.c)
 ##	28-11-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added comments and creation of history
 ##	01-01-08	(vp) Created (random date...)
@@ -164,7 +166,8 @@ void set_mol_barycenter_ptr(s_atm **latoms, int natoms, float bary[3])
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Get an monte carlo approximation of the volume occupied by the atoms given 
-	in argument (list of pointers).
+	in argument (list of pointers), or its volume on a grid with the
+	corresponding precision (see set_volume_engine).
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **atoms : List of pointer to atoms
@@ -180,6 +183,18 @@ float get_mol_volume_ptr(s_atm **atoms, int natoms, int niter)
 	int i = 0, j = 0,
 		nb_in = 0;
 
+	if(get_volume_engine() != M_VOLUME_MC) {
+		float vol, *xyzr = (float *) my_malloc((natoms > 0 ? 4*natoms : 1)*sizeof(float)) ;
+		for(i = 0 ; i < natoms ; i++) {
+			xyzr[4*i] = atoms[i]->x ; xyzr[4*i+1] = atoms[i]->y ;
+			xyzr[4*i+2] = atoms[i]->z ; xyzr[4*i+3] = atoms[i]->radius ;
+		}
+		vol = get_spheres_volume(xyzr, natoms, niter, 0) ;
+		my_free(xyzr) ;
+
+		return vol ;
+	}
+
 	float xmin = 0.0, xmax = 0.0,
 		  ymin = 0.0, ymax = 0.0,
 		  zmin = 0.0, zmax = 0.0,
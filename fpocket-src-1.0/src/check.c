@@ -13,6 +13,38 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	    Local re-tessellation tested with an element changed
+##	17-11-15	    Pocket and sphere counts of a default run against stored
+##					    ones; whole output compared with 2 and 4 threads
+##	17-11-15	    Binary result columns of the wrong rows, type or width
+##	17-11-15	    Long mmCIF residue names not taken for the ligand
+##	17-11-15	    Large pocket test no longer timed (see vbench)
+##	17-11-15	    Table of the pockets followed through the refinement steps
+##	17-11-15	    Test whole fpocket output with 1 and 4 threads
+##	17-11-15	    Corrupted alpha sphere cache files rejected
+##	17-11-15	    Local re-tessellation tested with added and removed atoms, and links
+##	17-11-15	    Sample paths given to rpdb_open in writable strings
+##	17-11-14	    Test binary columnar result
+##	17-11-13	    Test hand formatted records and packed pockets output
+##	17-11-12	    Test compressed input
+##	17-11-11	    Test mmCIF reader
+##	17-11-10	    Test single pass pdb reader
+##	17-11-09	    Test spatial index of atoms and vertices
+##	17-11-08	    Test contacted atoms of a large pocket
+##	17-11-07	    Test exact volumes
+##	17-11-06	    Test voxel grid volumes
+##	17-11-05	    Test vertice based descriptors against the pairwise scan
+##	17-11-05	    Test descriptors computed by several threads
+##	17-11-04	    Test table of the pockets
+##	17-11-03	    Test barycenter merge on a grid
+##	17-11-02	    Test single linkage clustering on a grid
+##	17-10-31	    Test tesselation memory kept between structures
+##	17-10-30	    Test native Delaunay engine against qhull
+##	17-10-29	    Test batch alpha sphere test (vtest_batch)
+##	17-10-28	    Test partitioned tesselation
+##	17-10-27	    Test alpha sphere cache
+##	17-10-27	    Test local re-tesselation (update_vvertices)
+##	17-10-26	    Test concurrent tessellations (re-entrant qhull)
 ##	23-03-09	(v) No more test for qhull installation
 ##	17-03-09	(v) Additional test routines for pdb reading
 ##	22-01-09	(v) Created
@@ -70,6 +102,29 @@ int main(void)
 	int nfailure = check_fparams() ;
 
 	nfailure += check_pdb_reader() ;
+	nfailure += check_qhull_threads() ;
+	nfailure += check_vvertices_update() ;
+	nfailure += check_vvertices_cache() ;
+	nfailure += check_vvertices_part() ;
+	nfailure += check_vtest() ;
+	nfailure += check_delaunay() ;
+	nfailure += check_keep_mem() ;
+	nfailure += check_ml_clust() ;
+	nfailure += check_refine() ;
+	nfailure += check_pockets_table() ;
+	nfailure += check_desc_threads() ;
+	nfailure += check_vert_desc() ;
+	nfailure += check_vgrid() ;
+	nfailure += check_exact_volume() ;
+	nfailure += check_big_pocket() ;
+	nfailure += check_nindex() ;
+	nfailure += check_rpdb() ;
+	nfailure += check_rcif() ;
+	nfailure += check_rpdb_gz() ;
+	nfailure += check_wpdb() ;
+	nfailure += check_fpbin() ;
+	nfailure += check_fpocket_baseline() ;
+	nfailure += check_fpocket_threads() ;
 	nfailure += check_fpocket () ;
 	
 	fprintf(stdout, "\n*** TESTING ENDS WITH %d FAILURES ***\n", nfailure) ;
@@ -93,6 +148,2630 @@ int check_qhull(void)
 	return status ;
 }
 
+/* Summary of a tessellation, filled by the run_qvoronoi_mem callbacks */
+typedef struct s_check_voro
+{
+	double *xyz ;
+	int npts,
+		nvvert,
+		ncalls,
+		status ;
+	double sum ;
+
+} s_check_voro ;
+
+static void check_voro_begin(void *data, int nvvert)
+{
+	((s_check_voro *)data)->nvvert = nvvert ;
+}
+
+static void check_voro_vert(void *data, int id, double *center, int *pts,
+							int *vneigh)
+{
+	s_check_voro *cv = (s_check_voro *)data ;
+	int i ;
+
+	cv->ncalls ++ ;
+	cv->sum += center[0] + center[1] + center[2] + id ;
+	for(i = 0 ; i < 4 ; i++) cv->sum += pts[i] + vneigh[i] ;
+}
+
+static void* check_voro_run(void *data)
+{
+	s_check_voro *cv = (s_check_voro *)data ;
+	cv->status = run_qvoronoi_mem(cv->xyz, cv->npts, check_voro_begin,
+								  check_voro_vert, cv) ;
+	return NULL ;
+}
+
+int check_qhull_threads(void)
+{
+	fprintf(stdout, "\n--> TESTING RE-ENTRANT QHULL <--\n") ;
+
+	int i, n = 0, nfail = 0, nthreads = 4 ;
+	s_check_voro ref, cv[4] ;
+	pthread_t threads[4] ;
+
+	char pdb_path[] = "sample/3LKF.pdb" ;
+	s_pdb *pdb =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	if(!pdb) {
+		fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+		return 1 ;
+	}
+	rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+	double *xyz = my_malloc(3*pdb->natoms*sizeof(double)) ;
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		if(strcmp(pdb->latoms[i].symbol, "H")) {
+			xyz[3*n] = pdb->latoms[i].x ;
+			xyz[3*n+1] = pdb->latoms[i].y ;
+			xyz[3*n+2] = pdb->latoms[i].z ;
+			n++ ;
+		}
+	}
+
+	/* Reference: a single tessellation */
+	memset(&ref, 0, sizeof(s_check_voro)) ;
+	ref.xyz = xyz ; ref.npts = n ;
+	check_voro_run(&ref) ;
+
+	fprintf(stdout, "    SINGLE TESSELLATION ............ ") ;
+	if(ref.status != 0 || ref.nvvert <= 0 || ref.ncalls != ref.nvvert) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	/* Same tessellation, run concurrently */
+	for(i = 0 ; i < nthreads ; i++) {
+		memset(&(cv[i]), 0, sizeof(s_check_voro)) ;
+		cv[i].xyz = xyz ; cv[i].npts = n ;
+		pthread_create(&(threads[i]), NULL, check_voro_run, &(cv[i])) ;
+	}
+	for(i = 0 ; i < nthreads ; i++) pthread_join(threads[i], NULL) ;
+
+	fprintf(stdout, "    CONCURRENT TESSELLATIONS ....... ") ;
+	for(i = 0 ; i < nthreads ; i++) {
+		if(cv[i].status != ref.status || cv[i].nvvert != ref.nvvert
+		   || cv[i].ncalls != ref.ncalls || cv[i].sum != ref.sum) break ;
+	}
+	if(i < nthreads) {
+		nfail++ ;
+		fprintf(stdout, "FAILED (thread %d)\n", i) ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	my_free(xyz) ;
+	free_pdb_atoms(pdb) ;
+
+	return nfail ;
+}
+
+static int check_cmp_vsign(const void *a, const void *b)
+{
+	const int *sa = (const int *) a,
+			  *sb = (const int *) b ;
+	int i ;
+
+	for(i = 0 ; i < 4 ; i++) if(sa[i] != sb[i]) return sa[i] - sb[i] ;
+
+	return 0 ;
+}
+
+/* Sorted atom indexes of each vertice, sorted */
+/* Sorted indexes of the 4 atoms of a vertex */
+static void check_get_vsign(s_vvertice *v, s_pdb *pdb, int *sign)
+{
+	int j, k, tmp ;
+
+	for(j = 0 ; j < 4 ; j++) sign[j] = v->neigh[j] - pdb->latoms ;
+	for(j = 1 ; j < 4 ; j++) {
+		for(k = j ; k > 0 && sign[k-1] > sign[k] ; k--) {
+			tmp = sign[k] ; sign[k] = sign[k-1] ; sign[k-1] = tmp ;
+		}
+	}
+}
+
+static int check_cmp_vlink(const void *a, const void *b)
+{
+	int r = check_cmp_vsign(a, b) ;
+
+	return (r != 0) ? r : check_cmp_vsign((const int *) a + 4, (const int *) b + 4) ;
+}
+
+static int* check_vvertices_sign(s_lst_vvertice *lvvert, s_pdb *pdb)
+{
+	int i ;
+	int *sign = my_malloc(4*(lvvert->nvert > 0 ? lvvert->nvert : 1)*sizeof(int)) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		check_get_vsign(lvvert->vertices + i, pdb, sign + 4*i) ;
+	}
+	qsort(sign, lvvert->nvert, 4*sizeof(int), check_cmp_vsign) ;
+
+	return sign ;
+}
+
+/* Links between vertices of the list, as pairs of vertex signatures (see
+ * check_vvertices_sign), sorted. Links to the vertex of signature skip are
+ * ignored. */
+static int* check_vvertices_links(s_lst_vvertice *lvvert, s_pdb *pdb,
+								  int *skip, int *nlinks)
+{
+	int i, j, k, vn, n = 0 ;
+	int *sign = check_vvertices_sign(lvvert, pdb), *cur = NULL ;
+	int *links = my_malloc(8*4*(lvvert->nvert > 0 ? lvvert->nvert : 1)*sizeof(int)) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		for(j = 0 ; j < 4 ; j++) {
+			vn = lvvert->vertices[i].vneigh[j] ;
+			if(vn <= 0 || vn >= lvvert->qhullSize) continue ;
+			k = get_vert_idx(lvvert, vn) ;
+			if(k == -1) continue ;
+
+			cur = links + 8*n ;
+			check_get_vsign(lvvert->vertices + i, pdb, cur) ;
+			check_get_vsign(lvvert->vertices + k, pdb, cur + 4) ;
+			if(skip && (check_cmp_vsign(cur, skip) == 0
+						|| check_cmp_vsign(cur + 4, skip) == 0)) continue ;
+			n++ ;
+		}
+	}
+	qsort(links, n, 8*sizeof(int), check_cmp_vlink) ;
+	my_free(sign) ;
+	*nlinks = n ;
+
+	return links ;
+}
+
+/* Remove the atoms of a residue from the atom list of a structure. Only
+ * latoms and natoms are updated, which is all the tessellation uses. */
+static void check_remove_residue(s_pdb *pdb, int resid)
+{
+	int i, n = 0 ;
+
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		if(pdb->latoms[i].res_id != resid) pdb->latoms[n++] = pdb->latoms[i] ;
+	}
+	pdb->natoms = n ;
+}
+
+/* Signatures of the apolar vertices of a list (see check_vvertices_sign),
+ * sorted; their number is given in n */
+static int* check_vvertices_apol(s_lst_vvertice *lvvert, s_pdb *pdb, int *n)
+{
+	int i ;
+	int *sign = my_malloc(4*(lvvert->nvert > 0 ? lvvert->nvert : 1)*sizeof(int)) ;
+
+	*n = 0 ;
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		if(lvvert->vertices[i].type != M_APOLAR_AS) continue ;
+		check_get_vsign(lvvert->vertices + i, pdb, sign + 4*(*n)) ;
+		(*n)++ ;
+	}
+	qsort(sign, *n, 4*sizeof(int), check_cmp_vsign) ;
+
+	return sign ;
+}
+
+/* Compare the vertices of pdb updated from the ones of old with those of a
+ * full tessellation of pdb: same alpha spheres, same types and same links */
+static int check_vupdate_case(const char *name, s_pdb *old, s_pdb *pdb,
+							  s_fparams *params)
+{
+	int nfail = 0 ;
+
+	s_lst_vvertice *ref = load_vvertices(old, params->min_apol_neigh,
+										 params->asph_min_size,
+										 params->asph_max_size) ;
+	s_lst_vvertice *full = load_vvertices(pdb, params->min_apol_neigh,
+										  params->asph_min_size,
+										  params->asph_max_size) ;
+	s_lst_vvertice *upd = ref ? update_vvertices(ref, old, pdb,
+												 params->min_apol_neigh,
+												 params->asph_min_size,
+												 params->asph_max_size) : NULL ;
+
+	fprintf(stdout, "    %s ............... ", name) ;
+	if(!ref || !full || !upd || full->nvert != upd->nvert) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else {
+		/* qhull gives 0 as index of its first vertex, which is also
+		 * taken as no neighbour: links to this vertex are ignored */
+		int nlfull, nlupd, nafull, naupd, skip[4] = {-1, -1, -1, -1},
+			k = get_vert_idx(full, 0) ;
+		if(k != -1) check_get_vsign(full->vertices + k, pdb, skip) ;
+
+		int *sfull = check_vvertices_sign(full, pdb),
+			*supd = check_vvertices_sign(upd, pdb),
+			*lfull = check_vvertices_links(full, pdb, skip, &nlfull),
+			*lupd = check_vvertices_links(upd, pdb, skip, &nlupd),
+			*afull = check_vvertices_apol(full, pdb, &nafull),
+			*aupd = check_vvertices_apol(upd, pdb, &naupd) ;
+		if(memcmp(sfull, supd, 4*full->nvert*sizeof(int)) != 0) {
+			nfail++ ;
+			fprintf(stdout, "FAILED (different vertices) \n") ;
+		}
+		else if(nafull != naupd || memcmp(afull, aupd, 4*nafull*sizeof(int)) != 0) {
+			nfail++ ;
+			fprintf(stdout, "FAILED (different apolar vertices) \n") ;
+		}
+		else if(nlfull != nlupd || memcmp(lfull, lupd, 8*nlfull*sizeof(int)) != 0) {
+			nfail++ ;
+			fprintf(stdout, "FAILED (different links) \n") ;
+		}
+		else fprintf(stdout, "OK \n") ;
+		my_free(sfull) ;
+		my_free(supd) ;
+		my_free(lfull) ;
+		my_free(lupd) ;
+		my_free(afull) ;
+		my_free(aupd) ;
+	}
+
+	if(ref) free_vert_lst(ref) ;
+	if(full) free_vert_lst(full) ;
+	if(upd) free_vert_lst(upd) ;
+
+	return nfail ;
+}
+
+int check_vvertices_update(void)
+{
+	fprintf(stdout, "\n--> TESTING LOCAL RE-TESSELLATION <--\n") ;
+
+	int i, resid, nfail = 0 ;
+	float mass, ray ;
+	s_fparams *params = init_def_fparams() ;
+
+	char pdb_path[] = "sample/3LKF.pdb" ;
+	s_pdb *pdb =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	s_pdb *mut =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	s_pdb *del =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	s_pdb *elem =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	if(!pdb || !mut || !del || !elem) {
+		fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+		return 1 ;
+	}
+	rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+	rpdb_read(mut, NULL, M_DONT_KEEP_LIG) ;
+	rpdb_read(del, NULL, M_DONT_KEEP_LIG) ;
+	rpdb_read(elem, NULL, M_DONT_KEEP_LIG) ;
+
+	/* Move a whole residue in the middle of the protein */
+	resid = mut->latoms[mut->natoms/2].res_id ;
+	for(i = 0 ; i < mut->natoms ; i++) {
+		if(mut->latoms[i].res_id == resid) {
+			mut->latoms[i].x += 0.8 ;
+			mut->latoms[i].y -= 0.5 ;
+			mut->latoms[i].z += 0.3 ;
+		}
+	}
+	/* Remove this residue; adding it is the update the other way round */
+	check_remove_residue(del, resid) ;
+	/* Only the element of an oxygen changes (as SER OG to CYS SG): same
+	 * coordinates, but vertices around it may change of type */
+	for(i = elem->natoms/2 ; i < elem->natoms ; i++) {
+		if(strcmp(elem->latoms[i].symbol, "O") == 0) {
+			strcpy(elem->latoms[i].symbol, "S") ;
+			pte_get_properties("S", &mass, &ray, &(elem->latoms[i].electroneg)) ;
+			break ;
+		}
+	}
+
+	nfail += check_vupdate_case("MOVED ATOMS  ", pdb, mut, params) ;
+	nfail += check_vupdate_case("REMOVED ATOMS", pdb, del, params) ;
+	nfail += check_vupdate_case("ADDED ATOMS  ", del, pdb, params) ;
+	nfail += check_vupdate_case("NEW ELEMENT  ", pdb, elem, params) ;
+
+	free_pdb_atoms(pdb) ;
+	free_pdb_atoms(mut) ;
+	free_pdb_atoms(del) ;
+	free_pdb_atoms(elem) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/* Number of links between vertices of the list */
+static int check_vvertices_nlinks(s_lst_vvertice *lvvert)
+{
+	int i, j, n = 0, vn ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		for(j = 0 ; j < 4 ; j++) {
+			vn = lvvert->vertices[i].vneigh[j] ;
+			if(vn > 0 && vn < lvvert->qhullSize && get_vert_idx(lvvert, vn) != -1) n++ ;
+		}
+	}
+
+	return n ;
+}
+
+int check_vvertices_part(void)
+{
+	fprintf(stdout, "\n--> TESTING PARTITIONED TESSELLATION <--\n") ;
+
+	int i, nfail = 0 ;
+	char pdbs[][32] = {"sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+
+	for(i = 0 ; i < 2 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		s_lst_vvertice *ref = load_vvertices(pdb, params->min_apol_neigh,
+											 params->asph_min_size,
+											 params->asph_max_size) ;
+		s_lst_vvertice *part = load_vvertices_part(pdb, params->min_apol_neigh,
+												   params->asph_min_size,
+												   params->asph_max_size, 4) ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(!ref || !part || ref->nvert != part->nvert
+		   || check_vvertices_nlinks(ref) != check_vvertices_nlinks(part)) {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		else {
+			int *sref = check_vvertices_sign(ref, pdb),
+				*spart = check_vvertices_sign(part, pdb) ;
+			if(memcmp(sref, spart, 4*ref->nvert*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (different vertices) \n") ;
+			}
+			else fprintf(stdout, "OK \n") ;
+			my_free(sref) ;
+			my_free(spart) ;
+		}
+
+		free_vert_lst(ref) ;
+		free_vert_lst(part) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/* Candidate vertices of a tessellation, filled by run_qvoronoi_mem */
+typedef struct s_check_vtest
+{
+	float *xyz ;
+	int *nb,
+		n ;
+
+} s_check_vtest ;
+
+static void check_vtest_begin(void *data, int nvvert)
+{
+	s_check_vtest *cv = (s_check_vtest *)data ;
+	cv->xyz = (float *)my_malloc(3*nvvert*sizeof(float)) ;
+	cv->nb = (int *)my_malloc(4*nvvert*sizeof(int)) ;
+	cv->n = 0 ;
+}
+
+static void check_vtest_vert(void *data, int id, double *center, int *pts,
+							 int *vneigh)
+{
+	s_check_vtest *cv = (s_check_vtest *)data ;
+	int i ;
+
+	for(i = 0 ; i < 4 ; i++) if(pts[i] < 0) return ;
+	for(i = 0 ; i < 3 ; i++) cv->xyz[3*cv->n+i] = (float) center[i] ;
+	for(i = 0 ; i < 4 ; i++) cv->nb[4*cv->n+i] = pts[i] ;
+	cv->n++ ;
+}
+
+int check_vtest(void)
+{
+	fprintf(stdout, "\n--> TESTING BATCH ALPHA SPHERE TEST <--\n") ;
+
+	int i, j, k, impl, nfail = 0, nbad ;
+	int impls[3] = {M_VTEST_SCALAR, M_VTEST_SSE, M_VTEST_AVX2} ;
+	float ray ;
+	double *xyz = NULL ;
+	s_check_vtest cv ;
+	s_lst_vvertice lvvert ;
+	s_vtest_batch *b = NULL ;
+	s_fparams *params = init_def_fparams() ;
+
+	char pdb_path[] = "sample/3LKF.pdb" ;
+	s_pdb *pdb =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	if(!pdb) {
+		fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+		return 1 ;
+	}
+	rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+	lvvert.h_tr = (int *)my_malloc(pdb->natoms*sizeof(int)) ;
+	xyz = (double *)my_malloc(3*pdb->natoms*sizeof(double)) ;
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		lvvert.h_tr[i] = i ;
+		xyz[3*i] = pdb->latoms[i].x ;
+		xyz[3*i+1] = pdb->latoms[i].y ;
+		xyz[3*i+2] = pdb->latoms[i].z ;
+	}
+	cv.xyz = NULL ;
+	cv.nb = NULL ;
+	run_qvoronoi_mem(xyz, pdb->natoms, check_vtest_begin, check_vtest_vert, &cv) ;
+
+	b = (s_vtest_batch *)my_malloc(sizeof(s_vtest_batch)) ;
+	for(impl = 0 ; impl < 3 ; impl++) {
+		if(vtest_set_impl(impls[impl]) != impls[impl]) continue ;
+
+		nbad = 0 ;
+		for(i = 0 ; i < cv.n ; i += M_VTEST_BATCH) {
+			b->n = (cv.n - i < M_VTEST_BATCH) ? cv.n - i : M_VTEST_BATCH ;
+			for(k = 0 ; k < b->n ; k++) {
+				b->cx[k] = cv.xyz[3*(i+k)] ;
+				b->cy[k] = cv.xyz[3*(i+k)+1] ;
+				b->cz[k] = cv.xyz[3*(i+k)+2] ;
+				for(j = 0 ; j < 4 ; j++) {
+					s_atm *ca = pdb->latoms + cv.nb[4*(i+k)+j] ;
+					b->ax[j][k] = ca->x ;
+					b->ay[j][k] = ca->y ;
+					b->az[j][k] = ca->z ;
+					b->en[j][k] = ca->electroneg ;
+				}
+			}
+			vtest_batch(b, params->asph_min_size, params->asph_max_size) ;
+
+			for(k = 0 ; k < b->n ; k++) {
+				int napol = 0 ;
+				ray = testVvertice(cv.xyz + 3*(i+k), cv.nb + 4*(i+k),
+								   pdb->latoms, params->asph_min_size,
+								   params->asph_max_size, &lvvert) ;
+				for(j = 0 ; j < 4 ; j++) if(b->en[j][k] < 2.8) napol++ ;
+				if(ray != b->ray[k] || (ray > 0 && napol != b->napol[k])) nbad++ ;
+			}
+		}
+
+		fprintf(stdout, "    %s (%d candidates) ............. ",
+				vtest_get_impl_name(), cv.n) ;
+		if(cv.n == 0 || nbad > 0) {
+			nfail++ ;
+			fprintf(stdout, "FAILED (%d differences) \n", nbad) ;
+		}
+		else fprintf(stdout, "OK \n") ;
+	}
+	vtest_set_impl(M_VTEST_AUTO) ;
+
+	my_free(b) ;
+	my_free(cv.xyz) ;
+	my_free(cv.nb) ;
+	my_free(xyz) ;
+	my_free(lvvert.h_tr) ;
+	free_pdb_atoms(pdb) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_delaunay(void)
+{
+	fprintf(stdout, "\n--> TESTING NATIVE DELAUNAY ENGINE <--\n") ;
+
+	int i, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		set_delaunay_engine(M_DELAUNAY_QHULL) ;
+		s_lst_vvertice *ref = load_vvertices(pdb, params->min_apol_neigh,
+											 params->asph_min_size,
+											 params->asph_max_size) ;
+		set_delaunay_engine(M_DELAUNAY_NATIVE) ;
+		s_lst_vvertice *nat = load_vvertices(pdb, params->min_apol_neigh,
+											 params->asph_min_size,
+											 params->asph_max_size) ;
+		set_delaunay_engine(M_DELAUNAY_QHULL) ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(!ref || !nat || ref->nvert != nat->nvert) {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		else {
+			/* qhull gives 0 as index of its first vertex, which is also
+			 * taken as no neighbour: links to this vertex are ignored */
+			int nlref, nlnat, skip[4] = {-1, -1, -1, -1},
+				k = get_vert_idx(ref, 0) ;
+			if(k != -1) check_get_vsign(ref->vertices + k, pdb, skip) ;
+
+			int *sref = check_vvertices_sign(ref, pdb),
+				*snat = check_vvertices_sign(nat, pdb),
+				*lref = check_vvertices_links(ref, pdb, skip, &nlref),
+				*lnat = check_vvertices_links(nat, pdb, skip, &nlnat) ;
+			if(memcmp(sref, snat, 4*ref->nvert*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (different vertices) \n") ;
+			}
+			else if(nlref != nlnat || memcmp(lref, lnat, 8*nlref*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (different links) \n") ;
+			}
+			else fprintf(stdout, "OK \n") ;
+			my_free(sref) ;
+			my_free(snat) ;
+			my_free(lref) ;
+			my_free(lnat) ;
+		}
+
+		if(ref) free_vert_lst(ref) ;
+		if(nat) free_vert_lst(nat) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_keep_mem(void)
+{
+	fprintf(stdout, "\n--> TESTING TESSELATION MEMORY KEPT BETWEEN STRUCTURES <--\n") ;
+
+	int i, j, k, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	s_lst_vvertice *ref[3], *kept[3] ;
+	s_pdb *pdb[3] ;
+
+	/* Structures are handled twice in a row, the second time with the memory
+	 * left by the previous one */
+	for(i = 0 ; i < 3 ; i++) {
+		pdb[i] = rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(pdb[i]) rpdb_read(pdb[i], NULL, M_DONT_KEEP_LIG) ;
+	}
+	for(k = 0 ; k < 2 ; k++) {
+		set_vvertices_keep_mem(k) ;
+		for(i = 0 ; i < 3 ; i++) {
+			s_lst_vvertice *lv = !pdb[i] ? NULL :
+								 load_vvertices(pdb[i], params->min_apol_neigh,
+												params->asph_min_size,
+												params->asph_max_size) ;
+			if(k == 0) ref[i] = lv ;
+			else kept[i] = lv ;
+		}
+	}
+	set_vvertices_keep_mem(0) ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		same = (ref[i] && kept[i] && ref[i]->nvert == kept[i]->nvert) ;
+		for(j = 0 ; same && j < ref[i]->nvert ; j++) {
+			s_vvertice *a = ref[i]->vertices + j,
+					   *b = kept[i]->vertices + j ;
+			same = (a->x == b->x && a->y == b->y && a->z == b->z
+					&& a->ray == b->ray && a->qhullId == b->qhullId
+					&& memcmp(a->vneigh, b->vneigh, 4*sizeof(int)) == 0
+					&& memcmp(a->neigh, b->neigh, 4*sizeof(s_atm*)) == 0) ;
+		}
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(ref[i]) free_vert_lst(ref[i]) ;
+		if(kept[i]) free_vert_lst(kept[i]) ;
+		if(pdb[i]) free_pdb_atoms(pdb[i]) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_vvertices_cache(void)
+{
+	fprintf(stdout, "\n--> TESTING ALPHA SPHERE CACHE <--\n") ;
+
+	int i, j, nfail = 0 ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	s_fparams *params = init_def_fparams() ;
+
+	char pdb_path[] = "sample/3LKF.pdb" ;
+	s_pdb *pdb =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	if(!pdb || mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+		return 1 ;
+	}
+	rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+	uint64_t key = get_vvertices_key(pdb, params->min_apol_neigh,
+									 params->asph_min_size,
+									 params->asph_max_size, 0) ;
+	s_lst_vvertice *ref = load_vvertices(pdb, params->min_apol_neigh,
+										 params->asph_min_size,
+										 params->asph_max_size) ;
+
+	fprintf(stdout, "    EMPTY CACHE .................... ") ;
+	if(read_vvertices_cache(dir, pdb, key) != NULL) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	fprintf(stdout, "    WRITING CACHE .................. ") ;
+	if(!ref || write_vvertices_cache(dir, pdb, key, ref) != 0) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	fprintf(stdout, "    READING CACHE .................. ") ;
+	s_lst_vvertice *cached = read_vvertices_cache(dir, pdb, key) ;
+	if(!ref || !cached || cached->nvert != ref->nvert
+	   || cached->qhullSize != ref->qhullSize) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else {
+		for(i = 0 ; i < ref->nvert ; i++) {
+			s_vvertice *a = ref->vertices + i,
+					   *b = cached->vertices + i ;
+			if(a->x != b->x || a->y != b->y || a->z != b->z || a->ray != b->ray
+			   || a->type != b->type || a->qhullId != b->qhullId) break ;
+			for(j = 0 ; j < 4 ; j++) {
+				if(a->neigh[j] != b->neigh[j] || a->vneigh[j] != b->vneigh[j]) break ;
+			}
+			if(j < 4) break ;
+		}
+		if(i < ref->nvert) {
+			nfail++ ;
+			fprintf(stdout, "FAILED (vertice %d) \n", i) ;
+		}
+		else fprintf(stdout, "OK \n") ;
+	}
+
+	fprintf(stdout, "    OTHER PARAMETERS MISS CACHE .... ") ;
+	uint64_t key2 = get_vvertices_key(pdb, params->min_apol_neigh,
+									  params->asph_min_size + 0.1,
+									  params->asph_max_size, 0) ;
+	if(key2 == key || read_vvertices_cache(dir, pdb, key2) != NULL) {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	/* A contacted atom, then a link, out of range in the last vertice */
+	char path[M_VCACHE_PATH_LEN] ;
+	snprintf(path, M_VCACHE_PATH_LEN, "%s/%016llx%s", dir,
+			 (unsigned long long) key, M_VCACHE_EXT) ;
+	size_t fields[2] = {offsetof(s_vcache_vert, neigh),
+						offsetof(s_vcache_vert, vneigh)} ;
+	for(i = 0 ; i < 2 ; i++) {
+		fprintf(stdout, "    CORRUPTED %s REJECTED ........ ", (i == 0) ? "ATOM" : "LINK") ;
+		int bad = (i == 0) ? pdb->natoms : ref->qhullSize ;
+		FILE *f = (ref && ref->nvert > 0) ? fopen(path, "r+b") : NULL ;
+		if(f) {
+			fseek(f, sizeof(s_vcache_header) + ref->n_h_tr*sizeof(int)
+					 + (ref->nvert-1)*sizeof(s_vcache_vert) + fields[i], SEEK_SET) ;
+			fwrite(&bad, sizeof(int), 1, f) ;
+			fclose(f) ;
+		}
+		s_lst_vvertice *corrupted = f ? read_vvertices_cache(dir, pdb, key) : NULL ;
+		if(!f || corrupted != NULL) {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+			if(corrupted) free_vert_lst(corrupted) ;
+		}
+		else fprintf(stdout, "OK \n") ;
+		if(i == 0 && write_vvertices_cache(dir, pdb, key, ref) != 0) nfail++ ;
+	}
+
+	remove(path) ;
+	rmdir(dir) ;
+
+	free_vert_lst(ref) ;
+	free_vert_lst(cached) ;
+	free_pdb_atoms(pdb) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_ml_pockets, check_ml_sign
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Pockets given to the single linkage clustering by fpocket (to the refine
+	step if refine is 0), and vertices
+	of the pockets after it (indexes of the vertices, -1 ending a pocket).
+	If canon is set, vertices of each pocket are sorted, and pockets are
+	sorted by their first vertex.
+   -----------------------------------------------------------------------------
+*/
+static c_lst_pockets* check_ml_pockets(s_lst_vvertice *lvert, s_fparams *params,
+										int refine)
+{
+	c_lst_pockets *pockets = clusterPockets(lvert, params) ;
+
+	if(pockets) {
+		reIndexPockets(pockets) ;
+		drop_tiny(pockets) ;
+		reIndexPockets(pockets) ;
+		if(refine) {
+			refinePockets(pockets, params) ;
+			reIndexPockets(pockets) ;
+		}
+	}
+
+	return pockets ;
+}
+
+static int check_cmp_int(const void *a, const void *b)
+{
+	return *((int *)a) - *((int *)b) ;
+}
+
+static int check_cmp_pock(const void *a, const void *b)
+{
+	return **((int **)a) - **((int **)b) ;
+}
+
+static int* check_ml_sign(c_lst_pockets *pockets, s_lst_vvertice *lvert,
+						  int canon, int *n)
+{
+	node_pocket *pcur = NULL ;
+	node_vertice *vcur = NULL ;
+	int i, j, k = 0, np = 0,
+		*sign = NULL,
+		**pstart = NULL ;
+
+	*n = 0 ;
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		*n += pcur->pocket->v_lst->n_vertices + 1 ;
+	}
+	sign = (int *) my_malloc((*n+1)*sizeof(int)) ;
+	pstart = (int **) my_malloc((pockets->n_pockets+1)*sizeof(int *)) ;
+
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		pstart[np++] = sign + k ;
+		for(vcur = pcur->pocket->v_lst->first ; vcur ; vcur = vcur->next) {
+			sign[k++] = (int)(vcur->vertice - lvert->vertices) ;
+		}
+		if(canon) qsort(pstart[np-1], sign+k-pstart[np-1], sizeof(int), check_cmp_int) ;
+		sign[k++] = -1 ;
+	}
+
+	if(canon) {
+		int *tmp = (int *) my_malloc((*n+1)*sizeof(int)) ;
+		qsort(pstart, np, sizeof(int *), check_cmp_pock) ;
+		for(i = 0, k = 0 ; i < np ; i++) {
+			for(j = 0 ; pstart[i][j] != -1 ; j++) tmp[k++] = pstart[i][j] ;
+			tmp[k++] = -1 ;
+		}
+		memcpy(sign, tmp, k*sizeof(int)) ;
+		my_free(tmp) ;
+	}
+	my_free(pstart) ;
+
+	return sign ;
+}
+
+int check_ml_clust(void)
+{
+	fprintf(stdout, "\n--> TESTING SINGLE LINKAGE CLUSTERING ON A GRID <--\n") ;
+
+	int i, k, n[4], nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh,
+											   params->asph_min_size,
+											   params->asph_max_size) ;
+		c_lst_pockets *pockets[4] ;
+		int *sign[4] ;
+
+		/* Reference, order mode, graph mode and graph mode on the list of
+		 * pockets reversed */
+		for(k = 0 ; k < 4 ; k++) {
+			pockets[k] = lvert ? check_ml_pockets(lvert, params, 1) : NULL ;
+			if(!pockets[k]) continue ;
+			if(k == 3) {
+				node_pocket *pcur = pockets[k]->first, *tmp = NULL ;
+				for( ; pcur ; pcur = pcur->prev) {
+					tmp = pcur->next ;
+					pcur->next = pcur->prev ;
+					pcur->prev = tmp ;
+				}
+				tmp = pockets[k]->first ;
+				pockets[k]->first = pockets[k]->last ;
+				pockets[k]->last = tmp ;
+			}
+			params->ml_clust = (k < 2) ? M_MLCLUST_ORDER : M_MLCLUST_GRAPH ;
+			if(k == 0) pck_ml_clust_naive(pockets[k], params) ;
+			else pck_ml_clust(pockets[k], params) ;
+			sign[k] = check_ml_sign(pockets[k], lvert, k >= 2, n + k) ;
+		}
+		params->ml_clust = M_MLCLUST_ORDER ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(!pockets[0] || !pockets[1] || !pockets[2] || !pockets[3]) {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		else {
+			if(n[0] != n[1] || memcmp(sign[0], sign[1], n[0]*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (order mode) \n") ;
+			}
+			else if(n[2] != n[3] || memcmp(sign[2], sign[3], n[2]*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (graph mode) \n") ;
+			}
+			else fprintf(stdout, "OK \n") ;
+		}
+
+		for(k = 0 ; k < 4 ; k++) {
+			if(!pockets[k]) continue ;
+			my_free(sign[k]) ;
+			pockets[k]->vertices = NULL ;
+			c_lst_pocket_free(pockets[k]) ;
+		}
+		if(lvert) free_vert_lst(lvert) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_refine(void)
+{
+	fprintf(stdout, "\n--> TESTING BARYCENTER MERGE ON A GRID <--\n") ;
+
+	int i, k, n[2], nclose, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *p1 = NULL, *p2 = NULL ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh,
+											   params->asph_min_size,
+											   params->asph_max_size) ;
+		c_lst_pockets *pockets[3] ;
+		int *sign[2] ;
+
+		/* Reference, order mode and fixpoint mode */
+		for(k = 0 ; k < 3 ; k++) {
+			pockets[k] = lvert ? check_ml_pockets(lvert, params, 0) : NULL ;
+			if(!pockets[k]) continue ;
+			params->refine_mode = (k < 2) ? M_REFINE_ORDER : M_REFINE_FIXPOINT ;
+			if(k == 0) refinePockets_naive(pockets[k], params) ;
+			else refinePockets(pockets[k], params) ;
+			if(k < 2) sign[k] = check_ml_sign(pockets[k], lvert, 0, n + k) ;
+		}
+		params->refine_mode = M_REFINE_ORDER ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(!pockets[0] || !pockets[1] || !pockets[2]) {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		else {
+			/* No barycenters are close at the fixpoint */
+			nclose = 0 ;
+			for(p1 = pockets[2]->first ; p1 ; p1 = p1->next) {
+				float *b1 = p1->pocket->bary, *b2 = NULL ;
+				for(p2 = p1->next ; p2 ; p2 = p2->next) {
+					b2 = p2->pocket->bary ;
+					if(dist(b1[0], b1[1], b1[2], b2[0], b2[1], b2[2])
+					   < params->refine_clust_dist) nclose++ ;
+				}
+			}
+			if(n[0] != n[1] || memcmp(sign[0], sign[1], n[0]*sizeof(int)) != 0) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (order mode) \n") ;
+			}
+			else if(nclose > 0 || pockets[2]->n_pockets > pockets[0]->n_pockets) {
+				nfail++ ;
+				fprintf(stdout, "FAILED (fixpoint mode) \n") ;
+			}
+			else fprintf(stdout, "OK \n") ;
+		}
+
+		for(k = 0 ; k < 3 ; k++) {
+			if(!pockets[k]) continue ;
+			if(k < 2) my_free(sign[k]) ;
+			pockets[k]->vertices = NULL ;
+			c_lst_pocket_free(pockets[k]) ;
+		}
+		if(lvert) free_vert_lst(lvert) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_pockets_table(void)
+{
+	fprintf(stdout, "\n--> TESTING TABLE OF THE POCKETS <--\n") ;
+
+	int i, k, n, tofree, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *pcur = NULL ;
+	node_vertice *vcur = NULL ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		/* Through the refinement steps, the chained rows of each pocket
+		 * give the vertices of its list */
+		s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh,
+											   params->asph_min_size,
+											   params->asph_max_size) ;
+		c_lst_pockets *pockets = check_ml_pockets(lvert, params, 1) ;
+		same = (pockets && pockets->ptab) ;
+		if(same) {
+			pck_ml_clust(pockets, params) ;
+			same = (pockets->ptab != NULL) ;
+		}
+		for(pcur = same ? pockets->first : NULL ; pcur && same ; pcur = pcur->next) {
+			s_pocket *p = pcur->pocket ;
+			s_vvertice **verts = get_pocket_vert_array(p, &n, &tofree) ;
+
+			same = (p->ptab == pockets->ptab && n == (int) p->v_lst->n_vertices) ;
+			for(k = 0, vcur = p->v_lst->first ; same && vcur ; vcur = vcur->next) {
+				same = (verts[k++] == vcur->vertice) ;
+			}
+			if(tofree) my_free(verts) ;
+		}
+		if(pockets) {
+			pockets->vertices = lvert ;
+			c_lst_pocket_free(pockets) ;
+		}
+		else free_vert_lst(lvert) ;
+
+		fprintf(stdout, "    REFINED %s ..... ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		pockets = search_pocket(pdb, params) ;
+		s_ptable *t = pockets ? pockets->ptab : NULL ;
+
+		/* Rows match the vertex lists and the pockets, and atoms contacted
+		 * are the same without the table */
+		same = (t != NULL) ;
+		for(pcur = same ? pockets->first : NULL ; pcur && same ; pcur = pcur->next) {
+			s_pocket *p = pcur->pocket ;
+			s_vvertice **verts = get_pocket_vert_array(p, &n, &tofree) ;
+
+			same = (p->ptab == t && !tofree && n == (int) p->v_lst->n_vertices
+					&& t->bx[p->prow] == p->bary[0] && t->by[p->prow] == p->bary[1]
+					&& t->bz[p->prow] == p->bary[2] && t->score[p->prow] == p->score) ;
+			for(k = 0, vcur = p->v_lst->first ; same && vcur ; vcur = vcur->next) {
+				same = (verts[k++] == vcur->vertice) ;
+			}
+		}
+		if(same) {
+			int *natm = (int *) my_malloc(pockets->n_pockets*sizeof(int)) ;
+			for(k = 0, pcur = pockets->first ; pcur ; pcur = pcur->next) {
+				natm[k++] = count_pocket_contacted_atms(pcur->pocket) ;
+			}
+			free_pockets_table(pockets) ;
+			for(k = 0, pcur = pockets->first ; pcur && same ; pcur = pcur->next) {
+				same = (pcur->pocket->ptab == NULL
+						&& natm[k++] == count_pocket_contacted_atms(pcur->pocket)) ;
+			}
+			my_free(natm) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+int check_desc_threads(void)
+{
+	fprintf(stdout, "\n--> TESTING DESCRIPTORS COMPUTED BY SEVERAL THREADS <--\n") ;
+
+	int i, k, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *p1 = NULL, *p2 = NULL ;
+
+	params->rand_seed = 7 ;
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		/* Same seed, 1 and 4 threads: descriptors must be bit-identical */
+		c_lst_pockets *pockets[2] ;
+		for(k = 0 ; k < 2 ; k++) {
+			params->desc_threads = (k == 0) ? 1 : 4 ;
+			pockets[k] = search_pocket(pdb, params) ;
+		}
+
+		same = (pockets[0] && pockets[1]
+				&& pockets[0]->n_pockets == pockets[1]->n_pockets) ;
+		for(p1 = same ? pockets[0]->first : NULL, p2 = same ? pockets[1]->first : NULL ;
+			p1 && p2 && same ; p1 = p1->next, p2 = p2->next) {
+			same = (p1->pocket->score == p2->pocket->score
+					&& memcmp(p1->pocket->pdesc, p2->pocket->pdesc, sizeof(s_desc)) == 0) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		for(k = 0 ; k < 2 ; k++) {
+			if(pockets[k]) c_lst_pocket_free(pockets[k]) ;
+		}
+		free_pdb_atoms(pdb) ;
+	}
+	set_rand_seed(-1) ;
+	set_pockets_desc_threads(1) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_vert_desc_eq
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Compare vertice based descriptors computed by set_vert_descriptors and
+	set_vert_descriptors_naive: all must be the same but as_density, which
+	is compared to the mean distance computed in double precision (the
+	naive sum in single precision drifts on large pockets).
+   -----------------------------------------------------------------------------
+*/
+static int check_vert_desc_eq(s_vvertice **tvert, int nvert)
+{
+	int i, j ;
+	double dx, dy, dz, dref = 0.0 ;
+	s_desc d1, d2 ;
+
+	reset_desc(&d1) ;
+	reset_desc(&d2) ;
+	set_vert_descriptors(tvert, nvert, &d1) ;
+	set_vert_descriptors_naive(tvert, nvert, &d2) ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		for(j = i + 1 ; j < nvert ; j++) {
+			dx = (double) tvert[i]->x - tvert[j]->x ;
+			dy = (double) tvert[i]->y - tvert[j]->y ;
+			dz = (double) tvert[i]->z - tvert[j]->z ;
+			dref += sqrt(dx*dx + dy*dy + dz*dz) ;
+		}
+	}
+	dref /= ((double)nvert*nvert - nvert) * 0.5 ;
+
+	return (d1.mean_loc_hyd_dens == d2.mean_loc_hyd_dens
+			&& d1.as_max_dst == d2.as_max_dst
+			&& d1.apolar_asphere_prop == d2.apolar_asphere_prop
+			&& d1.masph_sacc == d2.masph_sacc
+			&& d1.mean_asph_ray == d2.mean_asph_ray
+			&& d1.nb_asph == d2.nb_asph
+			&& d1.as_max_r == d2.as_max_r
+			&& fabs(d1.as_density - dref) <= 1e-5*dref) ;
+}
+
+int check_vert_desc(void)
+{
+	fprintf(stdout, "\n--> TESTING VERTICE BASED DESCRIPTORS <--\n") ;
+
+	int i, n, tofree, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *pcur = NULL ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		/* Each pocket, and all vertices as a single large pocket */
+		c_lst_pockets *pockets = search_pocket(pdb, params) ;
+		same = (pockets != NULL) ;
+		for(pcur = same ? pockets->first : NULL ; pcur && same ; pcur = pcur->next) {
+			s_vvertice **verts = get_pocket_vert_array(pcur->pocket, &n, &tofree) ;
+			same = check_vert_desc_eq(verts, n) ;
+			if(tofree) my_free(verts) ;
+		}
+		if(same) {
+			s_lst_vvertice *lvert = pockets->vertices ;
+			same = check_vert_desc_eq(lvert->pvertices, lvert->nvert) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_vgrid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the voxel grid volume engine: volume of a sphere and of the lens
+	shared by two spheres against their analytic value, union and overlap
+	of the two spheres against each other, and volume of the pockets of
+	the sample structures against a much finer grid.
+   -----------------------------------------------------------------------------
+*/
+int check_vgrid(void)
+{
+	fprintf(stdout, "\n--> TESTING VOXEL GRID VOLUMES <--\n") ;
+
+	int i, n, tofree, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	float spheres[8] = { 0.0, 0.0, 0.0, 3.0,  4.0, 0.0, 0.0, 2.0 },
+		  bmin[3], bmax[3], vol[2], vunion, voverlap, v, vref ;
+	double d = 4.0, r1 = 3.0, r2 = 2.0,
+		   vsph = 4.0/3.0*M_PI*r1*r1*r1,
+		   vlens = M_PI*(r1+r2-d)*(r1+r2-d)
+				   *(d*d + 2*d*r2 - 3*r2*r2 + 2*d*r1 + 6*r1*r2 - 3*r1*r1)/(12*d) ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *pcur = NULL ;
+	int engine = get_volume_engine() ;
+
+	set_volume_engine(M_VOLUME_GRID) ;
+
+	set_spheres_bbox(spheres, 1, bmin, bmax, 0) ;
+	set_spheres_bbox(spheres + 4, 1, bmin, bmax, 1) ;
+	s_vgrid *g = alloc_vgrid(bmin, bmax, 3000, 0, 2) ;
+	add_vgrid_spheres(g, 0, spheres, 1) ;
+	add_vgrid_spheres(g, 1, spheres + 4, 1) ;
+	get_vgrid_volumes(g, vol, &vunion, &voverlap) ;
+	free_vgrid(g) ;
+
+	fprintf(stdout, "    two spheres ............. ") ;
+	if(fabs(vol[0] - vsph) <= 0.01*vsph && fabs(voverlap - vlens) <= 0.05*vlens
+	   && fabs(vol[0] + vol[1] - voverlap - vunion) <= 1e-4*vunion) {
+		fprintf(stdout, "OK \n") ;
+	}
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		/* Default resolution against the finest grid allowed */
+		c_lst_pockets *pockets = search_pocket(pdb, params) ;
+		same = (pockets != NULL) ;
+		for(pcur = same ? pockets->first : NULL ; pcur && same ; pcur = pcur->next) {
+			s_vvertice **verts = get_pocket_vert_array(pcur->pocket, &n, &tofree) ;
+			v = get_verts_volume_ptr(verts, n, 3000) ;
+			vref = get_verts_volume_ptr(verts, n, M_VGRID_MAX_VOXELS) ;
+			same = (fabs(v - vref) <= 0.02*vref) ;
+			if(tofree) my_free(verts) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+	set_volume_engine(engine) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_exact_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the exact volume engine: a sphere, two overlapping spheres, a
+	sphere inside another one and the same sphere twice against their
+	analytic volume, and volume of the pockets of the sample structures
+	against the finest grid.
+   -----------------------------------------------------------------------------
+*/
+int check_exact_volume(void)
+{
+	fprintf(stdout, "\n--> TESTING EXACT VOLUMES <--\n") ;
+
+	int i, n, tofree, same, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	float lens[8] = { 0.0, 0.0, 0.0, 3.0,  4.0, 0.0, 0.0, 2.0 },
+		  inner[8] = { 0.0, 0.0, 0.0, 3.0,  1.0, 0.5, 0.0, 1.5 },
+		  twice[8] = { 1.0, 2.0, 3.0, 3.0,  1.0, 2.0, 3.0, 3.0 },
+		  v, vref ;
+	double d = 4.0, r1 = 3.0, r2 = 2.0,
+		   vsph = 4.0/3.0*M_PI*r1*r1*r1,
+		   vlens = M_PI*(r1+r2-d)*(r1+r2-d)
+				   *(d*d + 2*d*r2 - 3*r2*r2 + 2*d*r1 + 6*r1*r2 - 3*r1*r1)/(12*d),
+		   vunion = vsph + 4.0/3.0*M_PI*r2*r2*r2 - vlens ;
+	s_fparams *params = init_def_fparams() ;
+	node_pocket *pcur = NULL ;
+	int engine = get_volume_engine() ;
+
+	fprintf(stdout, "    spheres ............. ") ;
+	if(fabs(get_spheres_volume_exact(lens, 1) - vsph) <= 1e-5*vsph
+	   && fabs(get_spheres_volume_exact(lens, 2) - vunion) <= 1e-5*vunion
+	   && fabs(get_spheres_volume_exact(inner, 2) - vsph) <= 1e-5*vsph
+	   && fabs(get_spheres_volume_exact(twice, 2) - vsph) <= 1e-5*vsph) {
+		fprintf(stdout, "OK \n") ;
+	}
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		c_lst_pockets *pockets = search_pocket(pdb, params) ;
+		same = (pockets != NULL) ;
+		for(pcur = same ? pockets->first : NULL ; pcur && same ; pcur = pcur->next) {
+			s_vvertice **verts = get_pocket_vert_array(pcur->pocket, &n, &tofree) ;
+			set_volume_engine(M_VOLUME_EXACT) ;
+			v = get_verts_volume_ptr(verts, n, 0) ;
+			set_volume_engine(M_VOLUME_GRID) ;
+			vref = get_verts_volume_ptr(verts, n, M_VGRID_MAX_VOXELS) ;
+			same = (fabs(v - vref) <= 1e-3*vref) ;
+			if(tofree) my_free(verts) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+	set_volume_engine(engine) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_big_pocket
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Atoms contacted by a merged pocket of M_CHECK_BIG_NVERT alpha spheres
+	(synthetic, contacting M_CHECK_BIG_NATM atoms at random): number of uniq
+	atoms found by get_pocket_contacted_atms, count_pocket_contacted_atms
+	and get_vert_contacted_atms against a brute force count, and atom based
+	descriptors. They run on a thread with a small stack (nothing sized by
+	the pocket may be on the stack). The time they take is given by vbench.
+   -----------------------------------------------------------------------------
+*/
+typedef struct s_check_big
+{
+	s_pocket *pocket ;
+	int n[3] ;
+
+} s_check_big ;
+
+static void* check_big_run(void *data)
+{
+	s_check_big *cb = (s_check_big *)data ;
+	s_desc desc ;
+	s_atm **atoms = NULL ;
+
+	atoms = get_pocket_contacted_atms(cb->pocket, cb->n) ;
+	reset_desc(&desc) ;
+	set_atom_based_descriptors(atoms, cb->n[0], &desc) ;
+	my_free(atoms) ;
+	cb->n[1] = count_pocket_contacted_atms(cb->pocket) ;
+	atoms = get_vert_contacted_atms(cb->pocket->v_lst, cb->n + 2) ;
+	my_free(atoms) ;
+
+	return NULL ;
+}
+
+int check_big_pocket(void)
+{
+	fprintf(stdout, "\n--> TESTING CONTACTED ATOMS OF A LARGE POCKET <--\n") ;
+
+	int i, k, nuniq = 0, nfail = 0 ;
+	unsigned int r = 7 ;
+	s_check_big cb ;
+	pthread_t thread ;
+	pthread_attr_t attr ;
+
+	s_atm *atoms = (s_atm *) my_calloc(M_CHECK_BIG_NATM, sizeof(s_atm)) ;
+	s_vvertice *verts = (s_vvertice *) my_calloc(M_CHECK_BIG_NVERT, sizeof(s_vvertice)) ;
+	char *seen = (char *) my_calloc(M_CHECK_BIG_NATM, sizeof(char)) ;
+
+	for(i = 0 ; i < M_CHECK_BIG_NATM ; i++) {
+		atoms[i].id = 3*i + 1 ;
+		atoms[i].res_id = i / 8 ;
+		strcpy(atoms[i].res_name, "ALA") ;
+	}
+
+	cb.pocket = alloc_pocket() ;
+	cb.pocket->v_lst = c_lst_vertices_alloc() ;
+	for(i = 0 ; i < M_CHECK_BIG_NVERT ; i++) {
+		for(k = 0 ; k < 4 ; k++) {
+			r = r*1103515245u + 12345u ;
+			verts[i].neigh[k] = atoms + (r >> 8) % M_CHECK_BIG_NATM ;
+			if(!seen[verts[i].neigh[k] - atoms]) {
+				seen[verts[i].neigh[k] - atoms] = 1 ;
+				nuniq++ ;
+			}
+		}
+		c_lst_vertices_add_last(cb.pocket->v_lst, verts + i) ;
+	}
+
+	pthread_attr_init(&attr) ;
+	pthread_attr_setstacksize(&attr, M_CHECK_BIG_STACK) ;
+	cb.n[0] = cb.n[1] = cb.n[2] = -1 ;
+	if(pthread_create(&thread, &attr, check_big_run, &cb) == 0) {
+		pthread_join(thread, NULL) ;
+	}
+	pthread_attr_destroy(&attr) ;
+
+	fprintf(stdout, "    %d ALPHA SPHERES ............. ", M_CHECK_BIG_NVERT) ;
+	if(cb.n[0] != nuniq || cb.n[1] != nuniq || cb.n[2] != nuniq) {
+		nfail++ ;
+		fprintf(stdout, "FAILED (%d %d %d atoms, %d expected)\n", cb.n[0],
+				cb.n[1], cb.n[2], nuniq) ;
+	}
+	else fprintf(stdout, "OK \n") ;
+
+	c_lst_vertices_free(cb.pocket->v_lst) ;
+	my_free(cb.pocket->pdesc) ;
+	my_free(cb.pocket) ;
+	my_free(verts) ;
+	my_free(atoms) ;
+	my_free(seen) ;
+
+	return nfail ;
+}
+
+static int check_cmp_ptr(const void *a, const void *b)
+{
+	const char *pa = *(char * const *) a,
+			   *pb = *(char * const *) b ;
+
+	return (pa > pb) - (pa < pb) ;
+}
+
+static int check_cmp_float(const void *a, const void *b)
+{
+	float fa = *(const float *) a,
+		  fb = *(const float *) b ;
+
+	return (fa > fb) - (fa < fb) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_nindex_pocket
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Compare the index to the _naive functions and to a scan of all elements
+	for one pocket (see check_nindex).
+   -----------------------------------------------------------------------------
+*/
+static int check_nindex_pocket(s_pdb *pdb, s_lst_vvertice *lvert, s_nindex *sind,
+							   s_pocket *pocket)
+{
+	int i, j, n[2], nlig, nscan,
+		k = 5, same = 1 ;
+	int kres[5], *res = NULL ;
+	float kdist[5], d, v[2][2] ;
+	float *scan = (float *) my_malloc((sind->n+1)*sizeof(float)) ;
+	void *l[2] ;
+	s_atm **lig = get_pocket_contacted_atms(pocket, &nlig) ;
+	s_vvertice **pvert = get_pocket_pvertices(pocket) ;
+	s_nindex *lind = alloc_nindex(lig, nlig, NULL, 0, 3.0) ;
+
+	/* Same neighbours as the naive functions (order may change) */
+	for(j = 0 ; j < 3 && same ; j++) {
+		if(j == 0) {
+			l[0] = get_mol_atm_neigh_naive(lig, nlig, pdb->latoms_p, pdb->natoms, 4.0, n) ;
+			l[1] = get_mol_atm_neigh(lig, nlig, sind, 4.0, n+1) ;
+		}
+		else if(j == 1) {
+			l[0] = get_mol_ctd_atm_neigh_naive(lig, nlig, lvert->pvertices, lvert->nvert,
+											   4.0, M_INTERFACE_SEARCH, n) ;
+			l[1] = get_mol_ctd_atm_neigh(lig, nlig, sind, 4.0, M_INTERFACE_SEARCH, n+1) ;
+		}
+		else {
+			l[0] = get_mol_vert_neigh_naive(lig, nlig, lvert->pvertices, lvert->nvert,
+											4.0, n) ;
+			l[1] = get_mol_vert_neigh(lig, nlig, sind, 4.0, n+1) ;
+		}
+		if(n[0] != n[1]) same = 0 ;
+		else {
+			qsort(l[0], n[0], sizeof(void*), check_cmp_ptr) ;
+			qsort(l[1], n[1], sizeof(void*), check_cmp_ptr) ;
+			same = !memcmp(l[0], l[1], n[0]*sizeof(void*)) ;
+		}
+		my_free(l[0]) ;
+		my_free(l[1]) ;
+	}
+
+	v[0][0] = count_atm_prop_vert_neigh_naive(lig, nlig, pvert, pocket->size, 3.0) ;
+	v[0][1] = count_pocket_lig_vert_ovlp_naive(lig, nlig, pvert, pocket->size, 3.0) ;
+	v[1][0] = count_atm_prop_vert_neigh(lind, pvert, pocket->size, 3.0) ;
+	v[1][1] = count_pocket_lig_vert_ovlp(lind, pvert, pocket->size, 3.0) ;
+	if(v[0][0] != v[1][0] || v[0][1] != v[1][1]) same = 0 ;
+
+	/* Radius query further than the cells, and k nearest atoms */
+	for(i = 0, nscan = 0, j = 0 ; i < sind->n ; i++) {
+		d = dist(sind->xyz[3*i], sind->xyz[3*i+1], sind->xyz[3*i+2],
+				 pocket->bary[0], pocket->bary[1], pocket->bary[2]) ;
+		if(d < 9.5) nscan++ ;
+		if(sind->elem[i].type == M_ATOM_TYPE) scan[j++] = d ;
+	}
+	qsort(scan, j, sizeof(float), check_cmp_float) ;
+
+	i = 0 ;
+	if(get_nindex_neigh(sind, pocket->bary[0], pocket->bary[1], pocket->bary[2],
+						9.5, M_NINDEX_ALL, &res, &i) != nscan) same = 0 ;
+	if(get_nindex_knearest(sind, pocket->bary[0], pocket->bary[1], pocket->bary[2],
+						   k, M_ATOM_TYPE, kres, kdist) != k) same = 0 ;
+	for(i = 0 ; i < k && same ; i++) {
+		if(kdist[i] != scan[i] || sind->elem[kres[i]].type != M_ATOM_TYPE) same = 0 ;
+	}
+
+	if(res) my_free(res) ;
+	free_nindex(lind) ;
+	my_free(pvert) ;
+	my_free(lig) ;
+	my_free(scan) ;
+
+	return same ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_nindex
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the spatial index of atoms and vertices: taking as ligand the atoms
+	contacted by each pocket of the sample structures, neighbours and
+	vertice overlaps against the _naive functions, and radius and k nearest
+	queries around the pocket barycenters against a scan of all elements.
+   -----------------------------------------------------------------------------
+*/
+int check_nindex(void)
+{
+	fprintf(stdout, "\n--> TESTING SPATIAL INDEX OF ATOMS AND VERTICES <--\n") ;
+
+	int i, nfail = 0 ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		c_lst_pockets *pockets = search_pocket(pdb, params) ;
+		int same = (pockets != NULL), j ;
+		if(same) {
+			/* get_mol_vert_neigh_naive keeps one vertex per id: unique ids */
+			for(j = 0 ; j < pockets->vertices->nvert ; j++)
+				pockets->vertices->pvertices[j]->id = pdb->natoms + j + 1 ;
+
+			s_nindex *sind = alloc_nindex(pdb->latoms_p, pdb->natoms,
+										  pockets->vertices->pvertices,
+										  pockets->vertices->nvert, 4.0) ;
+			node_pocket *pcur = NULL ;
+			for(pcur = pockets->first ; pcur && same ; pcur = pcur->next) {
+				same = check_nindex_pocket(pdb, pockets->vertices, sind, pcur->pocket) ;
+			}
+			free_nindex(sind) ;
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(same) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/**
+	PDB records of the synthetic file read by check_rpdb: altloc, exponent,
+	missing and guessed elements, charges, kept and removed HETATM, ligand
+	as ATOM and HETATM, CRLF end of line, insertion code, atoms after END.
+*/
+static const char *ST_check_rpdb_lines[] = {
+	"CRYST1   52.000   58.600   63.400  90.00  90.00  90.00 P 21 21 21    4\n",
+	"ATOM      1  N   ALA A   1      11.104   6.134  -6.504  1.00  0.00           N  \n",
+	"ATOM      2  CA BALA A   1      11.639   6.071  -5.147  0.50  0.00           C  \n",
+	"ATOM      3  CA AALA A   1      11.639   6.071  -5.147  0.50  0.00           C  \n",
+	"ATOM      4  OXT ALA A   1      -0.000   1.0e1  -5.147  1.00 10.00           O1-\n",
+	"ATOM      5 1HG  GLU A   2     -14.861  -4.847   0.361  1.00  0.00              \n",
+	"ATOM      6  SD  MET A   3      1.2345   6.134  -6.504  1.00  0.00\n",
+	"HETATM    7 FE   HEM A 101      17.140   3.115  15.066  1.00 14.14          FE2+\n",
+	"HETATM    8  O   HOH A 201      10.885 -15.746 -14.404  1.00 47.47           O  \n",
+	"HETATM    9 ZN    ZN A 301      10.885 -15.746 -14.404  1.00 47.47          ZN  \n",
+	"HETATM   10  C1  LIG A 401       1.000   2.000   3.000  1.00 20.00           C  \n",
+	"HETATM   11  C2  LIG A 401       1.500   2.500   3.500  1.00 20.00           C  \r\n",
+	"ATOM     12  CA  LIG B 402       2.000   2.000   3.000  1.00 20.00           C  \n",
+	"ATOM     13  CA  GLY A1000A    999.999-999.999  -0.001  1.00  0.00           C  \n",
+	"ENDMDL\n",
+	"ATOM     14  CA  GLY A1001       1.000   1.000   1.000  1.00  0.00           C  \n"
+} ;
+
+static int check_rpdb_eq(s_pdb *a, s_pdb *b)
+{
+	int i ;
+	s_atm *u = NULL, *v = NULL ;
+
+	if(a->natoms != b->natoms || a->nhetatm != b->nhetatm
+	   || a->natm_lig != b->natm_lig || a->A != b->A || a->B != b->B
+	   || a->C != b->C || a->alpha != b->alpha || a->beta != b->beta
+	   || a->gamma != b->gamma) return 0 ;
+
+	for(i = 0 ; i < a->natoms ; i++) {
+		u = a->latoms + i ; v = b->latoms + i ;
+		if(a->latoms_p[i] != u || b->latoms_p[i] != v
+		   || strcmp(u->type, v->type) || strcmp(u->name, v->name)
+		   || strcmp(u->chain, v->chain) || strcmp(u->symbol, v->symbol)
+		   || strcmp(u->res_name, v->res_name) || u->id != v->id
+		   || u->res_id != v->res_id || u->charge != v->charge
+		   || u->pdb_insert != v->pdb_insert || u->pdb_aloc != v->pdb_aloc
+		   || u->x != v->x || u->y != v->y || u->z != v->z
+		   || u->occupancy != v->occupancy || u->bfactor != v->bfactor
+		   || u->mass != v->mass || u->radius != v->radius
+		   || u->electroneg != v->electroneg || u->sort_x != v->sort_x)
+			return 0 ;
+	}
+	for(i = 0 ; i < a->nhetatm ; i++) {
+		if(a->lhetatm[i] - a->latoms != b->lhetatm[i] - b->latoms) return 0 ;
+	}
+	for(i = 0 ; i < a->natm_lig ; i++) {
+		if(a->latm_lig[i] - a->latoms != b->latm_lig[i] - b->latoms) return 0 ;
+	}
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_rpdb
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the single pass reader (rpdb_open) against the two pass one
+	(rpdb_open_naive) on the sample structures and on a synthetic file, with
+	and without their ligand, and the perfect hash of the HETATM kept.
+   -----------------------------------------------------------------------------
+*/
+int check_rpdb(void)
+{
+	fprintf(stdout, "\n--> TESTING SINGLE PASS PDB READER <--\n") ;
+
+	int i, k, nfail = 0 ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char pdbs[][64] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb", ""} ;
+	const char *ligs[] = {"ATP", "PC1", "ABC", "LIG"} ;
+	FILE *f = NULL ;
+
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		return 1 ;
+	}
+	sprintf(pdbs[3], "%s/test.pdb", dir) ;
+	f = fopen(pdbs[3], "w") ;
+	for(i = 0 ; f && i < (int) (sizeof(ST_check_rpdb_lines)/sizeof(char *)) ; i++)
+		fputs(ST_check_rpdb_lines[i], f) ;
+	if(f) fclose(f) ;
+
+	for(i = 0 ; i < 4 ; i++) {
+		for(k = M_DONT_KEEP_LIG ; k <= M_KEEP_LIG ; k++) {
+			s_pdb *pdb = rpdb_open(pdbs[i], ligs[i], k) ;
+			s_pdb *ref = rpdb_open_naive(pdbs[i], ligs[i], k) ;
+			int same = (pdb != NULL && ref != NULL) ;
+			if(same) {
+				rpdb_read(pdb, ligs[i], k) ;
+				rpdb_read_naive(ref, ligs[i], k) ;
+				same = check_rpdb_eq(pdb, ref) ;
+			}
+			/* 10 atoms read in the synthetic file, 3 of the ligand: ZN is not
+			   kept, ST_keep_hetatm has "ZN" and not " ZN" */
+			if(same && i == 3) same = (pdb->natoms == 10 - 3*(1-k)
+									   && pdb->nhetatm == 1) ;
+
+			fprintf(stdout, "    %s %s ......... ", pdbs[i],
+					k == M_KEEP_LIG ? ligs[i] : "   ") ;
+			if(same) fprintf(stdout, "OK \n") ;
+			else {
+				nfail++ ;
+				fprintf(stdout, "FAILED \n") ;
+			}
+			if(pdb) free_pdb_atoms(pdb) ;
+			if(ref) free_pdb_atoms(ref) ;
+		}
+	}
+	remove(pdbs[3]) ;
+	rmdir(dir) ;
+
+	fprintf(stdout, "    KEPT HETATM HASH ............... ") ;
+	if(rpdb_is_kept_hetatm("HEM") && rpdb_is_kept_hetatm("MSE")
+	   && rpdb_is_kept_hetatm("PP9")
+	   && !rpdb_is_kept_hetatm("HOH") && !rpdb_is_kept_hetatm("ZN ")
+	   && !rpdb_is_kept_hetatm("ATP") && !rpdb_is_kept_hetatm("\0\0\0"))
+		fprintf(stdout, "OK \n") ;
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+
+	return nfail ;
+}
+
+/**
+	mmCIF file read by check_rcif: a text field and a loop before the atoms,
+	label_* values only, a 4 characters chain, ids of more than 5 digits,
+	a quoted name, and atoms of a second data block.
+*/
+static const char *ST_check_rcif_lines[] = {
+	"# comment\n",
+	"data_TEST\n",
+	"_cell.length_a    10.500\n_cell.length_b 20.25\n",
+	"_struct.title\n;loop_\n_atom_site.id 'no atom' here\n;\n",
+	"loop_\n_pdbx_poly.id\n_pdbx_poly.seq\n1 'A B'\n2 \"C D\"\n",
+	"loop_\n_atom_site.group_PDB\n_atom_site.id\n_atom_site.label_atom_id\n",
+	"_atom_site.label_comp_id\n_atom_site.label_asym_id\n_atom_site.label_seq_id\n",
+	"_atom_site.Cartn_x\n_atom_site.Cartn_y\n_atom_site.Cartn_z\n",
+	"ATOM 1234567 \"O5'\" U AAAA 123456 1.5 -2.25 1e1\n",
+	"ATOM 1234568 'P' U AAAA 123456 . ? 3\n",
+	"#\ndata_OTHER\nloop_\n_atom_site.id\n1\n2\n"
+} ;
+
+static void check_rcif_name(FILE *f, const char *s, int quote)
+{
+	if(s[0] == '\0' || s[0] == ' ' || strchr(s, '\'')) fprintf(f, " \"%s\"", s) ;
+	else if(quote) fprintf(f, " '%s'", s) ;
+	else fprintf(f, " %s", s) ;
+}
+
+static void check_rcif_row(FILE *f, s_atm *a, int i, char aloc, const char *resn,
+						   int model)
+{
+	char res[8], type[8] ;
+
+	strcpy(res, resn) ; str_trim(res) ;
+	strcpy(type, strcmp(res, "HOH") ? a->type : "HETATM") ; str_trim(type) ;
+	fprintf(f, "%s %d %s", type, a->id, a->symbol[0] ? a->symbol : "?") ;
+	check_rcif_name(f, a->name, i%7 == 0) ;
+	if(aloc == ' ') fprintf(f, " .") ;
+	else fprintf(f, " %c", aloc) ;
+	fprintf(f, " %s", res) ;
+	check_rcif_name(f, a->chain, 0) ;
+	fprintf(f, " 1") ;
+	if(i%4 == 2) fprintf(f, " .") ;
+	else fprintf(f, " %d", a->res_id) ;
+	if(a->pdb_insert == ' ') fprintf(f, " ?") ;
+	else fprintf(f, " %c", a->pdb_insert) ;
+	fprintf(f, " %.3f %.3f %.3f %.2f %.2f %d", a->x, a->y, a->z,
+			a->occupancy, a->bfactor, a->charge) ;
+	if(i%4 == 1) fprintf(f, " ?") ;
+	else fprintf(f, " %d", a->res_id) ;
+	fprintf(f, " %s", (i%5 == 3) ? "." : res) ;
+	if(i%3 == 1) fprintf(f, " ?") ;
+	else check_rcif_name(f, a->chain, 0) ;
+	if(i%6 == 5) fprintf(f, " .") ;
+	else check_rcif_name(f, a->name, 0) ;
+	fprintf(f, " %d\n", model) ;
+}
+
+/**
+	Write a structure in mmCIF, with shuffled columns, missing auth_* values,
+	and rows to skip: second alternate locations, waters and a second model.
+*/
+static void check_rcif_write(s_pdb *pdb, const char *path)
+{
+	int i ;
+	s_atm *a = NULL ;
+	FILE *f = fopen(path, "w") ;
+
+	if(!f) return ;
+	fprintf(f, "data_TEST\n#\n_entry.id TEST\n") ;
+	fprintf(f, "_cell.length_a %.3f\n_cell.length_b %.3f\n_cell.length_c %.3f\n",
+			pdb->A, pdb->B, pdb->C) ;
+	fprintf(f, "_cell.angle_alpha %.2f\n_cell.angle_beta %.2f\n_cell.angle_gamma %.2f\n",
+			pdb->alpha, pdb->beta, pdb->gamma) ;
+	fprintf(f, "#\nloop_\n_atom_site.group_PDB\n_atom_site.id\n"
+			"_atom_site.type_symbol\n_atom_site.label_atom_id\n"
+			"_atom_site.label_alt_id\n_atom_site.label_comp_id\n"
+			"_atom_site.label_asym_id\n_atom_site.label_entity_id\n"
+			"_atom_site.label_seq_id\n_atom_site.pdbx_PDB_ins_code\n"
+			"_atom_site.Cartn_x\n_atom_site.Cartn_y\n_atom_site.Cartn_z\n"
+			"_atom_site.occupancy\n_atom_site.B_iso_or_equiv\n"
+			"_atom_site.pdbx_formal_charge\n_atom_site.auth_seq_id\n"
+			"_atom_site.auth_comp_id\n_atom_site.auth_asym_id\n"
+			"_atom_site.auth_atom_id\n_atom_site.pdbx_PDB_model_num\n") ;
+
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		a = pdb->latoms + i ;
+		check_rcif_row(f, a, i, a->pdb_aloc, a->res_name, 1) ;
+		if(a->pdb_aloc == 'A') check_rcif_row(f, a, i, 'B', a->res_name, 1) ;
+		if(i%100 == 0) check_rcif_row(f, a, i, ' ', "HOH", 1) ;
+	}
+	for(i = 0 ; i < 5 && i < pdb->natoms ; i++) {
+		a = pdb->latoms + i ;
+		check_rcif_row(f, a, i, a->pdb_aloc, a->res_name, 2) ;
+	}
+	fprintf(f, "#\nloop_\n_pdbx_struct.id\n_pdbx_struct.val\n1 ATOM\n#\n") ;
+	fclose(f) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_rcif
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the mmCIF reader: the sample structures written in mmCIF are read
+	as their PDB file, with and without their ligand, and a small mmCIF file
+	gives the expected atoms. Residue names longer than 3 characters are
+	not taken for the ligand or a kept HETATM of the same 3 first ones.
+   -----------------------------------------------------------------------------
+*/
+int check_rcif(void)
+{
+	fprintf(stdout, "\n--> TESTING MMCIF READER <--\n") ;
+
+	int i, k, ok, nfail = 0 ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char cif[64] ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	const char *ligs[] = {"ATP", "PC1", "ABC"} ;
+	s_pdb *pdb = NULL, *ref = NULL ;
+	s_atm *a = NULL ;
+	FILE *f = NULL ;
+
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		return 1 ;
+	}
+	sprintf(cif, "%s/test.cif", dir) ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		ref = rpdb_open(pdbs[i], ligs[i], M_KEEP_LIG) ;
+		if(ref) {
+			rpdb_read(ref, ligs[i], M_KEEP_LIG) ;
+			check_rcif_write(ref, cif) ;
+			free_pdb_atoms(ref) ;
+		}
+		for(k = M_DONT_KEEP_LIG ; k <= M_KEEP_LIG ; k++) {
+			pdb = rpdb_open(cif, ligs[i], k) ;
+			ref = rpdb_open(pdbs[i], ligs[i], k) ;
+			ok = (pdb != NULL && ref != NULL) ;
+			if(ok) {
+				rpdb_read(pdb, ligs[i], k) ;
+				rpdb_read(ref, ligs[i], k) ;
+				ok = check_rpdb_eq(pdb, ref) ;
+			}
+			fprintf(stdout, "    %s %s ......... ", pdbs[i],
+					k == M_KEEP_LIG ? ligs[i] : "   ") ;
+			if(ok) fprintf(stdout, "OK \n") ;
+			else {
+				nfail++ ;
+				fprintf(stdout, "FAILED \n") ;
+			}
+			if(pdb) free_pdb_atoms(pdb) ;
+			if(ref) free_pdb_atoms(ref) ;
+		}
+	}
+
+	f = fopen(cif, "w") ;
+	for(i = 0 ; f && i < (int) (sizeof(ST_check_rcif_lines)/sizeof(char *)) ; i++)
+		fputs(ST_check_rcif_lines[i], f) ;
+	if(f) fclose(f) ;
+
+	pdb = rpdb_open(cif, NULL, M_DONT_KEEP_LIG) ;
+	ok = (pdb != NULL && pdb->natoms == 2 && pdb->A == 10.5f
+		  && pdb->B == 20.25f && pdb->C == 0.0f) ;
+	if(ok) {
+		a = pdb->latoms ;
+		ok = (a[0].id == 1234567 && a[1].id == 1234568 && a[0].res_id == 123456
+			  && !strcmp(a[0].name, "O5'") && !strcmp(a[1].name, "P")
+			  && !strcmp(a[0].res_name, "  U ") && !strcmp(a[0].chain, "AAAA")
+			  && !strcmp(a[0].type, "ATOM  ") && a[0].pdb_aloc == ' '
+			  && a[0].pdb_insert == ' ' && !strcmp(a[0].symbol, "O")
+			  && !strcmp(a[1].symbol, "P") && a[0].x == 1.5f
+			  && a[0].y == -2.25f && a[0].z == 10.0f && a[1].x == 0.0f
+			  && a[1].y == 0.0f && a[1].z == 3.0f) ;
+	}
+	fprintf(stdout, "    SYNTHETIC MMCIF FILE ........... ") ;
+	if(ok) fprintf(stdout, "OK \n") ;
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	if(pdb) free_pdb_atoms(pdb) ;
+
+	ok = (rpdb_atom_kind(1, "ABC ", "ABC", M_KEEP_LIG) == M_RPDB_LIG
+		  && rpdb_atom_kind(1, "ABCDE", "ABC", M_KEEP_LIG) == -1
+		  && rpdb_atom_kind(1, "ABC ", "ABCDE", M_KEEP_LIG) == -1
+		  && rpdb_atom_kind(0, "ABCDE", "ABC", M_DONT_KEEP_LIG) == M_RPDB_ATM
+		  && rpdb_atom_kind(1, "HEA ", NULL, M_DONT_KEEP_LIG) == M_RPDB_HET
+		  && rpdb_atom_kind(1, "HEAXY", NULL, M_DONT_KEEP_LIG) == -1) ;
+	fprintf(stdout, "    LONG RESIDUE NAMES ............. ") ;
+	if(ok) fprintf(stdout, "OK \n") ;
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+	remove(cif) ;
+	rmdir(dir) ;
+
+	return nfail ;
+}
+
+/**
+	Write a file compressed with gzip in two members (as two gzip files put
+	end to end), or with zstd. With cut > 0, the compressed file is truncated
+	of cut bytes.
+*/
+static void check_rpdb_compress(const char *src, const char *dest, int zstd, int cut)
+{
+	FILE *f = fopen(src, "rb") ;
+	char *buf = NULL ;
+	long n = 0 ;
+	gzFile gz ;
+
+	if(!f) return ;
+	fseek(f, 0, SEEK_END) ;
+	n = ftell(f) ;
+	rewind(f) ;
+	buf = (char *) my_malloc(n + 1) ;
+	n = fread(buf, 1, n, f) ;
+	fclose(f) ;
+
+	if(zstd) {
+#ifdef M_USE_ZSTD
+		size_t nz = ZSTD_compressBound(n) ;
+		char *z = (char *) my_malloc(nz) ;
+		nz = ZSTD_compress(z, nz, buf, n, 3) ;
+		f = fopen(dest, "wb") ;
+		if(f) {
+			fwrite(z, 1, nz - cut, f) ;
+			fclose(f) ;
+		}
+		my_free(z) ;
+#endif
+	}
+	else {
+		gz = gzopen(dest, "wb") ;
+		gzwrite(gz, buf, n/2) ;
+		gzclose(gz) ;
+		gz = gzopen(dest, "ab") ;
+		gzwrite(gz, buf + n/2, n - n/2) ;
+		gzclose(gz) ;
+		if(cut > 0 && (f = fopen(dest, "rb"))) {
+			fseek(f, 0, SEEK_END) ;
+			n = ftell(f) ;
+			fclose(f) ;
+			if(truncate(dest, n - cut) != 0) remove(dest) ;
+		}
+	}
+	my_free(buf) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_rpdb_gz
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the reading of compressed files: the sample structures (PDB and
+	mmCIF) compressed with gzip, and zstd if built with M_USE_ZSTD, are read
+	as the original files, and a truncated file is rejected.
+   -----------------------------------------------------------------------------
+*/
+int check_rpdb_gz(void)
+{
+	fprintf(stdout, "\n--> TESTING COMPRESSED INPUT <--\n") ;
+
+	int i, z, ok, nfail = 0 ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char path[3][64], name[] = "dir/1ATP.pdb.gz" ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	const char *ligs[] = {"ATP", "PC1", "ABC"} ;
+	const char *ext[] = {"gz", "zst"} ;
+	s_pdb *pdb = NULL, *ref = NULL ;
+
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		return 1 ;
+	}
+	sprintf(path[1], "%s/test.cif", dir) ;
+
+	for(z = 0 ; z < 2 ; z++) {
+#ifndef M_USE_ZSTD
+		if(z == 1) break ;
+#endif
+		for(i = 0 ; i < 3 ; i++) {
+			ref = rpdb_open(pdbs[i], ligs[i], M_KEEP_LIG) ;
+			if(!ref) continue ;
+			rpdb_read(ref, ligs[i], M_KEEP_LIG) ;
+			check_rcif_write(ref, path[1]) ;
+
+			sprintf(path[0], "%s/test.pdb.%s", dir, ext[z]) ;
+			check_rpdb_compress(pdbs[i], path[0], z, 0) ;
+			sprintf(path[2], "%s/test.cif.%s", dir, ext[z]) ;
+			check_rpdb_compress(path[1], path[2], z, 0) ;
+
+			pdb = rpdb_open(path[0], ligs[i], M_KEEP_LIG) ;
+			ok = (pdb != NULL) ;
+			if(ok) {
+				rpdb_read(pdb, ligs[i], M_KEEP_LIG) ;
+				ok = check_rpdb_eq(pdb, ref) ;
+				free_pdb_atoms(pdb) ;
+			}
+			pdb = rpdb_open(path[2], ligs[i], M_KEEP_LIG) ;
+			ok = ok && (pdb != NULL) ;
+			if(pdb) {
+				rpdb_read(pdb, ligs[i], M_KEEP_LIG) ;
+				ok = ok && check_rpdb_eq(pdb, ref) ;
+				free_pdb_atoms(pdb) ;
+			}
+			free_pdb_atoms(ref) ;
+
+			/* Truncated file */
+			check_rpdb_compress(pdbs[i], path[0], z, 10) ;
+			pdb = rpdb_open(path[0], ligs[i], M_KEEP_LIG) ;
+			if(pdb) {
+				ok = 0 ;
+				free_pdb_atoms(pdb) ;
+			}
+
+			fprintf(stdout, "    %s.%-3s ................ ", pdbs[i], ext[z]) ;
+			if(ok) fprintf(stdout, "OK \n") ;
+			else {
+				nfail++ ;
+				fprintf(stdout, "FAILED \n") ;
+			}
+			remove(path[0]) ;
+			remove(path[2]) ;
+		}
+	}
+	remove(path[1]) ;
+	rmdir(dir) ;
+
+	fprintf(stdout, "    COMPRESSED FILE NAMES .......... ") ;
+	remove_pdb_ext(name) ;
+	if(strcmp(name, "dir/1ATP") == 0 && compressed_ext_len("a.cif.ZST") == 4
+	   && compressed_ext_len("a.pdb") == 0)
+		fprintf(stdout, "OK \n") ;
+	else {
+		nfail++ ;
+		fprintf(stdout, "FAILED \n") ;
+	}
+
+	return nfail ;
+}
+
+static char* check_wpdb_load(const char *path, long *len)
+{
+	char *buf = NULL ;
+	FILE *f = fopen(path, "rb") ;
+
+	*len = -1 ;
+	if(f) {
+		fseek(f, 0, SEEK_END) ;
+		*len = ftell(f) ;
+		rewind(f) ;
+		buf = (char *) my_malloc(*len + 1) ;
+		if(fread(buf, 1, *len, f) != (size_t) *len) *len = -1 ;
+		buf[*len > 0 ? *len : 0] = '\0' ;
+		fclose(f) ;
+	}
+
+	return buf ;
+}
+
+static void check_wpdb_lines(FILE *f, FILE *fn, s_atm *a, float x, float y, float z,
+							 int id, int res_id, int charge)
+{
+	write_pdb_atom_line(f, a->type, id, a->name, a->pdb_aloc, a->res_name, 
+						a->chain, res_id, a->pdb_insert, x, y, z, a->occupancy, 
+						a->bfactor, a->symbol, charge) ;
+	write_pdb_atom_line_naive(fn, a->type, id, a->name, a->pdb_aloc, a->res_name, 
+						a->chain, res_id, a->pdb_insert, x, y, z, a->occupancy, 
+						a->bfactor, a->symbol, charge) ;
+	write_pqr_atom_line(f, "ATOM", id, "C", 'A', "STP", a->chain, res_id, ' ', 
+						x, y, z, z, x) ;
+	write_pqr_atom_line_naive(fn, "ATOM", id, "C", 'A', "STP", a->chain, res_id, 
+						' ', x, y, z, z, x) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_wpdb
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the output: records formatted by hand are the ones of fprintf
+	(atoms of the samples, rounding ties, signs, large numbers), and each
+	file of a packed output is, at the offset given by its index, the file
+	written in the pockets directory.
+   -----------------------------------------------------------------------------
+*/
+int check_wpdb(void)
+{
+	fprintf(stdout, "\n--> TESTING OUTPUT WRITERS <--\n") ;
+
+	int i, k, n, ok, nfail = 0 ;
+	long len[2], off, size ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char path[64], name[32], *buf[2], *p ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	const float vals[] = { 0.0f, -0.0f, 0.0005f, -0.0005f, 0.0015f, 0.125f, 
+						   -0.125f, 2.675f, 999.9995f, -999.9995f, 9999.999f, 
+						   -123456.7f, 1e9f, -1e12f, 1e20f } ;
+	const int ids[] = { 0, -1, 9999, 10000, 65535, 65536, 99999, 100000, 1048575 } ;
+	s_fparams *params = init_def_fparams() ;
+	size_t blen[2] ;
+	FILE *f[2] ;
+
+	/* Records */
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb = rpdb_open(pdbs[i], NULL, M_KEEP_LIG) ;
+		ok = (pdb != NULL) ;
+		if(pdb) {
+			rpdb_read(pdb, NULL, M_KEEP_LIG) ;
+			f[0] = open_memstream(&buf[0], &blen[0]) ;
+			f[1] = open_memstream(&buf[1], &blen[1]) ;
+			for(k = 0 ; k < pdb->natoms ; k++) {
+				s_atm *a = pdb->latoms + k ;
+				check_wpdb_lines(f[0], f[1], a, a->x, a->y, a->z, a->id, a->res_id, 
+								 a->charge) ;
+			}
+			if(i == 0) {
+				for(k = 0 ; k < 15*15*9 ; k++) {
+					check_wpdb_lines(f[0], f[1], pdb->latoms, vals[k%15], 
+									 vals[(k/15)%15], -vals[k%15], ids[(k/225)%9], 
+									 ids[k%9], (k%3) - 1) ;
+				}
+			}
+			fclose(f[0]) ;
+			fclose(f[1]) ;
+			ok = (blen[0] == blen[1] && memcmp(buf[0], buf[1], blen[0]) == 0) ;
+			free(buf[0]) ;
+			free(buf[1]) ;
+			free_pdb_atoms(pdb) ;
+		}
+		fprintf(stdout, "    RECORDS %s ..... ", pdbs[i]) ;
+		if(ok) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+	}
+
+	/* Packed pockets */
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		free_fparams(params) ;
+		return nfail + 1 ;
+	}
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb = rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		c_lst_pockets *pockets = NULL ;
+		ok = 0 ;
+		n = -1 ;
+		buf[0] = NULL ;
+		if(pdb) {
+			rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+			pockets = search_pocket(pdb, params) ;
+			sprintf(path, "%s/test.pack", dir) ;
+			write_each_pocket(dir, pockets) ;
+			ok = (write_pockets_pack(path, pockets) == 0) ;
+			buf[0] = check_wpdb_load(path, &len[0]) ;
+			remove(path) ;
+		}
+
+		/* Index, from the offset given by the last line */
+		if(ok && len[0] > 0 && buf[0][len[0]-1] == '\n') {
+			buf[0][len[0]-1] = '\0' ;
+			p = strrchr(buf[0], '\n') ;
+			ok = (p && sscanf(p, "\nEND_INDEX %ld", &off) == 1 && off < len[0]
+				  && strncmp(buf[0], "FPOCKET_PACK 1\n", 15) == 0
+				  && sscanf(buf[0] + off, "INDEX %d", &n) == 1
+				  && n == 2*(int) pockets->n_pockets) ;
+			p = ok ? strchr(buf[0] + off, '\n') + 1 : NULL ;
+		}
+		else ok = 0 ;
+
+		for(k = 0 ; k < n && ok ; k++) {
+			ok = (sscanf(p, "%ld %ld %31s", &off, &size, name) == 3
+				  && off + size <= len[0]) ;
+			sprintf(path, "%s/%s", dir, name) ;
+			sprintf(name, "pocket%d_%s", k/2, (k%2 == 0) ? "vert.pqr" : "atm.pdb") ;
+			ok = ok && strcmp(path + strlen(dir) + 1, name) == 0 ;
+			buf[1] = check_wpdb_load(path, &len[1]) ;
+			ok = ok && len[1] == size && memcmp(buf[0] + off, buf[1], size) == 0 ;
+			if(buf[1]) my_free(buf[1]) ;
+			remove(path) ;
+			p = strchr(p, '\n') + 1 ;
+		}
+
+		fprintf(stdout, "    PACK %s ........ ", pdbs[i]) ;
+		if(ok) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		if(buf[0]) my_free(buf[0]) ;
+		if(pockets) {
+			for(k = 0 ; k < 2*(int) pockets->n_pockets ; k++) {
+				sprintf(path, "%s/pocket%d_%s", dir, k/2, (k%2 == 0) ? "vert.pqr" : "atm.pdb") ;
+				remove(path) ;
+			}
+			c_lst_pocket_free(pockets) ;
+		}
+		if(pdb) free_pdb_atoms(pdb) ;
+	}
+	rmdir(dir) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/* Write a binary result and tell if fpb_open takes it */
+static int check_fpbin_valid(const char *path, const char *buf, long len)
+{
+	s_fpb *fpb = NULL ;
+	FILE *f = fopen(path, "wb") ;
+
+	if(!f) return 0 ;
+	fwrite(buf, 1, len, f) ;
+	fclose(f) ;
+	fpb = fpb_open(path) ;
+	if(fpb) fpb_close(fpb) ;
+
+	return fpb != NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_fpbin
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the binary result: read with fpb_open, each pocket has the score,
+	center, descriptors and alpha spheres of the pocket written, and its
+	atoms are the ones of its pdb file, in the same order. Truncated files,
+	rows out of the atom table and columns of the wrong rows, type or width
+	are rejected.
+   -----------------------------------------------------------------------------
+*/
+int check_fpbin(void)
+{
+	fprintf(stdout, "\n--> TESTING BINARY RESULT <--\n") ;
+
+	int i, k, j, n, first, nvert, tofree, ok, nfail = 0 ;
+	long len ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char path[64], bad[64], *buf, *txt, *line ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+	s_vvertice **verts ;
+	const int32_t *rows ;
+	size_t tlen ;
+	FILE *f ;
+
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		free_fparams(params) ;
+		return 1 ;
+	}
+	sprintf(path, "%s/test.fpb", dir) ;
+	sprintf(bad, "%s/bad.fpb", dir) ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb = rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		c_lst_pockets *pockets = NULL ;
+		s_fpb *fpb = NULL ;
+		ok = 0 ;
+		if(pdb) {
+			rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+			pockets = search_pocket(pdb, params) ;
+			ok = pockets && (write_pockets_bin(path, pdb, pockets) == 0) ;
+			fpb = ok ? fpb_open(path) : NULL ;
+			ok = (fpb != NULL && fpb->header->npockets == pockets->n_pockets) ;
+		}
+
+		if(ok) {
+			const float *score = fpb_f32(fpb, M_FPB_POCK_SCORE, NULL),
+						*center = fpb_f32(fpb, M_FPB_POCK_CENTER, NULL),
+						*vol = fpb_f32(fpb, "desc_volume", NULL),
+						*sph_c = fpb_f32(fpb, M_FPB_SPH_CENTER, NULL),
+						*sph_r = fpb_f32(fpb, M_FPB_SPH_RADIUS, NULL) ;
+			const int32_t *nasph = fpb_i32(fpb, "desc_nb_asph", NULL),
+						  *aa = fpb_i32(fpb, "desc_aa_compo", NULL),
+						  *atm_id = fpb_i32(fpb, M_FPB_ATM_ID, NULL) ;
+			const char *res = fpb_chars(fpb, M_FPB_ATM_RES_NAME, NULL) ;
+			node_pocket *pcur = pockets->first ;
+
+			ok = score && center && vol && sph_c && sph_r && nasph && aa && atm_id && res ;
+			for(k = 0 ; ok && pcur ; k++, pcur = pcur->next) {
+				s_pocket *p = pcur->pocket ;
+				ok = (score[k] == p->score && center[3*k] == p->bary[0]
+					  && center[3*k + 2] == p->bary[2] && vol[k] == p->pdesc->volume
+					  && nasph[k] == p->pdesc->nb_asph 
+					  && memcmp(aa + 20*k, p->pdesc->aa_compo, 20*sizeof(int)) == 0) ;
+
+				/* Alpha spheres */
+				verts = get_pocket_vert_array(p, &nvert, &tofree) ;
+				ok = ok && fpb_pocket_spheres(fpb, k, &first) == nvert ;
+				for(j = 0 ; ok && j < nvert ; j++) {
+					ok = (sph_c[3*(first + j)] == verts[j]->x 
+						  && sph_c[3*(first + j) + 1] == verts[j]->y
+						  && sph_r[first + j] == verts[j]->ray) ;
+				}
+				if(tofree) my_free(verts) ;
+
+				/* Atoms, in the order of the pdb file of the pocket */
+				f = open_memstream(&txt, &tlen) ;
+				print_pocket_pdb(f, p) ;
+				fclose(f) ;
+				n = fpb_pocket_atoms(fpb, k, &rows) ;
+				j = 0 ;
+				for(line = strtok(txt, "\n") ; ok && line ; line = strtok(NULL, "\n")) {
+					if(strncmp(line, "ATOM", 4) != 0 && strncmp(line, "HETATM", 6) != 0) continue ;
+					ok = (j < n && atoi(line + 6) == atm_id[rows[j]] 
+						  && strncmp(line + 17, res + 8*rows[j], strlen(res + 8*rows[j])) == 0) ;
+					j++ ;
+				}
+				ok = ok && (j == n) ;
+				free(txt) ;
+			}
+		}
+		if(fpb) fpb_close(fpb) ;
+
+		/* Truncated file, atom out of the table */
+		buf = ok ? check_wpdb_load(path, &len) : NULL ;
+		if(buf) {
+			f = fopen(bad, "wb") ;
+			fwrite(buf, 1, len - 8, f) ;
+			fclose(f) ;
+			fpb = fpb_open(bad) ;
+			if(fpb) {
+				ok = 0 ;
+				fpb_close(fpb) ;
+			}
+
+			((s_fpb_header *) buf)->natoms-- ;
+			ok = ok && !check_fpbin_valid(bad, buf, len) ;
+			((s_fpb_header *) buf)->natoms++ ;
+
+			/* Columns of the wrong rows, type or width */
+			for(k = 0 ; k < (int) ((s_fpb_header *) buf)->ncols ; k++) {
+				s_fpb_col *c = (s_fpb_col *) (buf + sizeof(s_fpb_header)) + k ;
+				if(strcmp(c->name, M_FPB_SPH_RADIUS) == 0) {
+					c->nrows-- ;
+					ok = ok && !check_fpbin_valid(bad, buf, len) ;
+					c->nrows++ ;
+				}
+				else if(strcmp(c->name, M_FPB_ATM_CENTER) == 0) {
+					c->type = M_FPB_I32 ;
+					ok = ok && !check_fpbin_valid(bad, buf, len) ;
+					c->type = M_FPB_F32 ;
+				}
+				else if(strcmp(c->name, M_FPB_ATM_NAME) == 0) {
+					c->width-- ;
+					ok = ok && !check_fpbin_valid(bad, buf, len) ;
+					c->width++ ;
+				}
+				else if(strcmp(c->name, "desc_volume") == 0) {
+					c->nrows-- ;
+					ok = ok && !check_fpbin_valid(bad, buf, len) ;
+					c->nrows++ ;
+				}
+			}
+			ok = ok && check_fpbin_valid(bad, buf, len) ;
+			my_free(buf) ;
+			remove(bad) ;
+		}
+		remove(path) ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(ok) fprintf(stdout, "OK \n") ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED \n") ;
+		}
+		if(pockets) c_lst_pocket_free(pockets) ;
+		if(pdb) free_pdb_atoms(pdb) ;
+	}
+	rmdir(dir) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/* Remove a directory and all its content */
+static void check_rm_tree(const char *dir)
+{
+	char path[512] ;
+	struct dirent *e = NULL ;
+	struct stat st ;
+	DIR *d = opendir(dir) ;
+
+	while(d && (e = readdir(d)) != NULL) {
+		if(strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue ;
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name) ;
+		if(stat(path, &st) == 0 && S_ISDIR(st.st_mode)) check_rm_tree(path) ;
+		else remove(path) ;
+	}
+	if(d) closedir(d) ;
+	rmdir(dir) ;
+}
+
+/* Number of files of the tree a missing or different in the tree b (-1 if a
+ * can't be read), the number of files of a being added to nfiles */
+static int check_cmp_tree(const char *a, const char *b, int *nfiles)
+{
+	int ndiff = 0 ;
+	long len[2] ;
+	char pa[512], pb[512], *buf[2] ;
+	struct dirent *e = NULL ;
+	struct stat st ;
+	DIR *d = opendir(a) ;
+
+	if(!d) return -1 ;
+	while((e = readdir(d)) != NULL) {
+		if(strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue ;
+		snprintf(pa, sizeof(pa), "%s/%s", a, e->d_name) ;
+		snprintf(pb, sizeof(pb), "%s/%s", b, e->d_name) ;
+		if(stat(pa, &st) == 0 && S_ISDIR(st.st_mode)) {
+			if(check_cmp_tree(pa, pb, nfiles) != 0) ndiff++ ;
+			continue ;
+		}
+		buf[0] = check_wpdb_load(pa, &len[0]) ;
+		buf[1] = check_wpdb_load(pb, &len[1]) ;
+		if(len[0] < 0 || len[0] != len[1] || memcmp(buf[0], buf[1], len[0]) != 0) {
+			ndiff++ ;
+		}
+		if(buf[0]) my_free(buf[0]) ;
+		if(buf[1]) my_free(buf[1]) ;
+		(*nfiles)++ ;
+	}
+	closedir(d) ;
+
+	return ndiff ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_fpocket_baseline
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test that a default run of fpocket (single qhull run) still gives the
+	number of pockets and of alpha spheres in pockets of the original
+	version on the 3 samples.
+   -----------------------------------------------------------------------------
+*/
+int check_fpocket_baseline(void)
+{
+	fprintf(stdout, "\n--> TESTING FPOCKET DEFAULT RUN AGAINST BASELINE <--\n") ;
+
+	int i, nfail = 0 ;
+	size_t nsph ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	size_t ref[][2] = { {18, 1380}, {16, 908}, {19, 1000} } ;
+	s_fparams *params = init_def_fparams() ;
+	params->rand_seed = 1 ;
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+		c_lst_pockets *pockets = search_pocket(pdb, params) ;
+		node_pocket *np = NULL ;
+		nsph = 0 ;
+		if(pockets) {
+			for(np = pockets->first ; np ; np = np->next) {
+				nsph += np->pocket->v_lst->n_vertices ;
+			}
+		}
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(pockets && pockets->n_pockets == ref[i][0] && nsph == ref[i][1]) {
+			fprintf(stdout, "OK (%d pockets, %d spheres) \n",
+					(int) ref[i][0], (int) ref[i][1]) ;
+		}
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED (%d pockets, %d spheres instead of %d, %d) \n",
+					pockets ? (int) pockets->n_pockets : 0, (int) nsph,
+					(int) ref[i][0], (int) ref[i][1]) ;
+		}
+
+		if(pockets) c_lst_pocket_free(pockets) ;
+		free_pdb_atoms(pdb) ;
+	}
+	set_rand_seed(-1) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	check_fpocket_threads
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test that the whole output of fpocket (pdb, pqr, info, scripts, pockets
+	and binary result) is the same with 2 and 4 tesselation threads (-t),
+	for a given seed (-S). A single thread keeps the qhull order of the
+	vertices, and is tested by check_fpocket_baseline.
+   -----------------------------------------------------------------------------
+*/
+int check_fpocket_threads(void)
+{
+	fprintf(stdout, "\n--> TESTING FPOCKET OUTPUT WITH 2 AND 4 THREADS <--\n") ;
+
+	int i, k, ndiff, n[2], nfail = 0 ;
+	char dir[] = "/tmp/fpocket_check_XXXXXX" ;
+	char path[2][128], out[2][128], code[8] ;
+	char pdbs[][32] = {"sample/1ATP.pdb", "sample/3LKF.pdb", "sample/7TAA.pdb"} ;
+	s_fparams *params = init_def_fparams() ;
+
+	if(mkdtemp(dir) == NULL) {
+		fprintf(stdout, "    WRITING TEST FILE............... FAILED \n") ;
+		free_fparams(params) ;
+		return 1 ;
+	}
+	params->rand_seed = 1 ;
+	params->out_bin = 1 ;
+	for(k = 0 ; k < 2 ; k++) {
+		snprintf(path[k], sizeof(path[k]), "%s/t%d", dir, k) ;
+		mkdir(path[k], 0755) ;
+	}
+
+	for(i = 0 ; i < 3 ; i++) {
+		s_pdb *pdb =  rpdb_open(pdbs[i], NULL, M_DONT_KEEP_LIG) ;
+		if(!pdb) {
+			fprintf(stdout, "    OPENING PDB FILE................ FAILED \n") ;
+			nfail++ ;
+			continue ;
+		}
+		rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+		sscanf(pdbs[i], "sample/%4s", code) ;
+
+		/* Same structure written in t0 with 2 threads, in t1 with 4 */
+		for(k = 0 ; k < 2 ; k++) {
+			params->nthreads = (k == 0) ? 2 : 4 ;
+			c_lst_pockets *pockets = search_pocket(pdb, params) ;
+			snprintf(path[k], sizeof(path[k]), "%s/t%d/%s.pdb", dir, k, code) ;
+			snprintf(out[k], sizeof(out[k]), "%s/t%d/%s_out", dir, k, code) ;
+			write_out_fpocket(pockets, pdb, path[k], params->out_layout, params->out_bin) ;
+			if(pockets) c_lst_pocket_free(pockets) ;
+		}
+
+		n[0] = n[1] = 0 ;
+		ndiff = check_cmp_tree(out[0], out[1], n) ;
+		if(ndiff == 0) ndiff = check_cmp_tree(out[1], out[0], n + 1) ;
+
+		fprintf(stdout, "    %s ............. ", pdbs[i]) ;
+		if(ndiff == 0 && n[0] > 0 && n[0] == n[1]) fprintf(stdout, "OK (%d files) \n", n[0]) ;
+		else {
+			nfail++ ;
+			fprintf(stdout, "FAILED (%d files differ) \n", ndiff) ;
+		}
+
+		for(k = 0 ; k < 2 ; k++) check_rm_tree(out[k]) ;
+		free_pdb_atoms(pdb) ;
+	}
+	check_rm_tree(dir) ;
+	set_rand_seed(-1) ;
+	free_fparams(params) ;
+
+	return nfail ;
+}
+
 int check_fpocket (void)
 {
 	fprintf(stdout, "\n--> TESTING FPOCKET ALGORITHM <--\n") ;
@@ -130,7 +2809,7 @@ int check_fpocket (void)
 			if(pockets && pockets->n_pockets > 0) {
 				fprintf(stdout, "OK \n") ;
 				fprintf(stdout, "    WRITING FPOCKET OUTPUT ......... ") ;
-				write_out_fpocket(pockets, pdb, params->pdb_path);
+				write_out_fpocket(pockets, pdb, params->pdb_path, params->out_layout, params->out_bin);
 				fprintf(stdout, "OK \n") ;
 				c_lst_pocket_free(pockets) ;
 			}
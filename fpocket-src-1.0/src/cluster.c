@@ -14,9 +14,17 @@
 ##	This file contains currently only one function, providing
 ##	a mutliple linkage clustering algorithm performed on a list
 ##	of pockets.
+##	Close alpha sphere centers are found with a uniform grid (cell size
+##	sl_clust_max_dist), giving the number of close pairs for each pair of
+##	pockets. Pockets are then merged either in the order of the list, as
+##	the original algorithm does (pck_ml_clust_naive, kept as a reference),
+##	or by connected components (independent from the order of the list).
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     set_mlgrid reads the table of the pockets (s_ptable)
+##	17-11-02	     Grid of alpha sphere centers, merge in the order of the
+##					 list (-l order) or by connected components (-l graph)
 ##      19-11-08        (p)  Extension of comments, change in multiple linkage clustering
 ##	28-11-08	(v)  Comments UTD + minor relooking
 ##	11-05-08	(v)  singleLinkageClustering -> pck_sl_clust
@@ -25,9 +33,6 @@
 ##	
 ## ----- TODO or SUGGESTIONS
 ##
-##	(v) Possible improvement:
-##		Use the sorted structure to find neighbors in a more
-##		efficient way.
 ##	(v) Rename the file ! (mlcluster.c for example...)
 ##		Or maybe move this function into pocket.c, as the
 ##		algorithm deals with pockets only...
@@ -67,11 +72,430 @@
 **/
 
 
+/* Grid of the alpha sphere centers of all pockets, vertices of a pocket being
+ * contiguous (pstart), and close pairs counted for each pair of pockets,
+ * stored by rows (pockets q > p in the row of p). */
+typedef struct s_mlgrid
+{
+	float *xyz ;		/* Centers of the alpha spheres */
+	int *pstart,		/* First alpha sphere of each pocket (np + 1) */
+		*pock,			/* Pocket of each alpha sphere */
+		*cell,			/* Cell of each alpha sphere */
+		*cstart,		/* First alpha sphere of each cell (ncell + 1) */
+		*cvert ;		/* Alpha spheres sorted by cell */
+
+	int *rstart,		/* First pair of each row (np + 1) */
+		*rpock,			/* Second pocket of each pair */
+		*rcnt ;			/* Number of close alpha spheres of each pair */
+
+	int np, n, npair,
+		nx, ny, nz ;
+	float xmin, ymin, zmin,
+		  cs ;
+
+} s_mlgrid ;
+
+static void set_mlgrid(s_mlgrid *g, node_pocket **pn, int np, float dmax) ;
+static void set_mlgrid_pairs(s_mlgrid *g, float dmax) ;
+static void free_mlgrid(s_mlgrid *g) ;
+static void ml_clust_order(s_mlgrid *g, node_pocket **pn, c_lst_pockets *pockets,
+						   int min_nneigh) ;
+static void ml_clust_graph(s_mlgrid *g, node_pocket **pn, c_lst_pockets *pockets,
+						   int min_nneigh) ;
+
 /**-----------------------------------------------------------------------------
-   ## FONCTION: 
+   ## FONCTION:
 	void pck_ml_clust(c_lst_pockets *pockets, s_fparams *params)
    -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	This function will apply a mutliple linkage clustering algorithm on the given
+	list of pockets. Considering two pockets, if params->ml_clust_min_nneigh
+	alpha spheres are separated by a distance lower than params->ml_clust_max_dist,
+	then merge the two pockets.
+	Close alpha spheres are searched in a grid of cell size sl_clust_max_dist,
+	and pockets are merged according to params->ml_clust:
+	 - M_MLCLUST_ORDER: same result as pck_ml_clust_naive. Each pocket of the
+	   list takes the next ones having enough close alpha spheres with it,
+	   including the ones it took before.
+	 - M_MLCLUST_GRAPH: two pockets having enough close alpha spheres are
+	   in the same group (connected components), the order of the list
+	   only changes the order of the vertices in the pocket.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets  : The list of pockets
+	@ s_fparams *params       : Parameters of the program, including single
+								linkage parameters
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void pck_ml_clust(c_lst_pockets *pockets, s_fparams *params)
+{
+	node_pocket *pcur = NULL,
+				**pn = NULL ;
+	s_mlgrid g ;
+	int np = 0 ;
+
+	if(!pockets) {
+		fprintf(stderr, "! Incorrect argument during Single Linkage Clustering.\n") ;
+		return ;
+	}
+	if(pockets->n_pockets < 2) return ;
+
+	pn = (node_pocket **) my_malloc(pockets->n_pockets*sizeof(node_pocket *)) ;
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) pn[np++] = pcur ;
+
+	set_mlgrid(&g, pn, np, params->sl_clust_max_dist) ;
+	set_mlgrid_pairs(&g, params->sl_clust_max_dist) ;
+
+	if(params->ml_clust == M_MLCLUST_GRAPH)
+		ml_clust_graph(&g, pn, pockets, params->sl_clust_min_nneigh) ;
+	else ml_clust_order(&g, pn, pockets, params->sl_clust_min_nneigh) ;
+
+	free_mlgrid(&g) ;
+	my_free(pn) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION:
+	ml_clust_order
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Merge pockets in the order of the list: for each pocket i remaining, the
+	next pockets j are visited in order, and j is merged with i if the number
+	of close alpha spheres between j and i (with the pockets merged with i
+	so far) reaches min_nneigh. Only pockets having at least one close alpha
+	sphere with i are visited, using a heap.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_mlgrid *g             : Grid with the pairs of pockets
+	@ node_pocket **pn        : Pockets of the list, in order
+	@ c_lst_pockets *pockets  : The list of pockets
+	@ int min_nneigh          : Min number of close alpha spheres
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void ml_clust_order(s_mlgrid *g, node_pocket **pn, c_lst_pockets *pockets,
+						   int min_nneigh)
+{
+	int i, j, k, c, q, nheap ;
+	int *alive = (int *) my_calloc(g->np, sizeof(int)),
+		*acc = (int *) my_calloc(g->np, sizeof(int)),
+		*heap = (int *) my_malloc(g->np*sizeof(int)) ;
+
+	for(i = 0 ; i < g->np ; i++) alive[i] = 1 ;
+
+	for(i = 0 ; i < g->np ; i++) {
+		if(!alive[i]) continue ;
+		if(min_nneigh <= 0) {
+		/* Every pocket is close enough */
+			for(j = i+1 ; j < g->np ; j++) {
+				mergePockets(pn[i], pn[j], pockets) ;
+				alive[j] = 0 ;
+			}
+			break ;
+		}
+
+		nheap = 0 ;
+		j = i ;
+		while(1) {
+			/* Pairs of the pocket merged (i first): acc[q] > 0 flags q in
+			 * the heap, as it is only used for q having a close pair */
+			for(k = g->rstart[j] ; k < g->rstart[j+1] ; k++) {
+				q = g->rpock[k] ;
+				if(!alive[q]) continue ;
+				if(acc[q] == 0) {
+					for(c = nheap++ ; c > 0 && heap[(c-1)/2] > q ; c = (c-1)/2)
+						heap[c] = heap[(c-1)/2] ;
+					heap[c] = q ;
+				}
+				acc[q] += g->rcnt[k] ;
+			}
+
+			/* Next candidate */
+			for(j = -1 ; nheap > 0 && j == -1 ; ) {
+				q = heap[0] ;
+				k = heap[--nheap] ;
+				for(c = 0 ; 2*c+1 < nheap ; ) {
+					int m = 2*c+1 ;
+					if(m+1 < nheap && heap[m+1] < heap[m]) m++ ;
+					if(heap[m] >= k) break ;
+					heap[c] = heap[m] ;
+					c = m ;
+				}
+				heap[c] = k ;
+
+				if(acc[q] >= min_nneigh) j = q ;
+				acc[q] = 0 ;
+			}
+			if(j == -1) break ;
+
+			mergePockets(pn[i], pn[j], pockets) ;
+			alive[j] = 0 ;
+		}
+	}
+
+	my_free(alive) ;
+	my_free(acc) ;
+	my_free(heap) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION:
+	ml_clust_graph
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Merge the connected components of the graph of pockets having at least
+	min_nneigh close alpha spheres. Each component is merged in its first
+	pocket of the list, the other ones being appended in order.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_mlgrid *g             : Grid with the pairs of pockets
+	@ node_pocket **pn        : Pockets of the list, in order
+	@ c_lst_pockets *pockets  : The list of pockets
+	@ int min_nneigh          : Min number of close alpha spheres
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void ml_clust_graph(s_mlgrid *g, node_pocket **pn, c_lst_pockets *pockets,
+						   int min_nneigh)
+{
+	int i, k, a, b ;
+	int *parent = (int *) my_malloc(g->np*sizeof(int)) ;
+
+	/* Disjoint sets, the root of a set being its first pocket */
+	for(i = 0 ; i < g->np ; i++) parent[i] = (min_nneigh <= 0) ? 0 : i ;
+
+	for(i = 0 ; i < g->np && min_nneigh > 0 ; i++) {
+		for(k = g->rstart[i] ; k < g->rstart[i+1] ; k++) {
+			if(g->rcnt[k] < min_nneigh) continue ;
+			for(a = i ; parent[a] != a ; a = parent[a] = parent[parent[a]]) ;
+			for(b = g->rpock[k] ; parent[b] != b ; b = parent[b] = parent[parent[b]]) ;
+			if(a < b) parent[b] = a ;
+			else if(b < a) parent[a] = b ;
+		}
+	}
+
+	for(i = 0 ; i < g->np ; i++) {
+		for(a = i ; parent[a] != a ; a = parent[a]) ;
+		if(a != i) mergePockets(pn[a], pn[i], pockets) ;
+	}
+
+	my_free(parent) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION:
+	set_mlgrid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Store the alpha sphere centers of the pockets, and sort them in a grid of
+	cell size dmax (larger if the box would have too many cells).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_mlgrid *g      : The grid to fill
+	@ node_pocket **pn : Pockets of the list, in order
+	@ int np           : Number of pockets
+	@ float dmax       : Distance criteria
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void set_mlgrid(s_mlgrid *g, node_pocket **pn, int np, float dmax)
+{
+	node_vertice *vcur = NULL ;
+	s_pocket *pock = NULL ;
+	s_ptable *t = NULL ;
+	float xmax, ymax, zmax ;
+	int i, k, p, r, ncell ;
+
+	g->np = np ;
+	g->pstart = (int *) my_malloc((np+1)*sizeof(int)) ;
+	g->n = 0 ;
+	for(p = 0 ; p < np ; p++) {
+		g->pstart[p] = g->n ;
+		g->n += pn[p]->pocket->v_lst->n_vertices ;
+	}
+	g->pstart[np] = g->n ;
+
+	g->xyz = (float *) my_malloc((3*g->n+3)*sizeof(float)) ;
+	g->pock = (int *) my_malloc((g->n+1)*sizeof(int)) ;
+	g->cell = (int *) my_malloc((g->n+1)*sizeof(int)) ;
+	g->cvert = (int *) my_malloc((g->n+1)*sizeof(int)) ;
+
+	i = 0 ;
+	for(p = 0 ; p < np ; p++) {
+		pock = pn[p]->pocket ;
+		if((t = pock->ptab)) {
+			for(r = pock->prow ; r != -1 ; r = t->rnext[r]) {
+				for(k = t->vstart[r] ; k < t->vstart[r+1] && i < g->pstart[p+1] ; k++) {
+					g->xyz[3*i] = t->vert[k]->x ;
+					g->xyz[3*i+1] = t->vert[k]->y ;
+					g->xyz[3*i+2] = t->vert[k]->z ;
+					g->pock[i++] = p ;
+				}
+			}
+		}
+		else {
+			for(vcur = pock->v_lst->first ; vcur && i < g->pstart[p+1] ;
+				vcur = vcur->next) {
+				g->xyz[3*i] = vcur->vertice->x ;
+				g->xyz[3*i+1] = vcur->vertice->y ;
+				g->xyz[3*i+2] = vcur->vertice->z ;
+				g->pock[i++] = p ;
+			}
+		}
+		g->pstart[p+1] = i ;
+	}
+	g->n = i ;
+
+	g->xmin = xmax = g->xyz[0] ; g->ymin = ymax = g->xyz[1] ; g->zmin = zmax = g->xyz[2] ;
+	for(i = 1 ; i < g->n ; i++) {
+		if(g->xyz[3*i] < g->xmin) g->xmin = g->xyz[3*i] ;
+		if(g->xyz[3*i] > xmax) xmax = g->xyz[3*i] ;
+		if(g->xyz[3*i+1] < g->ymin) g->ymin = g->xyz[3*i+1] ;
+		if(g->xyz[3*i+1] > ymax) ymax = g->xyz[3*i+1] ;
+		if(g->xyz[3*i+2] < g->zmin) g->zmin = g->xyz[3*i+2] ;
+		if(g->xyz[3*i+2] > zmax) zmax = g->xyz[3*i+2] ;
+	}
+
+	/* No more than ~8 cells per alpha sphere */
+	g->cs = (dmax > 0.01) ? dmax : 0.01 ;
+	while(((double)(xmax-g->xmin)/g->cs + 1.0) * ((double)(ymax-g->ymin)/g->cs + 1.0)
+		  * ((double)(zmax-g->zmin)/g->cs + 1.0) > 8.0*g->n + 64.0) g->cs *= 2.0 ;
+
+	g->nx = (int)((xmax-g->xmin)/g->cs) + 1 ;
+	g->ny = (int)((ymax-g->ymin)/g->cs) + 1 ;
+	g->nz = (int)((zmax-g->zmin)/g->cs) + 1 ;
+	ncell = g->nx*g->ny*g->nz ;
+
+	/* Counting sort of the alpha spheres by cell */
+	g->cstart = (int *) my_calloc(ncell+1, sizeof(int)) ;
+	for(i = 0 ; i < g->n ; i++) {
+		int cx = (int)((g->xyz[3*i]-g->xmin)/g->cs),
+			cy = (int)((g->xyz[3*i+1]-g->ymin)/g->cs),
+			cz = (int)((g->xyz[3*i+2]-g->zmin)/g->cs) ;
+		if(cx >= g->nx) cx = g->nx-1 ;
+		if(cy >= g->ny) cy = g->ny-1 ;
+		if(cz >= g->nz) cz = g->nz-1 ;
+		g->cell[i] = (cz*g->ny + cy)*g->nx + cx ;
+		g->cstart[g->cell[i]+1]++ ;
+	}
+	for(i = 0 ; i < ncell ; i++) g->cstart[i+1] += g->cstart[i] ;
+	for(i = 0 ; i < g->n ; i++) g->cvert[g->cstart[g->cell[i]]++] = i ;
+	for(i = ncell ; i > 0 ; i--) g->cstart[i] = g->cstart[i-1] ;
+	g->cstart[0] = 0 ;
+
+	g->rstart = NULL ;
+	g->rpock = NULL ;
+	g->rcnt = NULL ;
+	g->npair = 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION:
+	set_mlgrid_pairs
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Count, for each pair of pockets p < q, the pairs of alpha spheres closer
+	than dmax (same criteria as pck_ml_clust_naive), looking for the alpha
+	spheres of p in the 27 cells around them only.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_mlgrid *g : The grid
+	@ float dmax  : Distance criteria
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void set_mlgrid_pairs(s_mlgrid *g, float dmax)
+{
+	int i, k, p, q, f, cx, cy, cz, x, y, z, cell, ntouch,
+		nalloc = g->np + 16 ;
+	int *cnt = (int *) my_calloc(g->np, sizeof(int)),
+		*touch = (int *) my_malloc(g->np*sizeof(int)) ;
+	float *v = NULL ;
+
+	g->rstart = (int *) my_malloc((g->np+1)*sizeof(int)) ;
+	g->rpock = (int *) my_malloc(nalloc*sizeof(int)) ;
+	g->rcnt = (int *) my_malloc(nalloc*sizeof(int)) ;
+	g->npair = 0 ;
+
+	for(p = 0 ; p < g->np ; p++) {
+		g->rstart[p] = g->npair ;
+		ntouch = 0 ;
+		for(i = g->pstart[p] ; i < g->pstart[p+1] ; i++) {
+			v = g->xyz + 3*i ;
+			cx = g->cell[i] % g->nx ;
+			cy = (g->cell[i] / g->nx) % g->ny ;
+			cz = g->cell[i] / (g->nx*g->ny) ;
+
+			for(z = cz-1 ; z <= cz+1 ; z++) {
+				if(z < 0 || z >= g->nz) continue ;
+				for(y = cy-1 ; y <= cy+1 ; y++) {
+					if(y < 0 || y >= g->ny) continue ;
+					for(x = cx-1 ; x <= cx+1 ; x++) {
+						if(x < 0 || x >= g->nx) continue ;
+						cell = (z*g->ny + y)*g->nx + x ;
+						for(k = g->cstart[cell] ; k < g->cstart[cell+1] ; k++) {
+							f = g->cvert[k] ;
+							q = g->pock[f] ;
+							if(q <= p) continue ;
+							if(dist(v[0], v[1], v[2], g->xyz[3*f], g->xyz[3*f+1],
+									g->xyz[3*f+2]) < dmax) {
+								if(cnt[q] == 0) touch[ntouch++] = q ;
+								cnt[q]++ ;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		if(g->npair + ntouch > nalloc) {
+			nalloc = 2*(g->npair + ntouch) ;
+			g->rpock = (int *) my_realloc(g->rpock, nalloc*sizeof(int)) ;
+			g->rcnt = (int *) my_realloc(g->rcnt, nalloc*sizeof(int)) ;
+		}
+		for(k = 0 ; k < ntouch ; k++) {
+			g->rpock[g->npair] = touch[k] ;
+			g->rcnt[g->npair++] = cnt[touch[k]] ;
+			cnt[touch[k]] = 0 ;
+		}
+	}
+	g->rstart[g->np] = g->npair ;
+
+	my_free(cnt) ;
+	my_free(touch) ;
+}
+
+static void free_mlgrid(s_mlgrid *g)
+{
+	my_free(g->xyz) ;
+	my_free(g->pstart) ;
+	my_free(g->pock) ;
+	my_free(g->cell) ;
+	my_free(g->cstart) ;
+	my_free(g->cvert) ;
+	my_free(g->rstart) ;
+	my_free(g->rpock) ;
+	my_free(g->rcnt) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION: 
+	void pck_ml_clust_naive(c_lst_pockets *pockets, s_fparams *params)
+   -----------------------------------------------------------------------------
    ## SPECIFICATION: 
+	Reference implementation of pck_ml_clust (M_MLCLUST_ORDER), comparing
+	every pair of alpha spheres of every pair of pockets.
 	This function will apply a mutliple linkage clustering algorithm on the given
 	list of pockets. Considering two pockets, if params->ml_clust_min_nneigh
 	alpha spheres are separated by a distance lower than params->ml_clust_max_dist,
@@ -86,7 +510,7 @@
 	void
    -----------------------------------------------------------------------------
 */
-void pck_ml_clust(c_lst_pockets *pockets, s_fparams *params)
+void pck_ml_clust_naive(c_lst_pockets *pockets, s_fparams *params)
 {
 	node_pocket *pcur = NULL,
 				*pnext = NULL ,
@@ -0,0 +1,1102 @@
+#include "../headers/delaunay.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					delaunay.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	A 3D Delaunay triangulation engine, used instead of qhull when asked
+##	(see set_delaunay_engine in voronoi.c). It gives the same output as
+##	run_qvoronoi_mem: the circumcenter, 4 points and 4 neighbours of each
+##	Delaunay tetrahedron (each voronoi vertex).
+##
+##	The triangulation is built by incremental insertion (Bowyer-Watson):
+##	  - points are inserted in a biased randomized order (BRIO), each round
+##	    being sorted along a Hilbert curve, so the walk locating a point
+##	    starts next to it;
+##	  - the convex hull is closed by tetrahedra joining each hull face to a
+##	    point at infinity, so no bounding tetrahedron is needed;
+##	  - orientation and insphere predicates are exact: they are first
+##	    computed with doubles and an error bound, and again with exact
+##	    expansion arithmetic (Shewchuk, 1997) when the sign is not certain;
+##	  - tetrahedra are stored in a single growing array, those destroyed by
+##	    an insertion being reused by the next ones.
+##
+##	Duplicated points are skipped, as qhull does.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     get_dt_center is public
+##	17-10-30	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+/* Error free transformations below need each operation to be rounded */
+#ifdef __GNUC__
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+/* A tetrahedron: n[i] is the neighbour opposite to v[i]. Finite tetrahedra
+ * are positively oriented (orient3d(v0, v1, v2, v3) > 0), and the others
+ * would be if M_DT_INF was replaced by a point outside the hull. */
+typedef struct s_dtet
+{
+	int v[4],
+		n[4],
+		mark ;		/* Insertion stamp: > 0 in conflict, < 0 tested not */
+
+} s_dtet ;
+
+/* A face on the boundary of the cavity of an inserted point */
+typedef struct s_dbnd
+{
+	int v[4],		/* Vertices of the new tetrahedron */
+		face,		/* Position of the new point in v */
+		out,		/* Tetrahedron on the other side of the face */
+		outface ;	/* Position of the face in out */
+
+} s_dbnd ;
+
+/* New tetrahedra waiting for their neighbour across an edge */
+typedef struct s_dedge
+{
+	uint64_t key ;
+	int tet,
+		face ;
+
+} s_dedge ;
+
+typedef struct s_dtri
+{
+	const double *xyz ;
+	int npts ;
+
+	s_dtet *tets ;		/* Arena of tetrahedra */
+	int ntets,
+		nalloc,
+		*free_tets,		/* Free tetrahedra of the arena */
+		nfree,
+		last,			/* Last created tetrahedron (start of the walk) */
+		stamp ;
+
+	int *cav,			/* Tetrahedra of the current cavity */
+		ncav,
+		cav_alloc ;
+
+	s_dbnd *bnd ;		/* Boundary of the current cavity */
+	int nbnd,
+		bnd_alloc ;
+
+	s_dedge *edges ;	/* Hash table of edges of new tetrahedra */
+	int edge_bits ;
+
+	double *exact ;		/* Buffer for exact arithmetic */
+	unsigned int rng ;
+
+} s_dtri ;
+
+/* Hilbert key of a point, used to sort the points */
+typedef struct s_dkey
+{
+	uint64_t key ;
+	int id ;
+
+} s_dkey ;
+
+static double orient3d(s_dtri *dt, const double *a, const double *b,
+					   const double *c, const double *d) ;
+static double insphere(s_dtri *dt, const double *a, const double *b,
+					   const double *c, const double *d, const double *e) ;
+static double orient3d_exact(const double *a, const double *b,
+							 const double *c, const double *d) ;
+static double insphere_exact(s_dtri *dt, const double *a, const double *b,
+							 const double *c, const double *d, const double *e) ;
+
+static int init_dtri(s_dtri *dt, int *order, int n) ;
+static int insert_point(s_dtri *dt, int ip) ;
+static int locate_point(s_dtri *dt, const double *p) ;
+static int is_in_conflict(s_dtri *dt, int t, const double *p) ;
+static int new_tet(s_dtri *dt) ;
+static void link_new_tet(s_dtri *dt, int t, int face) ;
+static int* get_brio_order(const double *xyz, int n, unsigned int *rng) ;
+static uint64_t get_hilbert_key(unsigned int *x) ;
+static int cmp_dkey(const void *a, const void *b) ;
+static unsigned int dt_rand(unsigned int *rng) ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	run_delaunay_mem
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Delaunay triangulation of a set of 3D points. Same interface and output
+	as run_qvoronoi_mem: fbegin is called with the number of tetrahedra + 1,
+	then fvert for each tetrahedron with its index, circumcenter, points and
+	neighbours (indexes of neighbouring tetrahedra, -1 on the convex hull).
+	vneigh[i] is the tetrahedron opposite to pts[i]. Indexes start at 1, as
+	0 is taken as no neighbour when vertices are stored (see fill_vvertice).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ double *xyz             : Coordinates of the points
+	@ int numpoints           : Number of points
+	@ qvoronoi_begin_fct fbegin : Called once with the number of tetrahedra
+	@ qvoronoi_vert_fct fvert : Called for each tetrahedron
+	@ void *data              : Given to callbacks
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_DELAUNAY_SUCCESS, or an error code.
+   -----------------------------------------------------------------------------
+*/
+int run_delaunay_mem(double *xyz, int numpoints, qvoronoi_begin_fct fbegin,
+					 qvoronoi_vert_fct fvert, void *data)
+{
+	int i, j, t, nfinite, status ;
+	int *order = NULL,
+		*idx = NULL ;
+	int vneigh[4] ;
+	double center[3] ;
+	s_dtet *tet = NULL ;
+	s_dtri dt ;
+
+	memset(&dt, 0, sizeof(s_dtri)) ;
+	dt.xyz = xyz ;
+	dt.npts = numpoints ;
+	dt.rng = 12345 ;
+
+	if(numpoints < 4) return M_DELAUNAY_FLAT ;
+
+	order = get_brio_order(xyz, numpoints, &(dt.rng)) ;
+	status = init_dtri(&dt, order, numpoints) ;
+
+	for(i = 0 ; i < numpoints && status == M_DELAUNAY_SUCCESS ; i++) {
+		if(order[i] >= 0) status = insert_point(&dt, order[i]) ;
+	}
+
+	if(status == M_DELAUNAY_SUCCESS) {
+		/* Number the finite tetrahedra, in the order of the arena */
+		idx = (int *) my_malloc(dt.ntets*sizeof(int)) ;
+		nfinite = 1 ;
+		for(t = 0 ; t < dt.ntets ; t++) {
+			tet = dt.tets + t ;
+			idx[t] = (tet->v[0] == M_DT_DEAD || tet->v[0] == M_DT_INF
+					  || tet->v[1] == M_DT_INF || tet->v[2] == M_DT_INF
+					  || tet->v[3] == M_DT_INF) ? -1 : nfinite++ ;
+		}
+
+		fbegin(data, nfinite) ;
+		for(t = 0 ; t < dt.ntets ; t++) {
+			if(idx[t] < 0) continue ;
+
+			tet = dt.tets + t ;
+			get_dt_center(xyz + 3*tet->v[0], xyz + 3*tet->v[1],
+						  xyz + 3*tet->v[2], xyz + 3*tet->v[3], center) ;
+			for(j = 0 ; j < 4 ; j++) vneigh[j] = idx[tet->n[j]] ;
+			fvert(data, idx[t], center, tet->v, vneigh) ;
+		}
+		my_free(idx) ;
+	}
+
+	my_free(order) ;
+	if(dt.tets) my_free(dt.tets) ;
+	if(dt.cav) my_free(dt.cav) ;
+	if(dt.bnd) my_free(dt.bnd) ;
+	if(dt.edges) my_free(dt.edges) ;
+	if(dt.free_tets) my_free(dt.free_tets) ;
+	if(dt.exact) my_free(dt.exact) ;
+
+	return status ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	init_dtri
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Build the first tetrahedron (and the 4 tetrahedra joining its faces to
+	the point at infinity). Its points are chosen far from each other, and
+	are removed from the insertion order (set to -1).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt  : The triangulation
+	@ int *order  : Insertion order of the points
+	@ int n       : Number of points
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_DELAUNAY_SUCCESS, M_DELAUNAY_FLAT if all points are coplanar.
+   -----------------------------------------------------------------------------
+*/
+static int init_dtri(s_dtri *dt, int *order, int n)
+{
+	const double *xyz = dt->xyz ;
+	int i, j, k, t, p[4] ;
+	double d, best, u[3], v[3], w[3] ;
+	s_dtet *tet = NULL ;
+
+	/* First point: the first inserted one, then the farthest from it, the
+	 * farthest from their line, and the farthest from their plane. */
+	p[0] = order[0] ;
+	p[1] = p[2] = p[3] = -1 ;
+	best = 0.0 ;
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) u[k] = xyz[3*i+k] - xyz[3*p[0]+k] ;
+		d = u[0]*u[0] + u[1]*u[1] + u[2]*u[2] ;
+		if(d > best) { best = d ; p[1] = i ; }
+	}
+	if(p[1] < 0) return M_DELAUNAY_FLAT ;
+
+	best = 0.0 ;
+	for(k = 0 ; k < 3 ; k++) u[k] = xyz[3*p[1]+k] - xyz[3*p[0]+k] ;
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) v[k] = xyz[3*i+k] - xyz[3*p[0]+k] ;
+		w[0] = u[1]*v[2] - u[2]*v[1] ;
+		w[1] = u[2]*v[0] - u[0]*v[2] ;
+		w[2] = u[0]*v[1] - u[1]*v[0] ;
+		d = w[0]*w[0] + w[1]*w[1] + w[2]*w[2] ;
+		if(d > best) { best = d ; p[2] = i ; }
+	}
+	if(p[2] < 0) return M_DELAUNAY_FLAT ;
+
+	best = 0.0 ;
+	for(i = 0 ; i < n ; i++) {
+		d = fabs(orient3d(dt, xyz + 3*p[0], xyz + 3*p[1], xyz + 3*p[2],
+						  xyz + 3*i)) ;
+		if(d > best) { best = d ; p[3] = i ; }
+	}
+	if(p[3] < 0) return M_DELAUNAY_FLAT ;
+
+	if(orient3d(dt, xyz + 3*p[0], xyz + 3*p[1], xyz + 3*p[2], xyz + 3*p[3]) < 0) {
+		i = p[0] ; p[0] = p[1] ; p[1] = i ;
+	}
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 4 ; k++) if(order[i] == p[k]) order[i] = -1 ;
+	}
+
+	/* Tetrahedron 0 is the finite one, tetrahedron 1+i is opposite to p[i]:
+	 * p[i] is replaced by the point at infinity, and two other points are
+	 * swapped to keep the orientation. */
+	for(t = 0 ; t < 5 ; t++) new_tet(dt) ;
+	tet = dt->tets ;
+	for(i = 0 ; i < 4 ; i++) {
+		tet->v[i] = p[i] ;
+		tet->n[i] = 1 + i ;
+	}
+	for(i = 0 ; i < 4 ; i++) {
+		tet = dt->tets + 1 + i ;
+		for(k = 0 ; k < 4 ; k++) tet->v[k] = p[k] ;
+		tet->v[i] = M_DT_INF ;
+		j = (i + 1) % 4 ; k = (i + 2) % 4 ;
+		tet->v[j] = p[k] ;
+		tet->v[k] = p[j] ;
+	}
+	/* Neighbours of ghost i: tetrahedron 0 opposite to the point at
+	 * infinity, and the ghost lacking p[j] opposite to p[j]. */
+	for(i = 0 ; i < 4 ; i++) {
+		tet = dt->tets + 1 + i ;
+		for(k = 0 ; k < 4 ; k++) {
+			if(tet->v[k] == M_DT_INF) tet->n[k] = 0 ;
+			else {
+				for(j = 0 ; j < 4 ; j++) if(p[j] == tet->v[k]) break ;
+				tet->n[k] = 1 + j ;
+			}
+		}
+	}
+	dt->last = 0 ;
+
+	return M_DELAUNAY_SUCCESS ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	insert_point
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Insert a point: the tetrahedra whose circumsphere contains it (the
+	cavity) are replaced by tetrahedra joining the point to the faces of the
+	cavity boundary.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt : The triangulation
+	@ int ip     : Index of the point
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_DELAUNAY_SUCCESS, M_DELAUNAY_LOST if the point can't be located.
+   -----------------------------------------------------------------------------
+*/
+static int insert_point(s_dtri *dt, int ip)
+{
+	const double *p = dt->xyz + 3*ip ;
+	int i, j, k, t, u, top, nedges ;
+	s_dtet *tet = NULL ;
+	s_dbnd *b = NULL ;
+
+	t = locate_point(dt, p) ;
+	if(t < 0) return M_DELAUNAY_LOST ;
+
+	tet = dt->tets + t ;
+	for(i = 0 ; i < 4 ; i++) {
+		if(tet->v[i] != M_DT_INF && dt->xyz[3*tet->v[i]] == p[0]
+		   && dt->xyz[3*tet->v[i]+1] == p[1] && dt->xyz[3*tet->v[i]+2] == p[2]) {
+			return M_DELAUNAY_SUCCESS ;		/* Duplicated point */
+		}
+	}
+
+	/* Cavity: tetrahedra in conflict connected to the first one. The list
+	 * of the cavity is also used as a stack. */
+	dt->stamp++ ;
+	dt->ncav = 0 ;
+	dt->nbnd = 0 ;
+	tet->mark = dt->stamp ;
+	dt->cav[dt->ncav++] = t ;
+
+	for(top = 0 ; top < dt->ncav ; top++) {
+		t = dt->cav[top] ;
+		for(i = 0 ; i < 4 ; i++) {
+			u = dt->tets[t].n[i] ;
+			if(dt->tets[u].mark != dt->stamp && dt->tets[u].mark != -dt->stamp) {
+				if(is_in_conflict(dt, u, p)) {
+					dt->tets[u].mark = dt->stamp ;
+					if(dt->ncav >= dt->cav_alloc) {
+						dt->cav_alloc *= 2 ;
+						dt->cav = (int *) my_realloc(dt->cav, dt->cav_alloc*sizeof(int)) ;
+					}
+					dt->cav[dt->ncav++] = u ;
+					continue ;
+				}
+				dt->tets[u].mark = -dt->stamp ;
+			}
+			if(dt->tets[u].mark == dt->stamp) continue ;
+
+			/* Face on the cavity boundary */
+			if(dt->nbnd >= dt->bnd_alloc) {
+				dt->bnd_alloc *= 2 ;
+				dt->bnd = (s_dbnd *) my_realloc(dt->bnd, dt->bnd_alloc*sizeof(s_dbnd)) ;
+			}
+			b = dt->bnd + dt->nbnd++ ;
+			for(k = 0 ; k < 4 ; k++) b->v[k] = dt->tets[t].v[k] ;
+			b->v[i] = ip ;
+			b->face = i ;
+			b->out = u ;
+			for(k = 0 ; k < 4 ; k++) if(dt->tets[u].n[k] == t) b->outface = k ;
+		}
+	}
+
+	/* Edge table: at least twice the number of edges of new faces */
+	nedges = 3*dt->nbnd ;
+	if((1 << dt->edge_bits) < 2*nedges) {
+		while((1 << dt->edge_bits) < 2*nedges) dt->edge_bits++ ;
+		if(dt->edges) my_free(dt->edges) ;
+		dt->edges = (s_dedge *) my_malloc((1 << dt->edge_bits)*sizeof(s_dedge)) ;
+	}
+	for(i = 0 ; i < (1 << dt->edge_bits) ; i++) dt->edges[i].key = UINT64_MAX ;
+
+	/* New tetrahedra: slots of the cavity first, then new ones. In 3D the
+	 * cavity may have more tetrahedra than boundary faces: remaining slots
+	 * are freed. */
+	for(j = 0 ; j < dt->nbnd ; j++) {
+		b = dt->bnd + j ;
+		t = (j < dt->ncav) ? dt->cav[j] : new_tet(dt) ;
+		tet = dt->tets + t ;
+		for(k = 0 ; k < 4 ; k++) tet->v[k] = b->v[k] ;
+		tet->n[b->face] = b->out ;
+		tet->mark = 0 ;
+		dt->tets[b->out].n[b->outface] = t ;
+		link_new_tet(dt, t, b->face) ;
+	}
+	dt->last = t ;
+
+	for(j = dt->nbnd ; j < dt->ncav ; j++) {
+		dt->tets[dt->cav[j]].v[0] = M_DT_DEAD ;
+		dt->free_tets[dt->nfree++] = dt->cav[j] ;
+	}
+
+	return M_DELAUNAY_SUCCESS ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	link_new_tet
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Link a new tetrahedron to the other new ones: each face containing the
+	new point is shared with the new tetrahedron having the same edge of the
+	cavity boundary.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt : The triangulation
+	@ int t      : The new tetrahedron
+	@ int face   : Position of the new point in t
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void link_new_tet(s_dtri *dt, int t, int face)
+{
+	s_dtet *tet = dt->tets + t ;
+	s_dedge *e = NULL ;
+	int j, k, a, b, tmp ;
+	uint64_t key, mask = (1 << dt->edge_bits) - 1, h ;
+
+	for(j = 0 ; j < 4 ; j++) {
+		if(j == face) continue ;
+
+		/* Edge of the face opposite to v[j], without the new point */
+		a = b = M_DT_INF - 1 ;
+		for(k = 0 ; k < 4 ; k++) {
+			if(k == j || k == face) continue ;
+			if(a == M_DT_INF - 1) a = tet->v[k] ;
+			else b = tet->v[k] ;
+		}
+		if(a > b) { tmp = a ; a = b ; b = tmp ; }
+		key = (uint64_t)(a + 1) * (uint64_t)(dt->npts + 1) + (uint64_t)(b + 1) ;
+
+		h = (key * 0x9E3779B97F4A7C15ULL) >> (64 - dt->edge_bits) ;
+		for(;;) {
+			e = dt->edges + h ;
+			if(e->key == UINT64_MAX) {
+				e->key = key ;
+				e->tet = t ;
+				e->face = j ;
+				break ;
+			}
+			if(e->key == key && e->tet >= 0) {
+				tet->n[j] = e->tet ;
+				dt->tets[e->tet].n[e->face] = t ;
+				e->tet = -1 ;
+				break ;
+			}
+			h = (h + 1) & mask ;
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	locate_point
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Find a tetrahedron in conflict with a point: walk from the last created
+	tetrahedron towards the point, crossing faces separating them (in a
+	random order, so the walk can't cycle). Ends in the finite tetrahedron
+	containing the point, or in a tetrahedron outside the hull.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt      : The triangulation
+	@ const double *p : The point
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: the tetrahedron, -1 if the walk was too long.
+   -----------------------------------------------------------------------------
+*/
+static int locate_point(s_dtri *dt, const double *p)
+{
+	const double *q[4] ;
+	const double *tmp ;
+	int i, j, k, start, moved, nstep = 0,
+		t = dt->last ;
+	s_dtet *tet = dt->tets + t ;
+
+	for(i = 0 ; i < 4 ; i++) if(tet->v[i] == M_DT_INF) t = tet->n[i] ;
+
+	while(nstep++ <= dt->ntets) {
+		tet = dt->tets + t ;
+		for(i = 0 ; i < 4 ; i++) {
+			if(tet->v[i] == M_DT_INF) return t ;
+			q[i] = dt->xyz + 3*tet->v[i] ;
+		}
+
+		moved = 0 ;
+		start = dt_rand(&(dt->rng)) & 3 ;
+		for(j = 0 ; j < 4 && !moved ; j++) {
+			k = (start + j) & 3 ;
+			tmp = q[k] ;
+			q[k] = p ;
+			if(orient3d(dt, q[0], q[1], q[2], q[3]) < 0) {
+				t = tet->n[k] ;
+				moved = 1 ;
+			}
+			q[k] = tmp ;
+		}
+		if(!moved) return t ;
+	}
+
+	return -1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	is_in_conflict
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Say if a point is strictly inside the circumsphere of a tetrahedron. For
+	a tetrahedron with the point at infinity, it is the case when the point
+	is strictly outside its hull face, or on its plane and in conflict with
+	the finite tetrahedron on the other side.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt      : The triangulation
+	@ int t           : The tetrahedron
+	@ const double *p : The point
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if in conflict, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int is_in_conflict(s_dtri *dt, int t, const double *p)
+{
+	s_dtet *tet = dt->tets + t ;
+	const double *q[4] ;
+	double o ;
+	int i, inf = -1 ;
+
+	for(i = 0 ; i < 4 ; i++) {
+		if(tet->v[i] == M_DT_INF) {
+			inf = i ;
+			q[i] = p ;
+		}
+		else q[i] = dt->xyz + 3*tet->v[i] ;
+	}
+	if(inf < 0) return insphere(dt, q[0], q[1], q[2], q[3], p) > 0 ;
+
+	o = orient3d(dt, q[0], q[1], q[2], q[3]) ;
+	if(o != 0) return o > 0 ;
+
+	return is_in_conflict(dt, tet->n[inf], p) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	new_tet
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get a new tetrahedron from the arena: a free one if any, else the next
+	one (the arena and the working arrays are allocated on the first call).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_dtri *dt : The triangulation
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: index of the tetrahedron
+   -----------------------------------------------------------------------------
+*/
+static int new_tet(s_dtri *dt)
+{
+	int t ;
+
+	if(dt->nfree > 0) {
+		t = dt->free_tets[--dt->nfree] ;
+		dt->tets[t].mark = 0 ;
+		return t ;
+	}
+
+	if(dt->ntets >= dt->nalloc) {
+		if(dt->nalloc == 0) {
+			/* About 6.5 tetrahedra per point */
+			dt->nalloc = 7*dt->npts + 64 ;
+			dt->tets = (s_dtet *) my_malloc(dt->nalloc*sizeof(s_dtet)) ;
+			dt->free_tets = (int *) my_malloc(dt->nalloc*sizeof(int)) ;
+			dt->cav_alloc = dt->bnd_alloc = 64 ;
+			dt->cav = (int *) my_malloc(dt->cav_alloc*sizeof(int)) ;
+			dt->bnd = (s_dbnd *) my_malloc(dt->bnd_alloc*sizeof(s_dbnd)) ;
+		}
+		else {
+			dt->nalloc *= 2 ;
+			dt->tets = (s_dtet *) my_realloc(dt->tets, dt->nalloc*sizeof(s_dtet)) ;
+			dt->free_tets = (int *) my_realloc(dt->free_tets, dt->nalloc*sizeof(int)) ;
+		}
+	}
+	dt->tets[dt->ntets].mark = 0 ;
+
+	return dt->ntets++ ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_dt_center
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Circumcenter of a tetrahedron. Also used by voronoi.c to give the same
+	center to an alpha sphere whatever the tesselation it comes from.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const double *a, *b, *c, *d : The points
+	@ double *center             : OUTPUT, the center
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void get_dt_center(const double *a, const double *b, const double *c,
+				   const double *d, double *center)
+{
+	double bx = b[0] - a[0], by = b[1] - a[1], bz = b[2] - a[2],
+		   cx = c[0] - a[0], cy = c[1] - a[1], cz = c[2] - a[2],
+		   dx = d[0] - a[0], dy = d[1] - a[1], dz = d[2] - a[2] ;
+	double lb = bx*bx + by*by + bz*bz,
+		   lc = cx*cx + cy*cy + cz*cz,
+		   ld = dx*dx + dy*dy + dz*dz ;
+	double cdx = cy*dz - cz*dy, cdy = cz*dx - cx*dz, cdz = cx*dy - cy*dx,
+		   dbx = dy*bz - dz*by, dby = dz*bx - dx*bz, dbz = dx*by - dy*bx,
+		   bcx = by*cz - bz*cy, bcy = bz*cx - bx*cz, bcz = bx*cy - by*cx ;
+	double den = 2.0 * (bx*cdx + by*cdy + bz*cdz) ;
+
+	center[0] = a[0] + (lb*cdx + lc*dbx + ld*bcx) / den ;
+	center[1] = a[1] + (lb*cdy + lc*dby + ld*bcy) / den ;
+	center[2] = a[2] + (lb*cdz + lc*dbz + ld*bcz) / den ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_brio_order
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Biased randomized insertion order: points are shuffled, split in rounds
+	of growing size (the last one holds half of the points, the one before
+	a quarter...), and each round is sorted along a Hilbert curve.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const double *xyz  : Coordinates of the points
+	@ int n              : Number of points
+	@ unsigned int *rng  : Random generator state
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int *: the insertion order
+   -----------------------------------------------------------------------------
+*/
+static int* get_brio_order(const double *xyz, int n, unsigned int *rng)
+{
+	int i, j, k, tmp, end, beg ;
+	int *order = (int *) my_malloc(n*sizeof(int)) ;
+	s_dkey *keys = (s_dkey *) my_malloc(n*sizeof(s_dkey)) ;
+	double min[3], max[3], scale ;
+	unsigned int x[3] ;
+
+	for(i = 0 ; i < n ; i++) order[i] = i ;
+	for(i = n - 1 ; i > 0 ; i--) {
+		j = dt_rand(rng) % (i + 1) ;
+		tmp = order[i] ; order[i] = order[j] ; order[j] = tmp ;
+	}
+
+	for(k = 0 ; k < 3 ; k++) min[k] = max[k] = xyz[k] ;
+	for(i = 1 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) {
+			if(xyz[3*i+k] < min[k]) min[k] = xyz[3*i+k] ;
+			if(xyz[3*i+k] > max[k]) max[k] = xyz[3*i+k] ;
+		}
+	}
+	scale = 0.0 ;
+	for(k = 0 ; k < 3 ; k++) if(max[k] - min[k] > scale) scale = max[k] - min[k] ;
+	scale = (scale > 0.0) ? ((1 << M_DT_HILBERT_BITS) - 1) / scale : 0.0 ;
+
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++)
+			x[k] = (unsigned int) ((xyz[3*order[i]+k] - min[k]) * scale) ;
+		keys[i].key = get_hilbert_key(x) ;
+		keys[i].id = order[i] ;
+	}
+
+	/* Rounds, from the last (biggest) one */
+	end = n ;
+	while(end > 0) {
+		beg = (end > M_DT_BRIO_MIN) ? end / 2 : 0 ;
+		qsort(keys + beg, end - beg, sizeof(s_dkey), cmp_dkey) ;
+		end = beg ;
+	}
+	for(i = 0 ; i < n ; i++) order[i] = keys[i].id ;
+	my_free(keys) ;
+
+	return order ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_hilbert_key
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Position of a point of the grid along the Hilbert curve (J. Skilling,
+	Programming the Hilbert curve, 2004).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ unsigned int *x : Grid coordinates (M_DT_HILBERT_BITS bits), modified
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	uint64_t: the key
+   -----------------------------------------------------------------------------
+*/
+static uint64_t get_hilbert_key(unsigned int *x)
+{
+	unsigned int m = 1U << (M_DT_HILBERT_BITS - 1), p, q, t ;
+	uint64_t key = 0 ;
+	int i, b ;
+
+	/* Inverse undo */
+	for(q = m ; q > 1 ; q >>= 1) {
+		p = q - 1 ;
+		for(i = 0 ; i < 3 ; i++) {
+			if(x[i] & q) x[0] ^= p ;
+			else {
+				t = (x[0] ^ x[i]) & p ;
+				x[0] ^= t ;
+				x[i] ^= t ;
+			}
+		}
+	}
+	/* Gray encode */
+	for(i = 1 ; i < 3 ; i++) x[i] ^= x[i-1] ;
+	t = 0 ;
+	for(q = m ; q > 1 ; q >>= 1) if(x[2] & q) t ^= q - 1 ;
+	for(i = 0 ; i < 3 ; i++) x[i] ^= t ;
+
+	for(b = M_DT_HILBERT_BITS - 1 ; b >= 0 ; b--) {
+		for(i = 0 ; i < 3 ; i++) key = (key << 1) | ((x[i] >> b) & 1) ;
+	}
+
+	return key ;
+}
+
+static int cmp_dkey(const void *a, const void *b)
+{
+	const s_dkey *ka = (const s_dkey *) a,
+				 *kb = (const s_dkey *) b ;
+
+	if(ka->key != kb->key) return (ka->key < kb->key) ? -1 : 1 ;
+	return ka->id - kb->id ;
+}
+
+/* Linear congruential generator, so the order doesn't depend on rand() */
+static unsigned int dt_rand(unsigned int *rng)
+{
+	*rng = *rng * 1103515245U + 12345U ;
+	return *rng >> 8 ;
+}
+
+/* ------------------------- EXACT PREDICATES --------------------------------*/
+
+/* Expansions are sums of non overlapping doubles, by increasing magnitude
+ * (J. R. Shewchuk, Adaptive precision floating-point arithmetic and fast
+ * robust geometric predicates, 1997). */
+
+#define M_DT_SPLITTER 134217729.0			/* 2^27 + 1 */
+#define M_DT_EPSILON 1.1102230246251565e-16	/* 2^-53 */
+#define M_DT_O3D_ERR ((7.0 + 56.0*M_DT_EPSILON)*M_DT_EPSILON)
+#define M_DT_ISP_ERR ((16.0 + 224.0*M_DT_EPSILON)*M_DT_EPSILON)
+
+#define TWO_SUM(a, b, x, y) { double bv_, av_ ; x = a + b ; bv_ = x - a ; \
+	av_ = x - bv_ ; y = (a - av_) + (b - bv_) ; }
+#define FAST_TWO_SUM(a, b, x, y) { x = a + b ; y = b - (x - a) ; }
+#define TWO_DIFF(a, b, x, y) { double bv_, av_ ; x = a - b ; bv_ = a - x ; \
+	av_ = x + bv_ ; y = (a - av_) + (bv_ - b) ; }
+#define SPLIT(a, hi, lo) { double c_ = M_DT_SPLITTER * a ; \
+	hi = c_ - (c_ - a) ; lo = a - hi ; }
+#define TWO_PRODUCT_PRESPLIT(a, b, bhi, blo, x, y) { double ahi_, alo_ ; \
+	x = a * b ; SPLIT(a, ahi_, alo_) ; \
+	y = alo_*blo - (((x - ahi_*bhi) - alo_*bhi) - ahi_*blo) ; }
+
+/* h = e + b, h may be e */
+static int grow_exp(int elen, const double *e, double b, double *h)
+{
+	double q = b, qn, hh, enow ;
+	int i, n = 0 ;
+
+	for(i = 0 ; i < elen ; i++) {
+		enow = e[i] ;
+		TWO_SUM(q, enow, qn, hh) ;
+		q = qn ;
+		if(hh != 0.0) h[n++] = hh ;
+	}
+	if(q != 0.0 || n == 0) h[n++] = q ;
+
+	return n ;
+}
+
+/* h = e + f, h has room for elen + flen values */
+static int sum_exp(int elen, const double *e, int flen, const double *f, double *h)
+{
+	int i, n = elen ;
+
+	if(h != e) memcpy(h, e, elen*sizeof(double)) ;
+	for(i = 0 ; i < flen ; i++) n = grow_exp(n, h, f[i], h) ;
+
+	return n ;
+}
+
+/* h = e * b, h has room for 2*elen values */
+static int scale_exp(int elen, const double *e, double b, double *h)
+{
+	double q, sum, hh, p1, p0, bhi, blo ;
+	int i, n = 0 ;
+
+	SPLIT(b, bhi, blo) ;
+	TWO_PRODUCT_PRESPLIT(e[0], b, bhi, blo, q, hh) ;
+	if(hh != 0.0) h[n++] = hh ;
+	for(i = 1 ; i < elen ; i++) {
+		TWO_PRODUCT_PRESPLIT(e[i], b, bhi, blo, p1, p0) ;
+		TWO_SUM(q, p0, sum, hh) ;
+		if(hh != 0.0) h[n++] = hh ;
+		FAST_TWO_SUM(p1, sum, q, hh) ;
+		if(hh != 0.0) h[n++] = hh ;
+	}
+	if(q != 0.0 || n == 0) h[n++] = q ;
+
+	return n ;
+}
+
+/* h = e * f, h has room for 2*elen*flen values, tmp for 2*elen */
+static int mul_exp(int elen, const double *e, int flen, const double *f,
+				   double *h, double *tmp)
+{
+	int i, n, tlen ;
+
+	n = scale_exp(elen, e, f[0], h) ;
+	for(i = 1 ; i < flen ; i++) {
+		tlen = scale_exp(elen, e, f[i], tmp) ;
+		n = sum_exp(n, h, tlen, tmp, h) ;
+	}
+
+	return n ;
+}
+
+static void neg_exp(int elen, double *e)
+{
+	int i ;
+	for(i = 0 ; i < elen ; i++) e[i] = -e[i] ;
+}
+
+/* h = a*b - c*d for 2 values expansions (16 values) */
+static int cross_exp(const double *a, const double *b, const double *c,
+					 const double *d, double *h)
+{
+	double t1[8], t2[8], tmp[4] ;
+	int n1 = mul_exp(2, a, 2, b, t1, tmp),
+		n2 = mul_exp(2, c, 2, d, t2, tmp) ;
+
+	neg_exp(n2, t2) ;
+	return sum_exp(n1, t1, n2, t2, h) ;
+}
+
+/* h = a*m1 + b*m2 + c*m3, a, b, c of 2 values, m1, m2, m3 of up to 16
+ * values (192 values) */
+static int det3_exp(const double *a, int n1, const double *m1,
+					const double *b, int n2, const double *m2,
+					const double *c, int n3, const double *m3, double *h)
+{
+	double t[64], tmp[32] ;
+	int n, tlen ;
+
+	n = mul_exp(n1, m1, 2, a, h, tmp) ;
+	tlen = mul_exp(n2, m2, 2, b, t, tmp) ;
+	n = sum_exp(n, h, tlen, t, h) ;
+	tlen = mul_exp(n3, m3, 2, c, t, tmp) ;
+
+	return sum_exp(n, h, tlen, t, h) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	orient3d
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Orientation of 4 points: positive if d is below the plane of a, b, c
+	(a, b, c counterclockwise seen from above), negative if above, 0 if
+	coplanar. The sign is exact.
+   -----------------------------------------------------------------------------
+*/
+static double orient3d(s_dtri *dt, const double *a, const double *b,
+					   const double *c, const double *d)
+{
+	double adx = a[0] - d[0], bdx = b[0] - d[0], cdx = c[0] - d[0],
+		   ady = a[1] - d[1], bdy = b[1] - d[1], cdy = c[1] - d[1],
+		   adz = a[2] - d[2], bdz = b[2] - d[2], cdz = c[2] - d[2] ;
+	double bdxcdy = bdx*cdy, cdxbdy = cdx*bdy,
+		   cdxady = cdx*ady, adxcdy = adx*cdy,
+		   adxbdy = adx*bdy, bdxady = bdx*ady ;
+	double det = adz*(bdxcdy - cdxbdy) + bdz*(cdxady - adxcdy)
+				 + cdz*(adxbdy - bdxady) ;
+	double perm = (fabs(bdxcdy) + fabs(cdxbdy))*fabs(adz)
+				  + (fabs(cdxady) + fabs(adxcdy))*fabs(bdz)
+				  + (fabs(adxbdy) + fabs(bdxady))*fabs(cdz) ;
+
+	if(det > M_DT_O3D_ERR*perm || -det > M_DT_O3D_ERR*perm) return det ;
+
+	return orient3d_exact(a, b, c, d) ;
+}
+
+static double orient3d_exact(const double *a, const double *b,
+							 const double *c, const double *d)
+{
+	double ax[2], ay[2], az[2], bx[2], by[2], bz[2], cx[2], cy[2], cz[2] ;
+	double bc[16], ca[16], ab[16], det[192] ;
+	int nbc, nca, nab, n ;
+
+	TWO_DIFF(a[0], d[0], ax[1], ax[0]) ;
+	TWO_DIFF(a[1], d[1], ay[1], ay[0]) ;
+	TWO_DIFF(a[2], d[2], az[1], az[0]) ;
+	TWO_DIFF(b[0], d[0], bx[1], bx[0]) ;
+	TWO_DIFF(b[1], d[1], by[1], by[0]) ;
+	TWO_DIFF(b[2], d[2], bz[1], bz[0]) ;
+	TWO_DIFF(c[0], d[0], cx[1], cx[0]) ;
+	TWO_DIFF(c[1], d[1], cy[1], cy[0]) ;
+	TWO_DIFF(c[2], d[2], cz[1], cz[0]) ;
+
+	nbc = cross_exp(bx, cy, cx, by, bc) ;
+	nca = cross_exp(cx, ay, ax, cy, ca) ;
+	nab = cross_exp(ax, by, bx, ay, ab) ;
+	n = det3_exp(az, nbc, bc, bz, nca, ca, cz, nab, ab, det) ;
+
+	return det[n-1] ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	insphere
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Positive if e is inside the sphere through a, b, c, d (positively
+	oriented), negative if outside, 0 if on it. The sign is exact.
+   -----------------------------------------------------------------------------
+*/
+static double insphere(s_dtri *dt, const double *a, const double *b,
+					   const double *c, const double *d, const double *e)
+{
+	double aex = a[0] - e[0], bex = b[0] - e[0], cex = c[0] - e[0], dex = d[0] - e[0],
+		   aey = a[1] - e[1], bey = b[1] - e[1], cey = c[1] - e[1], dey = d[1] - e[1],
+		   aez = a[2] - e[2], bez = b[2] - e[2], cez = c[2] - e[2], dez = d[2] - e[2] ;
+	double aexbey = aex*bey, bexaey = bex*aey, bexcey = bex*cey, cexbey = cex*bey,
+		   cexdey = cex*dey, dexcey = dex*cey, dexaey = dex*aey, aexdey = aex*dey,
+		   aexcey = aex*cey, cexaey = cex*aey, bexdey = bex*dey, dexbey = dex*bey ;
+	double ab = aexbey - bexaey, bc = bexcey - cexbey, cd = cexdey - dexcey,
+		   da = dexaey - aexdey, ac = aexcey - cexaey, bd = bexdey - dexbey ;
+	double abc = aez*bc - bez*ac + cez*ab,
+		   bcd = bez*cd - cez*bd + dez*bc,
+		   cda = cez*da + dez*ac + aez*cd,
+		   dab = dez*ab + aez*bd + bez*da ;
+	double alift = aex*aex + aey*aey + aez*aez,
+		   blift = bex*bex + bey*bey + bez*bez,
+		   clift = cex*cex + cey*cey + cez*cez,
+		   dlift = dex*dex + dey*dey + dez*dez ;
+	double det = (dlift*abc - clift*dab) + (blift*cda - alift*bcd) ;
+	double aezp = fabs(aez), bezp = fabs(bez), cezp = fabs(cez), dezp = fabs(dez),
+		   aexbeyp = fabs(aexbey), bexaeyp = fabs(bexaey), bexceyp = fabs(bexcey),
+		   cexbeyp = fabs(cexbey), cexdeyp = fabs(cexdey), dexceyp = fabs(dexcey),
+		   dexaeyp = fabs(dexaey), aexdeyp = fabs(aexdey), aexceyp = fabs(aexcey),
+		   cexaeyp = fabs(cexaey), bexdeyp = fabs(bexdey), dexbeyp = fabs(dexbey) ;
+	double perm = ((cexdeyp + dexceyp)*bezp + (dexbeyp + bexdeyp)*cezp
+				   + (bexceyp + cexbeyp)*dezp)*alift
+				+ ((dexaeyp + aexdeyp)*cezp + (aexceyp + cexaeyp)*dezp
+				   + (cexdeyp + dexceyp)*aezp)*blift
+				+ ((aexbeyp + bexaeyp)*dezp + (bexdeyp + dexbeyp)*aezp
+				   + (dexaeyp + aexdeyp)*bezp)*clift
+				+ ((bexceyp + cexbeyp)*aezp + (cexaeyp + aexceyp)*bezp
+				   + (aexbeyp + bexaeyp)*cezp)*dlift ;
+
+	if(det > M_DT_ISP_ERR*perm || -det > M_DT_ISP_ERR*perm) return det ;
+
+	return insphere_exact(dt, a, b, c, d, e) ;
+}
+
+/* Lift of a point: x^2 + y^2 + z^2 of 2 values expansions (24 values) */
+static int lift_exp(const double *x, const double *y, const double *z, double *h)
+{
+	double t[8], tmp[4] ;
+	int n, tlen ;
+
+	n = mul_exp(2, x, 2, x, h, tmp) ;
+	tlen = mul_exp(2, y, 2, y, t, tmp) ;
+	n = sum_exp(n, h, tlen, t, h) ;
+	tlen = mul_exp(2, z, 2, z, t, tmp) ;
+
+	return sum_exp(n, h, tlen, t, h) ;
+}
+
+static double insphere_exact(s_dtri *dt, const double *a, const double *b,
+							 const double *c, const double *d, const double *e)
+{
+	const double *pts[4] = {a, b, c, d} ;
+	double x[4][2], y[4][2], z[4][2], lift[4][24] ;
+	double ab[16], bc[16], cd[16], da[16], ac[16], bd[16], ca[16], db[16] ;
+	double m[4][192] ;
+	double *det, *t, *tmp ;
+	int i, nl[4], nm[4], nab, nbc, ncd, nda, nac, nbd, n, tlen ;
+
+	if(dt->exact == NULL) {
+		dt->exact = (double *) my_malloc(M_DT_EXACT_BUF*sizeof(double)) ;
+	}
+	det = dt->exact ;
+	t = det + 4*2*192*24 ;
+	tmp = t + 2*192*24 ;
+
+	for(i = 0 ; i < 4 ; i++) {
+		TWO_DIFF(pts[i][0], e[0], x[i][1], x[i][0]) ;
+		TWO_DIFF(pts[i][1], e[1], y[i][1], y[i][0]) ;
+		TWO_DIFF(pts[i][2], e[2], z[i][1], z[i][0]) ;
+		nl[i] = lift_exp(x[i], y[i], z[i], lift[i]) ;
+	}
+
+	nab = cross_exp(x[0], y[1], x[1], y[0], ab) ;
+	nbc = cross_exp(x[1], y[2], x[2], y[1], bc) ;
+	ncd = cross_exp(x[2], y[3], x[3], y[2], cd) ;
+	nda = cross_exp(x[3], y[0], x[0], y[3], da) ;
+	nac = cross_exp(x[0], y[2], x[2], y[0], ac) ;
+	nbd = cross_exp(x[1], y[3], x[3], y[1], bd) ;
+	memcpy(ca, ac, nac*sizeof(double)) ;
+	neg_exp(nac, ca) ;
+	memcpy(db, bd, nbd*sizeof(double)) ;
+	neg_exp(nbd, db) ;
+
+	/* abc = aez*bc - bez*ac + cez*ab, bcd = bez*cd - cez*bd + dez*bc,
+	 * cda = cez*da + dez*ac + aez*cd, dab = dez*ab + aez*bd + bez*da */
+	nm[0] = det3_exp(z[0], nbc, bc, z[1], nac, ca, z[2], nab, ab, m[0]) ;
+	nm[1] = det3_exp(z[1], ncd, cd, z[2], nbd, db, z[3], nbc, bc, m[1]) ;
+	nm[2] = det3_exp(z[2], nda, da, z[3], nac, ac, z[0], ncd, cd, m[2]) ;
+	nm[3] = det3_exp(z[3], nab, ab, z[0], nbd, bd, z[1], nda, da, m[3]) ;
+
+	/* det = dlift*abc - clift*dab + blift*cda - alift*bcd */
+	n = mul_exp(nm[0], m[0], nl[3], lift[3], det, tmp) ;
+	tlen = mul_exp(nm[3], m[3], nl[2], lift[2], t, tmp) ;
+	neg_exp(tlen, t) ;
+	n = sum_exp(n, det, tlen, t, det) ;
+	tlen = mul_exp(nm[2], m[2], nl[1], lift[1], t, tmp) ;
+	n = sum_exp(n, det, tlen, t, det) ;
+	tlen = mul_exp(nm[1], m[1], nl[0], lift[0], t, tmp) ;
+	neg_exp(tlen, t) ;
+	n = sum_exp(n, det, tlen, t, det) ;
+
+	return det[n-1] ;
+}
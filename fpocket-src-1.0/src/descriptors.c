@@ -18,6 +18,10 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-08	     Residues of the atoms kept in a set of ids (s_idset)
+##	17-11-05	     Vertice based descriptors: apolar neighbours found on a
+##					 grid, mean distance summed 4 at a time, maximum distance
+##					 bounded by the distance to the barycenter
 ##	09-02-09	(v)  Maximum distance between two alpha sphere added
 ##	29-01-09	(v)  Normalized density and polarity score added
 ##	21-01-09	(v)  Density descriptor Added
@@ -32,8 +36,6 @@
 ##	    score is the best example: maybe replace by the molecular weight 
 ##	    for example, although the way we use this kind of descriptors 
 ##		might not be relevant at all anyway...)
-##	(v) Possible improvement:
-##		Use the sorted structure to calculate the apolar density.
 
 */
 
@@ -69,6 +71,21 @@
 **/
 
 
+/* Rank of a point by its distance to the barycenter (see get_max_dst) */
+typedef struct s_dst_rank
+{
+	double d ;
+	int id ;
+
+} s_dst_rank ;
+
+static void set_pair_descriptors(s_vvertice **tvert, int nvert, int *nneigh,
+								 double *sum_dst, float *max_dst) ;
+static void set_apol_neighbours(s_vvertice **tvert, int nvert, int *nneigh) ;
+static double get_sum_dst(float *x, float *y, float *z, int n) ;
+static float get_max_dst(float *x, float *y, float *z, int n) ;
+static int cmp_dst_rank(const void *a, const void *b) ;
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	allocate_s_desc 
@@ -169,6 +186,395 @@ void set_descriptors(s_atm **atoms, int natoms, s_vvertice **tvert, int nvert,
 	/* Setting vertice-based descriptors */
 	if(! tvert) return ;
 
+	set_vert_descriptors(tvert, nvert, desc) ;
+	desc->volume = get_verts_volume_ptr(tvert, nvert, 3000) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_vert_descriptors
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Set the vertice based descriptors (volume excepted), see set_descriptors.
+	Small pockets are handled by a single scan of all pairs of vertices
+	(set_pair_descriptors). For larger ones, apolar neighbours are found on
+	a grid of the apolar spheres of the pocket (set_apol_neighbours), the
+	mean distance between spheres is summed by get_sum_dst and the maximum
+	distance found by get_max_dst.
+	Results are the same as set_vert_descriptors_naive, except as_density
+	which is summed in a different order (and in double precision).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvertice **tvert : The list of vertices
+	@ int nvert          : The number of vertices
+	@ s_desc *desc       : OUTPUT: The descriptor structure to fill
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    void: s_desc is filled
+   -----------------------------------------------------------------------------
+*/
+void set_vert_descriptors(s_vvertice **tvert, int nvert, s_desc *desc)
+{
+	float d = 0.0,
+		  masph_sacc = 0.0, /* Mean alpha sphere solvent accessibility */
+		  mean_ashape_radius = 0.0,
+		  as_max_r = -1.0,
+		  as_max_dst = -1.0 ;
+
+	int i, nAlphaApol = 0 ;
+
+	s_vvertice *vcur = NULL ;
+
+	int *napol_neigh = (int *) my_calloc(nvert > 0 ? nvert : 1, sizeof(int)) ;
+	double sum_dst = 0.0 ;
+
+	if(nvert < M_DESC_GRID_MIN_VERT) {
+		set_pair_descriptors(tvert, nvert, napol_neigh, &sum_dst, &as_max_dst) ;
+	}
+	else {
+		float *x = (float *) my_malloc(3*nvert*sizeof(float)),
+			  *y = x + nvert,
+			  *z = y + nvert ;
+
+		for(i = 0 ; i < nvert ; i++) {
+			x[i] = tvert[i]->x ; y[i] = tvert[i]->y ; z[i] = tvert[i]->z ;
+		}
+		set_apol_neighbours(tvert, nvert, napol_neigh) ;
+		sum_dst = get_sum_dst(x, y, z, nvert) ;
+		as_max_dst = get_max_dst(x, y, z, nvert) ;
+		my_free(x) ;
+	}
+
+	desc->mean_loc_hyd_dens = 0.0 ;
+	for(i = 0 ; i < nvert ; i++) {
+		vcur = tvert[i] ;
+		if(vcur->ray > as_max_r) as_max_r = vcur->ray ;
+
+		if(vcur->type == M_APOLAR_AS) {
+			desc->mean_loc_hyd_dens += (float) napol_neigh[i] ;
+			nAlphaApol += 1 ;
+		}
+
+		mean_ashape_radius += vcur->ray ;
+		/* Estimating solvent accessibility of the sphere */
+		d = dist(vcur->x, vcur->y, vcur->z,
+				 vcur->bary[0], vcur->bary[1], vcur->bary[2]) ;
+		masph_sacc += d/vcur->ray ;
+	}
+
+	if(nAlphaApol>0) desc->mean_loc_hyd_dens /= (float)nAlphaApol ;
+	else desc->mean_loc_hyd_dens= 0.0;
+
+	desc->as_max_dst = as_max_dst ;
+	desc->apolar_asphere_prop = (float)nAlphaApol / (float)nvert ;
+	desc->masph_sacc =  masph_sacc / nvert ;
+	desc->mean_asph_ray = mean_ashape_radius / (float)nvert ;
+	desc->nb_asph = nvert ;
+	desc->as_density = (float) (sum_dst / (((double)nvert*nvert - nvert) * 0.5)) ;
+	desc->as_max_r = as_max_r ;
+
+	my_free(napol_neigh) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_pair_descriptors
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Number of apolar neighbours of each apolar sphere, sum of the distances
+	and maximum distance between spheres, the distance of each pair being
+	computed once.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvertice **tvert : The list of vertices
+	@ int nvert          : The number of vertices
+	@ int *nneigh        : OUTPUT: Number of apolar neighbours of each vertice
+	@ double *sum_dst    : OUTPUT: Sum of the distances
+	@ float *max_dst     : OUTPUT: Maximum distance, -1 if less than 2 vertices
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    void
+   -----------------------------------------------------------------------------
+*/
+static void set_pair_descriptors(s_vvertice **tvert, int nvert, int *nneigh,
+								 double *sum_dst, float *max_dst)
+{
+	int i, j ;
+	float d, row ;
+	s_vvertice *vcur = NULL, *vc = NULL ;
+
+	*sum_dst = 0.0 ;
+	*max_dst = -1.0 ;
+	for(i = 0 ; i < nvert ; i++) nneigh[i] = 0 ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		vcur = tvert[i] ;
+		row = 0.0 ;
+		for(j = i + 1 ; j < nvert ; j++) {
+			vc = tvert[j] ;
+			d = dist(vcur->x, vcur->y, vcur->z, vc->x, vc->y, vc->z) ;
+			row += d ;
+			if(d > *max_dst) *max_dst = d ;
+
+			if(vcur->type == M_APOLAR_AS && vc->type == M_APOLAR_AS
+			   && d - (vc->ray + vcur->ray) <= 0.) {
+				nneigh[i] += 1 ;
+				nneigh[j] += 1 ;
+			}
+		}
+		*sum_dst += row ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_apol_neighbours
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Number of apolar neighbours of each apolar sphere (see 
+	get_vert_apolar_density). Apolar spheres are put in the cells of a grid
+	at least twice as large as the largest of them: two overlapping
+	spheres lie in the same or in adjacent cells.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvertice **tvert : The list of vertices
+	@ int nvert          : The number of vertices
+	@ int *nneigh        : OUTPUT: Number of apolar neighbours of each apolar
+						   vertice (left untouched for others)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    void
+   -----------------------------------------------------------------------------
+*/
+static void set_apol_neighbours(s_vvertice **tvert, int nvert, int *nneigh)
+{
+	int i, j, k, c, n = 0, ncell, ng[3], cv[3], cn[3] ;
+	float min[3], max[3], xyz[3], rmax = 0.0, cell, vrad ;
+	s_vvertice *vcur = NULL, *vc = NULL ;
+
+	int *apol = (int *) my_malloc((nvert > 0 ? 3*nvert : 1)*sizeof(int)),
+		*vcell = apol + nvert,
+		*cvert = vcell + nvert ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		vcur = tvert[i] ;
+		if(vcur->type != M_APOLAR_AS) continue ;
+
+		xyz[0] = vcur->x ; xyz[1] = vcur->y ; xyz[2] = vcur->z ;
+		for(k = 0 ; k < 3 ; k++) {
+			if(n == 0 || xyz[k] < min[k]) min[k] = xyz[k] ;
+			if(n == 0 || xyz[k] > max[k]) max[k] = xyz[k] ;
+		}
+		if(vcur->ray > rmax) rmax = vcur->ray ;
+		apol[n++] = i ;
+	}
+
+	if(n > 0) {
+		/* Cells wide enough (rounding errors included), and not more cells
+		 * than M_DESC_CELLS_PER_SPHERE per sphere */
+		cell = 2.0*rmax + M_DESC_CELL_MARGIN ;
+		do {
+			for(k = 0, ncell = 1 ; k < 3 ; k++) {
+				ng[k] = (int) ((max[k] - min[k]) / cell) + 1 ;
+				ncell *= ng[k] ;
+			}
+			if(ncell > M_DESC_CELLS_PER_SPHERE*n) cell *= 2.0 ;
+		} while(ncell > M_DESC_CELLS_PER_SPHERE*n) ;
+
+		int *cstart = (int *) my_calloc(ncell+1, sizeof(int)) ;
+
+		/* Counting sort of the apolar spheres by cell */
+		for(j = 0 ; j < n ; j++) {
+			vcur = tvert[apol[j]] ;
+			xyz[0] = vcur->x ; xyz[1] = vcur->y ; xyz[2] = vcur->z ;
+			for(k = 0 ; k < 3 ; k++) {
+				cv[k] = (int) ((xyz[k] - min[k]) / cell) ;
+				if(cv[k] >= ng[k]) cv[k] = ng[k] - 1 ;
+			}
+			vcell[j] = (cv[2]*ng[1] + cv[1])*ng[0] + cv[0] ;
+			cstart[vcell[j]+1]++ ;
+		}
+		for(c = 0 ; c < ncell ; c++) cstart[c+1] += cstart[c] ;
+		for(j = 0 ; j < n ; j++) cvert[cstart[vcell[j]]++] = apol[j] ;
+		for(c = ncell ; c > 0 ; c--) cstart[c] = cstart[c-1] ;
+		cstart[0] = 0 ;
+
+		for(j = 0 ; j < n ; j++) nneigh[apol[j]] = 0 ;
+
+		/* The test is symmetric: each pair is tested once, from its lowest
+		 * vertice */
+		for(j = 0 ; j < n ; j++) {
+			i = apol[j] ;
+			vcur = tvert[i] ;
+			vrad = vcur->ray ;
+			cv[0] = vcell[j] % ng[0] ;
+			cv[1] = (vcell[j] / ng[0]) % ng[1] ;
+			cv[2] = vcell[j] / (ng[0]*ng[1]) ;
+
+			for(cn[2] = cv[2]-1 ; cn[2] <= cv[2]+1 ; cn[2]++) {
+				if(cn[2] < 0 || cn[2] >= ng[2]) continue ;
+				for(cn[1] = cv[1]-1 ; cn[1] <= cv[1]+1 ; cn[1]++) {
+					if(cn[1] < 0 || cn[1] >= ng[1]) continue ;
+					for(cn[0] = cv[0]-1 ; cn[0] <= cv[0]+1 ; cn[0]++) {
+						if(cn[0] < 0 || cn[0] >= ng[0]) continue ;
+
+						c = (cn[2]*ng[1] + cn[1])*ng[0] + cn[0] ;
+						for(k = cstart[c] ; k < cstart[c+1] ; k++) {
+							vc = tvert[cvert[k]] ;
+							if(cvert[k] > i &&
+							   dist(vcur->x, vcur->y, vcur->z, vc->x, vc->y, vc->z)
+							   -(vc->ray + vrad) <= 0.) {
+								nneigh[i] += 1 ;
+								nneigh[cvert[k]] += 1 ;
+							}
+						}
+					}
+				}
+			}
+		}
+		my_free(cstart) ;
+	}
+
+	my_free(apol) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_sum_dst
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Sum of the distances between all pairs of points. Each row of the
+	upper triangle is summed 4 distances at a time (SSE, if available) in
+	single precision, rows are summed in double precision.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *x, *y, *z : Coordinates of the points
+	@ int n            : Number of points
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    double: The sum
+   -----------------------------------------------------------------------------
+*/
+static double get_sum_dst(float *x, float *y, float *z, int n)
+{
+	int i, j ;
+	float row ;
+	double sum = 0.0 ;
+
+	for(i = 0 ; i < n - 1 ; i++) {
+		j = i + 1 ;
+		row = 0.0 ;
+
+#ifdef __SSE__
+		float lanes[4] ;
+		__m128 xi = _mm_set1_ps(x[i]),
+			   yi = _mm_set1_ps(y[i]),
+			   zi = _mm_set1_ps(z[i]),
+			   acc = _mm_setzero_ps() ;
+
+		for( ; j + 4 <= n ; j += 4) {
+			__m128 dx = _mm_sub_ps(xi, _mm_loadu_ps(x + j)),
+				   dy = _mm_sub_ps(yi, _mm_loadu_ps(y + j)),
+				   dz = _mm_sub_ps(zi, _mm_loadu_ps(z + j)) ;
+
+			acc = _mm_add_ps(acc, _mm_sqrt_ps(
+				  _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+							 _mm_mul_ps(dz, dz)))) ;
+		}
+		_mm_storeu_ps(lanes, acc) ;
+		row = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) ;
+#endif
+
+		for( ; j < n ; j++) row += dist(x[i], y[i], z[i], x[j], y[j], z[j]) ;
+		sum += row ;
+	}
+
+	return sum ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_max_dst
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Maximum distance between two points, -1 if less than two points.
+	Points are sorted by decreasing distance to their barycenter G. As
+	d(a, b) <= d(a, G) + d(b, G), pairs are scanned in this order until
+	this bound is below the maximum found: only the few points far from
+	the barycenter are compared in practice. Distances are computed as in
+	set_vert_descriptors_naive, so the result is exactly the same.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *x, *y, *z : Coordinates of the points
+	@ int n            : Number of points
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    float: The maximum distance
+   -----------------------------------------------------------------------------
+*/
+static float get_max_dst(float *x, float *y, float *z, int n)
+{
+	int i, j, a, b ;
+	float dtmp, dmax = -1.0 ;
+	double gx = 0.0, gy = 0.0, gz = 0.0 ;
+
+	if(n < 2) return dmax ;
+
+	s_dst_rank *rank = (s_dst_rank *) my_malloc(n*sizeof(s_dst_rank)) ;
+
+	for(i = 0 ; i < n ; i++) {
+		gx += x[i] ; gy += y[i] ; gz += z[i] ;
+	}
+	gx /= n ; gy /= n ; gz /= n ;
+	for(i = 0 ; i < n ; i++) {
+		rank[i].id = i ;
+		rank[i].d = sqrt((x[i]-gx)*(x[i]-gx) + (y[i]-gy)*(y[i]-gy)
+						 + (z[i]-gz)*(z[i]-gz)) ;
+	}
+	qsort(rank, n, sizeof(s_dst_rank), cmp_dst_rank) ;
+
+	for(i = 0 ; i < n - 1 ; i++) {
+		if(rank[i].d + rank[i+1].d + M_DESC_DST_MARGIN < dmax) break ;
+		a = rank[i].id ;
+		for(j = i + 1 ; j < n ; j++) {
+			if(rank[i].d + rank[j].d + M_DESC_DST_MARGIN < dmax) break ;
+			b = rank[j].id ;
+			dtmp = dist(x[a], y[a], z[a], x[b], y[b], z[b]) ;
+			if(dtmp > dmax) dmax = dtmp ;
+		}
+	}
+	my_free(rank) ;
+
+	return dmax ;
+}
+
+static int cmp_dst_rank(const void *a, const void *b)
+{
+	double da = ((s_dst_rank *)a)->d,
+		   db = ((s_dst_rank *)b)->d ;
+
+	return (da < db) - (da > db) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_vert_descriptors_naive
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Original version of set_vert_descriptors, scanning all pairs of
+	vertices. Kept for tests and benchmarks.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvertice **tvert : The list of vertices
+	@ int nvert          : The number of vertices
+	@ s_desc *desc       : OUTPUT: The descriptor structure to fill
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    void: s_desc is filled
+   -----------------------------------------------------------------------------
+*/
+void set_vert_descriptors_naive(s_vvertice **tvert, int nvert, s_desc *desc)
+{
 	float d = 0.0, vx, vy, vz, vrad,
 		  masph_sacc = 0.0, /* Mean alpha sphere solvent accessibility */
 		  mean_ashape_radius = 0.0,
@@ -243,8 +649,6 @@ void set_descriptors(s_atm **atoms, int natoms, s_vvertice **tvert, int nvert,
 	desc->mean_asph_ray = mean_ashape_radius / (float)nvert ;
 	desc->nb_asph = nvert ;
 	desc->as_density = as_density / ((nvert*nvert - nvert) * 0.5) ;
-		
-	desc->volume = get_verts_volume_ptr(tvert, nvert, 3000) ;
 	desc->as_max_r = as_max_r ;
 
 }
@@ -317,18 +721,17 @@ void set_atom_based_descriptors(s_atm **atoms, int natoms, s_desc *desc)
 	s_atm *curatom = NULL ;
 
 	int i,
-		res_ids[natoms],	/* Maximum natoms residues contacting the pocket */
 		nb_res_ids = 0 ;	/* Current number of residus */
 
 	int nb_polar_atm = 0 ;
+	s_idset *res_ids = alloc_idset(natoms) ;
  
 	for(i = 0 ; i < natoms ; i++) {
 		curatom = atoms[i] ;
 
 	/* Setting amino acid descriptor of the current atom */
-		if(in_tab(res_ids,  nb_res_ids, curatom->res_id) == 0) {
+		if(add_idset(res_ids, curatom->res_id)) {
 			set_aa_desc(desc, atoms[i]->res_name) ;
-			res_ids[nb_res_ids] = curatom->res_id ;
 			nb_res_ids ++ ;
 		}
 
@@ -336,6 +739,7 @@ void set_atom_based_descriptors(s_atm **atoms, int natoms, s_desc *desc)
 		desc->flex += curatom->bfactor ;
 		if(curatom->electroneg > 2.7)  nb_polar_atm += 1 ;
 	}
+	free_idset(res_ids) ;
 
 	desc->hydrophobicity_score = desc->hydrophobicity_score/ (float) nb_res_ids ;
 	desc->volume_score = desc->volume_score / (float) nb_res_ids ;
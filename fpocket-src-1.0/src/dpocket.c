@@ -51,6 +51,8 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-09	     Neighbours searched in a spatial index of the atoms and
+##					     vertices, and of the ligand (see neighbor.c)
 ##	06-03-09	(v)  Criteria 4, 5, 6 added to dpocket output
 ##	09-02-09	(v)  Maximum distance between two alpha sphere added
 ##	21-01-09	(v)  Density descriptor added
@@ -186,13 +188,15 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
 {
 	c_lst_pockets *pockets = NULL ;
 	s_lst_vvertice *verts = NULL ;
+	s_nindex *sind = NULL,		/* Index of the atoms and vertices */
+			 *lind = NULL ;		/* Index of the ligand atoms */
 	
 	s_atm **interface = NULL ;
 	s_desc *edesc ;
 	s_atm **lig = NULL,
 		  **patoms ;
 
-	float vol, ovlp, dst = 0.0, tmp, c4, c5 ;
+	float vol, ovlp, dst = 0.0, c4, c5 ;
 	int nal = 0,
 		nai = 0,	/* Number of atoms in the interface */
 		nbpa ;
@@ -239,8 +243,12 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
 */
 
 	verts = pockets->vertices ;
+	sind = alloc_nindex(pdb_cplx_l->latoms_p, pdb_cplx_l->natoms,
+						verts->pvertices, verts->nvert, par->interface_dist_crit) ;
+	lind = alloc_nindex(lig, nal, NULL, 0, M_CRIT4_D) ;
+
 	edesc = allocate_s_desc() ;
-	interface = get_explicit_desc(pdb_cplx_l, verts, lig, nal, par,
+	interface = get_explicit_desc(pdb_cplx_l, sind, lig, nal, par,
 								   &nai, edesc) ;
 
 	/* Writing output */
@@ -256,23 +264,14 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
 
 		/* Get the smallest distance of the ligand to the pocket
 		   (PocketPicker criteria) */
-		for (j = 0 ; j < nal ; j++) {
-			tmp = dist(lig[j]->x, lig[j]->y, lig[j]->z,
-					   cur->pocket->bary[0], cur->pocket->bary[1],
-					   cur->pocket->bary[2]) ;
-			if(j == 0) dst = tmp ;
-			else {
-				if(tmp < dst) dst = tmp ;
-			}
-		}
+		get_nindex_knearest(lind, cur->pocket->bary[0], cur->pocket->bary[1],
+							cur->pocket->bary[2], 1, M_ATOM_TYPE, &j, &dst) ;
 
 		/* Get the consensus criteria too */
 		pvert = get_pocket_pvertices(cur->pocket) ;
 
-		c4 = count_atm_prop_vert_neigh( lig, pdb_cplx_l->natm_lig,
-									    pvert, cur->pocket->size, M_CRIT4_D) ;
-		c5 = count_pocket_lig_vert_ovlp(lig, pdb_cplx_l->natm_lig,
-										pvert, cur->pocket->size, M_CRIT5_D) ;
+		c4 = count_atm_prop_vert_neigh(lind, pvert, cur->pocket->size, M_CRIT4_D) ;
+		c5 = count_pocket_lig_vert_ovlp(lind, pvert, cur->pocket->size, M_CRIT5_D) ;
 
 		/* */
 		if(ovlp > 40.0 || dst < 4.0) {
@@ -289,6 +288,8 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
 
 	/* Free memory */
 	c_lst_pocket_free(pockets) ;
+	free_nindex(sind) ;
+	free_nindex(lind) ;
 	my_free(interface) ;
 	free_pdb_atoms(pdb_cplx_l) ;
 	free_pdb_atoms(pdb_cplx_nl) ;
@@ -305,7 +306,7 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_pdb *pdb_cplx_l     : The pdb structure
-	@ s_lst_vvertice *verts : The vertices found
+	@ s_nindex *sind        : Index of the atoms and of the vertices found
 	@ s_atm **lig           : Atoms of the ligand
 	@ int nal               : Number of atom in the ligand
 	@ s_dparams *par        : Parameters
@@ -317,7 +318,7 @@ void desc_pocket(char fcomplexe[], const char ligname[], s_dparams *par,
 	plus nai and desc are filled.
    -----------------------------------------------------------------------------
 */
-s_atm** get_explicit_desc(s_pdb *pdb_cplx_l, s_lst_vvertice *verts, s_atm **lig, 
+s_atm** get_explicit_desc(s_pdb *pdb_cplx_l, s_nindex *sind, s_atm **lig, 
 						  int nal, s_dparams *par, int *nai, s_desc *desc)
 {
 	int nvn = 0 ;	/* Number of vertices in the interface */
@@ -331,21 +332,18 @@ s_atm** get_explicit_desc(s_pdb *pdb_cplx_l, s_lst_vvertice *verts, s_atm **lig,
 	
 	if(par->interface_method == M_INTERFACE_METHOD2) {
 	/* Use the distance-based method to define the interface */
-		interface = get_mol_atm_neigh(	lig, nal, pdb_cplx_l->latoms_p,
-										pdb_cplx_l->natoms,
-										par->interface_dist_crit, nai) ;
+		interface = get_mol_atm_neigh(lig, nal, sind, par->interface_dist_crit, nai) ;
 	}
 	else {
 	/* Use the voronoi vertices-based method to define the interface */
 		
-		interface = get_mol_ctd_atm_neigh(lig, nal, verts->pvertices, verts->nvert,
-										  par->interface_dist_crit,
+		interface = get_mol_ctd_atm_neigh(lig, nal, sind, par->interface_dist_crit,
 										  M_INTERFACE_SEARCH, nai) ;
 	}
 
 	/* Get a tab of pointer for interface's vertices to send a correct argument 
 	 * type to set_descriptors */
-	s_vvertice **tpverts = get_mol_vert_neigh(lig, nal, verts->pvertices, verts->nvert,
+	s_vvertice **tpverts = get_mol_vert_neigh(lig, nal, sind,
 											  par->interface_dist_crit, &nvn) ;
 	
 	/* Ok we have the interface and the correct vertices list, now calculate 
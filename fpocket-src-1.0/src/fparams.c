@@ -16,7 +16,18 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
--##	17-03-09	(v)  Segfault avoided when freeing pdb list
+##	17-11-14	     Binary result (-B)
+##	17-11-13	     Output layout of the pockets (-O)
+##	17-11-07	     Exact volume engine (-V exact)
+##	17-11-06	     Volume engine (-V)
+##	17-11-05	     Number of threads for the descriptors (-j), seed (-S)
+##	17-11-03	     Barycenter merge mode (-R)
+##	17-11-02	     Single linkage merge mode (-l)
+##	17-10-30	     Tesselation engine (-T)
+##	17-10-28	     Number of threads for the tesselation (-t)
+##	17-10-27	     Alpha sphere cache directory (-c)
+##	17-10-26	     Number of worker processes for a list of pdb (-w)
+##	17-03-09	(v)  Segfault avoided when freeing pdb list
 ##	15-12-08	(v)  Added function to check if a single letter is a fpocket
 ##					 command line option (usefull for t/dpocket) + minor modifs
 ##	28-11-08	(v)  List of pdb taken into account as a single file input.
@@ -64,6 +75,18 @@ s_fparams* init_def_fparams(void)
 	par->clust_max_dist = M_CLUST_MAX_DIST ;
 	par->npdb = 0 ;
 	par->pdb_lst = NULL ;
+	par->pdb_lst_path[0] = '\0' ;
+	par->nworkers = M_NB_WORKERS ;
+	par->cache_dir[0] = '\0' ;
+	par->nthreads = M_NB_THREADS ;
+	par->delaunay = M_DELAUNAY_QHULL ;
+	par->ml_clust = M_MLCLUST_ORDER ;
+	par->refine_mode = M_REFINE_ORDER ;
+	par->desc_threads = M_NB_DESC_THREADS ;
+	par->rand_seed = M_RAND_SEED ;
+	par->volume = M_VOLUME_GRID ;
+	par->out_layout = M_OUT_FILES ;
+	par->out_bin = 0 ;
 
 	return par ;
 }
@@ -120,6 +143,28 @@ s_fparams* get_fpocket_args(int nargs, char **args)
 				case M_PAR_REFINE_MIN_NAPOL_AS: 
 					status += parse_refine_minaap(args[++i], par) ; 
 					break ;
+				case M_PAR_NB_WORKERS		  : 
+					status += parse_nb_workers(args[++i], par) ;		break ;
+				case M_PAR_NB_THREADS		  : 
+					status += parse_nb_threads(args[++i], par) ;		break ;
+				case M_PAR_DELAUNAY			  : 
+					status += parse_delaunay_engine(args[++i], par) ;	break ;
+				case M_PAR_ML_CLUST			  : 
+					status += parse_ml_clust_mode(args[++i], par) ;		break ;
+				case M_PAR_REFINE_MODE		  : 
+					status += parse_refine_mode(args[++i], par) ;		break ;
+				case M_PAR_DESC_THREADS		  : 
+					status += parse_desc_threads(args[++i], par) ;		break ;
+				case M_PAR_RAND_SEED		  : 
+					status += parse_rand_seed(args[++i], par) ;			break ;
+				case M_PAR_VOLUME			  : 
+					status += parse_volume_engine(args[++i], par) ;		break ;
+				case M_PAR_OUT_LAYOUT		  : 
+					status += parse_out_layout(args[++i], par) ;		break ;
+				case M_PAR_OUT_BIN			  : 
+					status += parse_out_bin(args[++i], par) ;			break ;
+				case M_PAR_VERT_CACHE		  : 
+					status += parse_cache_dir(args[++i], par) ;			break ;
 				case M_PAR_PDB_LIST :
 					pdb_lst = args[++i] ; break ;
 					
@@ -147,6 +192,9 @@ s_fparams* get_fpocket_args(int nargs, char **args)
 	if(pdb_lst != NULL) {
 		FILE *f = fopen(pdb_lst, "r") ;
 		if(f != NULL) {
+			strncpy(par->pdb_lst_path, pdb_lst, M_MAX_PDB_NAME_LEN - 1) ;
+			par->pdb_lst_path[M_MAX_PDB_NAME_LEN - 1] = '\0' ;
+
 			/* Count the number of lines */
 			int n = 0 ;
 			char cline [M_MAX_PDB_NAME_LEN + 1] ;
@@ -502,6 +550,313 @@ int parse_min_pock_nb_asph(char *str, s_fparams *p)
 }
 
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_nb_workers
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the number of processes handling a list of pdb.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (here a valid int > 0), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_nb_workers(char *str, s_fparams *p) 
+{
+	if(str_is_number(str, M_NO_SIGN) && atoi(str) > 0) {
+		p->nworkers = (int) atoi(str) ;
+	}
+	else {
+		fprintf(stdout, "! Invalid value (%s) given for the number of workers.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_nb_threads
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the number of threads used by the tesselation.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (here a valid int > 0), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_nb_threads(char *str, s_fparams *p) 
+{
+	if(str_is_number(str, M_NO_SIGN) && atoi(str) > 0) {
+		p->nthreads = (int) atoi(str) ;
+	}
+	else {
+		fprintf(stdout, "! Invalid value (%s) given for the number of threads.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_delaunay_engine
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the engine used by the tesselation.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (qhull or native), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_delaunay_engine(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "qhull") == 0) p->delaunay = M_DELAUNAY_QHULL ;
+	else if(strcmp(str, "native") == 0) p->delaunay = M_DELAUNAY_NATIVE ;
+	else {
+		fprintf(stdout, "! Invalid tesselation engine (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_ml_clust_mode
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the way pockets are merged by the single linkage
+	clustering.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (order or graph), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_ml_clust_mode(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "order") == 0) p->ml_clust = M_MLCLUST_ORDER ;
+	else if(strcmp(str, "graph") == 0) p->ml_clust = M_MLCLUST_GRAPH ;
+	else {
+		fprintf(stdout, "! Invalid single linkage merge (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_refine_mode
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the way pockets with close barycenters are merged.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (order or fixpoint), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_refine_mode(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "order") == 0) p->refine_mode = M_REFINE_ORDER ;
+	else if(strcmp(str, "fixpoint") == 0) p->refine_mode = M_REFINE_FIXPOINT ;
+	else {
+		fprintf(stdout, "! Invalid barycenter merge (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_desc_threads
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the number of threads used by the descriptors of
+	the pockets.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (here a valid int > 0), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_desc_threads(char *str, s_fparams *p) 
+{
+	if(str_is_number(str, M_NO_SIGN) && atoi(str) > 0) {
+		p->desc_threads = (int) atoi(str) ;
+	}
+	else {
+		fprintf(stdout, "! Invalid value (%s) given for the number of descriptor threads.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_rand_seed
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the seed of the random number generator.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (here a valid int >= 0), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_rand_seed(char *str, s_fparams *p) 
+{
+	if(str_is_number(str, M_NO_SIGN) && strlen(str) < 10) {
+		p->rand_seed = (int) atoi(str) ;
+	}
+	else {
+		fprintf(stdout, "! Invalid value (%s) given for the seed.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_volume_engine
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the engine computing the volumes.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (grid, exact or mc), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_volume_engine(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "grid") == 0) p->volume = M_VOLUME_GRID ;
+	else if(strcmp(str, "exact") == 0) p->volume = M_VOLUME_EXACT ;
+	else if(strcmp(str, "mc") == 0) p->volume = M_VOLUME_MC ;
+	else {
+		fprintf(stdout, "! Invalid volume engine (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_out_layout
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the output layout of the pockets.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (files or pack), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_out_layout(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "files") == 0) p->out_layout = M_OUT_FILES ;
+	else if(strcmp(str, "pack") == 0) p->out_layout = M_OUT_PACK ;
+	else {
+		fprintf(stdout, "! Invalid output layout (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_out_bin
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the binary result (written if 1).
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (0 or 1), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_out_bin(char *str, s_fparams *p) 
+{
+	if(strcmp(str, "0") == 0 || strcmp(str, "1") == 0) p->out_bin = atoi(str) ;
+	else {
+		fprintf(stdout, "! Invalid value (%s) given for the binary result.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	parse_cache_dir
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 	
+	Parsing function for the alpha sphere cache directory.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ char *str    : The string to parse
+	@ s_fparams *p : The structure than will contain the parsed parameter
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the parameter is valid (an existing directory), 1 if not
+   -----------------------------------------------------------------------------
+*/
+int parse_cache_dir(char *str, s_fparams *p) 
+{
+	struct stat st ;
+
+	if(strlen(str) < M_MAX_PDB_NAME_LEN && stat(str, &st) == 0
+	   && S_ISDIR(st.st_mode)) {
+		strcpy(p->cache_dir, str) ;
+	}
+	else {
+		fprintf(stdout, "! Invalid cache directory (%s) given.\n", str) ;
+		return 1 ;
+	}
+
+	return 0 ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	is_fpocket_opt
@@ -530,7 +885,17 @@ int is_fpocket_opt(const char opt)
 		opt == M_PAR_BASIC_VOL_DIVISION ||
 		opt == M_PAR_MIN_POCK_NB_ASPH ||
 		opt == M_PAR_REFINE_DIST ||
-		opt == M_PAR_REFINE_MIN_NAPOL_AS) {
+		opt == M_PAR_REFINE_MIN_NAPOL_AS ||
+		opt == M_PAR_VERT_CACHE ||
+		opt == M_PAR_NB_THREADS ||
+		opt == M_PAR_DELAUNAY ||
+		opt == M_PAR_ML_CLUST ||
+		opt == M_PAR_REFINE_MODE ||
+		opt == M_PAR_DESC_THREADS ||
+		opt == M_PAR_RAND_SEED ||
+		opt == M_PAR_VOLUME ||
+		opt == M_PAR_OUT_LAYOUT ||
+		opt == M_PAR_OUT_BIN) {
 		return 1 ;
 	}
 
@@ -0,0 +1,395 @@
+
+#include "../headers/fpbatch.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					fpbatch.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	Parallel handling of a list of pdb (-F option). Several worker processes
+##	take pdb files from a queue shared with the parent process, biggest files
+##	first. The state of each pdb is kept in shared memory, so the parent can
+##	write a summary of the batch even if a worker crashes.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     Single worker run in the process, summary written for
+##					 any number of workers
+##	17-10-31	     Workers keep the tesselation memory between pdb
+##					 (set_vvertices_keep_mem), resident memory reported
+##	17-10-26	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+static int run_batch_worker(s_fparams *params, s_batch_job *jobs, int *order,
+							int *next) ;
+static void write_batch_summary(s_fparams *params, s_batch_job *jobs,
+								double time) ;
+static int cmp_batch_jobs(const void *a, const void *b) ;
+static int run_batch_serial(s_fparams *params, s_batch_job *jobs) ;
+
+/* Jobs being sorted, used by cmp_batch_jobs */
+static s_batch_job *ST_sort_jobs = NULL ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	process_pdb_batch
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Run fpocket on each pdb of the list given in the parameters, using
+	params->nworkers worker processes. Pdb are sorted by decreasing file size
+	so that large structures don't end the batch alone. A worker that dies
+	is replaced as long as pdb remain in the queue, and its current pdb is
+	reported as crashed. With a single worker, pdb are handled in the order
+	of the list by the process itself (run_batch_serial). The summary is
+	written in <pdb_list>.summary in both cases.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fparams *params : Parameters, including the list of pdb
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of pdb that could not be handled
+   -----------------------------------------------------------------------------
+*/
+int process_pdb_batch(s_fparams *params)
+{
+	int i, j, status, nrunning = 0, nfail = 0,
+		nworkers = params->nworkers ;
+	int *order = NULL,
+		*next = NULL ;
+	pid_t pid ;
+	struct stat st ;
+	double start = get_wall_time() ;
+	size_t shsize = params->npdb*sizeof(s_batch_job) + sizeof(int) ;
+
+	if(params->npdb <= 0) return 0 ;
+	if(nworkers > params->npdb) nworkers = params->npdb ;
+	if(nworkers < 1) nworkers = 1 ;
+
+	if(nworkers == 1) {
+		s_batch_job *jobs = (s_batch_job *) my_malloc(params->npdb*sizeof(s_batch_job)) ;
+		for(i = 0 ; i < params->npdb ; i++) {
+			jobs[i].state = M_BATCH_TODO ;
+			jobs[i].result = 0 ;
+			jobs[i].worker = (int) getpid() ;
+			jobs[i].rss = 0 ;
+			jobs[i].time = 0.0 ;
+			jobs[i].fsize = (stat(params->pdb_lst[i], &st) == 0) ? (long) st.st_size : -1 ;
+		}
+		nfail = run_batch_serial(params, jobs) ;
+		write_batch_summary(params, jobs, get_wall_time() - start) ;
+		fprintf(stdout, "> Batch done in %.2f s: %d pdb handled, %d failed\n",
+				get_wall_time() - start, params->npdb - nfail, nfail) ;
+		my_free(jobs) ;
+
+		return nfail ;
+	}
+
+	/* Job states and queue head are shared with the workers */
+	void *shm = mmap(NULL, shsize, PROT_READ | PROT_WRITE,
+					 MAP_SHARED | MAP_ANONYMOUS, -1, 0) ;
+	if(shm == MAP_FAILED) {
+		fprintf(stderr, "! Shared memory for the batch couldn't be allocated.\n") ;
+		return params->npdb ;
+	}
+	s_batch_job *jobs = (s_batch_job *) shm ;
+	next = (int *) (jobs + params->npdb) ;
+	*next = 0 ;
+
+	/* Biggest structures first */
+	order = (int *) my_malloc(params->npdb*sizeof(int)) ;
+	for(i = 0 ; i < params->npdb ; i++) {
+		jobs[i].state = M_BATCH_TODO ;
+		jobs[i].result = 0 ;
+		jobs[i].worker = 0 ;
+		jobs[i].rss = 0 ;
+		jobs[i].time = 0.0 ;
+		jobs[i].fsize = (stat(params->pdb_lst[i], &st) == 0) ? (long) st.st_size : -1 ;
+		order[i] = i ;
+	}
+	ST_sort_jobs = jobs ;
+	qsort(order, params->npdb, sizeof(int), cmp_batch_jobs) ;
+	ST_sort_jobs = NULL ;
+
+	fprintf(stdout, "> Batch of %d pdb, %d worker(s)\n", params->npdb, nworkers) ;
+	fflush(stdout) ;
+
+	for(i = 0 ; i < nworkers ; i++) {
+		pid = fork() ;
+		if(pid == 0) _exit(run_batch_worker(params, jobs, order, next)) ;
+		else if(pid > 0) nrunning++ ;
+		else fprintf(stderr, "! Worker %d couldn't be started.\n", i) ;
+	}
+
+	/* Wait for workers, and replace the ones that died before the end */
+	while(nrunning > 0) {
+		pid = wait(&status) ;
+		if(pid < 0) break ;
+		nrunning-- ;
+
+		if(WIFEXITED(status) && WEXITSTATUS(status) == 0) continue ;
+
+		for(j = 0 ; j < params->npdb ; j++) {
+			if(jobs[j].worker == pid && jobs[j].state == M_BATCH_RUNNING) {
+				jobs[j].state = M_BATCH_CRASHED ;
+				fprintf(stderr, "! Worker %d died while handling %s\n",
+						(int) pid, params->pdb_lst[j]) ;
+			}
+		}
+		if(*next < params->npdb) {
+			fflush(stdout) ;
+			pid = fork() ;
+			if(pid == 0) _exit(run_batch_worker(params, jobs, order, next)) ;
+			else if(pid > 0) nrunning++ ;
+		}
+	}
+
+	for(i = 0 ; i < params->npdb ; i++) {
+		if(jobs[i].state != M_BATCH_DONE) nfail++ ;
+	}
+	write_batch_summary(params, jobs, get_wall_time() - start) ;
+	fprintf(stdout, "> Batch done in %.2f s: %d pdb handled, %d failed\n",
+			get_wall_time() - start, params->npdb - nfail, nfail) ;
+
+	my_free(order) ;
+	munmap(shm, shsize) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	run_batch_worker
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Worker loop: take the next pdb of the shared queue until it is empty.
+	The memory of the tesselation is kept from one pdb to the next one.
+	The time and resident memory of the worker are reported for each pdb.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fparams *params : Parameters, including the list of pdb
+	@ s_batch_job *jobs : Shared job states
+	@ int *order        : Order in which pdb must be handled
+	@ int *next         : Shared position of the queue head
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: exit status of the worker (0)
+   -----------------------------------------------------------------------------
+*/
+static int run_batch_worker(s_fparams *params, s_batch_job *jobs, int *order,
+							int *next)
+{
+	int pos, job ;
+	double start ;
+	s_batch_job *cur = NULL ;
+
+	set_vvertices_keep_mem(1) ;
+	while((pos = __sync_fetch_and_add(next, 1)) < params->npdb) {
+		job = order[pos] ;
+		cur = jobs + job ;
+		cur->worker = (int) getpid() ;
+		cur->state = M_BATCH_RUNNING ;
+
+		start = get_wall_time() ;
+		cur->result = process_pdb(params->pdb_lst[job], params) ;
+		cur->time = get_wall_time() - start ;
+		cur->rss = get_current_rss() ;
+		cur->state = (cur->result >= 0) ? M_BATCH_DONE : M_BATCH_FAILED ;
+
+		fprintf(stdout, "> %s : %d pocket(s), %.2f s, %ld kB\n", 
+				params->pdb_lst[job], (cur->result > 0) ? cur->result : 0, 
+				cur->time, cur->rss) ;
+		fflush(stdout) ;
+	}
+	set_vvertices_keep_mem(0) ;
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	run_batch_serial
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Handle each pdb of the list, in its order, in the current process. The
+	memory of the tesselation is kept from one pdb to the next one.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fparams *params : Parameters, including the list of pdb
+	@ s_batch_job *jobs : Job states, filled here
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of pdb that could not be handled
+   -----------------------------------------------------------------------------
+*/
+static int run_batch_serial(s_fparams *params, s_batch_job *jobs)
+{
+	int i, nfail = 0 ;
+	double start ;
+	char name[M_MAX_PDB_NAME_LEN] ;
+
+	set_vvertices_keep_mem(1) ;
+	for (i = 0 ; i < params->npdb ; i++) {
+		jobs[i].state = M_BATCH_RUNNING ;
+		start = get_wall_time() ;
+
+		/* The name may be changed by process_pdb (case of the pdb code), the
+		 * list keeps the one given for the summary */
+		strncpy(name, params->pdb_lst[i], M_MAX_PDB_NAME_LEN - 1) ;
+		name[M_MAX_PDB_NAME_LEN - 1] = '\0' ;
+		jobs[i].result = process_pdb(name, params) ;
+		jobs[i].time = get_wall_time() - start ;
+		jobs[i].rss = get_current_rss() ;
+		jobs[i].state = (jobs[i].result >= 0) ? M_BATCH_DONE : M_BATCH_FAILED ;
+		if(jobs[i].state != M_BATCH_DONE) nfail++ ;
+
+		printf("> Protein %d / %d : %s : %d pocket(s), %.2f s, %ld kB\n",
+			   i, params->npdb, params->pdb_lst[i], 
+			   (jobs[i].result > 0) ? jobs[i].result : 0, jobs[i].time, jobs[i].rss) ;
+		fflush(stdout) ;
+	}
+	set_vvertices_keep_mem(0) ;
+
+	return nfail ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	write_batch_summary
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Write the batch manifest: one line per pdb, in the order of the input list,
+	giving its final state, number of pockets, file size and time spent.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fparams *params : Parameters, including the list of pdb
+	@ s_batch_job *jobs : Job states
+	@ double time       : Wall time of the whole batch
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void write_batch_summary(s_fparams *params, s_batch_job *jobs,
+								double time)
+{
+	int i ;
+	char fpath[M_MAX_PDB_NAME_LEN + 20] ;
+	const char *states[] = {"not_run", "running", "ok", "failed", "crashed"} ;
+
+	sprintf(fpath, "%s%s", params->pdb_lst_path, M_BATCH_SUMMARY_EXT) ;
+	FILE *f = fopen(fpath, "w") ;
+	if(f == NULL) {
+		fprintf(stderr, "! Batch summary %s couldn't be written.\n", fpath) ;
+		return ;
+	}
+
+	fprintf(f, "# fpocket batch: %d pdb, %d worker(s), %.2f s\n", params->npdb,
+			params->nworkers, time) ;
+	fprintf(f, "#pdb\tstatus\tnb_pockets\tfile_size\ttime\trss_kb\n") ;
+	for(i = 0 ; i < params->npdb ; i++) {
+		fprintf(f, "%s\t%s\t%d\t%ld\t%.3f\t%ld\n", params->pdb_lst[i],
+				states[jobs[i].state], (jobs[i].result > 0) ? jobs[i].result : 0,
+				jobs[i].fsize, jobs[i].time, jobs[i].rss) ;
+	}
+
+	fclose(f) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	cmp_batch_jobs
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	qsort comparison: decreasing file size, then input order.
+   -----------------------------------------------------------------------------
+*/
+static int cmp_batch_jobs(const void *a, const void *b)
+{
+	int ia = *((const int *) a),
+		ib = *((const int *) b) ;
+
+	if(ST_sort_jobs[ia].fsize > ST_sort_jobs[ib].fsize) return -1 ;
+	if(ST_sort_jobs[ia].fsize < ST_sort_jobs[ib].fsize) return 1 ;
+
+	return ia - ib ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_wall_time
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Current wall clock time in seconds.
+   -----------------------------------------------------------------------------
+*/
+double get_wall_time(void)
+{
+	struct timeval tv ;
+	gettimeofday(&tv, NULL) ;
+
+	return tv.tv_sec + tv.tv_usec*1e-6 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_current_rss
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Current resident memory of the process in kB, read in /proc/self/statm.
+	If it can't be read, the peak resident memory given by getrusage.
+   -----------------------------------------------------------------------------
+*/
+long get_current_rss(void)
+{
+	long size = 0, resident = 0 ;
+	struct rusage ru ;
+	FILE *f = fopen("/proc/self/statm", "r") ;
+
+	if(f != NULL) {
+		int n = fscanf(f, "%ld %ld", &size, &resident) ;
+		fclose(f) ;
+		if(n == 2) return resident * (sysconf(_SC_PAGESIZE) / 1024) ;
+	}
+	if(getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss ;
+
+	return 0 ;
+}
@@ -0,0 +1,450 @@
+#include "../headers/fpbin.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					fpbin.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	Reader of the binary columnar result of fpocket (X_out/X_pockets.fpb,
+##	written by write_pockets_bin, see fpbin.h for the layout). The file is
+##	mapped and checked once, columns are then given as pointers in the
+##	mapping, without copy nor parsing.
+##
+##	Only the C library is used, so that fpbin.h and fpbin.c can be compiled
+##	in another programm reading the results of fpocket.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     Type, width and rows of the columns written checked
+##	17-11-14	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+##	Files written on a machine of the other byte order are rejected.
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+
+/* Tables of the file, in which the rows of a column are counted */
+#define M_FPB_TAB_POCK 0	/* npockets */
+#define M_FPB_TAB_PTR 1		/* npockets + 1 (CSR pointers) */
+#define M_FPB_TAB_SPH 2		/* nspheres */
+#define M_FPB_TAB_ATM 3		/* natoms */
+#define M_FPB_TAB_MEM 4		/* nmembers */
+
+/* A column written by write_pockets_bin */
+typedef struct s_fpb_known
+{
+	const char *name ;
+	uint32_t type,
+			 width ;
+	int table ;
+
+} s_fpb_known ;
+
+/* Columns written by write_pockets_bin, except the descriptors desc_<field>
+ * of one f32 or i32 per pocket */
+static const s_fpb_known ST_fpb_known[] = {
+	{ M_FPB_POCK_ID, M_FPB_I32, 1, M_FPB_TAB_POCK },
+	{ M_FPB_POCK_SCORE, M_FPB_F32, 1, M_FPB_TAB_POCK },
+	{ M_FPB_POCK_CENTER, M_FPB_F32, 3, M_FPB_TAB_POCK },
+	{ M_FPB_POCK_NAPOL, M_FPB_I32, 1, M_FPB_TAB_POCK },
+	{ "desc_aa_compo", M_FPB_I32, 20, M_FPB_TAB_POCK },
+	{ M_FPB_POCK_SPH_PTR, M_FPB_I32, 1, M_FPB_TAB_PTR },
+	{ M_FPB_POCK_ATM_PTR, M_FPB_I32, 1, M_FPB_TAB_PTR },
+	{ M_FPB_POCK_ATOMS, M_FPB_I32, 1, M_FPB_TAB_MEM },
+	{ M_FPB_SPH_CENTER, M_FPB_F32, 3, M_FPB_TAB_SPH },
+	{ M_FPB_SPH_RADIUS, M_FPB_F32, 1, M_FPB_TAB_SPH },
+	{ M_FPB_SPH_POLAR, M_FPB_I32, 1, M_FPB_TAB_SPH },
+	{ M_FPB_SPH_ATOMS, M_FPB_I32, 4, M_FPB_TAB_SPH },
+	{ M_FPB_ATM_ID, M_FPB_I32, 1, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_CENTER, M_FPB_F32, 3, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_NAME, M_FPB_CHAR, 5, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_RES_NAME, M_FPB_CHAR, 8, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_CHAIN, M_FPB_CHAR, 5, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_RES_ID, M_FPB_I32, 1, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_INSERT, M_FPB_CHAR, 1, M_FPB_TAB_ATM },
+	{ M_FPB_ATM_SYMBOL, M_FPB_CHAR, 3, M_FPB_TAB_ATM }
+} ;
+
+#define M_FPB_NKNOWN (int) (sizeof(ST_fpb_known)/sizeof(ST_fpb_known[0]))
+
+static int fpb_check(const s_fpb *fpb) ;
+static int fpb_check_col(const s_fpb_header *h, const s_fpb_col *c) ;
+static int fpb_check_rows(const s_fpb *fpb, const char *name, uint32_t nrows, 
+						  int ptr, uint32_t max) ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_open
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Map a result file and check its header and the columns (bounds, types,
+	alignment), so that the columns can then be used without any check.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *path : The file
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_fpb *: The file opened, NULL if it can't be read or is not valid.
+			 Must be closed by fpb_close.
+   -----------------------------------------------------------------------------
+*/
+s_fpb* fpb_open(const char *path)
+{
+	struct stat st ;
+	s_fpb *fpb = NULL ;
+	void *data ;
+	int fd = open(path, O_RDONLY) ;
+
+	if(fd < 0) {
+		fprintf(stderr, "! File %s could not be opened\n", path) ;
+		return NULL ;
+	}
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(s_fpb_header)) {
+		fprintf(stderr, "! %s is not a fpocket binary result\n", path) ;
+		close(fd) ;
+		return NULL ;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+	close(fd) ;
+	if(data == MAP_FAILED) {
+		fprintf(stderr, "! File %s could not be mapped\n", path) ;
+		return NULL ;
+	}
+
+	fpb = (s_fpb *) malloc(sizeof(s_fpb)) ;
+	if(fpb) {
+		fpb->data = (const char *) data ;
+		fpb->size = st.st_size ;
+		fpb->header = (const s_fpb_header *) data ;
+		fpb->cols = (const s_fpb_col *) (fpb->data + sizeof(s_fpb_header)) ;
+	}
+	if(!fpb || !fpb_check(fpb)) {
+		fprintf(stderr, "! %s is not a valid fpocket binary result\n", path) ;
+		munmap(data, st.st_size) ;
+		free(fpb) ;
+		return NULL ;
+	}
+
+	return fpb ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_check
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check the header and the directory of a mapped result file (columns of
+	write_pockets_bin as it writes them, see fpb_check_col), and the values
+	giving rows of another table (CSR pointers, atoms of the pockets and of
+	the alpha spheres), so that they can be followed without check.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb : The file
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the file is valid, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int fpb_check(const s_fpb *fpb)
+{
+	const s_fpb_header *h = fpb->header ;
+	const s_fpb_col *c ;
+	uint64_t end ;
+	uint32_t i ;
+
+	if(memcmp(h->magic, M_FPB_MAGIC, 8) != 0 || h->version != M_FPB_VERSION
+	   || h->byte_order != M_FPB_BYTE_ORDER || h->size != fpb->size
+	   || h->ncols > (fpb->size - sizeof(s_fpb_header))/sizeof(s_fpb_col)) {
+		return 0 ;
+	}
+
+	for(i = 0 ; i < h->ncols ; i++) {
+		c = fpb->cols + i ;
+		if(memchr(c->name, '\0', M_FPB_NAME_LEN) == NULL
+		   || c->type < M_FPB_F32 || c->type > M_FPB_CHAR 
+		   || c->offset % M_FPB_ALIGN != 0 || c->offset > fpb->size
+		   || c->width == 0 || c->nrows > fpb->size) {
+			return 0 ;
+		}
+		end = c->nrows*c->width*((c->type == M_FPB_CHAR) ? 1 : 4) ;
+		if(end > fpb->size - c->offset || !fpb_check_col(h, c)) return 0 ;
+	}
+
+	return fpb_check_rows(fpb, M_FPB_POCK_SPH_PTR, h->npockets + 1, 1, h->nspheres)
+		   && fpb_check_rows(fpb, M_FPB_POCK_ATM_PTR, h->npockets + 1, 1, h->nmembers)
+		   && fpb_check_rows(fpb, M_FPB_POCK_ATOMS, h->nmembers, 0, h->natoms)
+		   && fpb_check_rows(fpb, M_FPB_SPH_ATOMS, h->nspheres, 0, h->natoms) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_check_col
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check a column written by write_pockets_bin (ST_fpb_known, or a
+	descriptor): its type and width are the ones written, and it has a row
+	per row of its table. Other columns are left to the caller.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb_header *h : Header of the file
+	@ const s_fpb_col *c    : The column
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the column is valid or not known, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int fpb_check_col(const s_fpb_header *h, const s_fpb_col *c)
+{
+	const s_fpb_known *k = NULL ;
+	uint64_t nrows[5] ;
+	int i ;
+
+	nrows[M_FPB_TAB_POCK] = h->npockets ;
+	nrows[M_FPB_TAB_PTR] = (uint64_t) h->npockets + 1 ;
+	nrows[M_FPB_TAB_SPH] = h->nspheres ;
+	nrows[M_FPB_TAB_ATM] = h->natoms ;
+	nrows[M_FPB_TAB_MEM] = h->nmembers ;
+
+	for(i = 0 ; i < M_FPB_NKNOWN ; i++) {
+		k = ST_fpb_known + i ;
+		if(strcmp(c->name, k->name) == 0) {
+			return c->type == k->type && c->width == k->width
+				   && c->nrows == nrows[k->table] ;
+		}
+	}
+
+	if(strncmp(c->name, "desc_", 5) == 0) {
+		return (c->type == M_FPB_F32 || c->type == M_FPB_I32) && c->width == 1
+			   && c->nrows == nrows[M_FPB_TAB_POCK] ;
+	}
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_check_rows
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check a column of rows of another table: number of rows, and values
+	lower than max, or, for CSR pointers (ptr), values increasing from 0 to
+	max.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb : The file
+	@ const char *name : Name of the column
+	@ uint32_t nrows   : Number of rows expected
+	@ int ptr          : 1 for CSR pointers, 0 for rows
+	@ uint32_t max     : Rows of the table pointed
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the column is valid, 0 if not (or not found)
+   -----------------------------------------------------------------------------
+*/
+static int fpb_check_rows(const s_fpb *fpb, const char *name, uint32_t nrows, 
+						  int ptr, uint32_t max)
+{
+	const s_fpb_col *c = fpb_col(fpb, name) ;
+	const int32_t *v ;
+	uint64_t i, n ;
+
+	if(!c || c->type != M_FPB_I32 || c->nrows != nrows) return 0 ;
+	v = (const int32_t *) (fpb->data + c->offset) ;
+	n = c->nrows*c->width ;
+
+	for(i = 0 ; i < n ; i++) {
+		if(v[i] < 0 || (uint32_t) v[i] > max) return 0 ;
+		if(ptr && i > 0 && v[i] < v[i-1]) return 0 ;
+		if(!ptr && (uint32_t) v[i] == max) return 0 ;
+	}
+
+	return !ptr || (v[0] == 0 && (uint32_t) v[n-1] == max) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_close
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Unmap a result file. Columns given for this file can't be used anymore.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fpb *fpb : The file
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void fpb_close(s_fpb *fpb)
+{
+	if(fpb) {
+		munmap((void *) fpb->data, fpb->size) ;
+		free(fpb) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_col
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Find a column by its name (see the M_FPB_* names in fpbin.h).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb : The file
+	@ const char *name : Name of the column
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	const s_fpb_col *: The column in the directory, NULL if not found
+   -----------------------------------------------------------------------------
+*/
+const s_fpb_col* fpb_col(const s_fpb *fpb, const char *name)
+{
+	uint32_t i ;
+
+	for(i = 0 ; i < fpb->header->ncols ; i++) {
+		if(strcmp(fpb->cols[i].name, name) == 0) return fpb->cols + i ;
+	}
+
+	return NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_f32, fpb_i32, fpb_chars
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Values of a column of reals, integers or characters, in the mapping.
+	Row i is at i*width.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb : The file
+	@ const char *name : Name of the column
+	@ int *width       : OUTPUT Values per row (may be NULL)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	The values, NULL if the column is not found or not of this type
+   -----------------------------------------------------------------------------
+*/
+const float* fpb_f32(const s_fpb *fpb, const char *name, int *width)
+{
+	const s_fpb_col *c = fpb_col(fpb, name) ;
+
+	if(!c || c->type != M_FPB_F32) return NULL ;
+	if(width) *width = c->width ;
+
+	return (const float *) (fpb->data + c->offset) ;
+}
+
+const int32_t* fpb_i32(const s_fpb *fpb, const char *name, int *width)
+{
+	const s_fpb_col *c = fpb_col(fpb, name) ;
+
+	if(!c || c->type != M_FPB_I32) return NULL ;
+	if(width) *width = c->width ;
+
+	return (const int32_t *) (fpb->data + c->offset) ;
+}
+
+const char* fpb_chars(const s_fpb *fpb, const char *name, int *width)
+{
+	const s_fpb_col *c = fpb_col(fpb, name) ;
+
+	if(!c || c->type != M_FPB_CHAR) return NULL ;
+	if(width) *width = c->width ;
+
+	return fpb->data + c->offset ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_pocket_atoms
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Atoms contacted by the alpha spheres of a pocket, as rows of the atom
+	table, in the order of the pocketN_atm.pdb file.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb      : The file
+	@ int pocket            : Row of the pocket (0 for the first pocket)
+	@ const int32_t **atoms : OUTPUT Rows of the atoms in the atom table
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of atoms, -1 if the pocket or the columns are not found
+   -----------------------------------------------------------------------------
+*/
+int fpb_pocket_atoms(const s_fpb *fpb, int pocket, const int32_t **atoms)
+{
+	const int32_t *ptr = fpb_i32(fpb, M_FPB_POCK_ATM_PTR, NULL),
+				  *idx = fpb_i32(fpb, M_FPB_POCK_ATOMS, NULL) ;
+
+	if(!ptr || !idx || pocket < 0 || pocket >= (int) fpb->header->npockets) return -1 ;
+	*atoms = idx + ptr[pocket] ;
+
+	return ptr[pocket+1] - ptr[pocket] ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fpb_pocket_spheres
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Alpha spheres of a pocket: rows first to first+n-1 of the sph_* columns.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_fpb *fpb : The file
+	@ int pocket       : Row of the pocket (0 for the first pocket)
+	@ int *first       : OUTPUT First row of the pocket in the sphere table
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of alpha spheres n, -1 if the pocket or the column is not
+	found
+   -----------------------------------------------------------------------------
+*/
+int fpb_pocket_spheres(const s_fpb *fpb, int pocket, int *first)
+{
+	const int32_t *ptr = fpb_i32(fpb, M_FPB_POCK_SPH_PTR, NULL) ;
+
+	if(!ptr || pocket < 0 || pocket >= (int) fpb->header->npockets) return -1 ;
+	*first = ptr[pocket] ;
+
+	return ptr[pocket+1] - ptr[pocket] ;
+}
@@ -7,7 +7,7 @@
 ##
 ## FILE 					fpmain.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			01-04-08
+## LAST MODIFIED			17-11-15
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -16,6 +16,16 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     process_pdb returns -1 if the pockets could not be found
+##					 or written
+##	17-11-15	     List of pdb always handled by process_pdb_batch (summary
+##					 written with one worker too). Exit status 1 if a pdb
+##					 could not be handled
+##	17-10-31	     List of pdb handled by a single process: tesselation
+##					 memory kept between pdb, time and resident memory
+##					 reported for each pdb. The pdb is freed by process_pdb
+##	17-10-26	     List of pdb handled by fpbatch (-w worker processes),
+##					 process_pdb returns the number of pockets found
 ##	19-01-09	(v)  Minor modif (print on the same line)
 ##	28-11-08	(v)  process_pdb added, list of pdb taken into account as input
 ##					 Comments UTD.
@@ -70,6 +80,8 @@
 */
 int main(int argc, char *argv[])
 {
+	int status = 0 ;
+
 	fprintf(stdout, "***** POCKET HUNTING BEGINS ***** \n") ;
 
 	s_fparams *params = get_fpocket_args(argc, argv) ;
@@ -78,25 +90,15 @@ int main(int argc, char *argv[])
 	if(params) {
 		if(params->pdb_lst != NULL) {
 		/* Handle a list of pdb */
-			int i ;
-            for (i = 0 ; i < params->npdb ; i++) {
-				
-				printf("> Protein %d / %d : %s", i, params->npdb,
-												   params->pdb_lst[i]) ;
-				if(i == params->npdb - 1) fprintf(stdout, "\n") ;
-				else fprintf(stdout, "\r") ;
-				fflush(stdout) ;
-                process_pdb(params->pdb_lst[i], params) ;
-            }
+			if(process_pdb_batch(params) > 0) status = 1 ;
 		}
 		else {
 			if(params->pdb_path == NULL || strlen(params->pdb_path) <= 0) {
 				fprintf(stdout, "! Invalid pdb name given.\n");
 				print_pocket_usage(stdout) ;
+				status = 1 ;
 			}
-			else {
-				process_pdb(params->pdb_path, params) ;
-			}
+			else if(process_pdb(params->pdb_path, params) < 0) status = 1 ;
 		}
 	
 		free_fparams(params) ;
@@ -108,7 +110,7 @@ int main(int argc, char *argv[])
 	fprintf(stdout, "***** POCKET HUNTING ENDS ***** \n") ;
 	free_all() ;
 
-	return 0;
+	return status ;
 }
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
@@ -123,19 +125,22 @@ int main(int argc, char *argv[])
 	@ s_fparams *params : Parameters of the algorithm. See fparams.c/.h
    -----------------------------------------------------------------------------
    ## RETURN: 
-	void
+	int: Number of pockets found, -1 if the pdb couldn't be read, the pockets
+	couldn't be calculated or the output couldn't be written
    -----------------------------------------------------------------------------
 */
-void process_pdb(char *pdbname, s_fparams *params) 
+int process_pdb(char *pdbname, s_fparams *params) 
 {
+	int npockets = 0 ;
+
 	/* Check the PDB file */
-	if(pdbname == NULL) return ;
+	if(pdbname == NULL) return -1 ;
 	
 	int len = strlen(pdbname) ;
 	if(len >= M_MAX_PDB_NAME_LEN || len <= 0) {
 		fprintf(stderr, "! Invalid length for the pdb file name. (Max: %d, Min 1)\n",
 				M_MAX_PDB_NAME_LEN) ;
-		return ;
+		return -1 ;
 	}
 	
 	/* Try to open it */
@@ -146,9 +151,21 @@ void process_pdb(char *pdbname, s_fparams *params)
 			rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
 			c_lst_pockets *pockets = search_pocket(pdb, params);
 			if(pockets) {
-				write_out_fpocket(pockets, pdb, pdbname);
+				npockets = (int) pockets->n_pockets ;
+				if(write_out_fpocket(pockets, pdb, pdbname, params->out_layout,
+									 params->out_bin) != 0) {
+					fprintf(stderr, "! Output of %s could not be written!\n", pdbname);
+					npockets = -1 ;
+				}
 				c_lst_pocket_free(pockets) ;
 			}
+			else npockets = -1 ;
+			free_pdb_atoms(pdb) ;
 	}
-	else fprintf(stderr, "! PDB reading failed!\n");
+	else {
+		fprintf(stderr, "! PDB reading failed!\n");
+		return -1 ;
+	}
+
+	return npockets ;
 }
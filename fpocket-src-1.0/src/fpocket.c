@@ -19,6 +19,15 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-06	     Volume engine set from the parameters (-V)
+##	17-11-05	     Descriptor threads (-j) and seed (-S) set from the parameters
+##	17-11-04	     Table of the pockets built after the single linkage step
+##	17-10-30	     Tesselation engine set from the parameters (-T)
+##	17-10-28	     Partitioned tesselation if more than one thread (-t)
+##	17-10-27	     Alpha spheres read from / written to the cache (-c)
+##	17-10-27	     update_pocket_search added (local re-tesselation after a
+##					 structure modification), pocket steps moved in
+##					 search_pocket_vert
 ##	09-02-09	(v)  Drop tiny pocket step added
 ##	28-11-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added comments and creation of history
@@ -85,8 +94,6 @@ c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params)
 	clock_t b, e ;
 	time_t bt, et ;
 */
-	c_lst_pockets *pockets = NULL ;
-
 	/* Calculate and read voronoi vertices comming from qhull */
 /*
  	fprintf(stdout,"========= fpocket algorithm begins =========\n") ;
@@ -95,9 +102,35 @@ c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params)
 
 	bt = time(NULL) ;
 */
-	s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh, 
-												params->asph_min_size, 
-												params->asph_max_size) ;
+	s_lst_vvertice *lvert = NULL ;
+	uint64_t key = 0 ;
+
+	if(params->cache_dir[0] != '\0') {
+		key = get_vvertices_key(pdb, params->min_apol_neigh, 
+								params->asph_min_size, params->asph_max_size,
+								(params->nthreads > 1) + 2*params->delaunay) ;
+		lvert = read_vvertices_cache(params->cache_dir, pdb, key) ;
+	}
+	if(lvert == NULL) {
+		set_delaunay_engine(params->delaunay) ;
+		if(params->nthreads > 1) {
+			lvert = load_vvertices_part(pdb, params->min_apol_neigh, 
+										params->asph_min_size, 
+										params->asph_max_size,
+										params->nthreads) ;
+		}
+		else {
+			lvert = load_vvertices(pdb, params->min_apol_neigh, 
+									params->asph_min_size, 
+									params->asph_max_size) ;
+		}
+		if(lvert != NULL && params->cache_dir[0] != '\0') {
+			if(write_vvertices_cache(params->cache_dir, pdb, key, lvert) != 0) {
+				fprintf(stderr, "! Alpha spheres couldn't be written in the cache %s\n",
+						params->cache_dir) ;
+			}
+		}
+	}
 /*
 	et = time(NULL) ;
  	fprintf(stdout, "> Vertices successfully calculated in apox. %f sec.\n",
@@ -108,6 +141,71 @@ c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params)
 		fprintf(stderr, "! Vertice calculation failed!\n");
 		return NULL ;
 	}
+
+	return search_pocket_vert(lvert, params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	update_pocket_search
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Search pockets on a modified version of a structure already handled by
+	search_pocket (typically after a mutation). Only atoms close to the
+	modification are tesselated again (see update_vvertices), the
+	pockets are then built from the updated vertices.
+	The old pockets are left untouched.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets : Pockets found on the original structure
+	@ s_pdb *old             : The original structure
+	@ s_pdb *pdb             : The modified structure
+	@ s_fparams              : Parameters of the algorithm
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	A chained list of pockets found on the modified structure
+   -----------------------------------------------------------------------------
+*/
+c_lst_pockets* update_pocket_search(c_lst_pockets *pockets, s_pdb *old,
+									s_pdb *pdb, s_fparams *params)
+{
+	if(pockets == NULL || pockets->vertices == NULL) {
+		return search_pocket(pdb, params) ;
+	}
+
+	set_delaunay_engine(params->delaunay) ;
+	s_lst_vvertice *lvert = update_vvertices(pockets->vertices, old, pdb,
+											 params->min_apol_neigh, 
+											 params->asph_min_size, 
+											 params->asph_max_size) ;
+	if(lvert == NULL) {
+		fprintf(stderr, "! Vertice calculation failed!\n");
+		return NULL ;
+	}
+
+	return search_pocket_vert(lvert, params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	search_pocket_vert
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Clustering, refinment, descriptors and sorting of pockets, starting from
+	a list of vertices. The vertices are then owned by the pockets returned.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvert : The vertices of the protein
+	@ s_fparams             : Parameters of the algorithm
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	A chained list of pockets found, sorted according to the current critera
+   -----------------------------------------------------------------------------
+*/
+c_lst_pockets* search_pocket_vert(s_lst_vvertice *lvert, s_fparams *params)
+{
+	c_lst_pockets *pockets = NULL ;
+
 	/* First clustering */
 /* 		fprintf(stdout,"> Basic clustering ...\n");
 
@@ -143,6 +241,7 @@ c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params)
 		fprintf(stdout,"\t* 3rd refinment step -> single linkage clusturing...\n");
 */
 		pck_ml_clust(pockets, params);	/* Single Linkage Clustering */
+		set_pockets_table(pockets) ;	/* One row per pocket in the table */
 		reIndexPockets(pockets) ;
 
 	/* Descriptors calculation */
@@ -150,6 +249,9 @@ c_lst_pockets* search_pocket(s_pdb *pdb, s_fparams *params)
 		fprintf(stdout,"> Calculating descriptors and score...\n");
 		b = clock() ;
 */
+		if(params->rand_seed >= 0) set_rand_seed(params->rand_seed) ;
+		set_pockets_desc_threads(params->desc_threads) ;
+		set_volume_engine(params->volume) ;
 		set_pockets_descriptors(pockets);
 /*
 		e = clock() ;
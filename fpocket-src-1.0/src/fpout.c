@@ -7,7 +7,7 @@
 ##
 ## FILE 					fpout.h
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			28-11-08
+## LAST MODIFIED			17-11-15
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -15,6 +15,12 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     write_out_fpocket returns a status
+##	17-11-14	     Binary columnar result X_pockets.fpb if asked (bin)
+##	17-11-13	     Directories created with mkdir(2) instead of system().
+##					 Pockets written in X_pockets.pack if asked (layout)
+##	17-11-12	     Output named after the structure without its compression
+##					 extension (1ATP.pdb.gz gives 1ATP_out)
 ##	12-02-09	(v)  No more pocket.info output (useless...)
 ##	15-12-08	(v)  Minor bug corrected (output dir in the current dir...)
 ##	28-11-08	(v)  Last argument of write_out_fpocket changed to char *
@@ -24,7 +30,6 @@
 ##	
 ## ----- TODO or SUGGESTIONS
 ##
-##	(v) Handle system command failure, clean!
 
 */
 
@@ -60,6 +65,8 @@
 
 **/
 
+static int make_out_dir(const char *path) ;
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	write_out_fpocket
@@ -71,35 +78,39 @@
  *  @ c_lst_pockets *pockets : All pockets found and kept.
  *  @ c_lst_pockets *pockets : The (input) pdb structure
 	@ char *pdbname          : Name of the pdb
+	@ int layout             : Output of each pocket: M_OUT_FILES (pqr and pdb
+							   files in the pockets directory) or M_OUT_PACK
+							   (single file X_pockets.pack, see 
+							   write_pockets_pack)
+	@ int bin                : 1 to write also X_pockets.fpb (binary columnar
+							   result, see write_pockets_bin and fpbin.h)
    -----------------------------------------------------------------------------
    ## RETURN: 
-	void
+	int: 0 if the output has been written, 1 if no pockets were given or a
+	directory or a file could not be written
    -----------------------------------------------------------------------------
 */
-void write_out_fpocket(c_lst_pockets *pockets, s_pdb *pdb, char *pdbname) 
+int write_out_fpocket(c_lst_pockets *pockets, s_pdb *pdb, char *pdbname, int layout, int bin) 
 {
 	char pdb_code[350] = "" ;
 	char pdb_path[350] = "" ;
 	char out_path[350] = "" ;
 	char pdb_out_path[350] = "" ;
 	char fout[350] = "" ;
-	char command[370] = "" ;
-	int status ;
+	int status = 0 ;
 	
 	if(pockets) {
 	/* Extract path, pdb code... */
 		strcpy(pdb_code, pdbname) ;
 		extract_path(pdbname, pdb_path) ;
-		remove_ext(pdb_code) ;
+		remove_pdb_ext(pdb_code) ;
 		remove_path(pdb_code) ;
 
 		if(strlen(pdb_path) > 0) sprintf(out_path, "%s/%s_out", pdb_path, pdb_code) ;
 		else sprintf(out_path, "%s_out", pdb_code) ;
 		
-		sprintf(command, "mkdir %s", out_path) ;
-		status = system(command) ;
-		if(status != 0) {
-			return ;
+		if(make_out_dir(out_path) != 0) {
+			return 1 ;
 		}
 		
 		sprintf(out_path, "%s/%s", out_path, pdb_code) ;
@@ -112,23 +123,62 @@ void write_out_fpocket(c_lst_pockets *pockets, s_pdb *pdb, char *pdbname)
 	/* Writing full pdb */
 		sprintf(pdb_out_path, "%s_out.pdb", out_path) ;
 
-		write_pockets_single_pdb(pdb_out_path, pdb, pockets) ;
+		status += write_pockets_single_pdb(pdb_out_path, pdb, pockets) ;
 	
 	/* Writing pockets as a single pqr */
 		sprintf(fout, "%s_pockets.pqr", out_path) ;
-		write_pockets_single_pqr(fout, pockets) ;
+		status += write_pockets_single_pqr(fout, pockets) ;
+
+	/* Writing the binary result */
+		if(bin) {
+			sprintf(fout, "%s_pockets.fpb", out_path) ;
+			status += write_pockets_bin(fout, pdb, pockets) ;
+		}
+
+	/* Writing individual pockets in a single packed file */
+		if(layout == M_OUT_PACK) {
+			sprintf(fout, "%s_pockets.pack", out_path) ;
+			status += write_pockets_pack(fout, pockets) ;
+			return (status > 0) ;
+		}
 
 	/* Writing individual pockets pqr */
 		if(strlen(pdb_path) > 0) sprintf(out_path, "%s/%s_out", pdb_path, pdb_code) ;
 		else sprintf(out_path, "%s_out", pdb_code) ;
 		
 		sprintf(out_path, "%s/pockets", out_path) ;
-		sprintf(command, "mkdir %s", out_path) ;
-		status = system(command) ;
-		if(status != 0) {
-			return ;
+		if(make_out_dir(out_path) != 0) {
+			return 1 ;
 		}
 
 		write_each_pocket(out_path, pockets) ;
+
+		return (status > 0) ;
+	}
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	make_out_dir
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Create an output directory (mkdir(2), no shell is run).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *path : The directory
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	int: 0 if the directory has been created, 1 if not
+   -----------------------------------------------------------------------------
+*/
+static int make_out_dir(const char *path)
+{
+	if(mkdir(path, 0777) != 0) {
+		fprintf(stderr, "! Cannot create directory %s (%s)\n", path, strerror(errno)) ;
+		return 1 ;
 	}
+
+	return 0 ;
 }
@@ -32,6 +32,8 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-10-28	     The list of pointers is protected by a mutex, so my_malloc
+##					 and my_free can be called from several threads
 ##	28-11-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added comments and creation of history
 ##	01-01-08	(vp) Created (random date...)
@@ -94,6 +96,9 @@ typedef struct
 
 /* A list containing all the allocated pointers. */
 static ptr_lst *ST_lst_alloc = NULL ;
+
+/* Lock of the list, as blocs can be allocated by several threads */
+static pthread_mutex_t ST_lst_lock = PTHREAD_MUTEX_INITIALIZER ;
 #ifdef M_MEM_DEBUG
 static FILE *ST_fdebug = NULL ;
 #endif
@@ -291,6 +296,8 @@ static void add_bloc(void *bloc)
 		if(ST_fdebug) fprintf(ST_fdebug, "> Adding bloc %p\n", bloc) ;
 	#endif
 
+	pthread_mutex_lock(&ST_lst_lock) ;
+
 	/* First check if the list exists, if not create it. */
 	if(!ST_lst_alloc) {
 
@@ -321,6 +328,8 @@ static void add_bloc(void *bloc)
 	}
 
 	ST_lst_alloc->n_ptr += 1 ;
+
+	pthread_mutex_unlock(&ST_lst_lock) ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -344,6 +353,8 @@ static void remove_bloc(void *bloc)
 #ifdef M_MEM_DEBUG
 	size_t i = 0 ;
 #endif
+	pthread_mutex_lock(&ST_lst_lock) ;
+
 	/* First check if the list exists, if not create it. */
 
 	if(ST_lst_alloc) {
@@ -394,6 +405,8 @@ static void remove_bloc(void *bloc)
 		if(ST_fdebug) fprintf(ST_fdebug, "! No bloc allocated -> cannot remove given argument from an empty list.\n") ;
 	}	
 	#endif
+
+	pthread_mutex_unlock(&ST_lst_lock) ;
 }
 
 /**-----------------------------------------------------------------------------
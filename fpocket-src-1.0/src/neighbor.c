@@ -13,13 +13,18 @@
 ##
 ## This file define functions used to perform a space search
 ## operation like looking for all neighbors of a given molecule
-## situated at a given distance. It makes use of a sorting system,
-## which sort all atoms/vertices according to each dimension.
-##
-## See sort.c for information on the sorting procedure.
+## situated at a given distance. Atoms and vertices are put once per
+## structure in a spatial index (s_nindex, uniform grid), giving
+## radius, k nearest and batch queries. The original functions, sorting
+## all atoms/vertices on X at each call (see sort.c), are kept with the
+## _naive suffix.
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-09	     Spatial index of atoms and vertices (s_nindex), all
+##					     searches done on it
+##	17-11-08	     Atoms and vertices already found kept in a set of ids (s_idset),
+##					     no more variable length array
 ##	11-02-09	(v)  Modified argument type for sorting function
 ##	28-11-08	(v)  Comments UTD + relooking.
 ##	01-04-08	(v)  Added template for comments and creation of history
@@ -63,16 +68,829 @@
 
 **/
 
+static int get_nindex_cells(s_nindex *ind, float x, float y, float z,
+							float dcrit, int *lo, int *hi) ;
+static void get_nindex_range(s_nindex *ind, int cell, int type,
+							 int *start, int *end) ;
+static int add_nindex_neigh(s_nindex *ind, float x, float y, float z,
+							float dcrit, int type, s_idset *seen,
+							int n, int **res, int *nmax) ;
+static void add_nindex_knearest(s_nindex *ind, int cell, int type,
+								float x, float y, float z, int k,
+								int *res, float *rdist, int *n) ;
+static float* get_atoms_xyz(s_atm **atoms, int natoms) ;
+static int cmp_nindex_ptr(const void *a, const void *b) ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	alloc_nindex
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Build the spatial index of the given atoms and vertices: elements are
+	sorted by cell of a uniform grid of cell size cs (larger if the box
+	would have more than M_NINDEX_CELLS_PER_ELEM cells per element), atoms
+	of each cell first, in the order of the input. The index is built once
+	per structure in O(n), and queries of any distance can be done on it,
+	the best being a cell size close to the distance criteria used.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm **atoms       : Atoms to index (may be NULL)
+	@ int natoms          : Number of atoms
+	@ s_vvertice **pvert  : Vertices to index (may be NULL)
+	@ int nvert           : Number of vertices
+	@ float cs            : Size of the cells
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_nindex *: The index, to free with free_nindex
+   -----------------------------------------------------------------------------
+*/
+s_nindex* alloc_nindex(s_atm **atoms, int natoms, s_vvertice **pvert, int nvert,
+					   float cs)
+{
+	s_nindex *ind = (s_nindex *) my_malloc(sizeof(s_nindex)) ;
+	int i, c, cx, cy, cz, ncell,
+		n = natoms + nvert ;
+	int *key = (int *) my_malloc((n+1)*sizeof(int)) ;
+	float *xyz = (float *) my_malloc((3*n+3)*sizeof(float)) ;
+	float xmax = 0.0, ymax = 0.0, zmax = 0.0, *p = NULL ;
+
+	ind->n = n ;
+	ind->natm = natoms ;
+	ind->nvert = nvert ;
+	ind->elem = (s_vect_elem *) my_malloc((n+1)*sizeof(s_vect_elem)) ;
+	ind->xyz = (float *) my_malloc((3*n+3)*sizeof(float)) ;
+
+	for(i = 0 ; i < natoms ; i++) {
+		xyz[3*i] = atoms[i]->x ;
+		xyz[3*i+1] = atoms[i]->y ;
+		xyz[3*i+2] = atoms[i]->z ;
+	}
+	for(i = 0 ; i < nvert ; i++) {
+		xyz[3*(natoms+i)] = pvert[i]->x ;
+		xyz[3*(natoms+i)+1] = pvert[i]->y ;
+		xyz[3*(natoms+i)+2] = pvert[i]->z ;
+	}
+
+	ind->xmin = ind->ymin = ind->zmin = 0.0 ;
+	for(i = 0 ; i < n ; i++) {
+		p = xyz + 3*i ;
+		if(i == 0 || p[0] < ind->xmin) ind->xmin = p[0] ;
+		if(i == 0 || p[0] > xmax) xmax = p[0] ;
+		if(i == 0 || p[1] < ind->ymin) ind->ymin = p[1] ;
+		if(i == 0 || p[1] > ymax) ymax = p[1] ;
+		if(i == 0 || p[2] < ind->zmin) ind->zmin = p[2] ;
+		if(i == 0 || p[2] > zmax) zmax = p[2] ;
+	}
+
+	ind->cs = (cs > 0.01) ? cs : 0.01 ;
+	while(((double)(xmax-ind->xmin)/ind->cs + 1.0) * ((double)(ymax-ind->ymin)/ind->cs + 1.0)
+		  * ((double)(zmax-ind->zmin)/ind->cs + 1.0)
+		  > (double) M_NINDEX_CELLS_PER_ELEM*n + 64.0) ind->cs *= 2.0 ;
+
+	ind->nx = (int)((xmax-ind->xmin)/ind->cs) + 1 ;
+	ind->ny = (int)((ymax-ind->ymin)/ind->cs) + 1 ;
+	ind->nz = (int)((zmax-ind->zmin)/ind->cs) + 1 ;
+	ncell = ind->nx*ind->ny*ind->nz ;
+
+	/* Counting sort of the elements by cell and type */
+	ind->cstart = (int *) my_calloc(2*ncell+1, sizeof(int)) ;
+	for(i = 0 ; i < n ; i++) {
+		p = xyz + 3*i ;
+		cx = (int)((p[0]-ind->xmin)/ind->cs) ;
+		cy = (int)((p[1]-ind->ymin)/ind->cs) ;
+		cz = (int)((p[2]-ind->zmin)/ind->cs) ;
+		if(cx >= ind->nx) cx = ind->nx-1 ;
+		if(cy >= ind->ny) cy = ind->ny-1 ;
+		if(cz >= ind->nz) cz = ind->nz-1 ;
+		key[i] = 2*((cz*ind->ny + cy)*ind->nx + cx) + (i >= natoms) ;
+		ind->cstart[key[i]+1]++ ;
+	}
+	for(c = 0 ; c < 2*ncell ; c++) ind->cstart[c+1] += ind->cstart[c] ;
+	for(i = 0 ; i < n ; i++) {
+		c = ind->cstart[key[i]]++ ;
+		if(i < natoms) {
+			ind->elem[c].data = atoms[i] ;
+			ind->elem[c].type = M_ATOM_TYPE ;
+		}
+		else {
+			ind->elem[c].data = pvert[i-natoms] ;
+			ind->elem[c].type = M_VERTICE_TYPE ;
+		}
+		ind->xyz[3*c] = xyz[3*i] ;
+		ind->xyz[3*c+1] = xyz[3*i+1] ;
+		ind->xyz[3*c+2] = xyz[3*i+2] ;
+	}
+	for(c = 2*ncell ; c > 0 ; c--) ind->cstart[c] = ind->cstart[c-1] ;
+	ind->cstart[0] = 0 ;
+
+	my_free(key) ;
+	my_free(xyz) ;
+
+	return ind ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	free_nindex
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Free the index (not the atoms and vertices).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind : The index
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void free_nindex(s_nindex *ind)
+{
+	if(ind) {
+		my_free(ind->elem) ;
+		my_free(ind->xyz) ;
+		my_free(ind->cstart) ;
+		my_free(ind) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_nindex_cells
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Cells of the index to look at for elements within dcrit of (x, y, z),
+	given as a range of cells in each dimension.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float x, y, z     : The query point
+	@ float dcrit       : The distance criteria
+	@ int *lo, *hi      : OUTPUT First and last cell in each dimension
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 0 if no cell of the index is close enough, 1 else
+   -----------------------------------------------------------------------------
+*/
+static int get_nindex_cells(s_nindex *ind, float x, float y, float z,
+							float dcrit, int *lo, int *hi)
+{
+	float p[3] = {x - ind->xmin, y - ind->ymin, z - ind->zmin} ;
+	int nc[3] = {ind->nx, ind->ny, ind->nz}, k ;
+	double r = dcrit + M_NINDEX_MARGIN, flo, fhi ;
+
+	if(ind->n <= 0) return 0 ;
+	for(k = 0 ; k < 3 ; k++) {
+		flo = floor((p[k] - r) / ind->cs) ;
+		fhi = floor((p[k] + r) / ind->cs) ;
+		if(fhi < 0.0 || flo >= nc[k]) return 0 ;
+
+		lo[k] = (flo < 0.0) ? 0 : (int) flo ;
+		hi[k] = (fhi >= nc[k]) ? nc[k]-1 : (int) fhi ;
+	}
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_nindex_range
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Elements of the given type in a cell of the index: [start, end[
+   -----------------------------------------------------------------------------
+*/
+static void get_nindex_range(s_nindex *ind, int cell, int type,
+							 int *start, int *end)
+{
+	*start = ind->cstart[2*cell + (type == M_VERTICE_TYPE)] ;
+	*end = ind->cstart[2*cell + 1 + (type != M_ATOM_TYPE)] ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	add_nindex_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Add to res the elements of the given type situated at a distance lower
+	than dcrit from (x, y, z), and not already in the set seen, if given
+	(elements added are put in the set).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float x, y, z     : The query point
+	@ float dcrit       : The distance criteria
+	@ int type          : M_ATOM_TYPE, M_VERTICE_TYPE or M_NINDEX_ALL
+	@ s_idset *seen     : Elements already found (may be NULL)
+	@ int n             : Number of elements already in res
+	@ int **res         : OUTPUT Elements found (reallocated if needed)
+	@ int *nmax         : OUTPUT Size of res
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of elements in res
+   -----------------------------------------------------------------------------
+*/
+static int add_nindex_neigh(s_nindex *ind, float x, float y, float z,
+							float dcrit, int type, s_idset *seen,
+							int n, int **res, int *nmax)
+{
+	int lo[3], hi[3], cx, cy, cz, k, end ;
+	float *p = NULL ;
+
+	if(!get_nindex_cells(ind, x, y, z, dcrit, lo, hi)) return n ;
+
+	for(cz = lo[2] ; cz <= hi[2] ; cz++) {
+		for(cy = lo[1] ; cy <= hi[1] ; cy++) {
+			for(cx = lo[0] ; cx <= hi[0] ; cx++) {
+				get_nindex_range(ind, (cz*ind->ny + cy)*ind->nx + cx, type, &k, &end) ;
+				for( ; k < end ; k++) {
+					p = ind->xyz + 3*k ;
+					if(dist(p[0], p[1], p[2], x, y, z) >= dcrit) continue ;
+					if(seen && !add_idset(seen, k)) continue ;
+
+					if(n >= *nmax) {
+						*nmax = 2*(*nmax) + 16 ;
+						if(*res) *res = (int *) my_realloc(*res, (*nmax)*sizeof(int)) ;
+						else *res = (int *) my_malloc((*nmax)*sizeof(int)) ;
+					}
+					(*res)[n++] = k ;
+				}
+			}
+		}
+	}
+
+	return n ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_nindex_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Radius query: elements of the given type situated at a distance lower
+	than dcrit from (x, y, z), as indexes in ind->elem.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float x, y, z     : The query point
+	@ float dcrit       : The distance criteria
+	@ int type          : M_ATOM_TYPE, M_VERTICE_TYPE or M_NINDEX_ALL
+	@ int **res         : OUTPUT Elements found. May be NULL, and is
+						  reallocated if needed, so it can be used for
+						  several queries. To free with my_free.
+	@ int *nmax         : OUTPUT Size of res (0 if res is NULL)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of elements found
+   -----------------------------------------------------------------------------
+*/
+int get_nindex_neigh(s_nindex *ind, float x, float y, float z, float dcrit,
+					 int type, int **res, int *nmax)
+{
+	return add_nindex_neigh(ind, x, y, z, dcrit, type, NULL, 0, res, nmax) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	is_nindex_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Say if at least one element of the given type lies at a distance lower
+	than dcrit from (x, y, z). Stops at the first one found.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float x, y, z     : The query point
+	@ float dcrit       : The distance criteria
+	@ int type          : M_ATOM_TYPE, M_VERTICE_TYPE or M_NINDEX_ALL
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if an element is found, 0 if not
+   -----------------------------------------------------------------------------
+*/
+int is_nindex_neigh(s_nindex *ind, float x, float y, float z, float dcrit,
+					int type)
+{
+	int lo[3], hi[3], cx, cy, cz, k, end ;
+	float *p = NULL ;
+
+	if(!get_nindex_cells(ind, x, y, z, dcrit, lo, hi)) return 0 ;
+
+	for(cz = lo[2] ; cz <= hi[2] ; cz++) {
+		for(cy = lo[1] ; cy <= hi[1] ; cy++) {
+			for(cx = lo[0] ; cx <= hi[0] ; cx++) {
+				get_nindex_range(ind, (cz*ind->ny + cy)*ind->nx + cx, type, &k, &end) ;
+				for( ; k < end ; k++) {
+					p = ind->xyz + 3*k ;
+					if(dist(p[0], p[1], p[2], x, y, z) < dcrit) return 1 ;
+				}
+			}
+		}
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_nindex_knearest
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	k nearest elements of the given type from (x, y, z), by increasing
+	distance. Cells are looked at by shells around the cell of the query
+	point, until the k-th distance found is lower than the distance to the
+	cells not seen yet.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float x, y, z     : The query point
+	@ int k             : Number of elements asked
+	@ int type          : M_ATOM_TYPE, M_VERTICE_TYPE or M_NINDEX_ALL
+	@ int *res          : OUTPUT Elements found, as indexes in ind->elem
+						  (at least k values)
+	@ float *rdist      : OUTPUT Their distance to the query point (at least
+						  k values)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of elements found (k, or less if the index has less
+	elements of this type)
+   -----------------------------------------------------------------------------
+*/
+int get_nindex_knearest(s_nindex *ind, float x, float y, float z, int k,
+						int type, int *res, float *rdist)
+{
+	float p[3] = {x - ind->xmin, y - ind->ymin, z - ind->zmin} ;
+	int nc[3] = {ind->nx, ind->ny, ind->nz},
+		q[3], a, s, cx, cy, cz, n = 0, on_shell ;
+	double f, bound, edge ;
+
+	if(k <= 0 || ind->n <= 0) return 0 ;
+	if(type == M_ATOM_TYPE && ind->natm <= 0) return 0 ;
+	if(type == M_VERTICE_TYPE && ind->nvert <= 0) return 0 ;
+
+	for(a = 0 ; a < 3 ; a++) {
+		f = floor(p[a] / ind->cs) ;
+		q[a] = (f < 0.0) ? 0 : ((f >= nc[a]) ? nc[a]-1 : (int) f) ;
+	}
+
+	for(s = 0 ; ; s++) {
+		for(cz = q[2]-s ; cz <= q[2]+s ; cz++) {
+			if(cz < 0 || cz >= ind->nz) continue ;
+			for(cy = q[1]-s ; cy <= q[1]+s ; cy++) {
+				if(cy < 0 || cy >= ind->ny) continue ;
+				on_shell = (cz == q[2]-s || cz == q[2]+s || cy == q[1]-s || cy == q[1]+s) ;
+				for(cx = q[0]-s ; cx <= q[0]+s ; cx += (on_shell || s == 0) ? 1 : 2*s) {
+					if(cx < 0 || cx >= ind->nx) continue ;
+					add_nindex_knearest(ind, (cz*ind->ny + cy)*ind->nx + cx, type,
+										x, y, z, k, res, rdist, &n) ;
+				}
+			}
+		}
+
+		/* Distance from the query point to the cells not seen yet */
+		bound = -1.0 ;
+		for(a = 0 ; a < 3 ; a++) {
+			if(q[a]-s > 0) {
+				edge = p[a] - (q[a]-s)*(double)ind->cs ;
+				if(bound < 0.0 || edge < bound) bound = edge ;
+			}
+			if(q[a]+s < nc[a]-1) {
+				edge = (q[a]+s+1)*(double)ind->cs - p[a] ;
+				if(bound < 0.0 || edge < bound) bound = edge ;
+			}
+		}
+
+		/* All cells seen, or k elements closer than the cells not seen */
+		if(bound < 0.0 || (n == k && rdist[k-1] <= bound)) break ;
+	}
+
+	return n ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	add_nindex_knearest
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Insert the elements of the given type of a cell in the list of the k
+	nearest ones found (sorted by distance).
+   -----------------------------------------------------------------------------
+*/
+static void add_nindex_knearest(s_nindex *ind, int cell, int type,
+								float x, float y, float z, int k,
+								int *res, float *rdist, int *n)
+{
+	int i, j, end ;
+	float d, *p = NULL ;
+
+	get_nindex_range(ind, cell, type, &i, &end) ;
+	for( ; i < end ; i++) {
+		p = ind->xyz + 3*i ;
+		d = dist(p[0], p[1], p[2], x, y, z) ;
+		if(*n == k && d >= rdist[k-1]) continue ;
+
+		j = (*n < k) ? (*n)++ : k-1 ;
+		for( ; j > 0 && rdist[j-1] > d ; j--) {
+			rdist[j] = rdist[j-1] ;
+			res[j] = res[j-1] ;
+		}
+		rdist[j] = d ;
+		res[j] = i ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_nindex_batch_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Batch radius query: elements of the given type situated at a distance
+	lower than dcrit from at least one of the query points, each element
+	being given once, in the order they are found.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *ind     : The index
+	@ float *xyz        : The query points (x, y, z for each)
+	@ int nq            : Number of query points
+	@ float dcrit       : The distance criteria
+	@ int type          : M_ATOM_TYPE, M_VERTICE_TYPE or M_NINDEX_ALL
+	@ int *nneigh       : OUTPUT Number of elements found
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int *: Elements found, as indexes in ind->elem (to free with my_free)
+   -----------------------------------------------------------------------------
+*/
+int* get_nindex_batch_neigh(s_nindex *ind, float *xyz, int nq, float dcrit,
+							int type, int *nneigh)
+{
+	int i, n = 0, nmax = 16 ;
+	int *res = (int *) my_malloc(nmax*sizeof(int)) ;
+	s_idset *seen = alloc_idset(nq) ;
+
+	for(i = 0 ; i < nq ; i++) {
+		n = add_nindex_neigh(ind, xyz[3*i], xyz[3*i+1], xyz[3*i+2], dcrit,
+							 type, seen, n, &res, &nmax) ;
+	}
+
+	free_idset(seen) ;
+	*nneigh = n ;
+
+	return res ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_atoms_xyz
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Coordinates of a list of atoms (x, y, z for each), to use as query
+	points of a batch query.
+   -----------------------------------------------------------------------------
+*/
+static float* get_atoms_xyz(s_atm **atoms, int natoms)
+{
+	float *xyz = (float *) my_malloc((3*natoms+3)*sizeof(float)) ;
+	int i ;
+
+	for(i = 0 ; i < natoms ; i++) {
+		xyz[3*i] = atoms[i]->x ;
+		xyz[3*i+1] = atoms[i]->y ;
+		xyz[3*i+2] = atoms[i]->z ;
+	}
+
+	return xyz ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	get_mol_atm_neigh
    -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Return a list of pointer to the atoms situated a distance lower than
+	dcrit from a molecule represented by a list of atoms. Atoms of the
+	molecule are not returned (atoms having the same id).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm **atoms        : The molecule atoms.
+	@ int natoms		   : Number of atoms in the molecule
+	@ s_nindex *ind        : Index of all atoms of the system
+	@ float dcrit  	       : The distance criteria.
+	@ int *nneigh          : OUTPUT A pointer to the number of neighbour found,
+							 will be modified in the function...
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	A tab of pointers to the neighbours, with the number of neighbors stored in
+	nneigh
+   -----------------------------------------------------------------------------
+*/
+s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+						  float dcrit, int *nneigh)
+{
+	float *xyz = get_atoms_xyz(atoms, natoms) ;
+	int i, n, nb_neigh = 0 ;
+	int *found = get_nindex_batch_neigh(ind, xyz, natoms, dcrit, M_ATOM_TYPE, &n) ;
+	s_atm *cur = NULL ;
+	s_atm **neigh = (s_atm**) my_malloc(sizeof(s_atm*)*(n+1)) ;
+
+	/* Ids of the molecule and of the neighbours found */
+	s_idset *ids = alloc_idset(natoms + n) ;
+	for(i = 0 ; i < natoms ; i++) add_idset(ids, atoms[i]->id) ;
+
+	for(i = 0 ; i < n ; i++) {
+		cur = (s_atm *) ind->elem[found[i]].data ;
+		if(add_idset(ids, cur->id)) neigh[nb_neigh++] = cur ;
+	}
+
+	*nneigh = nb_neigh ;
+	free_idset(ids) ;
+	my_free(found) ;
+	my_free(xyz) ;
+
+	return neigh ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_mol_vert_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Return a list of pointer to the vertices situated a distance lower than
+	dcrit of a molecule represented by it's list of atoms, each vertex once.
+	(get_mol_vert_neigh_naive keeps one vertex per id, and vertices read
+	from qhull may share an id.)
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm **atoms         : The molecule.
+	@ int natoms		    : Number of atoms in the molecule
+	@ s_nindex *ind         : Index of all vertices of the system
+	@ float dcrit           : The distance criteria.
+	@ int *nneigh           : OUTPUT A pointer to the number of neighbour found,
+							  will be modified in the function...
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	A tab of pointers to the neighbours.
+   -----------------------------------------------------------------------------
+*/
+s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+								float dcrit, int *nneigh)
+{
+	float *xyz = get_atoms_xyz(atoms, natoms) ;
+	int i, n ;
+	int *found = get_nindex_batch_neigh(ind, xyz, natoms, dcrit, M_VERTICE_TYPE, &n) ;
+	s_vvertice **neigh = (s_vvertice**) my_malloc(sizeof(s_vvertice*)*(n+1)) ;
+
+	for(i = 0 ; i < n ; i++) neigh[i] = (s_vvertice *) ind->elem[found[i]].data ;
+
+	*nneigh = n ;
+	my_free(found) ;
+	my_free(xyz) ;
+
+	return neigh ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_mol_ctd_atm_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Return a list of atoms contacted by voronoi vertices situated at dcrit
+	of a given molecule represented by a list of its atoms. If interface_search
+	is set, an atom is kept only if it lies within M_INTERFACE_SEARCH_DIST of
+	the molecule atom the vertice is close to.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm **atoms         : The molecule.
+	@ int natoms		    : Number of atoms in the molecule
+	@ s_nindex *ind         : Index of all vertices of the system
+	@ float vdcrit          : The distance criteria.
+    @ int interface_search  : Perform an interface-type search ?
+	@ int *nneigh           : OUTPUT A pointer to the number of neighbour found,
+							  will be modified in the function...
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	A tab of pointers to atoms describing the pocket.
+   -----------------------------------------------------------------------------
+*/
+s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms, s_nindex *ind,
+							  float vdcrit, int interface_search, int *nneigh)
+{
+	int i, j, k, nv,
+		nb_neigh = 0,
+		real_size = 10,
+		nmax = 0 ;
+	int *found = NULL ;
+	float lx, ly, lz ;
+
+	s_vvertice *vcur = NULL ;
+	s_atm *curatm = NULL ;
+	s_atm **neigh = (s_atm**) my_malloc(sizeof(s_atm*)*real_size) ;
+	s_idset *ids = alloc_idset(natoms) ;
+
+	for(i = 0 ; i < natoms ; i++) {
+		lx = atoms[i]->x ; ly = atoms[i]->y ; lz = atoms[i]->z ;
+		nv = get_nindex_neigh(ind, lx, ly, lz, vdcrit, M_VERTICE_TYPE, &found, &nmax) ;
+
+		for(k = 0 ; k < nv ; k++) {
+			vcur = (s_vvertice *) ind->elem[found[k]].data ;
+			for(j = 0 ; j < 4 ; j++) {
+				curatm = vcur->neigh[j] ;
+				if(interface_search && dist(curatm->x, curatm->y, curatm->z, lx, ly, lz)
+										>= M_INTERFACE_SEARCH_DIST) continue ;
+				if(!add_idset(ids, curatm->id)) continue ;
+
+				if(nb_neigh >= real_size) {
+					real_size *= 2 ;
+					neigh = (s_atm**) my_realloc(neigh, sizeof(s_atm*)*real_size) ;
+				}
+				neigh[nb_neigh++] = curatm ;
+			}
+		}
+	}
+
+	*nneigh = nb_neigh ;
+	free_idset(ids) ;
+	if(found) my_free(found) ;
+
+	return neigh ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	count_pocket_lig_vert_ovlp
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Return the proportion of alpha sphere given in parameter that lies within
+	dcrit A of the ligand.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *lind      : Index of the ligand atoms
+    @ s_vvertice *pvert   : List of vertices to check.
+	@ int nvert		      : Number of verties (tipically in a given pocket)
+	@ float dcrit         : The distance criteria.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The proportion of vertices close to the ligand
+   -----------------------------------------------------------------------------
+*/
+float count_pocket_lig_vert_ovlp(s_nindex *lind, s_vvertice **pvert, int nvert,
+								 float dcrit)
+{
+	int i, nb_neigh = 0 ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		nb_neigh += is_nindex_neigh(lind, pvert[i]->x, pvert[i]->y, pvert[i]->z,
+									dcrit, M_ATOM_TYPE) ;
+	}
+
+	return (float)nb_neigh/(float)nvert ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	count_atm_prop_vert_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Return the proportion of ligand atoms that have at least one of the
+	given vertices within dcrit A.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_nindex *lind      : Index of the ligand atoms
+    @ s_vvertice *pvert   : List of vertices to check.
+	@ int nvert		      : Number of verties (tipically in a given pocket)
+	@ float dcrit         : The distance criteria.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The proportion of ligand atoms close to the vertices
+   -----------------------------------------------------------------------------
+*/
+float count_atm_prop_vert_neigh(s_nindex *lind, s_vvertice **pvert, int nvert,
+								float dcrit)
+{
+	int i, nb_neigh = 0, nmax = 0 ;
+	int *found = NULL ;
+	s_idset *seen = alloc_idset(lind->natm) ;
+
+	for(i = 0 ; i < nvert && nb_neigh < lind->natm ; i++) {
+		nb_neigh = add_nindex_neigh(lind, pvert[i]->x, pvert[i]->y, pvert[i]->z,
+									dcrit, M_ATOM_TYPE, seen, nb_neigh, &found, &nmax) ;
+	}
+
+	free_idset(seen) ;
+	if(found) my_free(found) ;
+
+	return (float)nb_neigh/(float)lind->natm ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	count_vert_neigh_P
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Count the number of vertices that lies within a distance < dcrit from
+	a list of query vertices.
+	The user must provide the query vertices, the full list of vertices to
+	consider, and the distance criteria.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+    @ s_vvertice *pvert     : List of pointer to query vertices
+    @ int nvert				: Number of query vertices
+    @ s_vvertice *pvert_all : List of pointer to all vertice to consider
+    @ int nvert_all			: Total number of vertices to consider
+	@ float dcrit			: The distance criteria.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: The total number of vertices lying within dist_crit A of the query vertices
+   -----------------------------------------------------------------------------
+*/
+int count_vert_neigh_P(s_vvertice **pvert, int nvert,
+					   s_vvertice **pvert_all, int nvert_all,
+					   float dcrit)
+{
+	s_nindex *ind = alloc_nindex(NULL, 0, pvert_all, nvert_all, dcrit) ;
+	int res = count_vert_neigh(ind, pvert, nvert, dcrit) ;
+
+	free_nindex(ind) ;
+
+	return res ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	count_vert_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Count the number of vertices of the index that lies within a distance
+	< dcrit from a list of query vertices, the query vertices excepted.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+    @ s_nindex *ind         : Index of the vertices to consider
+    @ s_vvertice **pvert    : List of pointer to query vertices
+    @ int nvert				: Number of query vertices
+	@ float dcrit			: The distance criteria.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: The total number of vertices lying within dist_crit A of the query vertices
+   -----------------------------------------------------------------------------
+*/
+int count_vert_neigh(s_nindex *ind, s_vvertice **pvert, int nvert, float dcrit)
+{
+	int i, n, nb_neigh = 0 ;
+	int *found = NULL ;
+	float *xyz = (float *) my_malloc((3*nvert+3)*sizeof(float)) ;
+	s_vvertice **query = (s_vvertice **) my_malloc((nvert+1)*sizeof(s_vvertice*)) ;
+	void *v = NULL ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		xyz[3*i] = pvert[i]->x ;
+		xyz[3*i+1] = pvert[i]->y ;
+		xyz[3*i+2] = pvert[i]->z ;
+		query[i] = pvert[i] ;
+	}
+
+	/* Query vertices sorted by address (ids of the vertices are not unique) */
+	qsort(query, nvert, sizeof(s_vvertice*), cmp_nindex_ptr) ;
+
+	found = get_nindex_batch_neigh(ind, xyz, nvert, dcrit, M_VERTICE_TYPE, &n) ;
+	for(i = 0 ; i < n ; i++) {
+		v = ind->elem[found[i]].data ;
+		if(!bsearch(&v, query, nvert, sizeof(s_vvertice*), cmp_nindex_ptr)) nb_neigh++ ;
+	}
+
+	my_free(query) ;
+	my_free(found) ;
+	my_free(xyz) ;
+
+	return nb_neigh ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	cmp_nindex_ptr
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Compare two pointers (qsort, bsearch).
+   -----------------------------------------------------------------------------
+*/
+static int cmp_nindex_ptr(const void *a, const void *b)
+{
+	const char *pa = *(char * const *) a,
+			   *pb = *(char * const *) b ;
+
+	return (pa > pb) - (pa < pb) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_mol_atm_neigh_naive
+   -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Return a list of pointer to the atoms situated a distance lower or equal
 	to dcrit from a molecule represented by a list of atoms.
 
 	This functon use a list of atoms that is sorted on the X dimension to accelerate
 	the research.
+
+	Original version of get_mol_atm_neigh, sorting the atoms and vertices on X at
+	each call. Kept for tests and benchmarks.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **atoms        : The molecule atoms.
@@ -87,7 +905,7 @@
 	nneigh
    -----------------------------------------------------------------------------
 */
-s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
+s_atm** get_mol_atm_neigh_naive(s_atm **atoms, int natoms, s_atm **all, int nall,
 						  float dcrit, int *nneigh)
 {	
 	/* No vertices, we only search atoms... */
@@ -108,6 +926,10 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 	
 	s_atm *curap = NULL, *curam = NULL ;
 	s_atm **neigh = (s_atm**)my_malloc(sizeof(s_atm*)*real_size) ;
+
+	/* Ids of the molecule and of the neighbours found */
+	s_idset *ids = alloc_idset(2*natoms) ;
+	for(i = 0 ; i < natoms ; i++) add_idset(ids, atoms[i]->id) ;
 	
 	nb_neigh = 0 ;
 	for(i = 0 ; i < natoms ; i++) {
@@ -136,8 +958,7 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 					if(dist(curap->x, curap->y, curap->z, vvalx, vvaly, vvalz) < dcrit) {
 					/* Distance OK, see if the molecule is not one part of the 
 						input, and if we have not already seen it. */
-						seen = is_in_lst_atm(atoms, natoms, curap->id) 
-							   + is_in_lst_atm(neigh, nb_neigh, curap->id) ;
+						seen = !add_idset(ids, curap->id) ;
 						if(!seen) {
 							if(nb_neigh >= real_size-1) {
 								real_size *= 2 ;
@@ -163,8 +984,7 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 					if(dist(curam->x, curam->y, curam->z, vvalx, vvaly, vvalz) < dcrit){
 					/* Distance OK, see if the molecule is not one part of the 
 						input, and if we have not already seen it. */
-						seen = is_in_lst_atm(atoms, natoms, curam->id) 
-							   + is_in_lst_atm(neigh, nb_neigh, curam->id) ;
+						seen = !add_idset(ids, curam->id) ;
 						if(!seen) {
 							if(nb_neigh >= real_size-1) {
 								real_size *= 2 ;
@@ -182,6 +1002,7 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 	}
 	
 	*nneigh = nb_neigh ;
+	free_idset(ids) ;
 	free_s_vsort(lsort) ;
 
 	return neigh ;
@@ -189,7 +1010,7 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	get_mol_vert_neigh
+	get_mol_vert_neigh_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Return a list of pointer to the vertices situated a distance lower or equal
@@ -197,6 +1018,9 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 
 	This functon use a list of atoms that is sorted on the X dimension to accelerate
 	the research.
+
+	Original version of get_mol_vert_neigh, sorting the atoms and vertices on X at
+	each call. Kept for tests and benchmarks.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **atoms         : The molecule.
@@ -210,7 +1034,7 @@ s_atm** get_mol_atm_neigh(s_atm **atoms, int natoms, s_atm **all, int nall,
 	A tab of pointers to the neighbours.
    -----------------------------------------------------------------------------
 */
-s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
+s_vvertice** get_mol_vert_neigh_naive(s_atm **atoms, int natoms,
 								s_vvertice **pvert, int nvert,
 								float dcrit, int *nneigh)
 {	
@@ -231,6 +1055,7 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 	
 	s_vvertice *curvp = NULL, *curvm = NULL ;
 	s_vvertice **neigh = (s_vvertice**)my_malloc(sizeof(s_vvertice*)*real_size) ;
+	s_idset *ids = alloc_idset(natoms) ;
 	
 	nb_neigh = 0 ;
 	for(i = 0 ; i < natoms ; i++) {
@@ -258,7 +1083,7 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 				 * calculate real distance */
 					if(dist(curvp->x, curvp->y, curvp->z, vvalx, vvaly, vvalz) < dcrit) {
 					/* Distance OK, see if the molecule have not been already seen. */
-						seen = is_in_lst_vert(neigh, nb_neigh, curvp->id) ;
+						seen = !add_idset(ids, curvp->id) ;
 						if(!seen) {
 							if(nb_neigh >= real_size-1) {
 								real_size *= 2 ;
@@ -285,7 +1110,7 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 					if(dist(curvm->x, curvm->y, curvm->z, vvalx, vvaly, vvalz) < dcrit){
 					/* Distance OK, see if the molecule is not one part of the 
 					 * input, and if we have not already seen it. */
-						seen = is_in_lst_vert(neigh, nb_neigh, curvm->id) ;
+						seen = !add_idset(ids, curvm->id) ;
 						if(!seen) {
 							if(nb_neigh >= real_size-1) {
 								real_size *= 2 ;
@@ -303,6 +1128,7 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 	}
 	
 	*nneigh = nb_neigh ;
+	free_idset(ids) ;
 	free_s_vsort(lsort) ;
 
 	return neigh ;
@@ -310,11 +1136,14 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	get_mol_ctd_atm_neigh
+	get_mol_ctd_atm_neigh_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
 	Return a list of atoms contacted by voronoi vertices situated at dcrit
 	of a given molecule represented by a list of its atoms.
+
+	Original version of get_mol_ctd_atm_neigh, sorting the atoms and vertices on X at
+	each call. Kept for tests and benchmarks.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **atoms         : The molecule.
@@ -329,7 +1158,7 @@ s_vvertice** get_mol_vert_neigh(s_atm **atoms, int natoms,
 	A tab of pointers to atoms describing the pocket.
    -----------------------------------------------------------------------------
 */
-s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms,
+s_atm** get_mol_ctd_atm_neigh_naive(s_atm **atoms, int natoms,
 							  s_vvertice **pvert, int nvert,
 							  float vdcrit, int interface_search, int *nneigh)
 {
@@ -482,12 +1311,15 @@ s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms,
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
-	count_pocket_lig_vert_ovlp
+	count_pocket_lig_vert_ovlp_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
 	Return the proportion of alpha sphere given in parameter that lies within
 	dcrit A of the ligand -> we loop on each ligand atom and we count the
 	number of unique vertices next to each atoms using dist-crit.
+
+	Original version of count_pocket_lig_vert_ovlp, sorting the atoms and vertices on X at
+	each call. Kept for tests and benchmarks.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **lig         : The molecule.
@@ -500,7 +1332,7 @@ s_atm** get_mol_ctd_atm_neigh(s_atm **atoms, int natoms,
 	A tab of pointers to the neighbours.
    -----------------------------------------------------------------------------
 */
-float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
+float count_pocket_lig_vert_ovlp_naive(s_atm **lig, int nlig,
 								 s_vvertice **pvert, int nvert,
 								 float dcrit)
 {
@@ -516,11 +1348,7 @@ float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
 
 	float vvalx, vvaly, vvalz ;
 	
-	s_vvertice *ids[nvert] ;
-	for(i = 0 ; i < nvert ; i++) {
-		pvert[i]->seen = 0 ;
-		ids[i] = NULL ;
-	}
+	for(i = 0 ; i < nvert ; i++) pvert[i]->seen = 0 ;
 
 	s_vvertice *curvp = NULL, *curvm = NULL ;
 
@@ -551,7 +1379,6 @@ float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
 					if(dist(curvp->x, curvp->y, curvp->z, vvalx, vvaly, vvalz) < dcrit) {
 					/* Distance OK, see if the molecule have not been already seen. */
 						if(! curvp->seen) {
-							ids[nb_neigh] = curvp ;
 							curvp->seen = 1 ;
 							nb_neigh ++ ;
 						}
@@ -573,7 +1400,6 @@ float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
 					/* Distance OK, see if the molecule is not one part of the
 					 * input, and if we have not already seen it. */
 						if(!curvm->seen) {
-							ids[nb_neigh] = curvm ;
 							curvm->seen = 1 ;
 							nb_neigh ++ ;
 						}
@@ -590,11 +1416,14 @@ float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
 }
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
-	count_pocket_lig_vert_ovlp
+	count_atm_prop_vert_neigh_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
 	Return the proportion of atoms given in parameter that have at least one
 	vertice that lies within dcrit A
+
+	Original version of count_atm_prop_vert_neigh, sorting the atoms and vertices on X at
+	each call. Kept for tests and benchmarks.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_atm **lig         : The molecule.
@@ -607,7 +1436,7 @@ float count_pocket_lig_vert_ovlp(s_atm **lig, int nlig,
 	A tab of pointers to the neighbours.
    -----------------------------------------------------------------------------
 */
-float count_atm_prop_vert_neigh (s_atm **lig, int nlig,
+float count_atm_prop_vert_neigh_naive(s_atm **lig, int nlig,
 								 s_vvertice **pvert, int nvert,
 								 float dcrit)
 {
@@ -680,143 +1509,3 @@ float count_atm_prop_vert_neigh (s_atm **lig, int nlig,
 	free_s_vsort(lsort) ;
 	return (float)nb_neigh/(float)nlig ;
 }
-
-
-/**-----------------------------------------------------------------------------
-   ## FUNCTION:
-	count_vert_neigh_P
-   -----------------------------------------------------------------------------
-   ## SPECIFICATION:
-	Count the number of vertices that lies within a distance <= dist_crit from
-	a list of query vertices.
-	The user must provide the query vertices, the full list of vertices to
-	consider, and the distance criteria.
-   -----------------------------------------------------------------------------
-   ## PARAMETRES:
-    @ s_vvertice *pvert     : List of pointer to query vertices
-    @ int nvert				: Number of query vertices
-    @ s_vvertice *pvert_all : List of pointer to all vertice to consider
-    @ int nvert_all			: Total number of vertices to consider
-	@ float dcrit			: The distance criteria.
-   -----------------------------------------------------------------------------
-   ## RETURN:
-	int: The total number of vertices lying within dist_crit A of the query vertices
-   -----------------------------------------------------------------------------
-*/
-int count_vert_neigh_P(s_vvertice **pvert, int nvert,
-					 s_vvertice **pvert_all, int nvert_all,
-					 float dcrit)
-{
-	s_vsort *lsort =  get_sorted_list(NULL, 0, pvert_all, nvert_all) ;
-	int res = count_vert_neigh(lsort, pvert, nvert, dcrit) ;
-
-	free_s_vsort(lsort) ;
-	
-	return res ;
-}
-
-
-/**-----------------------------------------------------------------------------
-   ## FUNCTION:
-	count_vert_neigh
-   -----------------------------------------------------------------------------
-   ## SPECIFICATION:
-	Count the number of vertices that lies within a distance <= dist_crit from
-	a list of query vertices.
-	The user must provide the list of sorted vertices (that should include the
-  	query vertices and all other vertices to consider), the query vertices and
-	the distance criteria.
-
-	Note that if the query vertices are not present in the list of ordered
-	vertices, the function will return 0.
-   -----------------------------------------------------------------------------
-   ## PARAMETRES:
-    @ s_vsort *lsort	    : List of sorted vertices.
-    @ s_vvertice **pvert    : List of pointer to query vertices
-    @ int nvert				: Number of query vertices
-	@ float dcrit			: The distance criteria.
-   -----------------------------------------------------------------------------
-   ## RETURN:
-	int: The total number of vertices lying within dist_crit A of the query vertices
-   -----------------------------------------------------------------------------
-*/
-int count_vert_neigh(s_vsort *lsort, s_vvertice **pvert, int nvert, float dcrit)
-{
-	s_vect_elem *xsort = lsort->xsort ;
-
-	s_vvertice *vcur = NULL ;
-
-	int ip, im, i,
-		stopm, stopp,
-		nb_neigh,
-		sort_x,
-		ntest_x,
-		dim = lsort->nelem ;
-
-	float vvalx, vvaly, vvalz;
-
-	/* Set all vertices to NOT SEEN, except the query vertices */
-	for(i = 0 ; i < dim ; i++) ((s_vvertice*) lsort->xsort[i].data)->seen = 0 ;
-	for(i = 0 ; i < nvert ; i++) pvert[i]->seen = 2 ;
-
-	s_vvertice *curvp = NULL, *curvm = NULL ;
-	nb_neigh = 0 ;
-	for(i = 0 ; i < nvert ; i++) {
-		vcur = pvert[i] ;
-
-		/* Reinitialize variables */
-		stopm = 0; stopp = 0;
-		sort_x = vcur->sort_x ;
-		ntest_x = 1 ;
-		vvalx = vcur->x ; vvaly = vcur->y ; vvalz = vcur->z ;
-
-		/* Search neighbors */
-		while(!stopm || !stopp) {
-			/* Do the neighbor search while wa are in tab and we dont reach a
-			 * distance up to our criteria */
-			ip = ntest_x + sort_x ;
-
-			/* Stop the search if we reach dim*/
-			if(ip >= dim) stopp = 1 ;
-
-			if(stopp == 0) {
-				curvp = (s_vvertice*) xsort[ip].data ;
-
-				/* Stop the search the distance on X is > dcrit*/
-				if(curvp->x - vvalx > dcrit) stopp = 1 ;
-				/* Check if the current vertice has not already been counted */
-				else if(curvp->seen == 0) {
-					if(dist(curvp->x, curvp->y, curvp->z, vvalx, vvaly, vvalz) < dcrit) {
-						/* Distance OK, count and mark the vertice */
-						curvp->seen = 1 ;
-						nb_neigh ++ ;
-					}
-				}
-			}
-
-			im = sort_x - ntest_x ;
-			if(im < 0) stopm = 1 ;
-
-			if(stopm == 0) {
-				curvm = (s_vvertice*) xsort[im].data ;
-
-				/* Stop the search the distance on X is > dcrit*/
-				if(vvalx - curvm->x > dcrit) stopm = 1 ;
-				/* Check if the current vertice has not already been counted */
-				else if(curvp->seen == 0) {
-				/* OK we have an atom which is near our vertice on X, so
-				 * calculate real distance */
-					if(dist(curvm->x, curvm->y, curvm->z, vvalx, vvaly, vvalz) < dcrit){
-						/* Distance OK, count and mark the vertice */
-						curvm->seen = 1 ;
-						nb_neigh ++ ;
-					}
-				}
-			}
-
-			ntest_x += 1 ;
-		}
-	}
-
-	return nb_neigh ;
-}
\ No newline at end of file
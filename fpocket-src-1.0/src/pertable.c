@@ -7,15 +7,19 @@
 ##
 ## FILE 					pertable.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			28-11-08
+## LAST MODIFIED			17-11-10
 ##
 ## ----- SPECIFICATIONS
 ##
 ## This file defines the periodic element table. It's strongly based on the
 ## VMD source code.
 ##
+## An element is found from its symbol in constant time: the two characters
+## of the symbol index a table (ST_pte_index) giving the element number.
+##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-10	     Symbols looked up in a two character table
 ##  17-03-09    (v)  Added function testing if a string is a valid element symbol
 ##	28-11-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
@@ -137,6 +141,127 @@ static const float ST_pte_rvdw[] = {
 	/* Mt */ 2.0, 2.0, 2.0
 };
 
+/**
+	Element number of each symbol, indexed by pte_key. -1 for unknown symbols.
+*/
+static signed char ST_pte_index[M_PTE_NKEY] ;
+static pthread_once_t ST_pte_once = PTHREAD_ONCE_INIT ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	pte_key
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Index of a symbol in ST_pte_index. The case is ignored as in the previous
+	linear search: the first character is taken upper case and the second one
+	lower case. Only a letter, or a letter followed by a letter, can match.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ int c0 : First character of the symbol
+	@ int c1 : Second character of the symbol ('\0' for one letter)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: the index, -1 if the symbol can't be an element
+   -----------------------------------------------------------------------------
+*/
+static int pte_key(int c0, int c1)
+{
+	c0 = toupper((unsigned char) c0) ;
+	c1 = tolower((unsigned char) c1) ;
+
+	if(c0 < 'A' || c0 > 'Z') return -1 ;
+	if(c1 == '\0') return (c0 - 'A')*27 ;
+	if(c1 < 'a' || c1 > 'z') return -1 ;
+
+	return (c0 - 'A')*27 + c1 - 'a' + 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	pte_init_index
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Fill ST_pte_index from the table of symbols. Called once, by pthread_once.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void pte_init_index(void)
+{
+	int i, k ;
+
+	memset(ST_pte_index, -1, sizeof(ST_pte_index)) ;
+	for(i = ST_nelem - 1 ; i >= 0 ; i--) {
+		k = pte_key(ST_pte_symbol[i][0], ST_pte_symbol[i][1]) ;
+		if(k >= 0) ST_pte_index[k] = (signed char) i ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	pte_get_index
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Returns the position of an element in the periodic table, in constant time.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ const char *symbol: The symbol of the element in the periodic table
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: the position, -1 if the symbol is not an element
+   -----------------------------------------------------------------------------
+*/
+int pte_get_index(const char *symbol)
+{
+	int k ;
+
+	if(symbol == NULL) return -1 ;
+
+	k = pte_key(symbol[0], symbol[0] ? symbol[1] : '\0') ;
+	if(k < 0) return -1 ;
+
+	pthread_once(&ST_pte_once, pte_init_index) ;
+
+	return ST_pte_index[k] ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	pte_get_properties
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Returns the mass, the van der walls radius and the electronegativity of an
+	element with a single lookup. Each value is -1 if the symbol is unknown.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ const char *symbol : The symbol of the element in the periodic table
+	@ float *mass        : OUTPUT The mass
+	@ float *ray         : OUTPUT The vdw radius
+	@ float *eneg        : OUTPUT The electronegativity
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: the position of the element, -1 if the symbol is not an element
+   -----------------------------------------------------------------------------
+*/
+int pte_get_properties(const char *symbol, float *mass, float *ray, float *eneg)
+{
+	int i = pte_get_index(symbol) ;
+
+	if(i < 0) {
+		*mass = *ray = *eneg = -1 ;
+	}
+	else {
+		*mass = ST_pte_mass[i] ;
+		*ray = ST_pte_rvdw[i] ;
+		*eneg = ST_pte_electronegativity[i] ;
+	}
+
+	return i ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	pte_get_mass
@@ -152,24 +277,10 @@ static const float ST_pte_rvdw[] = {
    -----------------------------------------------------------------------------
 */
 float pte_get_mass(const char *symbol)
-{	
-	char atom[3] ;
-	if (symbol != NULL) {
-		atom[0] = (char) toupper((int) symbol[0]);
-		atom[1] = (char) tolower((int) symbol[1]);	
-		atom[2] = '\0' ;
-	
-		int i ;
-		for (i = 0; i < ST_nelem ; i++) {
-			if ( (ST_pte_symbol[i][0] == atom[0]) && (ST_pte_symbol[i][1] == atom[1]) ) {
-				
-				return ST_pte_mass[i] ;
-			}
-		}
-	}
-
+{
+	int i = pte_get_index(symbol) ;
 
-	return -1 ;
+	return (i >= 0) ? ST_pte_mass[i] : -1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -188,22 +299,9 @@ float pte_get_mass(const char *symbol)
 */
 float pte_get_vdw_ray(const char *symbol)
 {
-	char atom[3] ;
+	int i = pte_get_index(symbol) ;
 
-	if (symbol != NULL) {
-		atom[0] = (char) toupper((int) symbol[0]);
-		atom[1] = (char) tolower((int) symbol[1]);
-		atom[2] = '\0' ;
-	
-		int i ;
-		for (i = 0; i < ST_nelem ; i++) {
-			if ( (ST_pte_symbol[i][0] == atom[0]) && (ST_pte_symbol[i][1] == atom[1]) ) {
-				return ST_pte_rvdw[i] ;
-			}
-		}
-	}
-
-	return -1 ;
+	return (i >= 0) ? ST_pte_rvdw[i] : -1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -222,22 +320,9 @@ float pte_get_vdw_ray(const char *symbol)
 */
 float pte_get_enegativity(const char *symbol)
 {
-	char atom[3] = "" ;
+	int i = pte_get_index(symbol) ;
 
-	if (symbol != NULL) {
-		atom[0] = (char) toupper((int) symbol[0]);
-		atom[1] = (char) tolower((int) symbol[1]);
-		atom[2] = '\0' ;
-	
-		int i ;
-		for (i = 0; i < ST_nelem ; i++) {
-			if ( (ST_pte_symbol[i][0] == atom[0]) && (ST_pte_symbol[i][1] == atom[1]) ) {
-				return ST_pte_electronegativity[i] ;
-			}
-		}
-	}
-
-	return -1 ;
+	return (i >= 0) ? ST_pte_electronegativity[i] : -1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -15,6 +15,21 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     Table of the pockets built by clusterPockets, merged
+##					 pockets chained in it, so the refinement steps walk
+##					 the arrays too
+##	17-11-08	     Contacted atoms kept in a set of ids (s_idset)
+##	17-11-07	     Pocket volumes: exact engine (see volume.c)
+##	17-11-06	     Pocket volumes: grid engine (see volume.c)
+##	17-11-05	     Descriptors of the pockets computed by a pool of threads
+##					 (set_pockets_desc_threads), one generator per pocket
+##	17-11-04	     Pockets as arrays (s_ptable), read by the descriptors
+##					 and volumes when built
+##	17-11-01	     clusterPockets: disjoint-set forest instead of updateIds
+##					 (list scans and relabelling of all vertices)
+##	17-10-31	     Vertex lists and descriptors of dropped / merged pockets
+##					 freed (memory of a batch of pdb)
+##	17-10-28	     Neighbour vertices found with get_vert_idx
 ##  10-03-09    (v)  Added a function that count the number of atoms in a pocket.
 ##	09-02-09	(v)  Normalized maximum distance between two alpha sphere added
 ##	29-01-09	(v)  Normalized density and polarity score added
@@ -64,6 +79,59 @@
 **/
 
 
+/* Clusters of clusterPockets: a disjoint-set forest over the clusters, the
+ * data of a cluster being valid for roots only. */
+typedef struct s_pclust
+{
+	s_vvertice *vertices ;
+
+	int *vclust,		/* Cluster of each vertex, -1 if none */
+		*parent,		/* Parent of each cluster in the forest */
+		*csize,			/* Number of clusters in the tree */
+		*cid,			/* Id of the cluster (resid of its vertices) */
+		*cslot,			/* Creation index of its pocket in the list */
+		*chead,			/* First / last member of its vertex list */
+		*ctail,
+		*capol,			/* Number of apolar / polar vertices */
+		*cpol,
+		*order,			/* Root of each creation index, -1 if merged */
+		*mvert,			/* Members: vertex, and next member of the list */
+		*mnext ;
+
+	int nclust,
+		nmemb ;
+
+} s_pclust ;
+
+static void alloc_pclust(s_pclust *pc, s_lst_vvertice *lvvert) ;
+static void free_pclust(s_pclust *pc) ;
+static int new_pclust(s_pclust *pc) ;
+static void add_pclust_vert(s_pclust *pc, int c, int v) ;
+static void merge_pclust(s_pclust *pc, int a, int b) ;
+static int get_pclust_root(s_pclust *pc, int c) ;
+
+static s_ptable* alloc_ptable(int np, int nv) ;
+static void free_ptable(s_ptable *t) ;
+
+/* Data shared by the threads computing the descriptors of the pockets */
+typedef struct s_pdesc_part
+{
+	s_pocket **pockets ;	/* Pockets, in the order of the list */
+	unsigned int seed ;		/* Seed from which the seed of each pocket is drawn */
+
+	int npockets,
+		next ;				/* Next pocket to handle */
+
+} s_pdesc_part ;
+
+static void* run_pdesc_thread(void *data) ;
+static void set_pocket_descriptors(s_pocket *pocket, unsigned int seed) ;
+static float get_pocket_spheres_volume(s_vvertice **verts, int nvert, int niter,
+									int idiscret) ;
+
+/* Number of threads used by set_pockets_descriptors */
+static int ST_desc_threads = 1 ;
+
 /**
  ================================================================================
  ================================================================================
@@ -86,6 +154,17 @@
 	This function takes in argument a list of vertice, and perform a first
 	clusturing algorithm to merge vertices close from each others. The distance
 	criteria is in the params struct.
+	
+	Vertices are visited in order, and each one is linked to its neighbours
+	(vneigh) closer than params->clust_max_dist:
+	 - two vertices without cluster create a new one,
+	 - a vertex without cluster joins the cluster of the other one,
+	 - two clusters are merged: the cluster of the current vertex gets the
+	   vertices of the other one (appended) and takes its id.
+	A vertex without any such neighbour creates a cluster alone. Clusters are
+	kept in a disjoint-set forest (see s_pclust), and the list of pockets is
+	built at the end, in the order clusters were created, together with the
+	table of the pockets (see s_ptable), read by the following steps.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_lst_vvertice *lvvert : The list of vertices.
@@ -97,32 +176,87 @@
 */
 c_lst_pockets *clusterPockets(s_lst_vvertice *lvvert, s_fparams *params)
 {
-	int i = -1,
-		j = -1,
-		curPocketId=1,
-		vNb[4] = {0,0,0,0};
-
-	
+	int i, j, k, a, b, linked, m ;
 	s_vvertice *vertices = lvvert->vertices,
-			   *vcur = NULL ;
+			   *vcur = NULL,
+			   *fvert = NULL ;
+	s_pclust pc ;
 
-	c_lst_pockets *pockets = c_lst_pockets_alloc();		
-		
-	for(i=0;i<lvvert->nvert;i++) {
+	alloc_pclust(&pc, lvvert) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
 		vcur = vertices + i ;
-		for(j=0;j<4;j++) vNb[j] = vcur->vneigh[j];
+		linked = 0 ;
+
+		for(j = 0 ; j < 4 ; j++) {
+			if(vcur->vneigh[j] <= 0 || vcur->vneigh[j] >= lvvert->qhullSize) continue ;
+			k = get_vert_idx(lvvert, vcur->vneigh[j]) ;
+			if(k == -1 || k >= lvvert->nvert) continue ;
+
+			fvert = vertices + k ;
+			if(dist(vcur->x, vcur->y, vcur->z, fvert->x, fvert->y, fvert->z)
+			   > params->clust_max_dist) continue ;
+
+			linked = 1 ;
+			a = (pc.vclust[i] == -1) ? -1 : get_pclust_root(&pc, pc.vclust[i]) ;
+			b = (pc.vclust[k] == -1) ? -1 : get_pclust_root(&pc, pc.vclust[k]) ;
 
-		curPocketId=updateIds(lvvert,i,vNb,vcur->resid, curPocketId,pockets, params);
+			if(a == -1 && b == -1) {
+				a = new_pclust(&pc) ;
+				add_pclust_vert(&pc, a, i) ;
+				add_pclust_vert(&pc, a, k) ;
+			}
+			else if(b == -1) add_pclust_vert(&pc, a, k) ;
+			else if(a == -1) add_pclust_vert(&pc, b, i) ;
+			else if(a != b) merge_pclust(&pc, a, b) ;
+		}
+
+		if(!linked) {
+		/* No close neighbour: the vertex is a cluster alone */
+			a = new_pclust(&pc) ;
+			add_pclust_vert(&pc, a, i) ;
+		}
 	}
 
-	node_pocket *p = pockets->first ;
-	while(p) {
-		p->pocket->size = p->pocket->v_lst->n_vertices ;
-		p = p->next ;
+	/* Pockets are created in the order of the clusters that remain */
+	c_lst_pockets *pockets = c_lst_pockets_alloc();		
+	s_ptable *t = alloc_ptable(pc.nclust, lvvert->nvert) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		vertices[i].resid = pc.cid[get_pclust_root(&pc, pc.vclust[i])] ;
+	}
+	for(i = 0 ; i < pc.nclust ; i++) pc.order[i] = -1 ;
+	for(i = 0 ; i < pc.nclust ; i++) {
+		if(pc.parent[i] == i) pc.order[pc.cslot[i]] = i ;
+	}
+	for(i = 0 ; i < pc.nclust ; i++) {
+		if((a = pc.order[i]) == -1) continue ;
+
+		s_pocket *pocket = alloc_pocket() ;
+		pocket->v_lst = c_lst_vertices_alloc() ;
+		j = t->np++ ;
+		t->vstart[j] = t->nv ;
+		for(m = pc.chead[a] ; m != -1 ; m = pc.mnext[m]) {
+			c_lst_vertices_add_last(pocket->v_lst, vertices + pc.mvert[m]) ;
+			t->vert[t->nv++] = vertices + pc.mvert[m] ;
+		}
+		t->vstart[j+1] = t->nv ;
+		t->nvert[j] = t->nv - t->vstart[j] ;
+		t->napol[j] = pc.capol[a] ;
+		t->npol[j] = pc.cpol[a] ;
+		pocket->ptab = t ;
+		pocket->prow = j ;
+		pocket->size = pocket->v_lst->n_vertices ;
+		c_lst_pockets_add_last(pockets, pocket, pc.capol[a], pc.cpol[a]) ;
 	}
+	free_pclust(&pc) ;
 
-	if(pockets->n_pockets > 0) return pockets ;
+	if(pockets->n_pockets > 0) {
+		pockets->ptab = t ;
+		return pockets ;
+	}
 	else {
+		free_ptable(t) ;
 		my_free(pockets) ;
 		return NULL ;
 	}
@@ -130,126 +264,145 @@ c_lst_pockets *clusterPockets(s_lst_vvertice *lvvert, s_fparams *params)
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	updateIds
+	alloc_pclust, free_pclust
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
-	Update ids.
+	Allocate the clusters of clusterPockets for the given vertices (no
+	cluster yet), and free them.
    -----------------------------------------------------------------------------
-   ## PARAMETRES:
-	@ s_lst_vvertice *lvvert : The list of vertices.
-	@ int i					 : 
-	@ int *vNb				 : 
-	@ int resid				 :  
-	@ int curPocket			 :
-	@ c_lst_pockets *pockets : The current list of pockets.
-	@ s_fparams *params		 : Parameters
+*/
+static void alloc_pclust(s_pclust *pc, s_lst_vvertice *lvvert)
+{
+	int i, n = (lvvert->nvert > 0) ? lvvert->nvert : 1 ;
+
+	pc->vertices = lvvert->vertices ;
+	pc->nclust = 0 ;
+	pc->nmemb = 0 ;
+	pc->vclust = (int *) my_malloc(n*sizeof(int)) ;
+	pc->parent = (int *) my_malloc(n*sizeof(int)) ;
+	pc->csize = (int *) my_malloc(n*sizeof(int)) ;
+	pc->cid = (int *) my_malloc(n*sizeof(int)) ;
+	pc->cslot = (int *) my_malloc(n*sizeof(int)) ;
+	pc->chead = (int *) my_malloc(n*sizeof(int)) ;
+	pc->ctail = (int *) my_malloc(n*sizeof(int)) ;
+	pc->capol = (int *) my_malloc(n*sizeof(int)) ;
+	pc->cpol = (int *) my_malloc(n*sizeof(int)) ;
+	pc->order = (int *) my_malloc(n*sizeof(int)) ;
+	pc->mvert = (int *) my_malloc(2*n*sizeof(int)) ;
+	pc->mnext = (int *) my_malloc(2*n*sizeof(int)) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) pc->vclust[i] = -1 ;
+}
+
+static void free_pclust(s_pclust *pc)
+{
+	my_free(pc->vclust) ;
+	my_free(pc->parent) ;
+	my_free(pc->csize) ;
+	my_free(pc->cid) ;
+	my_free(pc->cslot) ;
+	my_free(pc->chead) ;
+	my_free(pc->ctail) ;
+	my_free(pc->capol) ;
+	my_free(pc->cpol) ;
+	my_free(pc->order) ;
+	my_free(pc->mvert) ;
+	my_free(pc->mnext) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	new_pclust
    -----------------------------------------------------------------------------
-   int
+   ## SPECIFICATION:
+	Create a new empty cluster. Ids start at 2, as they always did.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: index of the cluster
    -----------------------------------------------------------------------------
 */
-int updateIds(s_lst_vvertice *lvvert, int i, int *vNb, int resid, int curPocket,
-			  c_lst_pockets *pockets, s_fparams *params)
+static int new_pclust(s_pclust *pc)
 {
-/* 	s_pocket *curPocket; */
-	int filteredIdx,j,z;
-	int groupCreatedFlag=0;
-	int cur_n_apol=0;
-	int cur_n_pol=0;
-
-	s_vvertice *vertices = lvvert->vertices ;
-	s_vvertice *vert = &(vertices[i]),
-			   *fvert = NULL ;
+	int c = pc->nclust++ ;
 
-	for(j=0;j<4;j++) {
-		if(vNb[j] < lvvert->qhullSize && vNb[j] > 0) {
-			filteredIdx = lvvert->tr[vNb[j]];
-			if(filteredIdx!=-1 && filteredIdx < lvvert->nvert){
-				fvert = &(vertices[filteredIdx]) ;
-				
-				if(dist(vert->x, vert->y, vert->z, fvert->x, fvert->y, fvert->z) <= params->clust_max_dist){
-					groupCreatedFlag=1;
-					/* Add a new pocket */
-					if(resid == -1 && fvert->resid==-1){						
-						resid=++curPocket;
-						vert->resid=resid;
-						fvert->resid=curPocket;	
-						/* Create a new pocket */
-						s_pocket *pocket = alloc_pocket();				
-						pocket->v_lst=c_lst_vertices_alloc();
-						/* Add vertices to the pocket */
-						c_lst_vertices_add_last(pocket->v_lst, vert);				
-						c_lst_vertices_add_last(pocket->v_lst, fvert);
-
-						if(vert->type==M_APOLAR_AS) cur_n_apol++;
-						else cur_n_pol++;
-
-						if(fvert->type==M_APOLAR_AS)cur_n_apol++;
-						else cur_n_pol++;
-
-						c_lst_pockets_add_last(pockets, pocket,cur_n_apol,cur_n_pol);
-					}
-					/* Add new vertice to existing pocket */
-					else if(resid!=-1 && fvert->resid==-1) 						
-					{
-						fvert->resid=resid;
-						node_pocket *pocket=searchPocket(resid,pockets);
-						if(pocket) c_lst_vertices_add_last(pocket->pocket->v_lst, fvert);
-
-						if(fvert->type==M_APOLAR_AS) pocket->pocket->nAlphaApol+=1;
-						else pocket->pocket->nAlphaPol+=1;
-					}
-					else if(resid==-1 && fvert->resid!=-1) {
-						vert->resid = fvert->resid;
-						resid=fvert->resid;
-						node_pocket *pocket = searchPocket(resid,pockets);
-						if(pocket) c_lst_vertices_add_last(pocket->pocket->v_lst, vert);
-						if(vert->type==M_APOLAR_AS) pocket->pocket->nAlphaApol+=1;
-						else pocket->pocket->nAlphaPol+=1;
-					}
-					else if((resid!=-1 && fvert->resid!=-1) && (resid!=fvert->resid)) {
-						node_pocket *pocket=searchPocket(resid,pockets);
- 						node_pocket *pocket2=searchPocket(fvert->resid,pockets);
-						/* Write content of pocket1 into pocket2 */
-						mergePockets(pocket,pocket2,pockets);					
-
-						for(z=0;z<lvvert->nvert;z++){
-							/* Merge two clusters -> to optimize */
-							if(vertices[z].resid==resid) vertices[z].resid=fvert->resid;	
-						}
-						resid=fvert->resid;
+	pc->parent[c] = c ;
+	pc->csize[c] = 1 ;
+	pc->cid[c] = c + 2 ;
+	pc->cslot[c] = c ;
+	pc->chead[c] = pc->ctail[c] = -1 ;
+	pc->capol[c] = pc->cpol[c] = 0 ;
 
-					}
-				}
-			}
-			else {
-				if(filteredIdx >= lvvert->nvert) {
-					fprintf(stdout, "INDEX ERROR\n") ;
-				}
-			}
-		}
-	}
-	/* if a pocket was created return the pocket */
-	if(groupCreatedFlag) return curPocket;
-	
-	/* if no vertice neighbours were found, still build a new pocket containing 
-	 * only one vertice */
-	
-	cur_n_apol=0;
-	cur_n_pol=0;
-	resid=++curPocket;
-	vert->resid=resid;
-	s_pocket *pocket=alloc_pocket();				/* Create a new pocket */
-	pocket->v_lst=c_lst_vertices_alloc();
-	c_lst_vertices_add_last(pocket->v_lst, vert);	/* Add vertices to the pocket */
-	if(vert->type==M_APOLAR_AS) cur_n_apol++;
-	else cur_n_pol++;
-
-	c_lst_pockets_add_last(pockets,pocket,cur_n_apol,cur_n_pol);
-
-	return curPocket;
-	
+	return c ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	add_pclust_vert
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Append a vertex to the list of a cluster (root), and set its cluster.
+	A vertex creating a cluster alone while it already was in a cluster
+	(neighbour links are not always symmetric) remains in the list of the
+	first one, as it always did.
+   -----------------------------------------------------------------------------
+*/
+static void add_pclust_vert(s_pclust *pc, int c, int v)
+{
+	int m = pc->nmemb++ ;
+
+	pc->mvert[m] = v ;
+	pc->mnext[m] = -1 ;
+	if(pc->ctail[c] == -1) pc->chead[c] = m ;
+	else pc->mnext[pc->ctail[c]] = m ;
+	pc->ctail[c] = m ;
+
+	if(pc->vertices[v].type == M_APOLAR_AS) pc->capol[c]++ ;
+	else pc->cpol[c]++ ;
+	pc->vclust[v] = c ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	merge_pclust
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Merge two clusters (roots): the result has the vertices of a then the ones
+	of b, the place of a in the list of pockets and the id of b. The root
+	of the largest tree becomes the root of the other one.
+   -----------------------------------------------------------------------------
+*/
+static void merge_pclust(s_pclust *pc, int a, int b)
+{
+	int r = (pc->csize[a] >= pc->csize[b]) ? a : b ;
+
+	pc->mnext[pc->ctail[a]] = pc->chead[b] ;
+	pc->chead[r] = pc->chead[a] ;
+	pc->ctail[r] = pc->ctail[b] ;
+	pc->capol[r] = pc->capol[a] + pc->capol[b] ;
+	pc->cpol[r] = pc->cpol[a] + pc->cpol[b] ;
+	pc->cslot[r] = pc->cslot[a] ;
+	pc->cid[r] = pc->cid[b] ;
+	pc->csize[r] = pc->csize[a] + pc->csize[b] ;
+	pc->parent[a] = pc->parent[b] = r ;
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_pclust_root
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Root of the tree of a cluster, with path halving.
+   -----------------------------------------------------------------------------
+*/
+static int get_pclust_root(s_pclust *pc, int c)
+{
+	while(pc->parent[c] != c) {
+		pc->parent[c] = pc->parent[pc->parent[c]] ;
+		c = pc->parent[c] ;
+	}
+
+	return c ;
+}
 
 				/* ------------------------------- */
 				/* VOLUME AND DESCRIPTOR FUNCTIONS */
@@ -262,7 +415,8 @@ int updateIds(s_lst_vvertice *lvvert, int i, int *vNb, int resid, int curPocket,
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Get an monte carlo approximation of the volume occupied by the pocket given
-	in argument.
+	in argument, or its volume on a grid with the corresponding precision
+	(see set_volume_engine).
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_pocket *pocket: Pockets to print
@@ -285,13 +439,20 @@ float set_pocket_mtvolume(s_pocket *pocket, int niter)
 		  xr = 0.0, yr = 0.0, zr = 0.0,
 		  vbox = 0.0 ;
 
-	c_lst_vertices *vertices = pocket->v_lst ;
-	node_vertice *cur = vertices->first ;
-	s_vvertice *vcur = NULL ;
+	int nvert, tofree, k ;
+	s_vvertice **verts = get_pocket_vert_array(pocket, &nvert, &tofree),
+			   *vcur = NULL ;
+
+	if(get_volume_engine() != M_VOLUME_MC) {
+		pocket->pdesc->volume = get_pocket_spheres_volume(verts, nvert, niter, 0) ;
+		if(tofree) my_free(verts) ;
+
+		return pocket->pdesc->volume ;
+	}
 
 	/* First, search extrems coordinates */
-	while(cur) {
-		vcur = cur->vertice ;
+	for(k = 0 ; k < nvert ; k++) {
+		vcur = verts[k] ;
 		
 		/* Update min: */
 		if(nit == 0) {
@@ -310,7 +471,6 @@ float set_pocket_mtvolume(s_pocket *pocket, int niter)
 			else if(zmax < (ztmp = vcur->z + vcur->ray)) zmax = ztmp ;
 		}
 
-		cur = cur->next ;
 		nit++ ;
 	}
 
@@ -322,10 +482,9 @@ float set_pocket_mtvolume(s_pocket *pocket, int niter)
 		xr = rand_uniform(xmin, xmax) ;
 		yr = rand_uniform(ymin, ymax) ;
 		zr = rand_uniform(zmin, zmax) ;
-		cur = vertices->first ;
-		
-		while(cur) {
-			vcur = cur->vertice ;
+
+		for(k = 0 ; k < nvert ; k++) {
+			vcur = verts[k] ;
 		/* Distance between the center of curent vertice and the random point */
 			xtmp = vcur->x - xr ;
 			ytmp = vcur->y - yr ;
@@ -336,9 +495,9 @@ float set_pocket_mtvolume(s_pocket *pocket, int niter)
 			/* The point is inside one of the vertice!! */
 				nb_in ++ ; break ;
 			}
-			cur = cur->next ;
 		}
 	}
+	if(tofree) my_free(verts) ;
 
 	pocket->pdesc->volume = ((float)nb_in)/((float)niter)*vbox ;
 
@@ -352,7 +511,8 @@ float set_pocket_mtvolume(s_pocket *pocket, int niter)
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Get an approximation of the volume occupied by the pocket given in argument,
-	using a discretized space.
+	using a discretized space (regular sampling of the box, or grid if the
+	grid engine is used, see set_volume_engine).
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_pocket *pocket: Pockets to print
@@ -380,13 +540,20 @@ float set_pocket_volume(s_pocket *pocket, int idiscret)
 		  xtmp = 0.0, ytmp = 0.0, ztmp = 0.0,
 		  vbox = 0.0 ;
 
-	c_lst_vertices *vertices = pocket->v_lst ;
-	node_vertice *cur = vertices->first ;
-	s_vvertice *vcur = NULL ;
+	int nvert, tofree, k ;
+	s_vvertice **verts = get_pocket_vert_array(pocket, &nvert, &tofree),
+			   *vcur = NULL ;
+
+	if(get_volume_engine() != M_VOLUME_MC) {
+		pocket->pdesc->volume = get_pocket_spheres_volume(verts, nvert, 0, idiscret) ;
+		if(tofree) my_free(verts) ;
+
+		return pocket->pdesc->volume ;
+	}
 
 	/* First, search extrems coordinates */
-	while(cur) {
-		vcur = cur->vertice ;
+	for(k = 0 ; k < nvert ; k++) {
+		vcur = verts[k] ;
 		
 		/* Update min: */
 		if(nit == 0) {
@@ -405,7 +572,6 @@ float set_pocket_volume(s_pocket *pocket, int idiscret)
 			else if(zmax < (ztmp = vcur->z + vcur->ray)) zmax = ztmp ;
 		}
 
-		cur = cur->next ;
 		nit++ ;
 	}
 
@@ -420,9 +586,8 @@ float set_pocket_volume(s_pocket *pocket, int idiscret)
 	for(x = xmin ; x < xmax ; x += xstep) {
 		for(y = ymin ; y < ymax ; y += ystep) {	
 			for(z = zmin ; z < zmax ; z += zstep) {
-				cur = vertices->first ;
-				while(cur) {
-					vcur = cur->vertice ;
+				for(k = 0 ; k < nvert ; k++) {
+					vcur = verts[k] ;
 					xtmp = vcur->x - x ;
 					ytmp = vcur->y - y ;
 					ztmp = vcur->z - z ;
@@ -432,12 +597,12 @@ float set_pocket_volume(s_pocket *pocket, int idiscret)
 					/*the point is inside one of the vertice!! */
 						nb_in ++ ; break ;
 					}
-					cur = cur->next ;
 				}
 				niter ++ ;
 			}
 		}
 	}
+	if(tofree) my_free(verts) ;
 
 	pocket->pdesc->volume = ((float)nb_in)/((float)niter)*vbox ;
 
@@ -445,6 +610,41 @@ float set_pocket_volume(s_pocket *pocket, int idiscret)
 	return pocket->pdesc->volume ;
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_pocket_spheres_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Volume of the alpha spheres of a pocket on a grid (see alloc_vgrid for
+	the precision) or exactly, following the volume engine (see
+	get_spheres_volume).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvertice **verts : The alpha spheres
+	@ int nvert          : Number of alpha spheres
+	@ int niter          : Number of Monte Carlo iterations
+	@ int idiscret       : Division of the box, or 0
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: volume.
+   -----------------------------------------------------------------------------
+*/
+static float get_pocket_spheres_volume(s_vvertice **verts, int nvert, int niter,
+									int idiscret)
+{
+	int k ;
+	float vol, *xyzr = (float *) my_malloc((nvert > 0 ? 4*nvert : 1)*sizeof(float)) ;
+
+	for(k = 0 ; k < nvert ; k++) {
+		xyzr[4*k] = verts[k]->x ; xyzr[4*k+1] = verts[k]->y ;
+		xyzr[4*k+2] = verts[k]->z ; xyzr[4*k+3] = verts[k]->ray ;
+	}
+	vol = get_spheres_volume(xyzr, nvert, niter, idiscret) ;
+	my_free(xyzr) ;
+
+	return vol ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	set_pockets_bary
@@ -465,7 +665,7 @@ void set_pockets_bary(c_lst_pockets *pockets)
 	s_pocket *pcur = NULL ;
 
 	float xsum, ysum, zsum ;
-	int n ;
+	int i, n, tofree ;
 
 	if(pockets && pockets->n_pockets > 0) {
 		cur = pockets->first ;
@@ -473,17 +673,14 @@ void set_pockets_bary(c_lst_pockets *pockets)
 			pcur = cur->pocket ;
 		/* Reset values and calculate barycenter */
 			xsum = 0.0 ; ysum = 0.0 ; zsum = 0.0 ; 
-			n = 0 ;
 
-			node_vertice *nvcur = pcur->v_lst->first ;
-			while(nvcur) {
-				xsum += nvcur->vertice->x ;
-				ysum += nvcur->vertice->y ;
-				zsum += nvcur->vertice->z ;
-				n ++ ;
-
-				nvcur = nvcur->next ;
+			s_vvertice **verts = get_pocket_vert_array(pcur, &n, &tofree) ;
+			for(i = 0 ; i < n ; i++) {
+				xsum += verts[i]->x ;
+				ysum += verts[i]->y ;
+				zsum += verts[i]->z ;
 			}
+			if(tofree) my_free(verts) ;
 
 			pcur->bary[0] = xsum / (float) n ;
 			pcur->bary[1] = ysum / (float) n ;
@@ -494,12 +691,39 @@ void set_pockets_bary(c_lst_pockets *pockets)
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_pockets_desc_threads
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Set the number of threads used by set_pockets_descriptors.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int nthreads : Number of threads (1 if lower)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_pockets_desc_threads(int nthreads)
+{
+	ST_desc_threads = (nthreads > 1) ? nthreads : 1 ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	set_descriptors
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
 	Set descriptors for a list of pockets.
+	Atom and vertice based descriptors of each pocket are computed by
+	set_pockets_desc_threads threads. Each pocket uses its own random number
+	generator (volume), seeded from the seed of the pocket list and the rank
+	of the pocket in the list: descriptors do not depend on the number of
+	threads, and are the same from one run to another if a seed was given
+	(see set_rand_seed).
+	Once all threads are done, descriptors are normalized and pockets are
+	scored.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ c_lst_pockets *pockets: The list of pockets to handle
@@ -511,39 +735,28 @@ void set_pockets_bary(c_lst_pockets *pockets)
 void set_pockets_descriptors(c_lst_pockets *pockets)
 {
 	node_pocket *cur = NULL ;
-	s_pocket *pcur = NULL ;
-	
-	int natms = 0, i ;
+	s_pdesc_part part ;
+	int i, j, nthreads ;
 
 	if(pockets && pockets->n_pockets > 0) {
-		cur = pockets->first ;
-		/* Perform a first loop to calculate atom and vertice based descriptors */
-		while(cur) {
-			pcur = cur->pocket ;
-
-			/* Get a list of vertices in a tab of pointer */
-			s_vvertice **tab_vert = (s_vvertice **)
-					my_malloc(pcur->v_lst->n_vertices*sizeof(s_vvertice*)) ;
-			i = 0 ;
-			node_vertice *nvcur = pcur->v_lst->first ;
-			while(nvcur) {
-				tab_vert[i] = nvcur->vertice ;
-				nvcur = nvcur->next ;
-				i++ ;
-			}
-
-			/* Get atoms contacted by vertices, and calculate descriptors */
-			s_atm **pocket_atoms = get_pocket_contacted_atms(pcur, &natms) ;
-
-			/* Calculate descriptors*/
-			set_descriptors(pocket_atoms, natms, tab_vert,
-							pcur->v_lst->n_vertices, pcur->pdesc) ;
-
-			my_free(pocket_atoms) ;
-			my_free(tab_vert) ;
+		part.pockets = (s_pocket **) my_malloc(pockets->n_pockets*sizeof(s_pocket*)) ;
+		part.npockets = 0 ;
+		part.next = 0 ;
+		part.seed = get_rand_seed() ;
+		for(cur = pockets->first ; cur ; cur = cur->next) {
+			part.pockets[part.npockets++] = cur->pocket ;
+		}
 
-			cur = cur->next ;
+		/* Perform a first loop to calculate atom and vertice based descriptors */
+		nthreads = (ST_desc_threads < part.npockets) ? ST_desc_threads : part.npockets ;
+		pthread_t *threads = (pthread_t *) my_malloc(nthreads*sizeof(pthread_t)) ;
+		for(i = 1 ; i < nthreads ; i++) {
+			if(pthread_create(threads + i, NULL, run_pdesc_thread, &part) != 0) break ;
 		}
+		run_pdesc_thread(&part) ;
+		for(j = 1 ; j < i ; j++) pthread_join(threads[j], NULL) ;
+		my_free(threads) ;
+		my_free(part.pockets) ;
 
 		/* Set normalized descriptors */
 		set_normalized_descriptors(pockets) ;
@@ -552,12 +765,80 @@ void set_pockets_descriptors(c_lst_pockets *pockets)
 		cur = pockets->first ;
 		while(cur) {
 			cur->pocket->score = score_pocket(cur->pocket->pdesc) ;
+			if(cur->pocket->ptab) {
+				cur->pocket->ptab->score[cur->pocket->prow] = cur->pocket->score ;
+			}
 
 			cur = cur->next ;
 		}
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	run_pdesc_thread
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Thread of set_pockets_descriptors: handle pockets until none is left.
+	The seed of the pocket of rank i is a hash of i and of the seed of the
+	list, so that close ranks give unrelated sequences.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ void *data : The s_pdesc_part shared by the threads
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	NULL
+   -----------------------------------------------------------------------------
+*/
+static void* run_pdesc_thread(void *data)
+{
+	int i ;
+	s_pdesc_part *part = (s_pdesc_part *) data ;
+
+	while((i = __sync_fetch_and_add(&(part->next), 1)) < part->npockets) {
+		set_pocket_descriptors(part->pockets[i],
+							   part->seed ^ ((unsigned int)(i+1) * 2654435761u)) ;
+	}
+	unset_thread_rand() ;
+
+	return NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_pocket_descriptors
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Set atom and vertice based descriptors of a single pocket, random numbers
+	being drawn from a generator seeded with the given seed.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pocket *pocket   : The pocket
+	@ unsigned int seed  : Seed of the generator
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void set_pocket_descriptors(s_pocket *pocket, unsigned int seed)
+{
+	int natms = 0, nvert, tofree ;
+
+	set_thread_rand_seed(seed) ;
+
+	/* Get vertices as an array of pointers */
+	s_vvertice **tab_vert = get_pocket_vert_array(pocket, &nvert, &tofree) ;
+
+	/* Get atoms contacted by vertices, and calculate descriptors */
+	s_atm **pocket_atoms = get_pocket_contacted_atms(pocket, &natms) ;
+
+	/* Calculate descriptors*/
+	set_descriptors(pocket_atoms, natms, tab_vert, nvert, pocket->pdesc) ;
+
+	my_free(pocket_atoms) ;
+	if(tofree) my_free(tab_vert) ;
+}
+
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
@@ -919,6 +1200,8 @@ void dropPocket(c_lst_pockets *pockets, node_pocket *pocket)
 
 	my_free(pocket->pocket->pdesc);
 	pocket->pocket->pdesc = NULL ;
+	c_lst_vertices_free(pocket->pocket->v_lst) ;
+	pocket->pocket->v_lst = NULL ;
 	my_free(pocket->pocket);
 	pocket->pocket= NULL;
 
@@ -932,7 +1215,8 @@ void dropPocket(c_lst_pockets *pockets, node_pocket *pocket)
 	 mergePockets
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
-	Merge two pockets.
+	Merge two pockets: vertices of the second one are appended to the first
+	one, in its list and in the table of the pockets (see s_ptable).
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ node_pocket *pocket: The first pocket
@@ -948,6 +1232,17 @@ void mergePockets(node_pocket *pocket,node_pocket *pocket2,c_lst_pockets *pocket
 	s_pocket *pock =  pocket->pocket,
 			 *pock2 = pocket2->pocket ;
 
+	/* Rows of the second pocket are chained after the ones of the first */
+	s_ptable *t = pockets->ptab ;
+	if(t && pock->ptab == t && pock2->ptab == t) {
+		t->rnext[t->rlast[pock->prow]] = pock2->prow ;
+		t->rlast[pock->prow] = t->rlast[pock2->prow] ;
+		t->nvert[pock->prow] += t->nvert[pock2->prow] ;
+		t->napol[pock->prow] += t->napol[pock2->prow] ;
+		t->npol[pock->prow] += t->npol[pock2->prow] ;
+	}
+	else free_pockets_table(pockets) ;
+
 	pock->nAlphaApol += pock2->nAlphaApol;
 	pock->nAlphaPol += pock2->nAlphaPol;
 	pock->v_lst->n_vertices += pock2->v_lst->n_vertices;
@@ -955,8 +1250,10 @@ void mergePockets(node_pocket *pocket,node_pocket *pocket2,c_lst_pockets *pocket
 	
 	pock->v_lst->last->next = pock2->v_lst->first;
 	pock->v_lst->last = pock2->v_lst->last;
+	my_free(pock2->v_lst) ;
 	pocket2->pocket->v_lst = NULL;
 
+	my_free(pock2->pdesc) ;
 	my_free(pocket2->pocket);
 	pocket2->pocket=NULL;
 	
@@ -1007,6 +1304,8 @@ s_pocket* alloc_pocket(void)
 	s_pocket *p = (s_pocket*)my_malloc(sizeof(s_pocket)) ;
 	p->pdesc = (s_desc*)my_malloc(sizeof(s_desc)) ;
 	p->v_lst = NULL ;
+	p->ptab = NULL ;
+	p->prow = -1 ;
 
 	reset_pocket(p) ;
 
@@ -1035,6 +1334,7 @@ c_lst_pockets *c_lst_pockets_alloc(void)
 	lst->current = NULL ;
 	lst->n_pockets = 0 ;
 	lst->vertices = NULL ;
+	lst->ptab = NULL ;
 
 	return lst ;
 }
@@ -1085,6 +1385,7 @@ void c_lst_pocket_free(c_lst_pockets *lst)
 				*next = NULL ;
 	
 	if(lst) {
+		free_pockets_table(lst) ;
 		cur = lst->first ;
 		while(cur) {
 			next = cur->next ;
@@ -1104,6 +1405,164 @@ void c_lst_pocket_free(c_lst_pockets *lst)
 
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_pockets_table
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Store the pockets of the list as arrays (see s_ptable): one row per
+	pocket, in the order of the list. If the list already has a table (built
+	by clusterPockets), the chained rows of the merged pockets are copied one
+	after the other, else the vertex lists are read. Called once the
+	clustering is done, so the descriptors and the output get a single row
+	per pocket. Lists are kept: pockets can still be dropped or sorted.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets : The list of pockets
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_ptable*: The table (also in pockets->ptab), NULL if no pockets
+   -----------------------------------------------------------------------------
+*/
+s_ptable* set_pockets_table(c_lst_pockets *pockets)
+{
+	node_pocket *pcur = NULL ;
+	node_vertice *vcur = NULL ;
+	s_pocket *pock = NULL ;
+	s_ptable *old = NULL,
+			 *t = NULL ;
+	int r, k = 0, nv = 0 ;
+
+	if(!pockets) return NULL ;
+	if(pockets->n_pockets <= 0) {
+		free_pockets_table(pockets) ;
+		return NULL ;
+	}
+
+	old = pockets->ptab ;
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		nv += (old && pcur->pocket->ptab == old) ? old->nvert[pcur->pocket->prow]
+												 : (int) pcur->pocket->v_lst->n_vertices ;
+	}
+	t = alloc_ptable(pockets->n_pockets, nv) ;
+
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next, t->np++) {
+		pock = pcur->pocket ;
+		t->vstart[t->np] = t->nv ;
+		if(old && pock->ptab == old) {
+			for(r = pock->prow ; r != -1 ; r = old->rnext[r]) {
+				for(k = old->vstart[r] ; k < old->vstart[r+1] && t->nv < nv ; k++) {
+					t->vert[t->nv++] = old->vert[k] ;
+				}
+			}
+		}
+		else {
+			for(vcur = pock->v_lst->first ; vcur && t->nv < nv ; vcur = vcur->next) {
+				t->vert[t->nv++] = vcur->vertice ;
+			}
+		}
+		r = t->np ;
+		t->vstart[r+1] = t->nv ;
+		t->bx[r] = pock->bary[0] ;
+		t->by[r] = pock->bary[1] ;
+		t->bz[r] = pock->bary[2] ;
+		t->score[r] = pock->score ;
+		t->nvert[r] = t->nv - t->vstart[r] ;
+		t->napol[r] = pock->nAlphaApol ;
+		t->npol[r] = pock->nAlphaPol ;
+
+		pock->ptab = t ;
+		pock->prow = r ;
+	}
+	if(old) free_ptable(old) ;
+	pockets->ptab = t ;
+
+	return t ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	free_pockets_table
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Free the table of the pockets (if any): pockets use their vertex lists
+	again.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets : The list of pockets
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void free_pockets_table(c_lst_pockets *pockets)
+{
+	node_pocket *pcur = NULL ;
+
+	if(!pockets || !pockets->ptab) return ;
+
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		pcur->pocket->ptab = NULL ;
+		pcur->pocket->prow = -1 ;
+	}
+
+	free_ptable(pockets->ptab) ;
+	pockets->ptab = NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	alloc_ptable, free_ptable
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Allocate an empty table for at most np rows and nv vertices (each row
+	alone in its pocket), and free it.
+   -----------------------------------------------------------------------------
+*/
+static s_ptable* alloc_ptable(int np, int nv)
+{
+	int i ;
+	s_ptable *t = (s_ptable *) my_malloc(sizeof(s_ptable)) ;
+
+	t->np = 0 ;
+	t->nv = 0 ;
+	t->vert = (s_vvertice **) my_malloc((nv+1)*sizeof(s_vvertice *)) ;
+	t->vstart = (int *) my_malloc((np+1)*sizeof(int)) ;
+	t->rnext = (int *) my_malloc((np+1)*sizeof(int)) ;
+	t->rlast = (int *) my_malloc((np+1)*sizeof(int)) ;
+	t->bx = (float *) my_calloc(np+1, sizeof(float)) ;
+	t->by = (float *) my_calloc(np+1, sizeof(float)) ;
+	t->bz = (float *) my_calloc(np+1, sizeof(float)) ;
+	t->score = (float *) my_calloc(np+1, sizeof(float)) ;
+	t->nvert = (int *) my_calloc(np+1, sizeof(int)) ;
+	t->napol = (int *) my_calloc(np+1, sizeof(int)) ;
+	t->npol = (int *) my_calloc(np+1, sizeof(int)) ;
+
+	t->vstart[0] = 0 ;
+	for(i = 0 ; i <= np ; i++) {
+		t->rnext[i] = -1 ;
+		t->rlast[i] = i ;
+	}
+
+	return t ;
+}
+
+static void free_ptable(s_ptable *t)
+{
+	my_free(t->vert) ;
+	my_free(t->vstart) ;
+	my_free(t->rnext) ;
+	my_free(t->rlast) ;
+	my_free(t->bx) ;
+	my_free(t->by) ;
+	my_free(t->bz) ;
+	my_free(t->score) ;
+	my_free(t->nvert) ;
+	my_free(t->napol) ;
+	my_free(t->npol) ;
+	my_free(t) ;
+}
+
 				// ----------------------------------------------- //
 				// SORTING FUNCTION (REARANGE CHAINED LIST TO HAVE //
 				// POCKETS SORTED ACCORDING TO SEVERAL PROPERTIES) //
@@ -1138,37 +1597,37 @@ s_atm** get_pocket_contacted_atms(s_pocket *pocket, int *natoms)
 {
 	int actual_size = 10,
 		nb_atoms = 0,
-		i = 0 ;
+		i = 0, k, nvert, tofree ;
 	
-	node_vertice *nvcur = NULL ;
-	s_vvertice *vcur = NULL ;
+	s_vvertice *vcur = NULL,
+			   **verts = NULL ;
 
 	s_atm **catoms = NULL ;
 	
 	if(pocket && pocket->v_lst && pocket->v_lst->n_vertices > 0) {
+		verts = get_pocket_vert_array(pocket, &nvert, &tofree) ;
 	/* Remember atoms already stored. */
-		int atm_ids[pocket->v_lst->n_vertices * 4] ;
+		s_idset *atm_ids = alloc_idset(nvert) ;
 
 	/* Do the search  */
 		catoms = (s_atm **)my_malloc(actual_size*sizeof(s_atm*)) ;
-		nvcur = pocket->v_lst->first ;
-		while(nvcur) {
-			vcur = nvcur->vertice ;
+		for(k = 0 ; k < nvert ; k++) {
+			vcur = verts[k] ;
 			/*printf("ID in the pocket: %d (%.3f %.3f %.3f\n", vcur->id, vcur->x, vcur->y, vcur->z) ;*/
 			for(i = 0 ; i < 4 ; i++) {
-				if(in_tab(atm_ids,  nb_atoms, vcur->neigh[i]->id) == 0) {
+				if(add_idset(atm_ids, vcur->neigh[i]->id)) {
 					if(nb_atoms >= actual_size) {
-						catoms = (s_atm **)my_realloc(catoms, (actual_size+10)*sizeof(s_atm**)) ;
-						actual_size += 10 ;
+						actual_size *= 2 ;
+						catoms = (s_atm **)my_realloc(catoms, actual_size*sizeof(s_atm*)) ;
 					}
 	
-					atm_ids[nb_atoms] = vcur->neigh[i]->id ;
 					catoms[nb_atoms] = vcur->neigh[i] ;
 					nb_atoms ++ ;
 				}
 			}
-			nvcur = nvcur->next ;
 		}
+		free_idset(atm_ids) ;
+		if(tofree) my_free(verts) ;
 	}
 
 	*natoms = nb_atoms ;
@@ -1195,31 +1654,89 @@ int count_pocket_contacted_atms(s_pocket *pocket)
 	if(!pocket || !(pocket->v_lst) || pocket->v_lst->n_vertices <= 0) return -1 ;
 
 	int nb_atoms = 0,
-		i = 0 ;
+		i = 0, k, nvert, tofree ;
 
-	node_vertice *nvcur = NULL ;
-	s_vvertice *vcur = NULL ;
+	s_vvertice *vcur = NULL,
+			   **verts = get_pocket_vert_array(pocket, &nvert, &tofree) ;
 
 	/* Remember atoms already stored. */
-	int atm_ids[pocket->v_lst->n_vertices * 4] ;
+	s_idset *atm_ids = alloc_idset(nvert) ;
 
 	/* Do the search  */
-	nvcur = pocket->v_lst->first ;
-	while(nvcur) {
-		vcur = nvcur->vertice ;
+	for(k = 0 ; k < nvert ; k++) {
+		vcur = verts[k] ;
 		/*printf("ID in the pocket: %d (%.3f %.3f %.3f\n", vcur->id, vcur->x, vcur->y, vcur->z) ;*/
 		for(i = 0 ; i < 4 ; i++) {
-			if(in_tab(atm_ids,  nb_atoms, vcur->neigh[i]->id) == 0) {
-				atm_ids[nb_atoms] = vcur->neigh[i]->id ;
-				nb_atoms ++ ;
-			}
+			nb_atoms += add_idset(atm_ids, vcur->neigh[i]->id) ;
 		}
-		nvcur = nvcur->next ;
 	}
+	free_idset(atm_ids) ;
+	if(tofree) my_free(verts) ;
 
 	return nb_atoms ;
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_pocket_vert_array
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the vertices of a pocket as an array: its row of the table of the
+	pockets if it is a single row (nothing allocated), else an array filled
+	from its chained rows or from its vertex list (to free by the caller,
+	tofree being set).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pocket *pocket : The pocket
+	@ int *nvert       : OUTPUT Number of vertices
+	@ int *tofree      : OUTPUT 1 if the array has to be freed, 0 if not
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_vvertice**: The vertices of the pocket
+   -----------------------------------------------------------------------------
+*/
+s_vvertice** get_pocket_vert_array(s_pocket *pocket, int *nvert, int *tofree)
+{
+	s_vvertice **verts = NULL ;
+	node_vertice *nvcur = NULL ;
+	int i = 0 ;
+
+	s_ptable *t = pocket->ptab ;
+	int r, k ;
+
+	if(t && t->rnext[pocket->prow] == -1) {
+		*nvert = t->nvert[pocket->prow] ;
+		*tofree = 0 ;
+
+		return t->vert + t->vstart[pocket->prow] ;
+	}
+	if(t) {
+		*nvert = t->nvert[pocket->prow] ;
+		*tofree = 1 ;
+		verts = (s_vvertice **) my_malloc((*nvert+1)*sizeof(s_vvertice *)) ;
+		for(r = pocket->prow ; r != -1 ; r = t->rnext[r]) {
+			for(k = t->vstart[r] ; k < t->vstart[r+1] && i < *nvert ; k++) {
+				verts[i++] = t->vert[k] ;
+			}
+		}
+		*nvert = i ;
+
+		return verts ;
+	}
+
+	*nvert = pocket->v_lst ? pocket->v_lst->n_vertices : 0 ;
+	*tofree = 1 ;
+	verts = (s_vvertice **) my_malloc((*nvert+1)*sizeof(s_vvertice *)) ;
+	if(pocket->v_lst) {
+		for(nvcur = pocket->v_lst->first ; nvcur && i < *nvert ; nvcur = nvcur->next) {
+			verts[i++] = nvcur->vertice ;
+		}
+	}
+	*nvert = i ;
+
+	return verts ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	get_pocket_contacted_atms
@@ -1236,14 +1753,14 @@ int count_pocket_contacted_atms(s_pocket *pocket)
 */
 s_vvertice** get_pocket_pvertices(s_pocket *pocket)
 {
-	s_vvertice **pverts = my_calloc(pocket->size, sizeof(s_vvertice*)) ;
-	int i = 0 ;
-	node_vertice *nvcur = pocket->v_lst->first ;
-	while(nvcur) {
-		pverts[i] = nvcur->vertice ;
-		nvcur = nvcur->next ;
-		i++ ;
-	}
+	int nvert, tofree ;
+	s_vvertice **verts = get_pocket_vert_array(pocket, &nvert, &tofree),
+			   **pverts = NULL ;
+
+	if(tofree) return verts ;
+
+	pverts = my_calloc(nvert+1, sizeof(s_vvertice*)) ;
+	memcpy(pverts, verts, nvert*sizeof(s_vvertice*)) ;
 
 	return pverts ;
 }
@@ -18,9 +18,9 @@
 /*========= qh definition (see qhull.h) =======================*/
 
 #if qh_QHpointer
-qhT *qh_qh= NULL;	/* pointer to all global variables */
+qh_THREADlocal qhT *qh_qh= NULL;	/* pointer to all global variables */
 #else
-qhT qh_qh;     		/* all global variables.
+qh_THREADlocal qhT qh_qh;     		/* all global variables.
 			   Add "= {0}" if this causes a compiler error.
 			   Also qh_qhstat in stat.c and qhmem in mem.c.  */
 #endif
@@ -168,7 +168,7 @@ unsigned long qh_clock (void) {
 
 #if (qh_CLOCKtype == 2)
   struct tms time;
-  static long clktck;  /* initialized first call */
+  static qh_THREADlocal long clktck;  /* initialized first call */
   double ratio, cpu;
   unsigned long ticks;
 
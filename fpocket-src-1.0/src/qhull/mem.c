@@ -17,6 +17,11 @@
     
   To free up all memory buffers:
     qh_memfreeshort (&curlong, &totlong);
+
+  To keep the memory buffers for the next run (not part of qhull 2003.1):
+    qh_memkeep (True);
+    ...
+    qh_memkeep (False);  -- frees the kept buffers
          
   if qh_NOmem, 
     malloc/free is used instead of mem.c
@@ -47,7 +52,13 @@ void    qh_errexit(int exitcode, facetT *, ridgeT *);
     see mem.h for definition
 */
 
-qhmemT qhmem= {0};     /* remove "= {0}" if this causes a compiler error */
+qh_THREADlocal qhmemT qhmem= {0};     /* remove "= {0}" if this causes a compiler error */
+
+/* buffers kept by qh_memfreeshort if qh_memkeep(True), oldest first, linked
+   by offset 0, with their size at offset 1 (outside of qhmem, which is
+   cleared by qh_meminit) */
+static qh_THREADlocal void *qhmem_spare= NULL;
+static qh_THREADlocal int qhmem_keep= 0;
 
 #ifndef qh_NOmem
 
@@ -118,7 +129,18 @@ void *qh_memalloc(int insize) {
         else
 	  bufsize= qhmem.BUFsize;
         qhmem.totshort += bufsize;
-	if (!(newbuffer= malloc(bufsize))) {
+	newbuffer= NULL;
+	if (qhmem_spare) {    /* buffer kept from a previous run */
+	  newbuffer= qhmem_spare;
+	  qhmem_spare= *((void **)newbuffer);
+	  if (*((int *)((void **)newbuffer + 1)) >= bufsize)
+	    bufsize= *((int *)((void **)newbuffer + 1));
+	  else {
+	    free (newbuffer);
+	    newbuffer= NULL;
+	  }
+	}
+	if (!newbuffer && !(newbuffer= malloc(bufsize))) {
 	  fprintf(qhmem.ferr, "qhull error (qh_memalloc): insufficient memory\n");
 	  qh_errexit(qhmem_ERRmem, NULL, NULL);
 	} 
@@ -202,6 +224,9 @@ void qh_memfree(void *object, int size) {
 
   returns:
     number and size of current long allocations
+
+  notes:
+    if qh_memkeep(True), the buffers are kept for the next allocations
 */
 void qh_memfreeshort (int *curlong, int *totlong) {
   void *buffer, *nextbuffer;
@@ -211,7 +236,12 @@ void qh_memfreeshort (int *curlong, int *totlong) {
   *totlong= qhmem .totlong;
   for(buffer= qhmem.curbuffer; buffer; buffer= nextbuffer) {
     nextbuffer= *((void **) buffer);
-    free(buffer);
+    if (qhmem_keep) {     /* curbuffer is the newest, the oldest is BUFinit */
+      *((int *)((void **) buffer + 1))= nextbuffer ? qhmem.BUFsize : qhmem.BUFinit;
+      *((void **) buffer)= qhmem_spare;
+      qhmem_spare= buffer;
+    }else
+      free(buffer);
   }
   qhmem.curbuffer= NULL;
   if (qhmem .LASTsize) {
@@ -241,6 +271,29 @@ void qh_meminit (FILE *ferr) {
   }
 } /* meminit */
 
+/*-<a                             href="qh-mem.htm#TOC"
+  >-------------------------------</a><a name="memkeep">-</a>
+  
+  qh_memkeep( keep )
+    if keep, qh_memfreeshort keeps the memory buffers for the next run
+    else frees the buffers kept
+
+  notes:
+    not part of qhull 2003.1.  Avoids allocating the buffers again for each
+    run of a batch.  The size of a buffer is stored after its link.
+*/
+void qh_memkeep (int keep) {
+  void *buffer;
+
+  qhmem_keep= keep;
+  if (!keep) {
+    while ((buffer= qhmem_spare)) {
+      qhmem_spare= *((void **)buffer);
+      free (buffer);
+    }
+  }
+} /* memkeep */
+
 /*-<a                             href="qh-mem.htm#TOC"
   >-------------------------------</a><a name="meminitbuffers">-</a>
   
@@ -439,6 +492,10 @@ void qh_memsetup (void) {
 
 }
 
+void qh_memkeep (int keep) {
+
+}
+
 void qh_memsize(int size) {
 
 }
@@ -79,8 +79,18 @@ typedef unsigned long ptr_intT;
    If you need separate address spaces, you can swap the
    contents of qhmem.
 */
+
+/* see qh_THREADlocal in user.h, repeated here since mem.c only includes mem.h */
+#ifndef qh_THREADlocal
+#ifdef qh_REENTRANT
+#define qh_THREADlocal __thread
+#else
+#define qh_THREADlocal
+#endif
+#endif
+
 typedef struct qhmemT qhmemT;
-extern qhmemT qhmem; 
+extern qh_THREADlocal qhmemT qhmem; 
 
 struct qhmemT {               /* global memory management variables */
   int      BUFsize;	      /* size of memory allocation buffer */
@@ -164,6 +174,7 @@ struct qhmemT {               /* global memory management variables */
 void *qh_memalloc(int insize);
 void qh_memfree (void *object, int size);
 void qh_memfreeshort (int *curlong, int *totlong);
+void qh_memkeep (int keep);
 void qh_meminit (FILE *ferr);
 void qh_meminitbuffers (int tracelevel, int alignment, int numsizes,
 			int bufsize, int bufinit);
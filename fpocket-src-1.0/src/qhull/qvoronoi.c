@@ -15,6 +15,11 @@
  * unchanged as well the rest of the qhull distribution. A qvoronoi.h file was
  * added.
  * You can obtain the original source code of this file on www.qhull.org.
+ *
+ * run_qvoronoi_mem(...) was added afterwards: it runs the same computation
+ * as run_qvoronoi ('p i Pp Fn Qt') on an in-memory coordinate array and
+ * hands each Voronoi vertex to a callback instead of printing it.
+ * qvoronoi_keep_mem(...) keeps its memory between runs (batches).
 */
 
 #include <stdio.h>
@@ -25,6 +30,8 @@
 #include "qhull.h"
 #include "mem.h"
 #include "qset.h"
+#include "qhull_a.h"
+#include "qvoronoi.h"
 
 #if __MWERKS__ && __POWERPC__
 #include <SIOUX.h>
@@ -340,3 +347,173 @@ int run_qvoronoi(FILE *fin,FILE *fout) {
   return exitcode;
 } /* main */
 
+
+/* point array and memory buffers kept between runs, see qvoronoi_keep_mem */
+static qh_THREADlocal int qvoronoi_keep= 0;
+static qh_THREADlocal coordT *qvoronoi_points= NULL;
+static qh_THREADlocal int qvoronoi_maxpoints= 0;
+
+/*-<a                             href="qh-qhull.htm#TOC"
+  >-------------------------------</a><a name="qvoronoi_keep_mem">-</a>
+
+  qvoronoi_keep_mem( keep )
+    if keep, run_qvoronoi_mem keeps its point array and the qhull memory
+    buffers (see qh_memkeep) for the next runs of the same thread
+    else frees them
+
+  notes:
+    qh_init_A and qh_freeqhull are still called for each run
+*/
+void qvoronoi_keep_mem(int keep) {
+
+  qvoronoi_keep= keep;
+  qh_memkeep (keep);
+  if (!keep && qvoronoi_points) {
+    free (qvoronoi_points);
+    qvoronoi_points= NULL;
+    qvoronoi_maxpoints= 0;
+  }
+} /* qvoronoi_keep_mem */
+
+/*-<a                             href="qh-qhull.htm#TOC"
+  >-------------------------------</a><a name="run_qvoronoi_mem">-</a>
+
+  run_qvoronoi_mem( xyz, numpoints, fbegin, fvert, data )
+    same as run_qvoronoi with 'p i Pp Fn Qt', but without any text i/o
+
+  returns:
+    exit code (qh_ERRnone if the diagram was computed)
+    fbegin is called once with the number of Voronoi vertices, then fvert
+    once per Voronoi vertex, in the order qvoronoi would print them:
+      id       index of the vertex (line number of the 'p' output)
+      center   coordinates of the vertex ('p' output)
+      pts      the 4 input points of the Delaunay region ('i' output)
+      vneigh   the 4 neighbour vertices, negative if unbounded ('Fn' output)
+
+  notes:
+    xyz holds numpoints 3-d points and is not modified.
+    points are lifted to the paraboloid exactly as qh_readpoints does.
+    the output preparation mirrors qh_produce_output and qh_printfacets
+*/
+int run_qvoronoi_mem(double *xyz, int numpoints, qvoronoi_begin_fct fbegin,
+                     qvoronoi_vert_fct fvert, void *data) {
+  int curlong, totlong; /* used !qh_NOmem */
+  int exitcode, i, k, nvvert;
+  int pts[4], vneigh[4];
+  coordT *points, *coords, *cur;
+  realT paraboloid;
+  facetT *facet, *neighbor, **neighborp;
+  vertexT *vertex, **vertexp;
+  char *argv[6];
+
+  argv[0]= "qvoronoi";
+  argv[1]= "p";
+  argv[2]= "i";
+  argv[3]= "Pp";
+  argv[4]= "Fn";
+  argv[5]= "Qt";
+  qh_init_A (NULL, stdout, stderr, 6, argv);
+  exitcode= setjmp (qh errexit);
+  if (!exitcode) {
+    qh_option ("voronoi  _bbound-last  _coplanar-keep", NULL, NULL);
+    qh DELAUNAY= True;     /* 'v'   */
+    qh VORONOI= True; 
+    qh SCALElast= True;    /* 'Qbb' */
+    qh_checkflags (qh qhull_command, hidden_options);
+    qh_initflags (qh qhull_command);
+    qh normal_size= 4 * sizeof(coordT);
+    if (qvoronoi_keep && qvoronoi_maxpoints >= numpoints)
+      points= qvoronoi_points;
+    else {
+      if (qvoronoi_points) {
+        free (qvoronoi_points);
+        qvoronoi_points= NULL;
+        qvoronoi_maxpoints= 0;
+      }
+      points= (coordT*)malloc (numpoints * 4 * sizeof(coordT));
+      if (qvoronoi_keep && points) {
+        qvoronoi_points= points;
+        qvoronoi_maxpoints= numpoints;
+      }
+    }
+    coords= points;
+    if (!points) {
+      fprintf (qh ferr, "qhull error: insufficient memory to store %d points\n",
+              numpoints);
+      qh_errexit (qh_ERRmem, NULL, NULL);
+    }
+    for (i= 0; i < numpoints; i++) {
+      paraboloid= 0.0;
+      for (k= 0; k < 3; k++) {
+        *(coords++)= xyz[3*i+k];
+        paraboloid += xyz[3*i+k] * xyz[3*i+k];
+      }
+      *(coords++)= paraboloid;
+    }
+    qh_init_B (points, numpoints, 4, True);
+    qh_qhull();
+    qh_check_output();
+
+    /* qh_produce_output() up to the print calls */
+    qh_clearcenters (qh_ASvoronoi);
+    qh_vertexneighbors();
+    if (qh TRIangulate)
+      qh_triangulate(); 
+    qh_findgood_all (qh facet_list); 
+
+    /* qh_countfacets(): visitid-1 is the index of the Voronoi vertex */
+    nvvert= 0;
+    FORALLfacets {
+      if ((facet->visible && qh NEWfacets) || qh_skipfacet (facet))
+        facet->visitid= 0;
+      else
+        facet->visitid= ++nvvert;
+    }
+    qh visit_id += nvvert+1;
+    fbegin (data, nvvert);
+
+    FORALLfacets {
+      if (!facet->visitid)
+        continue;
+      if (!facet->center)
+        facet->center= qh_facetcenter (facet->vertices);
+      k= 0;
+      if ((facet->toporient ^ qh_ORIENTclock) || !facet->simplicial) {
+        FOREACHvertex_(facet->vertices)
+          if (k < 4) pts[k++]= qh_pointid (vertex->point);
+      }else {
+        FOREACHvertexreverse12_(facet->vertices)
+          if (k < 4) pts[k++]= qh_pointid (vertex->point);
+      }
+      while (k < 4)
+        pts[k++]= -1;
+      k= 0;
+      FOREACHneighbor_(facet)
+        if (k < 4) vneigh[k++]= neighbor->visitid ? neighbor->visitid - 1: - neighbor->id;
+      while (k < 4)
+        vneigh[k++]= 0;
+      cur= facet->center;
+      fvert (data, facet->visitid - 1, cur, pts, vneigh);
+    }
+    exitcode= qh_ERRnone;
+  }
+  qh NOerrexit= True;  /* no more setjmp */
+  if (qvoronoi_points) {   /* the kept point array is not freed by qhull */
+    if (qh first_point == qvoronoi_points)
+      qh POINTSmalloc= False;
+    else if (qh first_point) {   /* replaced, freed by qhull */
+      qvoronoi_points= NULL;
+      qvoronoi_maxpoints= 0;
+    }
+  }
+#ifdef qh_NOmem
+  qh_freeqhull( True);
+#else
+  qh_freeqhull( False);
+  qh_memfreeshort (&curlong, &totlong);
+  if (curlong || totlong) 
+    fprintf (stderr, "qhull internal warning (run_qvoronoi_mem): did not free %d bytes of long memory (%d pieces)\n",
+       totlong, curlong);
+#endif
+  return exitcode;
+} /* run_qvoronoi_mem */
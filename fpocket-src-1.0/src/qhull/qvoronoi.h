@@ -11,8 +11,18 @@
 #define	_QVORONOI_H
 
 
+/* Callbacks used by run_qvoronoi_mem: the first one receives the number of
+ * Voronoi vertices, the second one each vertex with its 4 Delaunay points and
+ * its 4 neighbouring vertices (see qvoronoi.c) */
+typedef void (*qvoronoi_begin_fct)(void *data, int nvvert);
+typedef void (*qvoronoi_vert_fct)(void *data, int id, double *center,
+                                  int *pts, int *vneigh);
+
 int qvoronoi_test(int v);
 int run_qvoronoi(FILE *fin,FILE *fout);
+int run_qvoronoi_mem(double *xyz, int numpoints, qvoronoi_begin_fct fbegin,
+                     qvoronoi_vert_fct fvert, void *data);
+void qvoronoi_keep_mem(int keep);
 
 
 #endif	/* _QVORONOI_H */
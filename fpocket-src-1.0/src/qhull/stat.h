@@ -474,10 +474,10 @@ union intrealT {
 typedef struct qhstatT qhstatT; 
 #if qh_QHpointer
 #define qhstat qh_qhstat->
-extern qhstatT *qh_qhstat;
+extern qh_THREADlocal qhstatT *qh_qhstat;
 #else
 #define qhstat qh_qhstat.
-extern qhstatT qh_qhstat; 
+extern qh_THREADlocal qhstatT qh_qhstat; 
 #endif
 struct qhstatT {  
   intrealT   stats[ZEND];     /* integer and real statistics */
@@ -486,6 +486,26 @@
     #define qh_NOtrace
 */    
 
+/*-<a                             href="qh-user.htm#TOC"
+  >--------------------------------</a><a name="THREADlocal">-</a>
+  
+  qh_THREADlocal
+    storage class of qhull's global data structures
+
+  qh_REENTRANT defined (-Dqh_REENTRANT, see QRFLAGS in the fpocket makefile)
+                        qh, qhmem, qhstat, the random seed and the statics
+                        of qh_new_qhull and qh_clock are thread local
+  qh_REENTRANT undefined
+                        qh_THREADlocal is empty, default qhull behavior
+*/
+#ifndef qh_THREADlocal
+#ifdef qh_REENTRANT
+#define qh_THREADlocal __thread
+#else
+#define qh_THREADlocal
+#endif
+#endif
+
 /*-<a                             href="qh-user.htm#TOC"
   >--------------------------------</a><a name="QHpointer">-</a>
   
@@ -495,6 +515,9 @@
   qh_QHpointer  = 1     access globals via a pointer to allocated memory
                         enables qh_saveqhull() and qh_restoreqhull()
 			costs about 8% in time and 2% in space
+			set by qh_REENTRANT: qh_initqhull_start() then
+			allocates a new qhT for each run of qhull, and the
+			pointer is thread local (see qh_THREADlocal)
 
 		= 0     qh_qh and qh_qhstat are static data structures
 		        only one instance of qhull() can be active at a time
@@ -509,7 +532,11 @@
   see:
     user_eg.c for an example
 */
+#ifdef qh_REENTRANT
+#define qh_QHpointer 1
+#else
 #define qh_QHpointer 0
+#endif
 #if 0  /* sample code */
     qhT *oldqhA, *oldqhB;
 
@@ -0,0 +1,589 @@
+#include "../headers/rcif.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					rcif.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	mmCIF reader. The _atom_site loop of the first data block is read in a
+##	single pass over the file in memory (mapped by rpdb_open, which calls
+##	rcif_parse when the file starts with a data_ block). Values are taken
+##	where they are in the file, without copy of the rows, and the columns
+##	used are found once from the loop header, whatever their order.
+##
+##	Atoms are selected as in the PDB reader (rpdb_atom_kind): first model,
+##	first alternate location, HETATM removed except the ligand and the
+##	residues kept by fpocket. auth_* values are used when given (as in PDB
+##	files), label_* ones otherwise. Atom and residue ids are not limited to
+##	5 and 4 digits, and chain names keep up to 4 characters.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     Rows of the atom loop read by rcif_row, number of atoms
+##					 guessed from shorter rows
+##	17-11-11	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+##	BinaryCIF.
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+/**
+	Names of the _atom_site columns used, in the order of the M_RCIF_* ids.
+*/
+static const char *ST_rcif_fields[M_RCIF_NFIELD] = {
+	"group_PDB", "id", "type_symbol", "label_atom_id", "auth_atom_id",
+	"label_alt_id", "label_comp_id", "auth_comp_id", "label_asym_id",
+	"auth_asym_id", "label_seq_id", "auth_seq_id", "pdbx_PDB_ins_code",
+	"Cartn_x", "Cartn_y", "Cartn_z", "occupancy", "B_iso_or_equiv",
+	"pdbx_formal_charge", "pdbx_PDB_model_num"
+} ;
+
+static int rcif_next(const char *buf, const char **pos, const char *eof,
+					 s_rcif_tok *tok) ;
+static int rcif_row(const char *buf, const char **pos, const char *eof,
+					const char *last, s_rcif_tok *row, int col, int ncol) ;
+static int rcif_word(const s_rcif_tok *tok) ;
+static int rcif_is(const s_rcif_tok *tok, const char *str) ;
+static int rcif_field(const s_rcif_tok *tok) ;
+static void rcif_cell(s_pdb *pdb, const s_rcif_tok *key, const s_rcif_tok *val) ;
+static const s_rcif_tok* rcif_get(const s_rcif_tok *row, const int *map,
+								  int f, int alt) ;
+static void rcif_str(const s_rcif_tok *tok, char *dest, int max) ;
+static int rcif_int(const s_rcif_tok *tok) ;
+static float rcif_float(const s_rcif_tok *tok) ;
+static void rcif_atom(const s_rcif_tok *row, const int *map, s_rpdb_atoms *ra,
+					  const char *ligan, const int keep_lig, int *model) ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_is_cif
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check if a file in memory is a CIF file: the first thing after blanks and
+	comments is a data_ block.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *buf : The content of the file
+	@ size_t len      : Its size
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if CIF, 0 if not
+   -----------------------------------------------------------------------------
+*/
+int rcif_is_cif(const char *buf, size_t len)
+{
+	const char *p = buf,
+			   *eof = buf + len ;
+
+	while(p < eof) {
+		if(M_RCIF_SPACE(*p)) p++ ;
+		else if(*p == '#') {
+			p = (const char *) memchr(p, '\n', eof - p) ;
+			if(!p) return 0 ;
+		}
+		else break ;
+	}
+
+	return (eof - p >= 5 && strncasecmp(p, "data_", 5) == 0) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_parse
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Read the atoms of a mmCIF file in memory: the _atom_site loop of the
+	first data block, and the unit cell (_cell). The reading stops at the end
+	of the _atom_site loop.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb           : The structure to fill (set to 0 by the caller)
+	@ const char *buf      : The content of the file
+	@ size_t len           : Its size
+	@ const char *ligan    : Ligand resname.
+	@ const char *keep_lig :  Keep the given ligand or not?
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void (pdb->natoms is 0 and nothing is allocated if there is no atoms)
+   -----------------------------------------------------------------------------
+*/
+void rcif_parse(s_pdb *pdb, const char *buf, size_t len, const char *ligan,
+				const int keep_lig)
+{
+	const char *pos = buf,
+			   *eof = buf + len,
+			   *last = NULL ;
+	int i, f, word,
+		state = M_RCIF_NONE,
+		atom_loop = 0,
+		ndata = 0,
+		ncol = 0,
+		col = 0,
+		nrow = 16,
+		model = -1 ;
+	int map[M_RCIF_NFIELD] ;
+	s_rcif_tok tok, key ;
+	s_rcif_tok *row = (s_rcif_tok *) my_malloc(nrow*sizeof(s_rcif_tok)) ;
+	s_rpdb_atoms ra ;
+
+	rpdb_init_atoms(&ra, len/M_RCIF_ROW_LEN + 64) ;
+
+	while(rcif_next(buf, &pos, eof, &tok)) {
+		word = rcif_word(&tok) ;
+		if(word == M_RCIF_WORD_DATA) {
+			if(ndata++ > 0) break ;
+			state = M_RCIF_NONE ;
+		}
+		else if(word == M_RCIF_WORD_LOOP) {
+			if(atom_loop) break ;
+			state = M_RCIF_HEAD ;
+			ncol = 0 ;
+			for(i = 0 ; i < M_RCIF_NFIELD ; i++) map[i] = -1 ;
+		}
+		else if(word == M_RCIF_WORD_NAME) {
+			if(state == M_RCIF_HEAD) {
+				f = rcif_field(&tok) ;
+				if(f != M_RCIF_NOT_ATOM) atom_loop = 1 ;
+				if(f >= 0) map[f] = ncol ;
+				ncol++ ;
+				continue ;
+			}
+			/* A name out of a loop, and its value */
+			if(atom_loop) break ;
+			state = M_RCIF_NONE ;
+			key = tok ;
+			if(!rcif_next(buf, &pos, eof, &tok)) break ;
+			rcif_cell(pdb, &key, &tok) ;
+		}
+		else {
+			if(state == M_RCIF_HEAD) {
+				state = M_RCIF_DATA ;
+				col = 0 ;
+				if(ncol > nrow) {
+					nrow = ncol ;
+					row = (s_rcif_tok *) my_realloc(row, nrow*sizeof(s_rcif_tok)) ;
+				}
+			}
+			if(state == M_RCIF_DATA && atom_loop) {
+				/* Rows of the atom loop up to its end, which ends the parse */
+				row[0] = tok ;
+				col = 1 ;
+				for(last = eof - 1 ; last > pos && !M_RCIF_SPACE(*last) ; last--) ;
+				while(rcif_row(buf, &pos, eof, last, row, col, ncol)) {
+					rcif_atom(row, map, &ra, ligan, keep_lig, &model) ;
+					col = 0 ;
+				}
+				break ;
+			}
+		}
+	}
+
+	my_free(row) ;
+	rpdb_store_atoms(pdb, &ra) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_next
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Get the next value of a CIF file, skipping blanks and comments. A value
+	is a word, a string between quotes (' or ", ending at a quote followed by
+	a blank), or a text field between two lines starting with ';'.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *buf   : The content of the file
+	@ const char **pos  : Current position, moved after the value
+	@ const char *eof   : End of the content
+	@ s_rcif_tok *tok   : OUTPUT The value
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if a value is read, 0 at the end of the file
+   -----------------------------------------------------------------------------
+*/
+static int rcif_next(const char *buf, const char **pos, const char *eof,
+					 s_rcif_tok *tok)
+{
+	const char *p = *pos,
+			   *e = NULL ;
+	char q ;
+
+	while(p < eof) {
+		if(M_RCIF_SPACE(*p)) p++ ;
+		else if(*p == '#') {
+			p = (const char *) memchr(p, '\n', eof - p) ;
+			if(!p) p = eof ;
+		}
+		else break ;
+	}
+	if(p >= eof) {
+		*pos = eof ;
+		return 0 ;
+	}
+
+	tok->quoted = 0 ;
+	if(*p == ';' && (p == buf || p[-1] == '\n' || p[-1] == '\r')) {
+		/* Text field, up to the next line starting with ';' */
+		tok->s = e = p + 1 ;
+		tok->quoted = 1 ;
+		for(;;) {
+			e = (const char *) memchr(e, '\n', eof - e) ;
+			if(!e || e + 1 >= eof) {
+				tok->len = eof - tok->s ;
+				p = eof ;
+				break ;
+			}
+			if(e[1] == ';') {
+				tok->len = e - tok->s ;
+				p = e + 2 ;
+				break ;
+			}
+			e++ ;
+		}
+	}
+	else if(*p == '\'' || *p == '"') {
+		q = *(p++) ;
+		tok->s = p ;
+		tok->quoted = 1 ;
+		while(p < eof && !(*p == q && (p + 1 == eof || M_RCIF_SPACE(p[1])))) p++ ;
+		tok->len = p - tok->s ;
+		if(p < eof) p++ ;
+	}
+	else {
+		tok->s = p ;
+		while(p < eof && !M_RCIF_SPACE(*p)) p++ ;
+		tok->len = p - tok->s ;
+	}
+	*pos = p ;
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_row
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Read the values of a row of a loop, from the given column. Unquoted
+	words, nearly all values of an _atom_site loop, are read here; other
+	values (quoted, text fields) and comments are left to rcif_next.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *buf   : The content of the file
+	@ const char **pos  : Current position, moved after the row
+	@ const char *eof   : End of the content
+	@ const char *last  : Last blank of the content: words before it are
+						  read without checking the end of the content
+	@ s_rcif_tok *row   : OUTPUT The values of the row
+	@ int col           : First column to read
+	@ int ncol          : Number of columns of the loop
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the row is read, 0 at the end of the loop (end of the file,
+	reserved word or name) before the end of the row
+   -----------------------------------------------------------------------------
+*/
+static int rcif_row(const char *buf, const char **pos, const char *eof,
+					const char *last, s_rcif_tok *row, int col, int ncol)
+{
+	const char *p = *pos ;
+
+	for( ; col < ncol ; col++) {
+		while(p < eof && M_RCIF_SPACE(*p)) p++ ;
+		if(p < eof && *p != '\'' && *p != '"' && *p != ';' && *p != '#'
+		   && *p != '_') {
+			row[col].s = p ;
+			row[col].quoted = 0 ;
+			if(p < last) while(!M_RCIF_SPACE(*p)) p++ ;
+			else while(p < eof && !M_RCIF_SPACE(*p)) p++ ;
+			row[col].len = p - row[col].s ;
+			if(M_RCIF_RESERVED(*(row[col].s)) && rcif_word(row + col) != 0) return 0 ;
+			continue ;
+		}
+
+		*pos = p ;
+		if(!rcif_next(buf, pos, eof, row + col) || rcif_word(row + col) != 0)
+			return 0 ;
+		p = *pos ;
+	}
+	*pos = p ;
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_word
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check if a value read is a reserved word (data_ block, loop_) or a name.
+	Most values don't start as one of them, and are checked on their first
+	character only.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_rcif_tok *tok : The value
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_RCIF_WORD_DATA, M_RCIF_WORD_LOOP, M_RCIF_WORD_NAME, 0 for a value
+   -----------------------------------------------------------------------------
+*/
+static int rcif_word(const s_rcif_tok *tok)
+{
+	if(tok->quoted || !M_RCIF_RESERVED(tok->s[0])) return 0 ;
+	if(tok->s[0] == '_') return M_RCIF_WORD_NAME ;
+	if(tok->len >= 5 && strncasecmp(tok->s, "data_", 5) == 0) return M_RCIF_WORD_DATA ;
+	if(tok->len == 5 && strncasecmp(tok->s, "loop_", 5) == 0) return M_RCIF_WORD_LOOP ;
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_is
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check if a value is the given string, ignoring the case (as CIF names).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_rcif_tok *tok : The value
+	@ const char *str       : The string
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if equal, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int rcif_is(const s_rcif_tok *tok, const char *str)
+{
+	return ((int) strlen(str) == tok->len && strncasecmp(tok->s, str, tok->len) == 0) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_field
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Get the column read from a name of a loop header.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_rcif_tok *tok : The name (_category.item)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: The M_RCIF_* id of the column, M_RCIF_OTHER for another column of
+	_atom_site, M_RCIF_NOT_ATOM for a column of another category.
+   -----------------------------------------------------------------------------
+*/
+static int rcif_field(const s_rcif_tok *tok)
+{
+	int i ;
+	s_rcif_tok item ;
+
+	if(tok->len <= 11 || strncasecmp(tok->s, "_atom_site.", 11) != 0)
+		return M_RCIF_NOT_ATOM ;
+
+	item.s = tok->s + 11 ;
+	item.len = tok->len - 11 ;
+	for(i = 0 ; i < M_RCIF_NFIELD ; i++) {
+		if(rcif_is(&item, ST_rcif_fields[i])) return i ;
+	}
+
+	return M_RCIF_OTHER ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_cell
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Store a value of the unit cell (_cell.length_*, _cell.angle_*).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb            : The structure
+	@ const s_rcif_tok *key : Name of the value
+	@ const s_rcif_tok *val : The value
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void rcif_cell(s_pdb *pdb, const s_rcif_tok *key, const s_rcif_tok *val)
+{
+	if(rcif_is(key, "_cell.length_a")) pdb->A = rcif_float(val) ;
+	else if(rcif_is(key, "_cell.length_b")) pdb->B = rcif_float(val) ;
+	else if(rcif_is(key, "_cell.length_c")) pdb->C = rcif_float(val) ;
+	else if(rcif_is(key, "_cell.angle_alpha")) pdb->alpha = rcif_float(val) ;
+	else if(rcif_is(key, "_cell.angle_beta")) pdb->beta = rcif_float(val) ;
+	else if(rcif_is(key, "_cell.angle_gamma")) pdb->gamma = rcif_float(val) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_get
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Get a value of a row, or the value of another column if the first one is
+	missing or unknown ('.' or '?').
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_rcif_tok *row : The row
+	@ const int *map        : Column of each M_RCIF_* id, -1 if missing
+	@ int f                 : The M_RCIF_* id
+	@ int alt               : Id of the other column, -1 if none
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	const s_rcif_tok *: The value, NULL if missing or unknown
+   -----------------------------------------------------------------------------
+*/
+static const s_rcif_tok* rcif_get(const s_rcif_tok *row, const int *map,
+								  int f, int alt)
+{
+	const s_rcif_tok *tok = NULL ;
+
+	if(map[f] >= 0) {
+		tok = row + map[f] ;
+		if(tok->quoted || tok->len != 1 || (tok->s[0] != '.' && tok->s[0] != '?'))
+			return tok ;
+	}
+
+	return (alt >= 0) ? rcif_get(row, map, alt, -1) : NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_str, rcif_int, rcif_float
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Convert a value (NULL if missing): string of at most max characters,
+	integer or real (as the PDB reader does, 0 if missing).
+   -----------------------------------------------------------------------------
+*/
+static void rcif_str(const s_rcif_tok *tok, char *dest, int max)
+{
+	if(tok) rpdb_col_str(tok->s, tok->len, 0, max, dest) ;
+	else dest[0] = '\0' ;
+}
+
+static int rcif_int(const s_rcif_tok *tok)
+{
+	return tok ? rpdb_col_int(tok->s, tok->len, 0, tok->len) : 0 ;
+}
+
+static float rcif_float(const s_rcif_tok *tok)
+{
+	return tok ? rpdb_col_float(tok->s, tok->len, 0, tok->len) : 0.0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rcif_atom
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Read an atom from a row of the _atom_site loop, if it's kept. Fields are
+	stored as the PDB reader does: record name on 6 characters, residue name
+	right justified on 3 characters followed by a blank, ' ' for a missing
+	alternate location, chain or insertion code.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const s_rcif_tok *row : The row
+	@ const int *map        : Column of each M_RCIF_* id, -1 if missing
+	@ s_rpdb_atoms *ra      : The atoms read
+	@ const char *ligan     : Ligand resname.
+	@ const char *keep_lig  :  Keep the given ligand or not?
+	@ int *model            : The model read, -1 before the first atom
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void rcif_atom(const s_rcif_tok *row, const int *map, s_rpdb_atoms *ra,
+					  const char *ligan, const int keep_lig, int *model)
+{
+	const s_rcif_tok *tok = NULL ;
+	char res_name[8] ;
+	int i, kind, hetatm, m ;
+	s_atm *atom = NULL ;
+
+	/* First model only */
+	tok = rcif_get(row, map, M_RCIF_MODEL, -1) ;
+	if(tok) {
+		m = rcif_int(tok) ;
+		if(*model == -1) *model = m ;
+		else if(m != *model) return ;
+	}
+
+	/* First alternate location only */
+	tok = rcif_get(row, map, M_RCIF_ALT, -1) ;
+	if(tok && (tok->len != 1 || tok->s[0] != 'A')) return ;
+
+	tok = rcif_get(row, map, M_RCIF_AUTH_COMP, M_RCIF_LABEL_COMP) ;
+	if(tok && tok->len < 3) {
+		for(i = 0 ; i < 3 - tok->len ; i++) res_name[i] = ' ' ;
+		rcif_str(tok, res_name + i, 3) ;
+	}
+	else rcif_str(tok, res_name, 7) ;
+	if(strlen(res_name) < 4) strcat(res_name, " ") ;
+
+	hetatm = ((tok = rcif_get(row, map, M_RCIF_GROUP, -1)) && rcif_is(tok, "HETATM")) ;
+	kind = rpdb_atom_kind(hetatm, res_name, ligan, keep_lig) ;
+	if(kind < 0) return ;
+
+	atom = rpdb_new_atom(ra, kind) ;
+	strcpy(atom->type, hetatm ? "HETATM" : "ATOM  ") ;
+	strcpy(atom->res_name, res_name) ;
+	atom->id = rcif_int(rcif_get(row, map, M_RCIF_ID, -1)) ;
+	rcif_str(rcif_get(row, map, M_RCIF_AUTH_ATOM, M_RCIF_LABEL_ATOM), atom->name, 4) ;
+	atom->pdb_aloc = rcif_get(row, map, M_RCIF_ALT, -1) ? 'A' : ' ' ;
+	rcif_str(rcif_get(row, map, M_RCIF_AUTH_ASYM, M_RCIF_LABEL_ASYM), atom->chain, 4) ;
+	if(atom->chain[0] == '\0') strcpy(atom->chain, " ") ;
+	atom->res_id = rcif_int(rcif_get(row, map, M_RCIF_AUTH_SEQ, M_RCIF_LABEL_SEQ)) ;
+	tok = rcif_get(row, map, M_RCIF_INS, -1) ;
+	atom->pdb_insert = (tok && tok->len > 0) ? tok->s[0] : ' ' ;
+
+	atom->x = rcif_float(rcif_get(row, map, M_RCIF_X, -1)) ;
+	atom->y = rcif_float(rcif_get(row, map, M_RCIF_Y, -1)) ;
+	atom->z = rcif_float(rcif_get(row, map, M_RCIF_Z, -1)) ;
+	atom->occupancy = rcif_float(rcif_get(row, map, M_RCIF_OCC, -1)) ;
+	atom->bfactor = rcif_float(rcif_get(row, map, M_RCIF_BFACTOR, -1)) ;
+
+	rcif_str(rcif_get(row, map, M_RCIF_SYMBOL, -1), atom->symbol, 2) ;
+	atom->charge = rcif_int(rcif_get(row, map, M_RCIF_CHARGE, -1)) ;
+
+	rpdb_set_element(atom, &(ra->nguess)) ;
+}
@@ -16,6 +16,12 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     reIndexPockets follows the chained rows of merged pockets
+##	17-11-04	     reIndexPockets and dropSmallNpolarPockets read the table
+##					 of the pockets (s_ptable) when built
+##	17-11-03	     Grid of barycenters in refinePockets, merge in the order
+##					 of the list (-R order) or until no barycenters are close
+##					 (-R fixpoint)
 ##	09-02-09	(v)  Drop tiny pocket routine added
 ##	28-11-08	(v)  Comments UTD 
 ##	01-04-08	(v)  Added template for comments and creation of history
@@ -59,6 +65,27 @@
 
 **/
 
+/* Grid of the barycenters of the pockets (cell size refine_clust_dist) */
+typedef struct s_rgrid
+{
+	float *bary ;		/* Barycenters, 3 per pocket */
+	int *cell,			/* Cell of each pocket */
+		*cstart,		/* First pocket of each cell (ncell + 1) */
+		*cpock ;		/* Pockets sorted by cell */
+
+	int np,
+		nx, ny, nz ;
+	float xmin, ymin, zmin,
+		  cs ;
+
+} s_rgrid ;
+
+static void set_rgrid(s_rgrid *g, float *bary, int np, float dmax) ;
+static int get_rgrid_neighs(s_rgrid *g, int p, float dmax, int *neighs) ;
+static void free_rgrid(s_rgrid *g) ;
+static int cmp_rgrid_pock(const void *a, const void *b) ;
+static int refine_fixpoint(c_lst_pockets *pockets, float dmax) ;
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	refinePockets
@@ -66,6 +93,14 @@
    ## SPECIFICATION:
 	Refine algorithm: will merge two pockets whose barycenters are
 	close together (distance criteria given in params).
+	Close barycenters are searched in a grid, and pockets are merged
+	according to params->refine_mode:
+	 - M_REFINE_ORDER: same result as refinePockets_naive. Each pocket of
+	   the list takes the next ones whose barycenter is close to its own
+	   barycenter (not updated by the merge).
+	 - M_REFINE_FIXPOINT: pockets with close barycenters are merged by
+	   connected components, barycenters are updated, and this is repeated
+	   until no barycenters are close anymore.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ c_lst_pockets *pockets : The list of pockets.
@@ -76,6 +111,284 @@
    -----------------------------------------------------------------------------
 */
 void refinePockets(c_lst_pockets *pockets, s_fparams *params)
+{
+	node_pocket *pcur = NULL,
+				**pn = NULL ;
+	float *bary = NULL ;
+	int i, j, k, np = 0, nneigh,
+		*alive = NULL,
+		*neighs = NULL ;
+	s_rgrid g ;
+
+	if(!pockets) {
+		fprintf(stderr, "! No pocket to refine! (argument NULL: %p).\n", pockets) ;
+		return ;
+	}
+	if(pockets->n_pockets < 2) return ;
+
+	if(params->refine_mode == M_REFINE_FIXPOINT) {
+		while(refine_fixpoint(pockets, params->refine_clust_dist) > 0) ;
+		return ;
+	}
+
+	pn = (node_pocket **) my_malloc(pockets->n_pockets*sizeof(node_pocket *)) ;
+	bary = (float *) my_malloc(3*pockets->n_pockets*sizeof(float)) ;
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		pn[np] = pcur ;
+		for(k = 0 ; k < 3 ; k++) bary[3*np+k] = pcur->pocket->bary[k] ;
+		np++ ;
+	}
+	alive = (int *) my_malloc(np*sizeof(int)) ;
+	neighs = (int *) my_malloc(np*sizeof(int)) ;
+	for(i = 0 ; i < np ; i++) alive[i] = 1 ;
+
+	set_rgrid(&g, bary, np, params->refine_clust_dist) ;
+	for(i = 0 ; i < np ; i++) {
+		if(!alive[i]) continue ;
+		nneigh = get_rgrid_neighs(&g, i, params->refine_clust_dist, neighs) ;
+		qsort(neighs, nneigh, sizeof(int), cmp_rgrid_pock) ;
+		for(k = 0 ; k < nneigh ; k++) {
+			j = neighs[k] ;
+			if(j <= i || !alive[j]) continue ;
+			mergePockets(pn[i], pn[j], pockets) ;
+			alive[j] = 0 ;
+		}
+	}
+	free_rgrid(&g) ;
+
+	my_free(pn) ;
+	my_free(bary) ;
+	my_free(alive) ;
+	my_free(neighs) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	refine_fixpoint
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	One step of refinePockets in M_REFINE_FIXPOINT mode: pockets whose
+	barycenters are closer than dmax are grouped (union-find), each group is
+	merged in its first pocket of the list, and the barycenter of this pocket
+	is updated (mean of the barycenters weighted by the number of vertices).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets : The list of pockets.
+	@ float dmax             : Distance criteria
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of pockets merged
+   -----------------------------------------------------------------------------
+*/
+static int refine_fixpoint(c_lst_pockets *pockets, float dmax)
+{
+	node_pocket *pcur = NULL,
+				**pn = NULL ;
+	s_pocket *pock = NULL ;
+	float *bary = NULL, 
+		  *sum = NULL ;
+	int i, k, a, b, nneigh, nmerged = 0, np = 0,
+		*parent = NULL,
+		*nvert = NULL,
+		*neighs = NULL ;
+	s_rgrid g ;
+
+	if(pockets->n_pockets < 2) return 0 ;
+
+	pn = (node_pocket **) my_malloc(pockets->n_pockets*sizeof(node_pocket *)) ;
+	bary = (float *) my_malloc(3*pockets->n_pockets*sizeof(float)) ;
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		pn[np] = pcur ;
+		for(k = 0 ; k < 3 ; k++) bary[3*np+k] = pcur->pocket->bary[k] ;
+		np++ ;
+	}
+	parent = (int *) my_malloc(np*sizeof(int)) ;
+	nvert = (int *) my_malloc(np*sizeof(int)) ;
+	neighs = (int *) my_malloc(np*sizeof(int)) ;
+	sum = (float *) my_calloc(3*np, sizeof(float)) ;
+
+	/* Disjoint sets, the root of a set being its first pocket */
+	for(i = 0 ; i < np ; i++) parent[i] = i ;
+	set_rgrid(&g, bary, np, dmax) ;
+	for(i = 0 ; i < np ; i++) {
+		nneigh = get_rgrid_neighs(&g, i, dmax, neighs) ;
+		for(k = 0 ; k < nneigh ; k++) {
+			if(neighs[k] <= i) continue ;
+			for(a = i ; parent[a] != a ; a = parent[a] = parent[parent[a]]) ;
+			for(b = neighs[k] ; parent[b] != b ; b = parent[b] = parent[parent[b]]) ;
+			if(a < b) parent[b] = a ;
+			else if(b < a) parent[a] = b ;
+		}
+	}
+	free_rgrid(&g) ;
+
+	/* Number of vertices of the pockets are taken before the merge */
+	for(i = 0 ; i < np ; i++) nvert[i] = pn[i]->pocket->v_lst->n_vertices ;
+	for(i = 0 ; i < np ; i++) {
+		for(a = i ; parent[a] != a ; a = parent[a]) ;
+		for(k = 0 ; k < 3 ; k++) sum[3*a+k] += nvert[i]*bary[3*i+k] ;
+		if(a != i) {
+			mergePockets(pn[a], pn[i], pockets) ;
+			nmerged++ ;
+		}
+	}
+	for(i = 0 ; i < np && nmerged > 0 ; i++) {
+		if(parent[i] != i) continue ;
+		pock = pn[i]->pocket ;
+		for(k = 0 ; k < 3 ; k++) pock->bary[k] = sum[3*i+k] / (float) pock->v_lst->n_vertices ;
+	}
+
+	my_free(pn) ;
+	my_free(bary) ;
+	my_free(parent) ;
+	my_free(nvert) ;
+	my_free(neighs) ;
+	my_free(sum) ;
+
+	return nmerged ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_rgrid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Sort the barycenters of the pockets in a grid of cell size dmax (larger
+	if the box would have too many cells).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_rgrid *g  : The grid to fill
+	@ float *bary : Barycenters of the pockets
+	@ int np      : Number of pockets
+	@ float dmax  : Distance criteria
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void set_rgrid(s_rgrid *g, float *bary, int np, float dmax)
+{
+	float xmax, ymax, zmax ;
+	int i, ncell ;
+
+	g->bary = bary ;
+	g->np = np ;
+	g->xmin = xmax = bary[0] ; g->ymin = ymax = bary[1] ; g->zmin = zmax = bary[2] ;
+	for(i = 1 ; i < np ; i++) {
+		if(bary[3*i] < g->xmin) g->xmin = bary[3*i] ;
+		if(bary[3*i] > xmax) xmax = bary[3*i] ;
+		if(bary[3*i+1] < g->ymin) g->ymin = bary[3*i+1] ;
+		if(bary[3*i+1] > ymax) ymax = bary[3*i+1] ;
+		if(bary[3*i+2] < g->zmin) g->zmin = bary[3*i+2] ;
+		if(bary[3*i+2] > zmax) zmax = bary[3*i+2] ;
+	}
+
+	/* No more than ~8 cells per pocket */
+	g->cs = (dmax > 0.01) ? dmax : 0.01 ;
+	while(((double)(xmax-g->xmin)/g->cs + 1.0) * ((double)(ymax-g->ymin)/g->cs + 1.0)
+		  * ((double)(zmax-g->zmin)/g->cs + 1.0) > 8.0*np + 64.0) g->cs *= 2.0 ;
+
+	g->nx = (int)((xmax-g->xmin)/g->cs) + 1 ;
+	g->ny = (int)((ymax-g->ymin)/g->cs) + 1 ;
+	g->nz = (int)((zmax-g->zmin)/g->cs) + 1 ;
+	ncell = g->nx*g->ny*g->nz ;
+
+	/* Counting sort of the pockets by cell */
+	g->cell = (int *) my_malloc(np*sizeof(int)) ;
+	g->cpock = (int *) my_malloc(np*sizeof(int)) ;
+	g->cstart = (int *) my_calloc(ncell+1, sizeof(int)) ;
+	for(i = 0 ; i < np ; i++) {
+		int cx = (int)((bary[3*i]-g->xmin)/g->cs),
+			cy = (int)((bary[3*i+1]-g->ymin)/g->cs),
+			cz = (int)((bary[3*i+2]-g->zmin)/g->cs) ;
+		if(cx >= g->nx) cx = g->nx-1 ;
+		if(cy >= g->ny) cy = g->ny-1 ;
+		if(cz >= g->nz) cz = g->nz-1 ;
+		g->cell[i] = (cz*g->ny + cy)*g->nx + cx ;
+		g->cstart[g->cell[i]+1]++ ;
+	}
+	for(i = 0 ; i < ncell ; i++) g->cstart[i+1] += g->cstart[i] ;
+	for(i = 0 ; i < np ; i++) g->cpock[g->cstart[g->cell[i]]++] = i ;
+	for(i = ncell ; i > 0 ; i--) g->cstart[i] = g->cstart[i-1] ;
+	g->cstart[0] = 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	get_rgrid_neighs
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Pockets (other than p) whose barycenter is closer than dmax from the
+	barycenter of p, in the 27 cells around it.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_rgrid *g  : The grid
+	@ int p       : The pocket
+	@ float dmax  : Distance criteria
+	@ int *neighs : Output, pockets found (np at most)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of pockets found
+   -----------------------------------------------------------------------------
+*/
+static int get_rgrid_neighs(s_rgrid *g, int p, float dmax, int *neighs)
+{
+	float *b = g->bary + 3*p ;
+	int k, q, x, y, z, cell, n = 0,
+		cx = g->cell[p] % g->nx,
+		cy = (g->cell[p] / g->nx) % g->ny,
+		cz = g->cell[p] / (g->nx*g->ny) ;
+
+	for(z = cz-1 ; z <= cz+1 ; z++) {
+		if(z < 0 || z >= g->nz) continue ;
+		for(y = cy-1 ; y <= cy+1 ; y++) {
+			if(y < 0 || y >= g->ny) continue ;
+			for(x = cx-1 ; x <= cx+1 ; x++) {
+				if(x < 0 || x >= g->nx) continue ;
+				cell = (z*g->ny + y)*g->nx + x ;
+				for(k = g->cstart[cell] ; k < g->cstart[cell+1] ; k++) {
+					q = g->cpock[k] ;
+					if(q != p && dist(b[0], b[1], b[2], g->bary[3*q], g->bary[3*q+1],
+									  g->bary[3*q+2]) < dmax) neighs[n++] = q ;
+				}
+			}
+		}
+	}
+
+	return n ;
+}
+
+static void free_rgrid(s_rgrid *g)
+{
+	my_free(g->cell) ;
+	my_free(g->cstart) ;
+	my_free(g->cpock) ;
+}
+
+static int cmp_rgrid_pock(const void *a, const void *b)
+{
+	return *((int *)a) - *((int *)b) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	refinePockets_naive
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Refine algorithm: will merge two pockets whose barycenters are
+	close together (distance criteria given in params).
+	Reference implementation of refinePockets (M_REFINE_ORDER), comparing
+	every pair of pockets.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ c_lst_pockets *pockets : The list of pockets.
+	@ s_fparams *params      : Parameters
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void refinePockets_naive(c_lst_pockets *pockets, s_fparams *params)
 {
 	node_pocket *nextPocket;
 	node_pocket *curMobilePocket;
@@ -133,16 +446,25 @@ void dropSmallNpolarPockets(c_lst_pockets *pockets, s_fparams *params)
 	node_pocket *npcur = NULL,
 				*nextPocket1 = NULL;
 	s_pocket *pcur = NULL ;
+	int nvert, napol ;
 	
 	if(pockets) {
 		npcur = pockets->first ;
 		while(npcur) {
 			pcur = npcur->pocket ;
 			nextPocket1 = npcur->next ;
-			pasph = (float)((float)pcur->nAlphaApol/(float)pcur->v_lst->n_vertices) ;
+			if(pcur->ptab) {
+				nvert = pcur->ptab->nvert[pcur->prow] ;
+				napol = pcur->ptab->napol[pcur->prow] ;
+			}
+			else {
+				nvert = pcur->v_lst->n_vertices ;
+				napol = pcur->nAlphaApol ;
+			}
+			pasph = (float)((float)napol/(float)nvert) ;
 
 
-			if(pcur->v_lst->n_vertices < (size_t) params->min_pock_nb_asph 
+			if(nvert < params->min_pock_nb_asph 
 				||  pasph <  (params->refine_min_apolar_asphere_prop)){
 			/* If the pocket is too small or has not enough apolar alpha
 			 * spheres, drop it */
@@ -210,9 +532,10 @@ void reIndexPockets(c_lst_pockets *pockets)
 	node_vertice *vcur = NULL ;
 	node_pocket *pcur = NULL ;
 	s_pocket *pock_cur = NULL ;
+	s_ptable *t = NULL ;
 
 	int curPocket = 0,
-		n_vert ;
+		n_vert, k, r ;
 
 	float posSum[3];
 
@@ -228,7 +551,19 @@ void reIndexPockets(c_lst_pockets *pockets)
 			pock_cur->bary[2]=0 ;
 				
 			posSum[0]=0; posSum[1]=0; posSum[2]=0;
-			if(pock_cur->v_lst){
+			if((t = pock_cur->ptab)) {
+				for(r = pock_cur->prow ; r != -1 ; r = t->rnext[r]) {
+					for(k = t->vstart[r] ; k < t->vstart[r+1] ; k++) {
+						posSum[0] += t->vert[k]->x;
+						posSum[1] += t->vert[k]->y;
+						posSum[2] += t->vert[k]->z;
+						n_vert++;
+
+						t->vert[k]->resid = curPocket;	//set new index
+					}
+				}
+			}
+			else if(pock_cur->v_lst){
 				vcur = pock_cur->v_lst->first;
 				
 				while(vcur){
@@ -248,6 +583,11 @@ void reIndexPockets(c_lst_pockets *pockets)
 			pock_cur->bary[0] = posSum[0]/(float)n_vert;
 			pock_cur->bary[1] = posSum[1]/(float)n_vert;
 			pock_cur->bary[2] = posSum[2]/(float)n_vert;
+			if(t) {
+				t->bx[pock_cur->prow] = pock_cur->bary[0] ;
+				t->by[pock_cur->prow] = pock_cur->bary[1] ;
+				t->bz[pock_cur->prow] = pock_cur->bary[2] ;
+			}
 			pcur = pcur->next ;
 		}
 	}
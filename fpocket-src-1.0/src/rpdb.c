@@ -1,5 +1,6 @@
 
 #include "../headers/rpdb.h"
+#include "../headers/rcif.h"
 
 /**
 
@@ -7,7 +8,7 @@
 ##
 ## FILE 					rpdb.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			01-04-08
+## LAST MODIFIED			17-11-12
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -15,6 +16,20 @@
 ##  this reader is specific to fpocket, and essentially deals with ATOMS,
 ##  HETATMS and several other fields.
 ##
+##  The file is mapped in memory and parsed in a single pass by rpdb_open:
+##  fixed columns are converted by hand (rpdb_col_*), the atom list grows
+##  geometrically, the element properties come from the two character table
+##  of pertable.c and the HETATM to keep are found with a perfect hash of
+##  their resname. The previous two pass reader (fgets/atof) is kept as
+##  rpdb_open_naive/rpdb_read_naive for tests and benchmarks.
+##
+##  gzip files (and zstd ones, built with M_USE_ZSTD) are found from their
+##  first bytes and decompressed in memory before being parsed.
+##
+##  mmCIF files (starting with a data_ block) are read by rcif.c, which
+##  fills the atoms with the same helpers (rpdb_new_atom, rpdb_atom_kind,
+##  rpdb_set_element, rpdb_store_atoms).
+##
 ##
 ##  Curently:
 ##		- Hydrogens present in the PDB are kept
@@ -31,6 +46,15 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     Integer and decimal parts read by separate loops
+##					 (rpdb_col_float)
+##	17-11-15	     Whole residue name compared to the ligand (mmCIF names
+##					 can be longer than 3 characters)
+##	17-11-12	     gzip and zstd files decompressed in memory
+##	17-11-11	     mmCIF files read by rcif_parse, atom selection and storage
+##					 shared with it
+##	17-11-10	     Single pass reader of a mapped file, perfect hash of the
+##					 HETATM kept, fixed column parsing done by hand
 ##  17-03-09    (v)  Improved atom type guessing
 ##  10-03-09    (v)  Atom type guessed using resname when element symbol is missing
 ##  11-02-09    (v)  Added list of pointer on all atoms (usefull for sorting)
@@ -105,6 +129,33 @@ static const char *ST_keep_hetatm[] = {
 
 static const int ST_nb_keep_hetatm = 105 ;
 
+/**
+	Perfect hash table of the resnames above: slot M_RPDB_HET_HASH(key) holds
+	the key of the resname with the M_RPDB_HET_USED bit set, 0 if empty.
+	M_RPDB_HET_MULT has been chosen so that the resnames of ST_keep_hetatm
+	don't collide.
+*/
+static uint32_t ST_keep_hetatm_hash[M_RPDB_HET_NSLOT] ;
+static pthread_once_t ST_keep_hetatm_once = PTHREAD_ONCE_INIT ;
+
+/* Powers of 10 used to convert the fixed decimal fields */
+static const double ST_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+	1e14, 1e15
+} ;
+
+static void rpdb_init_hetatm(void) ;
+static char* rpdb_load_file(FILE *f, size_t *len, int *mapped) ;
+static void rpdb_unload_file(char *buf, size_t len, int mapped) ;
+static char* rpdb_gunzip(const char *src, size_t srclen, size_t *len) ;
+#ifdef M_USE_ZSTD
+static char* rpdb_unzstd(const char *src, size_t srclen, size_t *len) ;
+#endif
+static void rpdb_parse(s_pdb *pdb, const char *buf, size_t len,
+					   const char *ligan, const int keep_lig) ;
+static void rpdb_parse_atom(const char *line, int len, s_atm *atom, int *nguess) ;
+static int rpdb_is_short_name(const char *name) ;
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	rpdb_extract_pdb_atom
@@ -497,10 +548,809 @@ void rpdb_extract_cryst1(char *pdb_line, float *alpha, float *beta, float *gamma
 	rpdb_open
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
+	Open a PDB file and read all information on its atoms, in a single pass
+	over the file mapped in memory (rpdb_parse). mmCIF files, found from
+	their content, are read by rcif_parse.
+
+	Hydrogens are conserved.
+	All HETATM are removed, except the given ligand if we have to keep it, and
+	important HETATM listed in the static structure at the top of this file.
+	Only the first alternate location of an atom is read, and the reading
+	stops at the first END record.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *fpath    : The pdb path.
+	@ const char *ligan    : Ligand resname.
+	@ const char *keep_lig :  Keep the given ligand or not?
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	s_pdb: data containing PDB info, NULL if the file can't be read or
+	contains no atoms.
+   -----------------------------------------------------------------------------
+*/
+s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig)
+{
+	s_pdb *pdb = NULL ;
+	FILE *f = NULL ;
+	char *buf = NULL ;
+	size_t len = 0 ;
+	int mapped = 0 ;
+
+	f = fopen_pdb_check_case(fpath, "r") ;
+	if (!f) {
+		fprintf(stderr, "! File %s does not exist\n", fpath) ;
+		return NULL ;
+	}
+	buf = rpdb_load_file(f, &len, &mapped) ;
+	fclose(f) ;
+
+	pdb = (s_pdb *) my_calloc(1, sizeof(s_pdb)) ;
+	if(rcif_is_cif(buf, len)) rcif_parse(pdb, buf, len, ligan, keep_lig) ;
+	else rpdb_parse(pdb, buf, len, ligan, keep_lig) ;
+	rpdb_unload_file(buf, len, mapped) ;
+
+	if (pdb->natoms == 0) {
+		fprintf(stderr, "! File '%s' contains no atoms...\n", fpath) ;
+		my_free(pdb) ;
+
+		return NULL ;
+	}
+
+	return pdb ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_read
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Atoms are all read by rpdb_open: only report the problems found while
+	reading them (elements guessed, ligand missing).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb           : The structure returned by rpdb_open
+	@ const char *ligand   : The ligand resname
+	@ const char *keep_lig :  Keep the given ligand or not?
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void rpdb_read(s_pdb *pdb, const char *ligan, const int keep_lig) 
+{
+	if(pdb->nguess > 0) {
+		fprintf(stderr, ">! Warning: You did not provide a standard PDB file.\nElements were guessed by fpocket, because not provided in the PDB file. \nThere is no guarantee on the results!\n");
+	}
+
+	if(ligan && keep_lig && pdb->natm_lig <= 0) {
+		fprintf(stderr, ">! Warning: ligand '%s' not found in the pdb...\n", ligan) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_is_kept_hetatm
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check if a HETATM of the given residue is kept (ST_keep_hetatm), with a
+	single probe of the perfect hash table of these residues.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *resb : The residue name (3 first characters are used)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if kept, 0 if not
+   -----------------------------------------------------------------------------
+*/
+int rpdb_is_kept_hetatm(const char *resb)
+{
+	uint32_t key = M_RPDB_HET_KEY(resb) ;
+
+	pthread_once(&ST_keep_hetatm_once, rpdb_init_hetatm) ;
+
+	return ST_keep_hetatm_hash[M_RPDB_HET_HASH(key)] == (key | M_RPDB_HET_USED) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_init_hetatm
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Fill the perfect hash table of ST_keep_hetatm. Called once, by
+	pthread_once.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void rpdb_init_hetatm(void)
+{
+	int i ;
+	uint32_t key, *slot ;
+
+	for(i = 0 ; i < ST_nb_keep_hetatm ; i++) {
+		key = M_RPDB_HET_KEY(ST_keep_hetatm[i]) ;
+		slot = ST_keep_hetatm_hash + M_RPDB_HET_HASH(key) ;
+
+		if(*slot != 0 && *slot != (key | M_RPDB_HET_USED)) {
+			fprintf(stderr, "! Collision of HETATM %s in rpdb_init_hetatm\n",
+					ST_keep_hetatm[i]) ;
+		}
+		*slot = key | M_RPDB_HET_USED ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_load_file
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Get the content of an opened file in memory: the file is mapped when it's
+	a regular file, else (pipe...) read in a buffer grown geometrically.
+	gzip (and zstd, when built with M_USE_ZSTD) files are decompressed in
+	memory, so the parsers read them in a single pass as other files.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ FILE *f      : The file
+	@ size_t *len  : OUTPUT The size of the content
+	@ int *mapped  : OUTPUT 1 if mapped, 0 if read in a buffer
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	char *: The content (not null terminated), to give to rpdb_unload_file.
+	NULL (and a size of 0) if a compressed file can't be read.
+   -----------------------------------------------------------------------------
+*/
+static char* rpdb_load_file(FILE *f, size_t *len, int *mapped)
+{
+	struct stat st ;
+	char *buf = NULL,
+		 *out = NULL ;
+	size_t n, nmax ;
+
+	*len = 0 ;
+	*mapped = 0 ;
+
+	if(fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		buf = (char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+							fileno(f), 0) ;
+		if(buf != MAP_FAILED) {
+			madvise(buf, st.st_size, MADV_SEQUENTIAL) ;
+			*len = st.st_size ;
+			*mapped = 1 ;
+		}
+		else buf = NULL ;
+	}
+
+	if(!buf) {
+		nmax = M_RPDB_READ_CHUNK ;
+		buf = (char *) my_malloc(nmax) ;
+		while((n = fread(buf + *len, 1, nmax - *len, f)) > 0) {
+			*len += n ;
+			if(*len == nmax) {
+				nmax *= 2 ;
+				buf = (char *) my_realloc(buf, nmax) ;
+			}
+		}
+	}
+
+	/* Compressed file: decompressed in memory, the compressed one released */
+	if(*len >= 4 && (M_RPDB_GZIP(buf) || M_RPDB_ZSTD(buf))) {
+		if(M_RPDB_GZIP(buf)) out = rpdb_gunzip(buf, *len, &n) ;
+#ifdef M_USE_ZSTD
+		else out = rpdb_unzstd(buf, *len, &n) ;
+#else
+		else {
+			fprintf(stderr, "! zstd compressed file: fpocket built without zstd (M_USE_ZSTD)\n") ;
+			n = 0 ;
+		}
+#endif
+		rpdb_unload_file(buf, *len, *mapped) ;
+		*len = n ;
+		*mapped = 0 ;
+
+		return out ;
+	}
+
+	return buf ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_gunzip
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Decompress a gzip file in memory, with all its members (as gzip -d). The
+	size of the output is taken from the end of the file (size of the last
+	member, modulo 2^32, plus one byte to see the end of the stream) when
+	it's large enough, and grows geometrically if needed.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *src : The compressed content
+	@ size_t srclen   : Its size
+	@ size_t *len     : OUTPUT The size of the decompressed content
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	char *: The decompressed content (not null terminated), NULL if the file
+	is corrupted or truncated
+   -----------------------------------------------------------------------------
+*/
+static char* rpdb_gunzip(const char *src, size_t srclen, size_t *len)
+{
+	const unsigned char *end = (const unsigned char *) src + srclen ;
+	char *out = NULL ;
+	size_t n = 0,
+		   nmax = (size_t) end[-4] | ((size_t) end[-3] << 8)
+				  | ((size_t) end[-2] << 16) | ((size_t) end[-1] << 24),
+		   in = 0 ;
+	int status = Z_OK ;
+	z_stream zs ;
+
+	nmax = (nmax < 2*srclen) ? 4*srclen : nmax + 1 ;
+	out = (char *) my_malloc(nmax) ;
+
+	memset(&zs, 0, sizeof(z_stream)) ;
+	if(inflateInit2(&zs, 15 + 16) != Z_OK) {
+		fprintf(stderr, "! Cannot initialize zlib\n") ;
+		my_free(out) ;
+		*len = 0 ;
+		return NULL ;
+	}
+
+	while(1) {
+		if(n == nmax) {
+			nmax *= 2 ;
+			out = (char *) my_realloc(out, nmax) ;
+		}
+		zs.next_in = (Bytef *) src + in ;
+		zs.avail_in = (srclen - in > UINT_MAX) ? UINT_MAX : (uInt) (srclen - in) ;
+		zs.next_out = (Bytef *) out + n ;
+		zs.avail_out = (nmax - n > UINT_MAX) ? UINT_MAX : (uInt) (nmax - n) ;
+
+		status = inflate(&zs, Z_NO_FLUSH) ;
+		in = (const char *) zs.next_in - src ;
+		n = (char *) zs.next_out - out ;
+
+		if(status == Z_STREAM_END) {
+			/* Next member if any, trailing zeros are ignored */
+			while(in < srclen && src[in] == 0) in++ ;
+			if(in == srclen) break ;
+			inflateReset(&zs) ;
+		}
+		else if(status != Z_OK && !(status == Z_BUF_ERROR && n == nmax)) break ;
+	}
+	inflateEnd(&zs) ;
+
+	if(status != Z_STREAM_END) {
+		fprintf(stderr, "! Corrupted or truncated gzip file (%s)\n",
+				zs.msg ? zs.msg : "unexpected end of file") ;
+		my_free(out) ;
+		*len = 0 ;
+		return NULL ;
+	}
+	*len = n ;
+
+	return out ;
+}
+
+#ifdef M_USE_ZSTD
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_unzstd
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Decompress a zstd file in memory, with all its frames. The size of the
+	output is taken from the header of the first frame when it's given, and
+	grows geometrically if needed.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *src : The compressed content
+	@ size_t srclen   : Its size
+	@ size_t *len     : OUTPUT The size of the decompressed content
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	char *: The decompressed content (not null terminated), NULL if the file
+	is corrupted or truncated
+   -----------------------------------------------------------------------------
+*/
+static char* rpdb_unzstd(const char *src, size_t srclen, size_t *len)
+{
+	unsigned long long size = ZSTD_getFrameContentSize(src, srclen) ;
+	size_t nmax = (size < ZSTD_CONTENTSIZE_ERROR && size >= 2*srclen) ?
+				  (size_t) size + 1 : 4*srclen,
+		   status = 1 ;
+	char *out = (char *) my_malloc(nmax) ;
+	ZSTD_DStream *zs = ZSTD_createDStream() ;
+	ZSTD_inBuffer in = { src, srclen, 0 } ;
+	ZSTD_outBuffer o = { out, nmax, 0 } ;
+
+	ZSTD_initDStream(zs) ;
+	while(1) {
+		if(o.pos == o.size) {
+			nmax *= 2 ;
+			out = (char *) my_realloc(out, nmax) ;
+			o.dst = out ;
+			o.size = nmax ;
+		}
+		status = ZSTD_decompressStream(zs, &o, &in) ;
+		if(ZSTD_isError(status)) break ;
+		/* All input read and no more output to flush */
+		if(in.pos == in.size && o.pos < o.size) break ;
+	}
+	ZSTD_freeDStream(zs) ;
+
+	if(status != 0) {
+		fprintf(stderr, "! Corrupted or truncated zstd file (%s)\n",
+				ZSTD_isError(status) ? ZSTD_getErrorName(status)
+									 : "unexpected end of file") ;
+		my_free(out) ;
+		*len = 0 ;
+		return NULL ;
+	}
+	*len = o.pos ;
+
+	return out ;
+}
+#endif
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_unload_file
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Release the content returned by rpdb_load_file.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ char *buf   : The content
+	@ size_t len  : Its size
+	@ int mapped  : 1 if mapped, 0 if read in a buffer
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void rpdb_unload_file(char *buf, size_t len, int mapped)
+{
+	if(mapped) munmap(buf, len) ;
+	else if(buf) my_free(buf) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_parse
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Read the atoms of a PDB file in memory, in a single pass. Records are
+	selected as in rpdb_open_naive/rpdb_read_naive.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb           : The structure to fill (set to 0 by the caller)
+	@ const char *buf      : The content of the file
+	@ size_t len           : Its size
+	@ const char *ligan    : Ligand resname.
+	@ const char *keep_lig :  Keep the given ligand or not?
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void (pdb->natoms is 0 and nothing is allocated if there is no atoms)
+   -----------------------------------------------------------------------------
+*/
+static void rpdb_parse(s_pdb *pdb, const char *buf, size_t len,
+					   const char *ligan, const int keep_lig)
+{
+	const char *line = buf,
+			   *eof = buf + len,
+			   *eol = NULL ;
+	char resb[4] ;
+	int i, l, kind ;
+	s_rpdb_atoms ra ;
+
+	rpdb_init_atoms(&ra, len/(2*M_PDB_LINE_LEN) + 64) ;
+
+	for( ; line < eof ; line = eol + 1) {
+		eol = (const char *) memchr(line, '\n', eof - line) ;
+		if(!eol) eol = eof ;
+		l = eol - line ;
+		if(l > 0 && line[l-1] == '\r') l-- ;
+
+		if(l >= 6 && memcmp(line, "CRYST1", 6) == 0) {
+			pdb->A = rpdb_col_float(line, l, 6, 15) ;
+			pdb->B = rpdb_col_float(line, l, 15, 24) ;
+			pdb->C = rpdb_col_float(line, l, 24, 33) ;
+			pdb->alpha = rpdb_col_float(line, l, 33, 40) ;
+			pdb->beta = rpdb_col_float(line, l, 40, 47) ;
+			pdb->gamma = rpdb_col_float(line, l, 47, 54) ;
+			continue ;
+		}
+		if(l >= 3 && memcmp(line, "END", 3) == 0) break ;
+
+		/* First occurence of an ATOM or HETATM only */
+		if(l <= 16 || (line[16] != ' ' && line[16] != 'A')) continue ;
+
+		for(i = 0 ; i < 3 ; i++) resb[i] = (17 + i < l) ? line[17 + i] : ' ' ;
+		resb[3] = '\0' ;
+
+		if(l >= 5 && memcmp(line, "ATOM ", 5) == 0) {
+			kind = rpdb_atom_kind(0, resb, ligan, keep_lig) ;
+		}
+		else if(l >= 6 && memcmp(line, "HETATM", 6) == 0) {
+			kind = rpdb_atom_kind(1, resb, ligan, keep_lig) ;
+		}
+		else continue ;
+
+		if(kind >= 0) rpdb_parse_atom(line, l, rpdb_new_atom(&ra, kind), &(ra.nguess)) ;
+	}
+
+	rpdb_store_atoms(pdb, &ra) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_parse_atom
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Same as rpdb_extract_pdb_atom, for a line that is not null terminated
+	(and without its end of line), and with the element properties stored.
+	Columns beyond the end of the line are blank.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *line : The PDB line
+	@ int len          : Its length
+	@ s_atm *atom      : The atom to fill
+	@ int *nguess      : Incremented if the element is guessed
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void rpdb_parse_atom(const char *line, int len, s_atm *atom, int *nguess)
+{
+	rpdb_col_str(line, len, 0, 6, atom->type) ;
+	atom->id = rpdb_col_int(line, len, 6, 11) ;
+
+	rpdb_col_str(line, len, 12, 16, atom->name) ;
+	str_trim(atom->name) ;
+
+	atom->pdb_aloc = line[16] ;
+	rpdb_col_str(line, len, 17, 21, atom->res_name) ;
+	atom->chain[0] = (len > 21) ? line[21] : ' ' ;
+	atom->chain[1] = '\0' ;
+	atom->res_id = rpdb_col_int(line, len, 22, 26) ;
+	atom->pdb_insert = (len > 26) ? line[26] : ' ' ;
+
+	atom->x = rpdb_col_float(line, len, 30, 38) ;
+	atom->y = rpdb_col_float(line, len, 38, 46) ;
+	atom->z = rpdb_col_float(line, len, 46, 54) ;
+	atom->occupancy = rpdb_col_float(line, len, 54, 60) ;
+	atom->bfactor = rpdb_col_float(line, len, 60, 66) ;
+
+	rpdb_col_str(line, len, 76, 78, atom->symbol) ;
+	atom->charge = rpdb_col_int(line, len, 78, 80) ;
+
+	rpdb_set_element(atom, nguess) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_init_atoms
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Initialize the list of atoms read by a parser (rpdb_parse, rcif_parse).
+	The list grows geometrically from the given size (rpdb_new_atom), and is
+	stored in a s_pdb at the end (rpdb_store_atoms).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_rpdb_atoms *ra : The list
+	@ int nmax         : Initial size, a guess of the number of atoms
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void rpdb_init_atoms(s_rpdb_atoms *ra, int nmax)
+{
+	ra->nmax = (nmax > 0) ? nmax : 1 ;
+	ra->n = ra->nhet = ra->nlig = ra->nguess = 0 ;
+	ra->atoms = (s_atm *) my_calloc(ra->nmax, sizeof(s_atm)) ;
+	ra->kind = (char *) my_malloc(ra->nmax*sizeof(char)) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_new_atom
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Add an atom (set to 0) to the list of atoms read, doubling its size when
+	it's full. The pointer is valid until the next call.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_rpdb_atoms *ra : The list
+	@ int kind         : M_RPDB_ATM, M_RPDB_HET or M_RPDB_LIG
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_atm *: The atom to fill
+   -----------------------------------------------------------------------------
+*/
+s_atm* rpdb_new_atom(s_rpdb_atoms *ra, int kind)
+{
+	if(ra->n == ra->nmax) {
+		ra->nmax *= 2 ;
+		ra->atoms = (s_atm *) my_realloc(ra->atoms, ra->nmax*sizeof(s_atm)) ;
+		ra->kind = (char *) my_realloc(ra->kind, ra->nmax*sizeof(char)) ;
+		memset(ra->atoms + ra->n, 0, (ra->nmax - ra->n)*sizeof(s_atm)) ;
+	}
+
+	if(kind == M_RPDB_LIG) ra->nlig++ ;
+	else if(kind == M_RPDB_HET) ra->nhet++ ;
+	ra->kind[ra->n] = (char) kind ;
+
+	return ra->atoms + (ra->n++) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_atom_kind
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Select an ATOM or HETATM record: ATOM are kept except the ligand if we
+	don't keep it, HETATM are removed except the ligand if we keep it and the
+	residues listed in ST_keep_hetatm.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int hetatm           : 1 for a HETATM, 0 for an ATOM
+	@ const char *resb     : Residue name, as columns 18-20 of a PDB record
+	@ const char *ligan    : Ligand resname.
+	@ const char *keep_lig :  Keep the given ligand or not?
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_RPDB_ATM, M_RPDB_HET or M_RPDB_LIG, -1 if the atom is removed
+   -----------------------------------------------------------------------------
+*/
+int rpdb_atom_kind(int hetatm, const char *resb, const char *ligan, const int keep_lig)
+{
+	int shortname = rpdb_is_short_name(resb),
+		lig = (ligan && ligan[0] == resb[0] && ligan[1] == resb[1]
+			   && ligan[2] == resb[2] && shortname && rpdb_is_short_name(ligan)) ;
+
+	if(!hetatm) {
+		if(lig) return keep_lig ? M_RPDB_LIG : -1 ;
+		return M_RPDB_ATM ;
+	}
+	if(lig && keep_lig) return M_RPDB_LIG ;
+	if(shortname && rpdb_is_kept_hetatm(resb)) return M_RPDB_HET ;
+
+	return -1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_is_short_name
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Check that a residue name has nothing but blanks after its 3 first
+	characters, so that comparing these 3 characters compares the names.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *name : The residue name
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the name has at most 3 characters, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int rpdb_is_short_name(const char *name)
+{
+	int i ;
+
+	for(i = 0 ; i < 3 ; i++) if(name[i] == '\0') return 1 ;
+	for(name += 3 ; *name == ' ' ; name++) ;
+
+	return *name == '\0' ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_set_element
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Finish an atom read: guess its element from its name if the symbol read is
+	blank, and store the properties of the element.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm *atom : The atom, with its name and symbol read
+	@ int *nguess : Incremented if the element is guessed
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void rpdb_set_element(s_atm *atom, int *nguess)
+{
+	str_trim(atom->symbol) ;
+	if(atom->symbol[0] == '\0') {
+		guess_element(atom->name, atom->symbol) ;
+		str_trim(atom->symbol) ;
+		*nguess += 1 ;
+	}
+
+	pte_get_properties(atom->symbol, &(atom->mass), &(atom->radius),
+					   &(atom->electroneg)) ;
+	atom->sort_x = -1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_store_atoms
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Store the atoms read in a s_pdb, with the lists of pointers to all atoms,
+	HETATM and ligand atoms. The list of atoms read is released.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb       : The structure to fill
+	@ s_rpdb_atoms *ra : The atoms read
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void (pdb->natoms is 0 and nothing is allocated if there is no atoms)
+   -----------------------------------------------------------------------------
+*/
+void rpdb_store_atoms(s_pdb *pdb, s_rpdb_atoms *ra)
+{
+	int i, n = ra->n, nhet = 0, nlig = 0 ;
+
+	pdb->nguess = ra->nguess ;
+	if(n == 0) {
+		my_free(ra->atoms) ;
+		my_free(ra->kind) ;
+		pdb->natoms = pdb->nhetatm = pdb->natm_lig = 0 ;
+		return ;
+	}
+
+	pdb->latoms = (s_atm *) my_realloc(ra->atoms, n*sizeof(s_atm)) ;
+	pdb->latoms_p = (s_atm **) my_calloc(n, sizeof(s_atm*)) ;
+	pdb->lhetatm = (ra->nhet > 0) ? (s_atm **) my_calloc(ra->nhet, sizeof(s_atm*)) : NULL ;
+	pdb->latm_lig = (ra->nlig > 0) ? (s_atm **) my_calloc(ra->nlig, sizeof(s_atm*)) : NULL ;
+	pdb->natoms = n ;
+	pdb->nhetatm = ra->nhet ;
+	pdb->natm_lig = ra->nlig ;
+
+	for(i = 0 ; i < n ; i++) {
+		pdb->latoms_p[i] = pdb->latoms + i ;
+		if(ra->kind[i] == M_RPDB_LIG) pdb->latm_lig[nlig++] = pdb->latoms + i ;
+		else if(ra->kind[i] == M_RPDB_HET) pdb->lhetatm[nhet++] = pdb->latoms + i ;
+	}
+	my_free(ra->kind) ;
+	ra->atoms = NULL ;
+	ra->kind = NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_col_str
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Copy the columns [beg, end[ of a line (as strncpy: stops at the end of
+	the line) and terminate the string.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *line : The line
+	@ int len          : Its length
+	@ int beg, end     : The columns (from 0)
+	@ char *dest       : OUTPUT The string, of at least end - beg + 1 chars
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void rpdb_col_str(const char *line, int len, int beg, int end, char *dest)
+{
+	int i ;
+
+	if(end > len) end = len ;
+	for(i = beg ; i < end ; i++) *(dest++) = line[i] ;
+	*dest = '\0' ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_col_int
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Integer value of the columns [beg, end[ of a line, as atoi would give it
+	on these columns alone.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *line : The line
+	@ int len          : Its length
+	@ int beg, end     : The columns (from 0)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: The value
+   -----------------------------------------------------------------------------
+*/
+int rpdb_col_int(const char *line, int len, int beg, int end)
+{
+	int i = beg,
+		neg = 0,
+		v = 0 ;
+
+	if(end > len) end = len ;
+	while(i < end && isspace((unsigned char) line[i])) i++ ;
+	if(i < end && (line[i] == '-' || line[i] == '+')) neg = (line[i++] == '-') ;
+	for( ; i < end && line[i] >= '0' && line[i] <= '9' ; i++) {
+		v = 10*v + (line[i] - '0') ;
+	}
+
+	return neg ? -v : v ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_col_float
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Real value of the columns [beg, end[ of a line, as atof would give it on
+	these columns alone.
+	A plain decimal number ([spaces][sign]digits[.digits], followed by spaces
+	or the end of the field) is converted by hand: its digits are read as an
+	integer and divided by a power of 10. The integer and the power of 10 are
+	both exact in double precision, so the division is the correctly rounded
+	value, ie the one of atof. Anything else is given to atof.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *line : The line
+	@ int len          : Its length
+	@ int beg, end     : The columns (from 0)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The value
+   -----------------------------------------------------------------------------
+*/
+float rpdb_col_float(const char *line, int len, int beg, int end)
+{
+	char tmp[M_PDB_BUF_LEN] ;
+	int i = beg,
+		neg = 0,
+		ndig = 0,
+		nfrac = 0 ;
+	long long m = 0 ;
+	double v ;
+
+	if(end > len) end = len ;
+	while(i < end && line[i] == ' ') i++ ;
+	if(i < end && (line[i] == '-' || line[i] == '+')) neg = (line[i++] == '-') ;
+	for( ; i < end && line[i] >= '0' && line[i] <= '9' ; i++, ndig++) {
+		m = 10*m + (line[i] - '0') ;
+	}
+	if(i < end && line[i] == '.') {
+		for(i++ ; i < end && line[i] >= '0' && line[i] <= '9' ; i++, nfrac++) {
+			m = 10*m + (line[i] - '0') ;
+		}
+		ndig += nfrac ;
+	}
+
+	if(ndig > 0 && ndig < 16 && (i == end || line[i] == ' ')) {
+		v = (double) m / ST_pow10[nfrac] ;
+
+		return (float) (neg ? -v : v) ;
+	}
+
+	i = (end > beg) ? end - beg : 0 ;
+	if(i >= M_PDB_BUF_LEN) i = M_PDB_BUF_LEN - 1 ;
+	memcpy(tmp, line + beg, i) ;
+	tmp[i] = '\0' ;
+
+	return (float) atof(tmp) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	rpdb_open_naive
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Original reader, kept for tests and benchmarks (see rpdb_open).
 	Open a PDB file, alloc memory for all information on this pdb, and store 
 	several information like the number of atoms, the header, the remark... 
 	This first reading of PDB rewinds the FILE* pointer. No coordinates are
-	actually read.
+	actually read: rpdb_read_naive reads the file a second time.
 
 	Hydrogens are conserved.
 	All HETATM are removed, except the given ligand if we have to keep it, and
@@ -515,7 +1365,7 @@ void rpdb_extract_cryst1(char *pdb_line, float *alpha, float *beta, float *gamma
 	s_pdb: data containing PDB info.
    -----------------------------------------------------------------------------
 */
-s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig)
+s_pdb* rpdb_open_naive(char *fpath, const char *ligan, const int keep_lig)
 {
 	s_pdb *pdb = NULL ;
 
@@ -605,6 +1455,7 @@ s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig)
 	pdb->natoms = natoms ;
 	pdb->nhetatm = nhetatm ;
 	pdb->natm_lig = natm_lig ;
+	pdb->nguess = 0 ;
 	rewind(pdb->fpdb) ;
 
 	return pdb ;
@@ -612,10 +1463,12 @@ s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig)
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	rpdb_read
+	rpdb_read_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
-	Read and store information on atoms for a pdb file.
+	Original reader, kept for tests and benchmarks (see rpdb_open).
+	Read and store information on atoms for a pdb file opened by
+	rpdb_open_naive.
     Curently:
 		- Hydrogens present in the PDB are kept
 		- HETATM are ignored except for specific cofactor, small molecule... 
@@ -631,7 +1484,7 @@ s_pdb* rpdb_open(char *fpath, const char *ligan, const int keep_lig)
    ## RETURN:
    -----------------------------------------------------------------------------
 */
-void rpdb_read(s_pdb *pdb, const char *ligan, const int keep_lig) 
+void rpdb_read_naive(s_pdb *pdb, const char *ligan, const int keep_lig) 
 {
 	int i,
 		iatoms,
@@ -784,8 +1637,8 @@ void rpdb_read(s_pdb *pdb, const char *ligan, const int keep_lig)
 	}
 	else if((ligfound == 1 && pdb->natm_lig <= 0) || (pdb->natm_lig <=0 
 			 && iatm_lig > 0)) {
-		fprintf(stderr, ">! Warning: ligand '%s' has been detected in rpdb_read \
-						but not in rpdb_open!\n", ligan) ;
+		fprintf(stderr, ">! Warning: ligand '%s' has been detected in rpdb_read_naive \
+						but not in rpdb_open_naive!\n", ligan) ;
 	}
 
 }
@@ -16,6 +16,9 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-09	     Neighbours searched in a spatial index (see neighbor.c)
+##	17-11-07	     Overlap volumes: exact engine (see volume.c)
+##	17-11-06	     Overlap volumes: grid engine (see volume.c)
 ##	10-03-09	(v)  Mean number of atom per pocket + ligand volume added
 ##	05-03-09	(v)  Mean pocket volume added to tpocket output
 ##	19-01-09	(v)  Minor modif (status output printed on the same line)
@@ -63,6 +66,9 @@
 
 **/
 
+static float set_spheres_overlap_volume(s_atm **lig, int natoms, s_pocket *pocket,
+									 int niter, int idiscret) ;
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	test_fpocket
@@ -517,7 +523,7 @@ int test_set(s_tparams *par, int i, float ddata [][M_NDDATA], int idata [][M_NID
 				  accpck, naccpck, ddata, idata, i) ;
 
 	if(par->keep_fpout != 0) {
-		write_out_fpocket(pockets, apdb, par->fapo[i]) ;
+		write_out_fpocket(pockets, apdb, par->fapo[i], par->fpar->out_layout, par->fpar->out_bin) ;
 	}
 	/* write_pdb_com(cpdb, par->fcomplex[i]) ; */
 	
@@ -556,17 +562,18 @@ int test_set(s_tparams *par, int i, float ddata [][M_NDDATA], int idata [][M_NID
 s_atm** get_actual_pocket(s_pdb *cpdb, s_pdb *cpdb_nolig, int i, s_tparams *par, int *nb_atm) 
 {
 	s_atm **neigh = NULL ;
+	s_nindex *vind = NULL ;
 
 	c_lst_pockets *pockets = search_pocket(cpdb_nolig, par->fpar);
 	if(pockets && pockets->n_pockets > 0) {
 		/* */
 		/* Get the list of atoms contacted by the vertices near the ligand. */
-		
-		neigh = get_mol_ctd_atm_neigh(cpdb->latm_lig, cpdb->natm_lig,
-									  pockets->vertices->pvertices,
-									  pockets->vertices->nvert, M_CRIT1_D,
-									  M_INTERFACE_SEARCH, nb_atm) ;
+		vind = alloc_nindex(NULL, 0, pockets->vertices->pvertices,
+							pockets->vertices->nvert, M_CRIT1_D) ;
+		neigh = get_mol_ctd_atm_neigh(cpdb->latm_lig, cpdb->natm_lig, vind,
+									  M_CRIT1_D, M_INTERFACE_SEARCH, nb_atm) ;
 
+		free_nindex(vind) ;
 		c_lst_pocket_free(pockets) ;
 	}
 	else {
@@ -601,19 +608,18 @@ s_atm** get_actual_pocket(s_pdb *cpdb, s_pdb *cpdb_nolig, int i, s_tparams *par,
 s_atm** get_actual_pocket_DEPRECATED(s_pdb *cpdb, float lig_dist_crit, int *nb_atm) 
 {
 	/* Getting the ligan's neighbors. */
-	s_atm **alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig,
-										cpdb->latoms_p, cpdb->natoms,
+	s_nindex *aind = alloc_nindex(cpdb->latoms_p, cpdb->natoms, NULL, 0,
+								  lig_dist_crit) ;
+	s_atm **alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig, aind,
 										lig_dist_crit, nb_atm) ;
 	if(*nb_atm <= 0) {
 		if(alneigh) my_free(alneigh) ;
-		alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig,
-									cpdb->latoms_p, cpdb->natoms,
+		alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig, aind,
 									lig_dist_crit+1.0, nb_atm) ;
 
 		if(*nb_atm <= 0) {
 			if(alneigh) my_free(alneigh) ;
-			alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig,
-										cpdb->latoms_p, cpdb->natoms,
+			alneigh = get_mol_atm_neigh(cpdb->latm_lig, cpdb->natm_lig, aind,
 										lig_dist_crit+2.0, nb_atm) ;
 			if(*nb_atm <= 0) {
 				if(alneigh) my_free(alneigh) ;
@@ -621,6 +627,7 @@ s_atm** get_actual_pocket_DEPRECATED(s_pdb *cpdb, float lig_dist_crit, int *nb_a
 			}
 		}
 	}
+	free_nindex(aind) ;
 	
 	return alneigh ;
 }
@@ -672,6 +679,9 @@ void check_pockets(c_lst_pockets *pockets, s_atm **accpck, int naccpck, s_atm **
 	
 	node_pocket *ncur = NULL ;
 	s_pocket *pcur = NULL ;
+
+	/* Index of the ligand atoms, for the vertice overlaps */
+	s_nindex *lind = alloc_nindex(lig, nalig, NULL, 0, M_CRIT4_D) ;
 	
 	/* Check the correspondance for each pocket found */
 	ncur = pockets->first ;
@@ -735,8 +745,7 @@ void check_pockets(c_lst_pockets *pockets, s_atm **accpck, int naccpck, s_atm **
 			if(!found[3]){
 				/* Calculate proportion of ligand atom that lies within 3A
 				   of at least one vertice */
-				ov3 = count_atm_prop_vert_neigh( lig, nalig,
-											 pvert, pcur->size, M_CRIT4_D) ;
+				ov3 = count_atm_prop_vert_neigh(lind, pvert, pcur->size, M_CRIT4_D) ;
 				if(ov3 > M_CRIT4_VAL) {
 					idata[i][M_POS4] = pos ;
 					ddata[i][M_CRIT4] = ov3 ;
@@ -748,8 +757,7 @@ void check_pockets(c_lst_pockets *pockets, s_atm **accpck, int naccpck, s_atm **
 			if(!found[4]){
 				/* Calculate proportion of pocket vertice that lies within 3A
 				   of at least one ligand atom */
-				ov4 = count_pocket_lig_vert_ovlp(lig, nalig,
-												 pvert, pcur->size, M_CRIT5_D) ;
+				ov4 = count_pocket_lig_vert_ovlp(lind, pvert, pcur->size, M_CRIT5_D) ;
 				if(ov4 > M_CRIT5_VAL) {
 					idata[i][M_POS5] = pos ;
 					ddata[i][M_CRIT5] = ov4 ;
@@ -759,10 +767,8 @@ void check_pockets(c_lst_pockets *pockets, s_atm **accpck, int naccpck, s_atm **
 			}
 
 			if(!found[5]){
-				ov3 = count_atm_prop_vert_neigh( lig, nalig,
-											 pvert, pcur->size, M_CRIT4_D) ;
-				ov4 = count_pocket_lig_vert_ovlp(lig, nalig,
-												 pvert, pcur->size, M_CRIT5_D) ;
+				ov3 = count_atm_prop_vert_neigh(lind, pvert, pcur->size, M_CRIT4_D) ;
+				ov4 = count_pocket_lig_vert_ovlp(lind, pvert, pcur->size, M_CRIT5_D) ;
 				if(ov4 > M_CRIT5_VAL && ov3 > M_CRIT4_VAL) {
 					idata[i][M_POS6] = pos ;
 					ddata[i][M_CRIT6] = 1.0 ;
@@ -781,6 +787,7 @@ void check_pockets(c_lst_pockets *pockets, s_atm **accpck, int naccpck, s_atm **
 		if(found[0] && found[1] && found[2] && found[3] && found[4] && found[5]) break ;
 		
 	}
+	free_nindex(lind) ;
 
 	if (! found[0]) {
 		ddata[i][M_MINDST] = 0.0 ;
@@ -910,6 +917,10 @@ float set_overlap_volumes(s_pocket *pocket, s_atm **lig, int natoms, float lig_v
 float set_mc_overlap_volume(s_atm **lig, int natoms, float lig_vol, 
 							s_pocket *pocket, int niter)
 {
+	if(get_volume_engine() != M_VOLUME_MC) {
+		return set_spheres_overlap_volume(lig, natoms, pocket, niter, 0) ;
+	}
+
 	c_lst_vertices *vertices = pocket->v_lst ;
 	s_vvertice *vcur = NULL ;
 
@@ -1033,6 +1044,10 @@ float set_mc_overlap_volume(s_atm **lig, int natoms, float lig_vol,
 float set_basic_overlap_volume(s_atm **lig, int natoms, float lig_vol,
 							   s_pocket *pocket, int idiscret)
 {
+	if(get_volume_engine() != M_VOLUME_MC) {
+		return set_spheres_overlap_volume(lig, natoms, pocket, 0, idiscret) ;
+	}
+
 	c_lst_vertices *vertices = pocket->v_lst ;
 	s_vvertice *vcur = NULL ;
 
@@ -1144,3 +1159,72 @@ float set_basic_overlap_volume(s_atm **lig, int natoms, float lig_vol,
 	/* Ok lets just return the volume Vpok = Nb_in/Niter*Vbox */
 	return pocket->vol_corresp ;
 }
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_spheres_overlap_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Overlap volume between a pocket and the ligand on a grid (see alloc_vgrid
+	for the precision): the alpha spheres of the pocket and the atoms of the
+	ligand are two objects of the same grid, and the proportion of the
+	ligand overlapped by the pocket is given by their intersection.
+	With the exact engine, the intersection is the sum of the volumes of
+	the pocket and of the ligand minus the volume of their union.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_atm **lig       : The ligand atoms.
+	@ int natoms        : Number of atoms of the ligand.
+	@ s_pocket *pocket  : The pocket
+	@ int niter         : Number of monte-carlo iterations
+	@ int idiscret      : Division of the box, or 0
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The proportion of the ligand volume overlapped
+   -----------------------------------------------------------------------------
+*/
+static float set_spheres_overlap_volume(s_atm **lig, int natoms, s_pocket *pocket,
+									 int niter, int idiscret)
+{
+	int i, nvert, tofree ;
+	float bmin[3], bmax[3], vol[M_VGRID_NOBJ], overlap = 0.0 ;
+	s_vvertice **verts = get_pocket_vert_array(pocket, &nvert, &tofree) ;
+
+	/* Spheres of the pocket followed by the atoms of the ligand */
+	float *pxyzr = (float *) my_malloc((nvert + natoms > 0 ? 4*(nvert + natoms) : 1)*sizeof(float)),
+		  *lxyzr = pxyzr + 4*nvert ;
+
+	for(i = 0 ; i < nvert ; i++) {
+		pxyzr[4*i] = verts[i]->x ; pxyzr[4*i+1] = verts[i]->y ;
+		pxyzr[4*i+2] = verts[i]->z ; pxyzr[4*i+3] = verts[i]->ray ;
+	}
+	for(i = 0 ; i < natoms ; i++) {
+		lxyzr[4*i] = lig[i]->x ; lxyzr[4*i+1] = lig[i]->y ;
+		lxyzr[4*i+2] = lig[i]->z ; lxyzr[4*i+3] = lig[i]->radius ;
+	}
+	if(tofree) my_free(verts) ;
+
+	pocket->vol_corresp = 0.0 ;
+	if(nvert > 0 && natoms > 0 && get_volume_engine() == M_VOLUME_EXACT) {
+		vol[0] = get_spheres_volume_exact(pxyzr, nvert) ;
+		vol[1] = get_spheres_volume_exact(lxyzr, natoms) ;
+		overlap = vol[0] + vol[1] - get_spheres_volume_exact(pxyzr, nvert + natoms) ;
+		if(overlap < 0.0) overlap = 0.0 ;
+		if(vol[1] > 0.0) pocket->vol_corresp = overlap / vol[1] ;
+	}
+	else if(nvert > 0 && natoms > 0) {
+		set_spheres_bbox(pxyzr, nvert, bmin, bmax, 0) ;
+		set_spheres_bbox(lxyzr, natoms, bmin, bmax, 1) ;
+
+		s_vgrid *g = alloc_vgrid(bmin, bmax, niter, idiscret, 2) ;
+		add_vgrid_spheres(g, 0, pxyzr, nvert) ;
+		add_vgrid_spheres(g, 1, lxyzr, natoms) ;
+		get_vgrid_volumes(g, vol, NULL, &overlap) ;
+		free_vgrid(g) ;
+
+		if(vol[1] > 0.0) pocket->vol_corresp = overlap / vol[1] ;
+	}
+	my_free(pxyzr) ;
+
+	return pocket->vol_corresp ;
+}
@@ -15,6 +15,10 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-12	     Names of compressed structure files (.gz, .zst)
+##	17-11-08	     Sets of ids (s_idset) with constant time lookup
+##	17-11-05	     Fixed seed (set_rand_seed) and per thread generator
+##					     (set_thread_rand_seed) used by rand_uniform
 ##	22-01-09	(v)  Added function to split a string using a given separator
 ##	02-12-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
@@ -56,11 +60,20 @@
 
 **/
 
-
+static unsigned int get_idset_slot(s_idset *s, int val) ;
+static void grow_idset(s_idset *s) ;
 
 /* Says wether we have seeded the generator. */ 
 static int ST_is_rand_init = 0 ;
 
+/* Seed given by the user, -1 if the generator is seeded using the time */
+static int ST_rand_seed = -1 ;
+
+/* State of the generator of the current thread, used instead of the global
+ * one when ST_thread_rand_on is set (see set_thread_rand_seed) */
+static __thread unsigned int ST_thread_rand = 0 ;
+static __thread int ST_thread_rand_on = 0 ;
+
 #ifdef MD_USE_GSL	/* GSL */
 static gsl_rng *ST_r = NULL ;
 #endif				/* /GSL */
@@ -88,7 +101,7 @@ void start_rand_generator(void)
 			gsl_rng_free(ST_r);
 		}
 
-		gsl_rng_default_seed = time(NULL);
+		gsl_rng_default_seed = (ST_rand_seed >= 0) ? ST_rand_seed : time(NULL);
 
 		const gsl_rng_type *T = M_GEN_MTWISTER ;
 		ST_r = gsl_rng_alloc(T);
@@ -97,13 +110,85 @@ void start_rand_generator(void)
 	#else				/* /GSL */
 
 /* 		fprintf(stdout, "> Standard C generator used\n"); */
-		srand((int)time(NULL));
+		srand((ST_rand_seed >= 0) ? ST_rand_seed : (int)time(NULL));
 
 	#endif
 		ST_is_rand_init = 1 ;
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FONCTION: 
+	set_rand_seed
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Seed the generator with the given seed, so that two runs give the same
+	random numbers. A negative seed restores the seeding using the time.
+	The generator is (re)initialized in both cases.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int seed : The seed, or -1
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_rand_seed(int seed)
+{
+	ST_rand_seed = (seed >= 0) ? seed : -1 ;
+	ST_is_rand_init = 0 ;
+	start_rand_generator() ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION: 
+	get_rand_seed
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Return a seed for a new generator: the seed given to set_rand_seed if
+	any, a seed drawn from the global generator otherwise.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	unsigned int: The seed
+   -----------------------------------------------------------------------------
+*/
+unsigned int get_rand_seed(void)
+{
+	if(ST_rand_seed >= 0) return (unsigned int) ST_rand_seed ;
+
+	return (unsigned int) rand_uniform(0.0, 2147483647.0) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FONCTION: 
+	set_thread_rand_seed
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Give the calling thread its own generator, seeded with the given seed:
+	rand_uniform called from this thread does not touch the global generator
+	anymore, and the numbers drawn only depend on the seed. 
+	unset_thread_rand goes back to the global generator.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ unsigned int seed : The seed
+   -----------------------------------------------------------------------------
+   ## RETURN: 
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_thread_rand_seed(unsigned int seed)
+{
+	ST_thread_rand = seed ;
+	ST_thread_rand_on = 1 ;
+}
+
+void unset_thread_rand(void)
+{
+	ST_thread_rand_on = 0 ;
+}
+
 
 /**-----------------------------------------------------------------------------
    ## FONCTION: 
@@ -122,6 +207,10 @@ void start_rand_generator(void)
 */
 float rand_uniform(float min, float max)
 {
+	if(ST_thread_rand_on) {
+		return min + ((float)rand_r(&ST_thread_rand)/(float)RAND_MAX) * (max-min) ;
+	}
+
 	if(ST_is_rand_init == 0){
 		start_rand_generator() ;
 	}
@@ -458,6 +547,147 @@ int index_of(int *tab, int size, int val)
 	
 	return -1 ;
 }
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	alloc_idset
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Allocate a set of integers (atom, vertice or residue ids) with constant
+	time insertion and lookup: open addressing hash table in which a slot is
+	used only if its stamp is the generation of the set, so the set is
+	emptied in constant time by reset_idset and can be reused. The table
+	grows when it is half full.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int nmax : Expected number of values
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_idset*: The set
+   -----------------------------------------------------------------------------
+*/
+s_idset* alloc_idset(int nmax)
+{
+	s_idset *s = (s_idset *) my_malloc(sizeof(s_idset)) ;
+
+	s->size = M_IDSET_MIN_SIZE ;
+	while(s->size < 2*nmax) s->size *= 2 ;
+	s->keys = (int *) my_malloc(s->size*sizeof(int)) ;
+	s->stamp = (unsigned int *) my_calloc(s->size, sizeof(unsigned int)) ;
+	s->gen = 1 ;
+	s->n = 0 ;
+
+	return s ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	reset_idset
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Empty a set: next generation (stamps are cleared only when the
+	generation wraps around).
+   -----------------------------------------------------------------------------
+*/
+void reset_idset(s_idset *s)
+{
+	s->n = 0 ;
+	if(++s->gen == 0) {
+		memset(s->stamp, 0, s->size*sizeof(unsigned int)) ;
+		s->gen = 1 ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	add_idset, in_idset
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Add a value to a set / check if a value is in a set.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_idset *s : The set
+	@ int val    : The value
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: add_idset: 1 if val was added, 0 if it was already in the set
+		 in_idset: 1 if val is in the set, 0 if not
+   -----------------------------------------------------------------------------
+*/
+int add_idset(s_idset *s, int val)
+{
+	unsigned int i ;
+
+	if(2*(s->n + 1) > s->size) grow_idset(s) ;
+
+	for(i = get_idset_slot(s, val) ; s->stamp[i] == s->gen ; i = (i + 1) & (s->size - 1)) {
+		if(s->keys[i] == val) return 0 ;
+	}
+	s->stamp[i] = s->gen ;
+	s->keys[i] = val ;
+	s->n++ ;
+
+	return 1 ;
+}
+
+int in_idset(s_idset *s, int val)
+{
+	unsigned int i ;
+
+	for(i = get_idset_slot(s, val) ; s->stamp[i] == s->gen ; i = (i + 1) & (s->size - 1)) {
+		if(s->keys[i] == val) return 1 ;
+	}
+
+	return 0 ;
+}
+
+static unsigned int get_idset_slot(s_idset *s, int val)
+{
+	/* Fibonacci hashing: consecutive ids are spread over the table */
+	return (((unsigned int) val * 2654435761u) >> 7) & (s->size - 1) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	grow_idset
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Double the size of the table of a set, values being inserted again.
+   -----------------------------------------------------------------------------
+*/
+static void grow_idset(s_idset *s)
+{
+	int i, *keys = s->keys, size = s->size ;
+	unsigned int *stamp = s->stamp, gen = s->gen ;
+
+	s->size *= 2 ;
+	s->keys = (int *) my_malloc(s->size*sizeof(int)) ;
+	s->stamp = (unsigned int *) my_calloc(s->size, sizeof(unsigned int)) ;
+	s->gen = 1 ;
+	s->n = 0 ;
+	for(i = 0 ; i < size ; i++) {
+		if(stamp[i] == gen) add_idset(s, keys[i]) ;
+	}
+	my_free(keys) ;
+	my_free(stamp) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	free_idset
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Free a set.
+   -----------------------------------------------------------------------------
+*/
+void free_idset(s_idset *s)
+{
+	if(s) {
+		my_free(s->keys) ;
+		my_free(s->stamp) ;
+		my_free(s) ;
+	}
+}
+
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
@@ -641,6 +871,52 @@ void remove_ext(char *str)
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	compressed_ext_len
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Length of the compression extension of a file name (.gz or .zst, any
+	case), 0 if none.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *str : The file name
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 3 for .gz, 4 for .zst, 0 else
+   -----------------------------------------------------------------------------
+*/
+int compressed_ext_len(const char *str)
+{
+	int len = strlen(str) ;
+
+	if(len > 3 && strcasecmp(str + len - 3, ".gz") == 0) return 3 ;
+	if(len > 4 && strcasecmp(str + len - 4, ".zst") == 0) return 4 ;
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+    remove_pdb_ext
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+    Remove the extention of a structure file name, and the compression one
+	if any (1ATP.pdb.gz gives 1ATP)
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ char *str: INOUT String to deal with
+   -----------------------------------------------------------------------------
+   ## RETURN:
+    The input string is modified
+   -----------------------------------------------------------------------------
+*/
+void remove_pdb_ext(char *str)
+{
+	str[strlen(str) - compressed_ext_len(str)] = '\0' ;
+	remove_ext(str) ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
 	 fopen_pdb_check_case
@@ -649,6 +925,7 @@ void remove_ext(char *str)
 	Try to open a pdb file. If the open failed, put the 4 letter before extention
 	at the lower case and try again.
 	This function assume that the file name has the format path/file.pdb !
+	(or path/file.pdb.gz, path/file.pdb.zst)
    -----------------------------------------------------------------------------
    ## PARAMETERS:
 	@ char *name       : The string to parse
@@ -662,7 +939,7 @@ FILE* fopen_pdb_check_case(char *name, const char *mode)
 {
 	FILE *f = fopen(name, mode) ;
 	if(!f) {
-		int len = strlen(name) ;
+		int len = strlen(name) - compressed_ext_len(name) ;
 		name[len-5] = toupper(name[len-5]);
 		name[len-6] = toupper(name[len-6]);
 		name[len-7] = toupper(name[len-7]);
@@ -0,0 +1,984 @@
+#include "../headers/vbench.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					vbench.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	Micro benchmark of the alpha sphere test: testVvertice (one vertex at a
+##	time) against vtest_batch with each implementation available on the
+##	CPU. Candidates are the voronoi vertices of a PDB file (7TAA by
+##	default), and a synthetic set of 500000 candidates in a random box.
+##	The tesselation of the PDB file by qhull (with and without the memory
+##	kept between runs) and by the native Delaunay engine is timed too, as
+##	well as the merge of its pockets by refinePockets and pck_ml_clust,
+##	the volume of its pockets with each volume engine, and the neighbour
+##	searches of dpocket and tpocket. The throughput of the PDB reader is
+##	given for the single pass reader and the previous two pass one.
+##
+##	Usage: vbench [pdb file] [number of repetitions]
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     Contacted atoms of a large pocket timed (vbench_big_pocket)
+##	17-11-10	     PDB reader throughput (vbench_rpdb)
+##	17-11-09	     Neighbour searches timed (vbench_neigh)
+##	17-11-07	     Pocket volume engines timed (vbench_volume)
+##	17-11-05	     Vertice based descriptors timed (vbench_vert_desc)
+##	17-11-03	     Barycenter merge timed (vbench_refine)
+##	17-11-02	     Single linkage clustering timed (vbench_ml_clust)
+##	17-10-31	     qhull timed with its memory kept between runs
+##	17-10-30	     Tesselation engines timed (vbench_delaunay)
+##	17-10-29	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+static void vbench_begin(void *data, int nvvert) ;
+static void vbench_vert(void *data, int id, double *center, int *pts,
+						int *vneigh) ;
+static void vbench_synthetic(s_vbench *vb, s_atm **atoms, int ncand) ;
+static void vbench_run(s_vbench *vb, s_atm *atoms, int nrep) ;
+static int vbench_pack(s_vbench *vb, s_atm *atoms, s_vtest_batch *b) ;
+static double vbench_time(void) ;
+static void vbench_delaunay(double *xyz, int n, int nrep) ;
+static void vbench_ml_clust(s_pdb *pdb, int nrep) ;
+static void vbench_refine(s_pdb *pdb, int nrep) ;
+static void vbench_vert_desc(s_pdb *pdb, int nrep) ;
+static void vbench_big_pocket(int nrep) ;
+static void vbench_volume(s_pdb *pdb, int nrep) ;
+static void vbench_neigh(s_pdb *pdb, int nrep) ;
+static void vbench_rpdb(char *pdb_path, int nrep) ;
+static void vbench_neigh_lig(s_pdb *pdb, s_lst_vvertice *lvert, s_nindex *sind,
+							 s_atm **lig, int nlig, s_vvertice ***pverts,
+							 int *psize, int np, void **res, int *nres, float *ov) ;
+static int vbench_cmp_ptr(const void *a, const void *b) ;
+static void vbench_count_begin(void *data, int nvvert) ;
+static void vbench_count_vert(void *data, int id, double *center, int *pts,
+							  int *vneigh) ;
+
+int main(int argc, char *argv[])
+{
+	char *pdb_path = (argc > 1) ? argv[1] : (char *) "sample/7TAA.pdb" ;
+	int i, nrep = (argc > 2) ? atoi(argv[2]) : M_VBENCH_NREP ;
+	double *xyz = NULL ;
+	s_atm *atoms = NULL ;
+	s_vbench vb ;
+
+	if(nrep < 1) nrep = 1 ;
+
+	s_pdb *pdb =  rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+	if(!pdb) {
+		fprintf(stderr, "! Cannot open %s\n", pdb_path) ;
+		return 1 ;
+	}
+	rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+
+	xyz = (double *)my_malloc(3*pdb->natoms*sizeof(double)) ;
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		xyz[3*i] = pdb->latoms[i].x ;
+		xyz[3*i+1] = pdb->latoms[i].y ;
+		xyz[3*i+2] = pdb->latoms[i].z ;
+	}
+	vb.xyz = NULL ;
+	vb.nb = NULL ;
+	run_qvoronoi_mem(xyz, pdb->natoms, vbench_begin, vbench_vert, &vb) ;
+
+	fprintf(stdout, "%s: %d atoms, %d candidates, %d repetitions\n",
+			pdb_path, pdb->natoms, vb.n, nrep) ;
+	vbench_rpdb(pdb_path, nrep) ;
+	vbench_delaunay(xyz, pdb->natoms, nrep) ;
+	vbench_refine(pdb, nrep) ;
+	vbench_vert_desc(pdb, nrep) ;
+	vbench_big_pocket(nrep) ;
+	vbench_volume(pdb, nrep) ;
+	vbench_neigh(pdb, nrep) ;
+	vbench_ml_clust(pdb, nrep) ;
+	my_free(xyz) ;
+	vbench_run(&vb, pdb->latoms, nrep) ;
+	my_free(vb.xyz) ;
+	my_free(vb.nb) ;
+	free_pdb_atoms(pdb) ;
+
+	vbench_synthetic(&vb, &atoms, M_VBENCH_NSYNTH) ;
+	fprintf(stdout, "\nRandom box: %d atoms, %d candidates, %d repetitions\n",
+			4*vb.n, vb.n, nrep) ;
+	vbench_run(&vb, atoms, nrep) ;
+	my_free(vb.xyz) ;
+	my_free(vb.nb) ;
+	my_free(atoms) ;
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_begin, vbench_vert
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	run_qvoronoi_mem callbacks: store the center and the 4 atoms of each
+	voronoi vertex.
+   -----------------------------------------------------------------------------
+*/
+static void vbench_begin(void *data, int nvvert)
+{
+	s_vbench *vb = (s_vbench *)data ;
+	vb->xyz = (float *)my_malloc(3*nvvert*sizeof(float)) ;
+	vb->nb = (int *)my_malloc(4*nvvert*sizeof(int)) ;
+	vb->n = 0 ;
+}
+
+static void vbench_vert(void *data, int id, double *center, int *pts,
+						int *vneigh)
+{
+	s_vbench *vb = (s_vbench *)data ;
+	int i ;
+
+	for(i = 0 ; i < 4 ; i++) if(pts[i] < 0) return ;
+	for(i = 0 ; i < 3 ; i++) vb->xyz[3*vb->n+i] = (float) center[i] ;
+	for(i = 0 ; i < 4 ; i++) vb->nb[4*vb->n+i] = pts[i] ;
+	vb->n++ ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_rpdb
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Read the PDB file nrep times with rpdb_open/rpdb_read and with
+	rpdb_open_naive/rpdb_read_naive, and give the throughput of each in MB/s
+	(of PDB file read).
+   -----------------------------------------------------------------------------
+*/
+static void vbench_rpdb(char *pdb_path, int nrep)
+{
+	int r, k, natoms = 0 ;
+	double t0, t[2] = {0.0, 0.0}, mb ;
+	struct stat st ;
+	s_pdb *pdb = NULL ;
+
+	if(stat(pdb_path, &st) != 0) return ;
+	mb = st.st_size/1e6 ;
+
+	for(k = 0 ; k < 2 ; k++) {
+		for(r = 0 ; r < nrep ; r++) {
+			t0 = vbench_time() ;
+			if(k) {
+				pdb = rpdb_open(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+				if(pdb) rpdb_read(pdb, NULL, M_DONT_KEEP_LIG) ;
+			}
+			else {
+				pdb = rpdb_open_naive(pdb_path, NULL, M_DONT_KEEP_LIG) ;
+				if(pdb) rpdb_read_naive(pdb, NULL, M_DONT_KEEP_LIG) ;
+			}
+			t[k] += vbench_time() - t0 ;
+			if(!pdb) return ;
+
+			natoms = pdb->natoms ;
+			free_pdb_atoms(pdb) ;
+		}
+	}
+
+	fprintf(stdout, "    %-12s %8.2f MB/s   naive %8.2f MB/s      (%d atoms, %.2f MB, x%.2f)\n",
+			"pdb reader", nrep*mb/t[1], nrep*mb/t[0], natoms, mb, t[0]/t[1]) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_delaunay
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time the tesselation of the given points by qhull, by qhull keeping its
+	memory between runs (see qvoronoi_keep_mem) and by the native Delaunay
+	engine (nrep runs each), and print the time per point.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ double *xyz : Coordinates of the points
+	@ int n       : Number of points
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_delaunay(double *xyz, int n, int nrep)
+{
+	int r, nqh = 0, nkeep = 0, nnat = 0 ;
+	double t0, tqh, tkeep, tnat ;
+
+	t0 = vbench_time() ;
+	for(r = 0 ; r < nrep ; r++) 
+		run_qvoronoi_mem(xyz, n, vbench_count_begin, vbench_count_vert, &nqh) ;
+	tqh = vbench_time() - t0 ;
+
+	qvoronoi_keep_mem(1) ;
+	t0 = vbench_time() ;
+	for(r = 0 ; r < nrep ; r++) 
+		run_qvoronoi_mem(xyz, n, vbench_count_begin, vbench_count_vert, &nkeep) ;
+	tkeep = vbench_time() - t0 ;
+	qvoronoi_keep_mem(0) ;
+
+	t0 = vbench_time() ;
+	for(r = 0 ; r < nrep ; r++) 
+		run_delaunay_mem(xyz, n, vbench_count_begin, vbench_count_vert, &nnat) ;
+	tnat = vbench_time() - t0 ;
+
+	fprintf(stdout, "    %-12s %8.2f us/point                            (%d tetrahedra)\n",
+			"qhull", 1e6*tqh/((double)nrep*n), nqh) ;
+	fprintf(stdout, "    %-12s %8.2f us/point                            (%d tetrahedra, x%.2f)\n",
+			"qhull kept", 1e6*tkeep/((double)nrep*n), nkeep, tkeep > 0 ? tqh/tkeep : 0.0) ;
+	fprintf(stdout, "    %-12s %8.2f us/point                            (%d tetrahedra, x%.2f)\n",
+			"native", 1e6*tnat/((double)nrep*n), nnat, tnat > 0 ? tqh/tnat : 0.0) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_count_begin, vbench_count_vert
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Tesselation callbacks only counting the tetrahedra.
+   -----------------------------------------------------------------------------
+*/
+static void vbench_count_begin(void *data, int nvvert)
+{
+	*((int *)data) = 0 ;
+}
+
+static void vbench_count_vert(void *data, int id, double *center, int *pts,
+							  int *vneigh)
+{
+	(*((int *)data))++ ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_synthetic
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Build ncand random candidates in a box, each with its own 4 atoms. Half
+	of the candidates have their 4 atoms on a sphere (they are likely to
+	pass the test), the others have atoms at random distances.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vbench *vb    : Candidates to fill
+	@ s_atm **atoms   : Atoms created (4 per candidate)
+	@ int ncand       : Number of candidates
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_synthetic(s_vbench *vb, s_atm **atoms, int ncand)
+{
+	int i, j ;
+	float r, u, v, w, n ;
+	s_atm *a = NULL ;
+
+	srand(42) ;
+	vb->n = ncand ;
+	vb->xyz = (float *)my_malloc(3*ncand*sizeof(float)) ;
+	vb->nb = (int *)my_malloc(4*ncand*sizeof(int)) ;
+	*atoms = (s_atm *)my_calloc(4*ncand, sizeof(s_atm)) ;
+
+	for(i = 0 ; i < ncand ; i++) {
+		for(j = 0 ; j < 3 ; j++)
+			vb->xyz[3*i+j] = M_VBENCH_BOX * rand() / (float) RAND_MAX ;
+		r = 2.5 + 5.0 * rand() / (float) RAND_MAX ;
+
+		for(j = 0 ; j < 4 ; j++) {
+			u = rand() / (float) RAND_MAX - 0.5 ;
+			v = rand() / (float) RAND_MAX - 0.5 ;
+			w = rand() / (float) RAND_MAX - 0.5 ;
+			n = sqrt(u*u + v*v + w*w) + 1e-6 ;
+			if(i % 2) n *= 0.8 + 0.4 * rand() / (float) RAND_MAX ;
+
+			a = *atoms + 4*i + j ;
+			a->x = vb->xyz[3*i] + r * u / n ;
+			a->y = vb->xyz[3*i+1] + r * v / n ;
+			a->z = vb->xyz[3*i+2] + r * w / n ;
+			a->electroneg = (rand() % 2) ? 2.55 : 3.44 ;
+			vb->nb[4*i+j] = 4*i + j ;
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_run
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time testVvertice and vtest_batch (each implementation) on all
+	candidates, nrep times, and print the time per candidate. For
+	vtest_batch, the time of the test alone is given, and the time including
+	the copy of the candidates in the batches (as done in fill_vvertice).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vbench *vb  : Candidates
+	@ s_atm *atoms  : Atoms referenced by the candidates
+	@ int nrep      : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_run(s_vbench *vb, s_atm *atoms, int nrep)
+{
+	int impls[3] = {M_VTEST_SCALAR, M_VTEST_SSE, M_VTEST_AVX2} ;
+	int i, k, r, impl, npass = 0, nref = 0, natoms = 0,
+		nbatch = (vb->n + M_VTEST_BATCH - 1) / M_VTEST_BATCH ;
+	double t0, t, tref, tpack ;
+	s_lst_vvertice lvvert ;
+	s_vtest_batch *b = (s_vtest_batch *)my_malloc((nbatch > 0 ? nbatch : 1)
+												   *sizeof(s_vtest_batch)) ;
+
+	for(i = 0 ; i < 4*vb->n ; i++) if(vb->nb[i] >= natoms) natoms = vb->nb[i]+1 ;
+	lvvert.h_tr = (int *)my_malloc((natoms > 0 ? natoms : 1)*sizeof(int)) ;
+	for(i = 0 ; i < natoms ; i++) lvvert.h_tr[i] = i ;
+
+	t0 = vbench_time() ;
+	for(r = 0 ; r < nrep ; r++) {
+		nref = 0 ;
+		for(i = 0 ; i < vb->n ; i++) {
+			if(testVvertice(vb->xyz + 3*i, vb->nb + 4*i, atoms, M_MIN_ASHAPE_SIZE_DEFAULT,
+							M_MAX_ASHAPE_SIZE_DEFAULT, &lvvert) > 0) nref++ ;
+		}
+	}
+	tref = vbench_time() - t0 ;
+	fprintf(stdout, "    %-12s %8.2f ns/candidate                        (%d accepted)\n",
+			"testVvertice", 1e9*tref/((double)nrep*vb->n), nref) ;
+
+	t0 = vbench_time() ;
+	for(r = 0 ; r < nrep ; r++) nbatch = vbench_pack(vb, atoms, b) ;
+	tpack = vbench_time() - t0 ;
+
+	for(impl = 0 ; impl < 3 ; impl++) {
+		if(vtest_set_impl(impls[impl]) != impls[impl]) continue ;
+
+		t0 = vbench_time() ;
+		for(r = 0 ; r < nrep ; r++) {
+			for(i = 0 ; i < nbatch ; i++)
+				vtest_batch(b + i, M_MIN_ASHAPE_SIZE_DEFAULT, M_MAX_ASHAPE_SIZE_DEFAULT) ;
+		}
+		t = vbench_time() - t0 ;
+
+		npass = 0 ;
+		for(i = 0 ; i < nbatch ; i++)
+			for(k = 0 ; k < b[i].n ; k++) if(b[i].ray[k] > 0) npass++ ;
+
+		fprintf(stdout, "    %-12s %8.2f ns/candidate, %8.2f with copy  (%d accepted, x%.2f)\n",
+				vtest_get_impl_name(), 1e9*t/((double)nrep*vb->n),
+				1e9*(t+tpack)/((double)nrep*vb->n), npass,
+				t+tpack > 0 ? tref/(t+tpack) : 0.0) ;
+	}
+	vtest_set_impl(M_VTEST_AUTO) ;
+
+	my_free(lvvert.h_tr) ;
+	my_free(b) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_pack
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Copy the candidates in batches, as fill_vvertice does: candidates too
+	small or too big given their first atom are rejected right away.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vbench *vb      : Candidates
+	@ s_atm *atoms      : Atoms referenced by the candidates
+	@ s_vtest_batch *b  : Batches to fill
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of batches filled
+   -----------------------------------------------------------------------------
+*/
+static int vbench_pack(s_vbench *vb, s_atm *atoms, s_vtest_batch *b)
+{
+	int i, j, k, nbatch = 0 ;
+	float d ;
+	float *c = NULL ;
+	s_atm *ca = NULL ;
+
+	b->n = 0 ;
+	for(i = 0 ; i < vb->n ; i++) {
+		c = vb->xyz + 3*i ;
+		ca = atoms + vb->nb[4*i] ;
+		d = dist(c[0], c[1], c[2], ca->x, ca->y, ca->z) ;
+		if(d < M_MIN_ASHAPE_SIZE_DEFAULT || d > M_MAX_ASHAPE_SIZE_DEFAULT) continue ;
+
+		if(b->n == M_VTEST_BATCH) {
+			b++ ;
+			nbatch++ ;
+			b->n = 0 ;
+		}
+		k = b->n++ ;
+		b->cx[k] = c[0] ;
+		b->cy[k] = c[1] ;
+		b->cz[k] = c[2] ;
+		for(j = 0 ; j < 4 ; j++) {
+			ca = atoms + vb->nb[4*i+j] ;
+			b->ax[j][k] = ca->x ;
+			b->ay[j][k] = ca->y ;
+			b->az[j][k] = ca->z ;
+			b->en[j][k] = ca->electroneg ;
+		}
+	}
+
+	return nbatch + 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_refine
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time the merge of the pockets of the PDB file with close barycenters (as
+	given to it by fpocket) by refinePockets_naive and by refinePockets in
+	both modes (nrep runs each).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb  : The PDB file
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_refine(s_pdb *pdb, int nrep)
+{
+	int r, k, np[3] = {0, 0, 0} ;
+	double t0, t[3] = {0.0, 0.0, 0.0} ;
+	const char *name[3] = {"refine naive", "refine order", "refine fix"} ;
+	s_fparams *params = init_def_fparams() ;
+	s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh,
+										   params->asph_min_size,
+										   params->asph_max_size) ;
+	if(!lvert) {
+		free_fparams(params) ;
+		return ;
+	}
+
+	for(k = 0 ; k < 3 ; k++) {
+		params->refine_mode = (k == 2) ? M_REFINE_FIXPOINT : M_REFINE_ORDER ;
+		for(r = 0 ; r < nrep ; r++) {
+			c_lst_pockets *pockets = clusterPockets(lvert, params) ;
+			if(!pockets) continue ;
+			reIndexPockets(pockets) ;
+			drop_tiny(pockets) ;
+			reIndexPockets(pockets) ;
+
+			t0 = vbench_time() ;
+			if(k == 0) refinePockets_naive(pockets, params) ;
+			else refinePockets(pockets, params) ;
+			t[k] += vbench_time() - t0 ;
+
+			np[k] = pockets->n_pockets ;
+			pockets->vertices = NULL ;
+			c_lst_pocket_free(pockets) ;
+		}
+	}
+
+	for(k = 0 ; k < 3 ; k++) {
+		fprintf(stdout, "    %-12s %8.2f ms/run                              (%d pockets, x%.2f)\n",
+				name[k], 1e3*t[k]/nrep, np[k], t[k] > 0 ? t[0]/t[k] : 0.0) ;
+	}
+	free_vert_lst(lvert) ;
+	free_fparams(params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_vert_desc
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time the vertice based descriptors (volume excepted) computed by
+	set_vert_descriptors_naive and set_vert_descriptors on all pockets found
+	by fpocket, and on all vertices of the PDB file taken as a single large
+	pocket (nrep runs each).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb  : The PDB file
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_vert_desc(s_pdb *pdb, int nrep)
+{
+	int r, k, n, tofree, nvert = 0 ;
+	double t0, t[2][2] = {{0.0, 0.0}, {0.0, 0.0}} ;
+	s_desc desc ;
+	node_pocket *pcur = NULL ;
+	s_fparams *params = init_def_fparams() ;
+	c_lst_pockets *pockets = search_pocket(pdb, params) ;
+
+	if(!pockets) {
+		free_fparams(params) ;
+		return ;
+	}
+
+	for(k = 0 ; k < 2 ; k++) {
+		for(r = 0 ; r < nrep ; r++) {
+			for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+				s_vvertice **verts = get_pocket_vert_array(pcur->pocket, &n, &tofree) ;
+				if(k == 0 && r == 0) nvert += n ;
+
+				reset_desc(&desc) ;
+				t0 = vbench_time() ;
+				if(k == 0) set_vert_descriptors_naive(verts, n, &desc) ;
+				else set_vert_descriptors(verts, n, &desc) ;
+				t[0][k] += vbench_time() - t0 ;
+				if(tofree) my_free(verts) ;
+			}
+
+			reset_desc(&desc) ;
+			t0 = vbench_time() ;
+			if(k == 0) set_vert_descriptors_naive(pockets->vertices->pvertices,
+												  pockets->vertices->nvert, &desc) ;
+			else set_vert_descriptors(pockets->vertices->pvertices,
+									  pockets->vertices->nvert, &desc) ;
+			t[1][k] += vbench_time() - t0 ;
+		}
+	}
+
+	fprintf(stdout, "    %-12s %8.2f ms/run naive %8.2f ms/run      (%d pockets, %d spheres, x%.2f)\n",
+			"desc pockets", 1e3*t[0][0]/nrep, 1e3*t[0][1]/nrep, (int) pockets->n_pockets,
+			nvert, t[0][1] > 0 ? t[0][0]/t[0][1] : 0.0) ;
+	fprintf(stdout, "    %-12s %8.2f ms/run naive %8.2f ms/run      (%d spheres, x%.2f)\n",
+			"desc all", 1e3*t[1][0]/nrep, 1e3*t[1][1]/nrep, pockets->vertices->nvert,
+			t[1][1] > 0 ? t[1][0]/t[1][1] : 0.0) ;
+
+	c_lst_pocket_free(pockets) ;
+	free_fparams(params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_big_pocket
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time get_pocket_contacted_atms with the atom based descriptors,
+	count_pocket_contacted_atms and get_vert_contacted_atms on a merged
+	pocket of M_VBENCH_BIG_NVERT alpha spheres (synthetic, contacting
+	M_VBENCH_BIG_NATM atoms at random), as the large pocket test of pcheck.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_big_pocket(int nrep)
+{
+	int i, k, r, n = 0 ;
+	unsigned int seed = 7 ;
+	double t0, t[3] = {0.0, 0.0, 0.0} ;
+	s_desc desc ;
+	s_atm **catoms = NULL ;
+	s_pocket *pocket = alloc_pocket() ;
+
+	s_atm *atoms = (s_atm *) my_calloc(M_VBENCH_BIG_NATM, sizeof(s_atm)) ;
+	s_vvertice *verts = (s_vvertice *) my_calloc(M_VBENCH_BIG_NVERT, sizeof(s_vvertice)) ;
+
+	for(i = 0 ; i < M_VBENCH_BIG_NATM ; i++) {
+		atoms[i].id = 3*i + 1 ;
+		atoms[i].res_id = i / 8 ;
+		strcpy(atoms[i].res_name, "ALA") ;
+	}
+
+	pocket->v_lst = c_lst_vertices_alloc() ;
+	for(i = 0 ; i < M_VBENCH_BIG_NVERT ; i++) {
+		for(k = 0 ; k < 4 ; k++) {
+			seed = seed*1103515245u + 12345u ;
+			verts[i].neigh[k] = atoms + (seed >> 8) % M_VBENCH_BIG_NATM ;
+		}
+		c_lst_vertices_add_last(pocket->v_lst, verts + i) ;
+	}
+
+	for(r = 0 ; r < nrep ; r++) {
+		t0 = vbench_time() ;
+		catoms = get_pocket_contacted_atms(pocket, &n) ;
+		reset_desc(&desc) ;
+		set_atom_based_descriptors(catoms, n, &desc) ;
+		my_free(catoms) ;
+		t[0] += vbench_time() - t0 ;
+
+		t0 = vbench_time() ;
+		n = count_pocket_contacted_atms(pocket) ;
+		t[1] += vbench_time() - t0 ;
+
+		t0 = vbench_time() ;
+		catoms = get_vert_contacted_atms(pocket->v_lst, &n) ;
+		my_free(catoms) ;
+		t[2] += vbench_time() - t0 ;
+	}
+
+	fprintf(stdout, "    %-12s %8.2f ms/run count %8.2f ms/run verts %8.2f ms/run (%d spheres, %d atoms)\n",
+			"big pocket", 1e3*t[0]/nrep, 1e3*t[1]/nrep, 1e3*t[2]/nrep,
+			M_VBENCH_BIG_NVERT, n) ;
+
+	c_lst_vertices_free(pocket->v_lst) ;
+	my_free(pocket->pdesc) ;
+	my_free(pocket) ;
+	my_free(verts) ;
+	my_free(atoms) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Volume of the pockets found in the PDB file with the Monte Carlo and
+	grid engines at 3000 and 20000 iterations, and with the exact engine:
+	time of each, and mean relative error against the exact volume.
+   -----------------------------------------------------------------------------
+*/
+static void vbench_volume(s_pdb *pdb, int nrep)
+{
+	int r, k, n, tofree, nvert = 0,
+		engine[5] = {M_VOLUME_MC, M_VOLUME_MC, M_VOLUME_GRID, M_VOLUME_GRID, M_VOLUME_EXACT},
+		niter[5] = {3000, 20000, 3000, 20000, 0} ;
+	char name[5][16] = {"mc 3000", "mc 20000", "grid 3000", "grid 20000", "exact"} ;
+	double t0, t[5] = {0.0, 0.0, 0.0, 0.0, 0.0},
+		   err[5] = {0.0, 0.0, 0.0, 0.0, 0.0} ;
+	float v, vexact ;
+	node_pocket *pcur = NULL ;
+	s_fparams *params = init_def_fparams() ;
+	c_lst_pockets *pockets = search_pocket(pdb, params) ;
+
+	if(!pockets) {
+		free_fparams(params) ;
+		return ;
+	}
+
+	for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		s_vvertice **verts = get_pocket_vert_array(pcur->pocket, &n, &tofree) ;
+		nvert += n ;
+
+		set_volume_engine(M_VOLUME_EXACT) ;
+		vexact = get_verts_volume_ptr(verts, n, 0) ;
+		for(k = 0 ; k < 5 ; k++) {
+			set_volume_engine(engine[k]) ;
+			t0 = vbench_time() ;
+			for(r = 0 ; r < nrep ; r++) v = get_verts_volume_ptr(verts, n, niter[k]) ;
+			t[k] += vbench_time() - t0 ;
+			if(vexact > 0.0) err[k] += fabs(v - vexact) / vexact ;
+		}
+		if(tofree) my_free(verts) ;
+	}
+	set_volume_engine(params->volume) ;
+
+	for(k = 0 ; k < 5 ; k++) {
+		fprintf(stdout, "    %-12s %8.2f ms/run error %8.5f           (%d pockets, %d spheres)\n",
+				name[k], 1e3*t[k]/nrep, err[k]/pockets->n_pockets,
+				(int) pockets->n_pockets, nvert) ;
+	}
+
+	c_lst_pocket_free(pockets) ;
+	free_fparams(params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_neigh
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time the neighbour searches done by dpocket and tpocket for a ligand,
+	taking as ligand the atoms contacted by each pocket found in the PDB
+	file (see vbench_neigh_lig). Done by the _naive functions (list sorted
+	at each call) and on spatial indexes (one of the structure, built once
+	per run, and one of each ligand), nrep runs each. Results of both are
+	compared first.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb  : The PDB file
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_neigh(s_pdb *pdb, int nrep)
+{
+	int r, k, p, j, nlig, np, ndiff = 0, nquery = 0,
+		nres[2][3] ;
+	int *psize = NULL ;
+	double t0, t[2] = {0.0, 0.0}, tbuild = 0.0 ;
+	float *ov[2] ;
+	void *res[2][3] ;
+	s_atm **lig = NULL ;
+	s_vvertice ***pverts = NULL ;
+	s_nindex *sind = NULL ;
+	node_pocket *pcur = NULL ;
+	s_fparams *params = init_def_fparams() ;
+	c_lst_pockets *pockets = search_pocket(pdb, params) ;
+
+	if(!pockets) {
+		free_fparams(params) ;
+		return ;
+	}
+
+	np = pockets->n_pockets ;
+	pverts = (s_vvertice ***) my_malloc((np+1)*sizeof(s_vvertice**)) ;
+	psize = (int *) my_malloc((np+1)*sizeof(int)) ;
+	ov[0] = (float *) my_malloc((2*np+2)*sizeof(float)) ;
+	ov[1] = (float *) my_malloc((2*np+2)*sizeof(float)) ;
+	for(p = 0, pcur = pockets->first ; pcur && p < np ; p++, pcur = pcur->next) {
+		pverts[p] = get_pocket_pvertices(pcur->pocket) ;
+		psize[p] = pcur->pocket->size ;
+	}
+
+	/* Same neighbours and overlaps with and without the index (unique ids of
+	 * the vertices, get_mol_vert_neigh_naive keeping one vertex per id) */
+	for(j = 0 ; j < pockets->vertices->nvert ; j++)
+		pockets->vertices->pvertices[j]->id = pdb->natoms + j + 1 ;
+	sind = alloc_nindex(pdb->latoms_p, pdb->natoms, pockets->vertices->pvertices,
+						pockets->vertices->nvert, M_VBENCH_NEIGH_D) ;
+	for(p = 0, pcur = pockets->first ; pcur && p < np ; p++, pcur = pcur->next) {
+		lig = get_pocket_contacted_atms(pcur->pocket, &nlig) ;
+		nquery += nlig ;
+		for(k = 0 ; k < 2 ; k++) {
+			vbench_neigh_lig(pdb, pockets->vertices, k ? sind : NULL, lig, nlig,
+							 pverts, psize, np, res[k], nres[k], ov[k]) ;
+		}
+		for(j = 0 ; j < 3 ; j++) {
+			if(nres[0][j] != nres[1][j]) ndiff++ ;
+			else {
+				qsort(res[0][j], nres[0][j], sizeof(void*), vbench_cmp_ptr) ;
+				qsort(res[1][j], nres[1][j], sizeof(void*), vbench_cmp_ptr) ;
+				if(memcmp(res[0][j], res[1][j], nres[0][j]*sizeof(void*))) ndiff++ ;
+			}
+			my_free(res[0][j]) ;
+			my_free(res[1][j]) ;
+		}
+		for(j = 0 ; j < 2*np ; j++) if(ov[0][j] != ov[1][j]) ndiff++ ;
+		my_free(lig) ;
+	}
+	free_nindex(sind) ;
+
+	for(k = 0 ; k < 2 ; k++) {
+		for(r = 0 ; r < nrep ; r++) {
+			if(k == 1) {
+				t0 = vbench_time() ;
+				sind = alloc_nindex(pdb->latoms_p, pdb->natoms, pockets->vertices->pvertices,
+									pockets->vertices->nvert, M_VBENCH_NEIGH_D) ;
+				tbuild += vbench_time() - t0 ;
+				t[k] += vbench_time() - t0 ;
+			}
+
+			for(p = 0, pcur = pockets->first ; pcur && p < np ; p++, pcur = pcur->next) {
+				lig = get_pocket_contacted_atms(pcur->pocket, &nlig) ;
+				t0 = vbench_time() ;
+				vbench_neigh_lig(pdb, pockets->vertices, k ? sind : NULL, lig, nlig,
+								 pverts, psize, np, res[k], nres[k], ov[k]) ;
+				t[k] += vbench_time() - t0 ;
+				for(j = 0 ; j < 3 ; j++) my_free(res[k][j]) ;
+				my_free(lig) ;
+			}
+			if(k == 1) free_nindex(sind) ;
+		}
+	}
+
+	fprintf(stdout, "    %-12s %8.2f ms/run naive %8.2f ms/run      (%d ligands, %d atoms, x%.2f)\n",
+			"neighbours", 1e3*t[0]/nrep, 1e3*t[1]/nrep, np, nquery,
+			t[1] > 0 ? t[0]/t[1] : 0.0) ;
+	fprintf(stdout, "    %-12s %8.2f ms/run                              (%d atoms, %d spheres, %d differences)\n",
+			"index build", 1e3*tbuild/nrep, pdb->natoms, pockets->vertices->nvert, ndiff) ;
+
+	for(p = 0 ; p < np ; p++) my_free(pverts[p]) ;
+	my_free(pverts) ;
+	my_free(psize) ;
+	my_free(ov[0]) ;
+	my_free(ov[1]) ;
+	c_lst_pocket_free(pockets) ;
+	free_fparams(params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_neigh_lig
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Neighbour searches of dpocket and tpocket for one ligand: atoms and
+	vertices near the ligand, atoms contacted by these vertices, and vertice
+	overlaps of the ligand with every pocket. Done by the _naive functions
+	if no index is given, on the index (and on an index of the ligand)
+	else.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb            : The PDB file
+	@ s_lst_vvertice *lvert : All vertices
+	@ s_nindex *sind        : Index of the atoms and vertices, or NULL
+	@ s_atm **lig           : The ligand
+	@ int nlig              : Number of atoms of the ligand
+	@ s_vvertice ***pverts  : Vertices of each pocket
+	@ int *psize            : Number of vertices of each pocket
+	@ int np                : Number of pockets
+	@ void **res            : OUTPUT The 3 lists of neighbours (to free)
+	@ int *nres             : OUTPUT Size of each list
+	@ float *ov             : OUTPUT The 2 overlaps with each pocket
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_neigh_lig(s_pdb *pdb, s_lst_vvertice *lvert, s_nindex *sind,
+							 s_atm **lig, int nlig, s_vvertice ***pverts,
+							 int *psize, int np, void **res, int *nres, float *ov)
+{
+	int q ;
+	s_nindex *lind = NULL ;
+
+	if(!sind) {
+		res[0] = get_mol_atm_neigh_naive(lig, nlig, pdb->latoms_p, pdb->natoms,
+										 M_VBENCH_NEIGH_D, nres) ;
+		res[1] = get_mol_ctd_atm_neigh_naive(lig, nlig, lvert->pvertices, lvert->nvert,
+											 M_VBENCH_NEIGH_D, M_INTERFACE_SEARCH, nres+1) ;
+		res[2] = get_mol_vert_neigh_naive(lig, nlig, lvert->pvertices, lvert->nvert,
+										  M_VBENCH_NEIGH_D, nres+2) ;
+		for(q = 0 ; q < np ; q++) {
+			ov[2*q] = count_atm_prop_vert_neigh_naive(lig, nlig, pverts[q], psize[q],
+													  M_VBENCH_OVLP_D) ;
+			ov[2*q+1] = count_pocket_lig_vert_ovlp_naive(lig, nlig, pverts[q], psize[q],
+														 M_VBENCH_OVLP_D) ;
+		}
+	}
+	else {
+		lind = alloc_nindex(lig, nlig, NULL, 0, M_VBENCH_OVLP_D) ;
+		res[0] = get_mol_atm_neigh(lig, nlig, sind, M_VBENCH_NEIGH_D, nres) ;
+		res[1] = get_mol_ctd_atm_neigh(lig, nlig, sind, M_VBENCH_NEIGH_D,
+									   M_INTERFACE_SEARCH, nres+1) ;
+		res[2] = get_mol_vert_neigh(lig, nlig, sind, M_VBENCH_NEIGH_D, nres+2) ;
+		for(q = 0 ; q < np ; q++) {
+			ov[2*q] = count_atm_prop_vert_neigh(lind, pverts[q], psize[q], M_VBENCH_OVLP_D) ;
+			ov[2*q+1] = count_pocket_lig_vert_ovlp(lind, pverts[q], psize[q], M_VBENCH_OVLP_D) ;
+		}
+		free_nindex(lind) ;
+	}
+}
+
+static int vbench_cmp_ptr(const void *a, const void *b)
+{
+	const char *pa = *(char * const *) a,
+			   *pb = *(char * const *) b ;
+
+	return (pa > pb) - (pa < pb) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_ml_clust
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Time the single linkage clustering of the pockets of the PDB file (as
+	given to it by fpocket) by pck_ml_clust_naive and by pck_ml_clust in
+	both modes (nrep runs each).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb  : The PDB file
+	@ int nrep    : Number of repetitions
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void vbench_ml_clust(s_pdb *pdb, int nrep)
+{
+	int r, k, np[3] = {0, 0, 0} ;
+	double t0, t[3] = {0.0, 0.0, 0.0} ;
+	const char *name[3] = {"ml naive", "ml order", "ml graph"} ;
+	s_fparams *params = init_def_fparams() ;
+	s_lst_vvertice *lvert = load_vvertices(pdb, params->min_apol_neigh,
+										   params->asph_min_size,
+										   params->asph_max_size) ;
+	if(!lvert) {
+		free_fparams(params) ;
+		return ;
+	}
+
+	for(k = 0 ; k < 3 ; k++) {
+		params->ml_clust = (k == 2) ? M_MLCLUST_GRAPH : M_MLCLUST_ORDER ;
+		for(r = 0 ; r < nrep ; r++) {
+			c_lst_pockets *pockets = clusterPockets(lvert, params) ;
+			if(!pockets) continue ;
+			reIndexPockets(pockets) ;
+			drop_tiny(pockets) ;
+			reIndexPockets(pockets) ;
+			refinePockets(pockets, params) ;
+			reIndexPockets(pockets) ;
+
+			t0 = vbench_time() ;
+			if(k == 0) pck_ml_clust_naive(pockets, params) ;
+			else pck_ml_clust(pockets, params) ;
+			t[k] += vbench_time() - t0 ;
+
+			np[k] = pockets->n_pockets ;
+			pockets->vertices = NULL ;
+			c_lst_pocket_free(pockets) ;
+		}
+	}
+
+	for(k = 0 ; k < 3 ; k++) {
+		fprintf(stdout, "    %-12s %8.2f ms/run                              (%d pockets, x%.2f)\n",
+				name[k], 1e3*t[k]/nrep, np[k], t[k] > 0 ? t[0]/t[k] : 0.0) ;
+	}
+	free_vert_lst(lvert) ;
+	free_fparams(params) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vbench_time
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Monotonic time in seconds.
+   -----------------------------------------------------------------------------
+*/
+static double vbench_time(void)
+{
+	struct timespec ts ;
+	clock_gettime(CLOCK_MONOTONIC, &ts) ;
+
+	return ts.tv_sec + 1e-9*ts.tv_nsec ;
+}
@@ -0,0 +1,366 @@
+#include "../headers/vcache.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					vcache.c
+## LAST MODIFIED			17-11-15
+##
+## ----- SPECIFICATIONS
+##
+##	On disk cache of the alpha spheres (filtered voronoi vertices) of a
+##	structure. Vertices only depend on the heavy atoms and on the alpha
+##	sphere parameters (-m, -M, -A), so running fpocket again on the same
+##	structure with other clustering parameters can skip the tesselation.
+##	Each cache file is named after a hash of these inputs, and is read using
+##	mmap.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-15	     Version 4: single runs back to qhull order
+##	17-11-15	     Version 3: vertices in canonical order
+##	17-11-15	     Every index of a cache file checked before use
+##	17-10-30	     Native Delaunay engine gets its own key
+##	17-10-28	     Version 2: no more qhull id translation table
+##	17-10-28	     Partitioned tesselations get their own key
+##	17-10-27	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+static void get_vcache_path(char *path, const char *dir, uint64_t key) ;
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t n) ;
+static int is_vcache_valid(s_vcache_header *head, size_t size, s_pdb *pdb,
+						   uint64_t key) ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vvertices_key
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the cache key of a structure: a 64 bits FNV-1a hash of the index,
+	coordinates and electronegativity of each heavy atom, and of the alpha
+	sphere parameters. Partitioned tesselations and the native engine give
+	vertices in another order than a single qhull run, so each variant is
+	stored under another key.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb          : PDB informations
+	@ int min_apol_neigh  : Number of apolar neighbor of a vertice to be
+							considered as apolar
+	@ float asph_min_size : Minimum size of voronoi vertices to retain
+	@ float asph_max_size : Maximum size of voronoi vertices to retain
+	@ int variant         : 0 for a single qhull run, + 1 if vertices come
+							from load_vvertices_part, + 2 if they come from
+							the native Delaunay engine
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	uint64_t: the key
+   -----------------------------------------------------------------------------
+*/
+uint64_t get_vvertices_key(s_pdb *pdb, int min_apol_neigh, float asph_min_size,
+						   float asph_max_size, int variant)
+{
+	int i, version = M_VCACHE_VERSION ;
+	s_atm *ca = NULL ;
+	uint64_t h = 14695981039346656037ULL ;
+
+	h = hash_bytes(h, &version, sizeof(int)) ;
+	h = hash_bytes(h, &min_apol_neigh, sizeof(int)) ;
+	h = hash_bytes(h, &variant, sizeof(int)) ;
+	h = hash_bytes(h, &asph_min_size, sizeof(float)) ;
+	h = hash_bytes(h, &asph_max_size, sizeof(float)) ;
+	h = hash_bytes(h, &(pdb->natoms), sizeof(int)) ;
+
+	for(i = 0 ; i < pdb->natoms ; i++) {
+		ca = pdb->latoms + i ;
+		if(strcmp(ca->symbol, "H")) {
+			h = hash_bytes(h, &i, sizeof(int)) ;
+			h = hash_bytes(h, &(ca->x), sizeof(float)) ;
+			h = hash_bytes(h, &(ca->y), sizeof(float)) ;
+			h = hash_bytes(h, &(ca->z), sizeof(float)) ;
+			h = hash_bytes(h, &(ca->electroneg), sizeof(float)) ;
+		}
+	}
+
+	return h ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	read_vvertices_cache
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Load the vertices of a structure from the cache, if present. The file is
+	mapped in memory and checked (see is_vcache_valid) before use; any
+	mismatch rejects the file, and the caller then tesselates again.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *dir : Cache directory
+	@ s_pdb *pdb      : PDB informations
+	@ uint64_t key    : Key of the structure (see get_vvertices_key)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_lst_vvertice *: The vertices, NULL if not in the cache or invalid.
+   -----------------------------------------------------------------------------
+*/
+s_lst_vvertice* read_vvertices_cache(const char *dir, s_pdb *pdb, uint64_t key)
+{
+	int i, j, fd ;
+	char path[M_VCACHE_PATH_LEN] ;
+	struct stat st ;
+	s_vcache_header *head = NULL ;
+	s_vcache_vert *cv = NULL ;
+	s_vvertice *v = NULL ;
+	s_lst_vvertice *lvvert = NULL ;
+
+	get_vcache_path(path, dir, key) ;
+	fd = open(path, O_RDONLY) ;
+	if(fd < 0) return NULL ;
+
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(s_vcache_header)) {
+		close(fd) ;
+		return NULL ;
+	}
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+	close(fd) ;
+	if(map == MAP_FAILED) return NULL ;
+
+	head = (s_vcache_header *) map ;
+	if(!is_vcache_valid(head, (size_t) st.st_size, pdb, key)) {
+		munmap(map, st.st_size) ;
+		return NULL ;
+	}
+	int *h_tr = (int *) (head + 1) ;
+	cv = (s_vcache_vert *) (h_tr + head->n_h_tr) ;
+
+	lvvert = (s_lst_vvertice *) my_malloc(sizeof(s_lst_vvertice)) ;
+	lvvert->n_h_tr = head->n_h_tr ;
+	lvvert->nvert = head->nvert ;
+	lvvert->qhullSize = head->qhullSize ;
+	lvvert->h_tr = (int *) my_malloc((head->n_h_tr > 0 ? head->n_h_tr : 1)*sizeof(int)) ;
+	lvvert->vertices = (s_vvertice *) my_calloc(head->nvert > 0 ? head->nvert : 1, sizeof(s_vvertice)) ;
+	lvvert->pvertices = (s_vvertice **) my_calloc(head->nvert > 0 ? head->nvert : 1, sizeof(s_vvertice*)) ;
+
+	memcpy(lvvert->h_tr, h_tr, (size_t) head->n_h_tr*sizeof(int)) ;
+
+	for(i = 0 ; i < head->nvert ; i++) {
+		v = lvvert->vertices + i ;
+		v->x = cv[i].x ; v->y = cv[i].y ; v->z = cv[i].z ;
+		v->ray = cv[i].ray ;
+		v->id = cv[i].id ;
+		v->qhullId = cv[i].qhullId ;
+		v->type = cv[i].type ;
+		for(j = 0 ; j < 4 ; j++) {
+			v->vneigh[j] = cv[i].vneigh[j] ;
+			v->neigh[j] = pdb->latoms + cv[i].neigh[j] ;
+		}
+		v->seen = 0 ;
+		v->sort_x = -1 ;
+		v->apol_neighbours = 0 ;
+		v->resid = -1 ;
+		set_barycenter(v) ;
+
+		lvvert->pvertices[i] = v ;
+	}
+
+	munmap(map, st.st_size) ;
+
+	return lvvert ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	is_vcache_valid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Check a mapped cache file before using it: header, file size, heavy atom
+	indexes, atoms contacted by each vertice, qhull ids (increasing, as
+	get_vert_idx does a binary search on them) and links between vertices.
+	Sizes are computed in size_t from the checked counts.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vcache_header *head : The mapped file
+	@ size_t size           : Size of the file
+	@ s_pdb *pdb            : PDB informations
+	@ uint64_t key          : Expected key
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if the file can be used, 0 if not.
+   -----------------------------------------------------------------------------
+*/
+static int is_vcache_valid(s_vcache_header *head, size_t size, s_pdb *pdb,
+						   uint64_t key)
+{
+	int i, j, prev = -1 ;
+
+	if(memcmp(head->magic, M_VCACHE_MAGIC, 4) != 0
+	   || head->version != M_VCACHE_VERSION || head->key != key
+	   || head->natoms != pdb->natoms
+	   || head->n_h_tr < 0 || head->n_h_tr > head->natoms
+	   || head->nvert < 0 || head->qhullSize < head->nvert) return 0 ;
+
+	if(size != sizeof(s_vcache_header)
+			 + (size_t) head->n_h_tr*sizeof(int)
+			 + (size_t) head->nvert*sizeof(s_vcache_vert)) return 0 ;
+
+	int *h_tr = (int *) (head + 1) ;
+	s_vcache_vert *cv = (s_vcache_vert *) (h_tr + head->n_h_tr) ;
+
+	for(i = 0 ; i < head->n_h_tr ; i++) {
+		if(h_tr[i] < 0 || h_tr[i] >= head->natoms) return 0 ;
+	}
+	for(i = 0 ; i < head->nvert ; i++) {
+		if(cv[i].qhullId <= prev || cv[i].qhullId >= head->qhullSize) return 0 ;
+		prev = cv[i].qhullId ;
+
+		for(j = 0 ; j < 4 ; j++) {
+			if(cv[i].neigh[j] < 0 || cv[i].neigh[j] >= head->natoms
+			   || cv[i].vneigh[j] < 0 || cv[i].vneigh[j] >= head->qhullSize) {
+				return 0 ;
+			}
+		}
+	}
+
+	return 1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	write_vvertices_cache
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Store the vertices of a structure in the cache. The file is first written
+	under a temporary name, then renamed, so concurrent fpocket processes
+	never read a partial file.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *dir        : Cache directory
+	@ s_pdb *pdb             : PDB informations
+	@ uint64_t key           : Key of the structure (see get_vvertices_key)
+	@ s_lst_vvertice *lvvert : Vertices to store
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 0 if the file has been written, 1 if not.
+   -----------------------------------------------------------------------------
+*/
+int write_vvertices_cache(const char *dir, s_pdb *pdb, uint64_t key,
+						  s_lst_vvertice *lvvert)
+{
+	int i, j, status = 0 ;
+	char path[M_VCACHE_PATH_LEN],
+		 tmp[M_VCACHE_PATH_LEN + 32] ;
+	s_vcache_header head ;
+	s_vcache_vert cv ;
+	s_vvertice *v = NULL ;
+
+	get_vcache_path(path, dir, key) ;
+	snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int) getpid()) ;
+
+	FILE *f = fopen(tmp, "wb") ;
+	if(f == NULL) return 1 ;
+
+	memset(&head, 0, sizeof(s_vcache_header)) ;
+	memcpy(head.magic, M_VCACHE_MAGIC, 4) ;
+	head.version = M_VCACHE_VERSION ;
+	head.key = key ;
+	head.natoms = pdb->natoms ;
+	head.n_h_tr = lvvert->n_h_tr ;
+	head.nvert = lvvert->nvert ;
+	head.qhullSize = lvvert->qhullSize ;
+
+	if(fwrite(&head, sizeof(s_vcache_header), 1, f) != 1) status = 1 ;
+	if(fwrite(lvvert->h_tr, sizeof(int), lvvert->n_h_tr, f)
+	   != (size_t) lvvert->n_h_tr) status = 1 ;
+
+	for(i = 0 ; i < lvvert->nvert && status == 0 ; i++) {
+		v = lvvert->vertices + i ;
+		memset(&cv, 0, sizeof(s_vcache_vert)) ;
+		cv.x = v->x ; cv.y = v->y ; cv.z = v->z ;
+		cv.ray = v->ray ;
+		cv.id = v->id ;
+		cv.qhullId = v->qhullId ;
+		cv.type = v->type ;
+		for(j = 0 ; j < 4 ; j++) {
+			cv.vneigh[j] = v->vneigh[j] ;
+			cv.neigh[j] = v->neigh[j] - pdb->latoms ;
+		}
+		if(fwrite(&cv, sizeof(s_vcache_vert), 1, f) != 1) status = 1 ;
+	}
+
+	if(fclose(f) != 0) status = 1 ;
+	if(status == 0 && rename(tmp, path) != 0) status = 1 ;
+	if(status != 0) remove(tmp) ;
+
+	return status ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vcache_path
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Path of the cache file of a given key.
+   -----------------------------------------------------------------------------
+*/
+static void get_vcache_path(char *path, const char *dir, uint64_t key)
+{
+	snprintf(path, M_VCACHE_PATH_LEN, "%s/%016llx%s", dir,
+			 (unsigned long long) key, M_VCACHE_EXT) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	hash_bytes
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Update a FNV-1a hash with the given bytes.
+   -----------------------------------------------------------------------------
+*/
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t n)
+{
+	size_t i ;
+	const unsigned char *b = (const unsigned char *) data ;
+
+	for(i = 0 ; i < n ; i++) {
+		h ^= b[i] ;
+		h *= 1099511628211ULL ;
+	}
+
+	return h ;
+}
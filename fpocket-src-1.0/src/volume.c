@@ -0,0 +1,942 @@
+#include "../headers/volume.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					volume.c
+## LAST MODIFIED			17-11-07
+##
+## ----- SPECIFICATIONS
+##
+##	Volume of unions of spheres (alpha spheres of a pocket, atoms of a
+##	ligand), shared by all volume functions (see get_verts_volume_ptr,
+##	get_mol_volume_ptr, set_pocket_mtvolume, set_pocket_volume and the
+##	overlap volumes of tpocket).
+##
+##	With the grid engine, spheres are rasterised in a regular grid of cubic
+##	voxels: a voxel belongs to a sphere if its center is inside it. Each
+##	object is a bitset over the voxels, a sphere being filled row by row
+##	along x, 64 voxels per word written. Volumes of each object, of their
+##	union and of their overlap are then popcounts of the bitsets (or of
+##	their bitwise or / and).
+##	The result does not depend on random numbers. The size of the voxels is
+##	given by the precision asked for the former methods: the number of
+##	Monte Carlo iterations (-v) or the division of the box (-b).
+##
+##	With the exact engine, the volume of a union of spheres is the sum over
+##	the spheres of their part inside their own cell of the power diagram,
+##	computed analytically: there is no precision parameter, and the
+##	overlap of two unions is given by the volume of each and of their
+##	union.
+##
+##	The Monte Carlo engine is the original one, kept in each function.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-11-07	     Exact engine (power diagram)
+##	17-11-06	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+/* Convex cell of the power diagram, in coordinates centered on its sphere */
+typedef struct s_pcell
+{
+	double *pl,				/* Plane of each face: outer normal and offset */
+		   *v,				/* Vertices of the faces, counterclockwise */
+		   *cap,			/* Points and angles of the new face when clipping */
+		   radius ;			/* Largest distance of a vertex to the center */
+	int *fs,				/* First vertex of each face */
+		*fn,				/* Number of vertices of each face */
+		nf, nv,
+		capf, capv ;
+
+} s_pcell ;
+
+static void set_vgrid_span(uint64_t *row, int i0, int i1) ;
+static size_t get_bits_count(uint64_t *bits, size_t nword) ;
+static int cmp_plane_offset(const void *a, const void *b) ;
+static void init_pcell(s_pcell *c) ;
+static void free_pcell(s_pcell *c) ;
+static void set_pcell_cube(s_pcell *c, double l) ;
+static void set_pcell_capacity(s_pcell *c, int nf, int nv) ;
+static int clip_pcell(s_pcell *c, s_pcell *tmp, double *m, double eps) ;
+static int sort_pcell_cap(double *pts, double *ang, int n, double *m, double eps) ;
+static double get_pcell_volume(s_pcell *c, double r) ;
+static double get_cone_volume(double h, double d, double t, double r) ;
+static double get_triangle_solid_angle(double h, double d, double t) ;
+
+/* Engine used by the volume functions */
+static int ST_volume_engine = M_VOLUME_GRID ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_volume_engine
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Set the engine used to compute the volume of unions of spheres by all
+	volume functions: M_VOLUME_MC (original Monte Carlo or regular sampling),
+	M_VOLUME_GRID (bitset grid, see alloc_vgrid) or M_VOLUME_EXACT (power
+	diagram, see get_spheres_volume_exact).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int engine : The engine
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_volume_engine(int engine)
+{
+	ST_volume_engine = engine ;
+}
+
+int get_volume_engine(void)
+{
+	return ST_volume_engine ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_spheres_bbox
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Box containing a list of spheres, or extend a box to contain them.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *xyzr  : x, y, z and radius of each sphere
+	@ int n        : Number of spheres
+	@ float *bmin  : OUTPUT: Lower corner of the box
+	@ float *bmax  : OUTPUT: Upper corner of the box
+	@ int extend   : 1 to extend the box given, 0 to start a new one
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_spheres_bbox(float *xyzr, int n, float *bmin, float *bmax, int extend)
+{
+	int i, k ;
+
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) {
+			if((i == 0 && !extend) || xyzr[4*i+k] - xyzr[4*i+3] < bmin[k]) {
+				bmin[k] = xyzr[4*i+k] - xyzr[4*i+3] ;
+			}
+			if((i == 0 && !extend) || xyzr[4*i+k] + xyzr[4*i+3] > bmax[k]) {
+				bmax[k] = xyzr[4*i+k] + xyzr[4*i+3] ;
+			}
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	alloc_vgrid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Allocate an empty grid over a box, for nobj objects. The size of the
+	voxels is given by the precision of the former methods:
+		- if idiscret > 0, the largest side of the box is divided in
+		  idiscret voxels (regular sampling of the box);
+		- otherwise, the box holds M_VGRID_VOXELS_PER_ITER voxels per Monte
+		  Carlo iteration asked (niter).
+	Voxels are not smaller than M_VGRID_MIN_STEP, and the grid not larger
+	than M_VGRID_MAX_VOXELS.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *bmin, *bmax : The box
+	@ int niter          : Number of Monte Carlo iterations
+	@ int idiscret       : Division of the box, or 0
+	@ int nobj           : Number of objects (<= M_VGRID_NOBJ)
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_vgrid*: The grid
+   -----------------------------------------------------------------------------
+*/
+s_vgrid* alloc_vgrid(float *bmin, float *bmax, int niter, int idiscret, int nobj)
+{
+	int k ;
+	float side[3], smax = 0.0 ;
+	double nvox ;
+	s_vgrid *g = (s_vgrid *) my_malloc(sizeof(s_vgrid)) ;
+
+	for(k = 0 ; k < 3 ; k++) {
+		side[k] = (bmax[k] > bmin[k]) ? bmax[k] - bmin[k] : 0.0 ;
+		if(side[k] > smax) smax = side[k] ;
+		g->min[k] = bmin[k] ;
+	}
+
+	if(idiscret > 0) g->step = smax / (float) idiscret ;
+	else {
+		g->step = cbrt((double)side[0]*side[1]*side[2]
+					   / ((double)(niter > 0 ? niter : 1)*M_VGRID_VOXELS_PER_ITER)) ;
+	}
+	if(g->step < M_VGRID_MIN_STEP) g->step = M_VGRID_MIN_STEP ;
+
+	do {
+		for(k = 0, nvox = 1.0 ; k < 3 ; k++) {
+			g->n[k] = (int) ceil(side[k] / g->step) ;
+			if(g->n[k] < 1) g->n[k] = 1 ;
+			nvox *= g->n[k] ;
+		}
+		if(nvox > M_VGRID_MAX_VOXELS) g->step *= 1.25 ;
+	} while(nvox > M_VGRID_MAX_VOXELS) ;
+
+	g->nw = (g->n[0] + 63) / 64 ;
+	g->nword = (size_t) g->nw * g->n[1] * g->n[2] ;
+	g->nobj = (nobj < M_VGRID_NOBJ) ? nobj : M_VGRID_NOBJ ;
+	for(k = 0 ; k < M_VGRID_NOBJ ; k++) {
+		g->bits[k] = (k < g->nobj) ? (uint64_t *) my_calloc(g->nword, sizeof(uint64_t)) : NULL ;
+	}
+
+	return g ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	add_vgrid_spheres
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Add spheres to an object of the grid: for each row of voxels along x
+	crossing a sphere, the span of voxels whose center is inside the sphere
+	is set.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vgrid *g  : The grid
+	@ int obj     : The object
+	@ float *xyzr : x, y, z and radius of each sphere
+	@ int n       : Number of spheres
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void add_vgrid_spheres(s_vgrid *g, int obj, float *xyzr, int n)
+{
+	int s, i0, i1, j, j0, j1, k, k0, k1 ;
+	float x, y, z, r, dy, dz, rz, h,
+		  inv = 1.0 / g->step ;
+
+	if(obj < 0 || obj >= g->nobj) return ;
+
+	for(s = 0 ; s < n ; s++) {
+		x = xyzr[4*s] - g->min[0] ;
+		y = xyzr[4*s+1] - g->min[1] ;
+		z = xyzr[4*s+2] - g->min[2] ;
+		r = xyzr[4*s+3] ;
+
+		/* Voxels whose center is in [c - r, c + r] along y and z */
+		k0 = (int) ceil((z - r)*inv - 0.5) ; if(k0 < 0) k0 = 0 ;
+		k1 = (int) floor((z + r)*inv - 0.5) ; if(k1 >= g->n[2]) k1 = g->n[2] - 1 ;
+		j0 = (int) ceil((y - r)*inv - 0.5) ; if(j0 < 0) j0 = 0 ;
+		j1 = (int) floor((y + r)*inv - 0.5) ; if(j1 >= g->n[1]) j1 = g->n[1] - 1 ;
+
+		for(k = k0 ; k <= k1 ; k++) {
+			dz = (k + 0.5)*g->step - z ;
+			rz = r*r - dz*dz ;
+			if(rz <= 0.0) continue ;
+
+			for(j = j0 ; j <= j1 ; j++) {
+				dy = (j + 0.5)*g->step - y ;
+				if(rz - dy*dy <= 0.0) continue ;
+
+				h = sqrt(rz - dy*dy) ;
+				i0 = (int) ceil((x - h)*inv - 0.5) ; if(i0 < 0) i0 = 0 ;
+				i1 = (int) floor((x + h)*inv - 0.5) ; if(i1 >= g->n[0]) i1 = g->n[0] - 1 ;
+				if(i0 <= i1) {
+					set_vgrid_span(g->bits[obj] + ((size_t)k*g->n[1] + j)*g->nw, i0, i1) ;
+				}
+			}
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_vgrid_span
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Set bits i0 to i1 (included) of a row: partial first and last words are
+	masked, words between them are written whole.
+   -----------------------------------------------------------------------------
+*/
+static void set_vgrid_span(uint64_t *row, int i0, int i1)
+{
+	int w,
+		w0 = i0 >> 6,
+		w1 = i1 >> 6 ;
+	uint64_t m0 = ~((uint64_t) 0) << (i0 & 63),
+			 m1 = ~((uint64_t) 0) >> (63 - (i1 & 63)) ;
+
+	if(w0 == w1) {
+		row[w0] |= m0 & m1 ;
+		return ;
+	}
+
+	row[w0] |= m0 ;
+	for(w = w0 + 1 ; w < w1 ; w++) row[w] = ~((uint64_t) 0) ;
+	row[w1] |= m1 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vgrid_volumes
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Volumes given by a grid: volume of each object, of the union of all
+	objects, and of the overlap of the first two objects (0 if less than
+	two objects). Any output may be NULL.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vgrid *g       : The grid
+	@ float *vol       : OUTPUT: Volume of each object
+	@ float *vunion    : OUTPUT: Volume of the union of the objects
+	@ float *voverlap  : OUTPUT: Volume of the overlap of objects 0 and 1
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void get_vgrid_volumes(s_vgrid *g, float *vol, float *vunion, float *voverlap)
+{
+	int k ;
+	size_t w, nu = 0, no = 0 ;
+	uint64_t u ;
+	double vvox = (double) g->step * g->step * g->step ;
+
+	if(vol) {
+		for(k = 0 ; k < g->nobj ; k++) {
+			vol[k] = (float) (get_bits_count(g->bits[k], g->nword) * vvox) ;
+		}
+	}
+
+	if(vunion || voverlap) {
+		for(w = 0 ; w < g->nword ; w++) {
+			for(k = 0, u = 0 ; k < g->nobj ; k++) u |= g->bits[k][w] ;
+			nu += __builtin_popcountll(u) ;
+			if(g->nobj > 1) no += __builtin_popcountll(g->bits[0][w] & g->bits[1][w]) ;
+		}
+		if(vunion) *vunion = (float) (nu * vvox) ;
+		if(voverlap) *voverlap = (float) (no * vvox) ;
+	}
+}
+
+static size_t get_bits_count(uint64_t *bits, size_t nword)
+{
+	size_t w, n = 0 ;
+
+	for(w = 0 ; w < nword ; w++) n += __builtin_popcountll(bits[w]) ;
+
+	return n ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	free_vgrid
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Free a grid.
+   -----------------------------------------------------------------------------
+*/
+void free_vgrid(s_vgrid *g)
+{
+	int k ;
+
+	if(g) {
+		for(k = 0 ; k < g->nobj ; k++) my_free(g->bits[k]) ;
+		my_free(g) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_spheres_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Volume of a union of spheres, computed on a grid (see alloc_vgrid for
+	the precision), or exactly with the exact engine (niter and idiscret
+	are then ignored).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *xyzr   : x, y, z and radius of each sphere
+	@ int n         : Number of spheres
+	@ int niter     : Number of Monte Carlo iterations
+	@ int idiscret  : Division of the box, or 0
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The volume
+   -----------------------------------------------------------------------------
+*/
+float get_spheres_volume(float *xyzr, int n, int niter, int idiscret)
+{
+	float bmin[3], bmax[3], vol = 0.0 ;
+
+	if(n <= 0) return 0.0 ;
+	if(ST_volume_engine == M_VOLUME_EXACT) return get_spheres_volume_exact(xyzr, n) ;
+
+	set_spheres_bbox(xyzr, n, bmin, bmax, 0) ;
+	s_vgrid *g = alloc_vgrid(bmin, bmax, niter, idiscret, 1) ;
+	add_vgrid_spheres(g, 0, xyzr, n) ;
+	get_vgrid_volumes(g, &vol, NULL, NULL) ;
+	free_vgrid(g) ;
+
+	return vol ;
+}
+
+/**
+ ================================================================================
+ ================================================================================
+
+	EXACT VOLUME OF A UNION OF SPHERES (power diagram)
+
+ ================================================================================
+ ================================================================================
+*/
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_spheres_volume_exact
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Exact volume of a union of spheres. The power diagram of the spheres
+	splits the union into the parts of each sphere lying in its own power
+	cell, so the volume is the sum over the spheres of the volume of the
+	sphere clipped by its cell. The cell of a sphere is built by clipping a
+	cube around the sphere by the radical planes shared with the spheres
+	overlapping it (found with a cell list), and its volume inside the
+	sphere is computed analytically (see get_pcell_volume).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ float *xyzr   : x, y, z and radius of each sphere
+	@ int n         : Number of spheres
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	float: The volume
+   -----------------------------------------------------------------------------
+*/
+float get_spheres_volume_exact(float *xyzr, int n)
+{
+	int i, j, k, cx, cy, cz, nc[3], ncell, nneigh, maxneigh, empty,
+		*head = NULL, *next = NULL, *cell = NULL ;
+	float bmin[3], bmax[3], rmax = 0.0 ;
+	double cs, vol = 0.0, d2, dd, h, ri, rj, u[3] ;
+
+	if(n <= 0) return 0.0 ;
+
+	/* Cell list: spheres overlapping each other are in adjacent cells */
+	set_spheres_bbox(xyzr, n, bmin, bmax, 0) ;
+	for(i = 0 ; i < n ; i++) if(xyzr[4*i+3] > rmax) rmax = xyzr[4*i+3] ;
+	cs = (rmax > 0.0) ? 2.0*rmax : 1.0 ;
+	do {
+		for(k = 0, ncell = 1 ; k < 3 ; k++) {
+			nc[k] = (int) ((bmax[k] - bmin[k]) / cs) + 1 ;
+			ncell *= nc[k] ;
+		}
+		if(ncell > 8*n + 64) cs *= 1.5 ;
+	} while(ncell > 8*n + 64) ;
+
+	head = (int *) my_malloc(ncell*sizeof(int)) ;
+	next = (int *) my_malloc(n*sizeof(int)) ;
+	cell = (int *) my_malloc(3*n*sizeof(int)) ;
+	for(i = 0 ; i < ncell ; i++) head[i] = -1 ;
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) {
+			cell[3*i+k] = (int) ((xyzr[4*i+k] - bmin[k]) / cs) ;
+			if(cell[3*i+k] >= nc[k]) cell[3*i+k] = nc[k] - 1 ;
+		}
+		j = (cell[3*i+2]*nc[1] + cell[3*i+1])*nc[0] + cell[3*i] ;
+		next[i] = head[j] ;
+		head[j] = i ;
+	}
+
+	maxneigh = 64 ;
+	double *planes = (double *) my_malloc(4*maxneigh*sizeof(double)) ;
+	s_pcell c, tmp ;
+	init_pcell(&c) ;
+	init_pcell(&tmp) ;
+
+	for(i = 0 ; i < n ; i++) {
+		ri = xyzr[4*i+3] ;
+		if(ri <= 0.0) continue ;
+
+		/* Radical planes cutting the sphere, in coordinates centered on it */
+		nneigh = 0 ;
+		empty = 0 ;
+		for(cz = cell[3*i+2] - 1 ; cz <= cell[3*i+2] + 1 && !empty ; cz++) {
+			if(cz < 0 || cz >= nc[2]) continue ;
+			for(cy = cell[3*i+1] - 1 ; cy <= cell[3*i+1] + 1 && !empty ; cy++) {
+				if(cy < 0 || cy >= nc[1]) continue ;
+				for(cx = cell[3*i] - 1 ; cx <= cell[3*i] + 1 && !empty ; cx++) {
+					if(cx < 0 || cx >= nc[0]) continue ;
+					for(j = head[(cz*nc[1] + cy)*nc[0] + cx] ; j >= 0 ; j = next[j]) {
+						if(j == i) continue ;
+						rj = xyzr[4*j+3] ;
+						for(k = 0, d2 = 0.0 ; k < 3 ; k++) {
+							u[k] = (double) xyzr[4*j+k] - xyzr[4*i+k] ;
+							d2 += u[k]*u[k] ;
+						}
+						if(d2 >= (ri + rj)*(ri + rj)) continue ;
+
+						dd = sqrt(d2) ;
+						if(dd <= M_VEXACT_EPS*ri) {
+							/* Same center: the largest sphere (or the first
+							 * one) gets the whole volume */
+							if(rj > ri || (rj == ri && j < i)) empty = 1 ;
+							if(empty) break ;
+							continue ;
+						}
+						h = (d2 + ri*ri - rj*rj) / (2.0*dd) ;
+						if(h >= ri) continue ;
+						if(h <= -ri) {
+							empty = 1 ;
+							break ;
+						}
+
+						if(nneigh >= maxneigh) {
+							maxneigh *= 2 ;
+							planes = (double *) my_realloc(planes, 4*maxneigh*sizeof(double)) ;
+						}
+						for(k = 0 ; k < 3 ; k++) planes[4*nneigh+k] = u[k] / dd ;
+						planes[4*nneigh+3] = h ;
+						nneigh++ ;
+					}
+				}
+			}
+		}
+		if(empty) continue ;
+
+		/* Closest planes first: the cell shrinks quickly and farther planes
+		 * are then discarded by the radius of the cell */
+		qsort(planes, nneigh, 4*sizeof(double), cmp_plane_offset) ;
+
+		set_pcell_cube(&c, ri) ;
+		for(j = 0 ; j < nneigh && !empty ; j++) {
+			if(planes[4*j+3] >= c.radius) continue ;
+			empty = !clip_pcell(&c, &tmp, planes + 4*j, M_VEXACT_EPS*ri) ;
+		}
+		if(!empty) vol += get_pcell_volume(&c, ri) ;
+	}
+
+	free_pcell(&c) ;
+	free_pcell(&tmp) ;
+	my_free(planes) ;
+	my_free(head) ;
+	my_free(next) ;
+	my_free(cell) ;
+
+	return (float) vol ;
+}
+
+static int cmp_plane_offset(const void *a, const void *b)
+{
+	double ha = ((const double *) a)[3],
+		   hb = ((const double *) b)[3] ;
+
+	return (ha > hb) - (ha < hb) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	init_pcell, free_pcell, set_pcell_cube
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Allocation of a convex cell, and cube of half side l centered on the
+	origin (faces counterclockwise seen from outside).
+   -----------------------------------------------------------------------------
+*/
+static void init_pcell(s_pcell *c)
+{
+	c->capf = 64 ;
+	c->capv = 512 ;
+	c->pl = (double *) my_malloc(4*c->capf*sizeof(double)) ;
+	c->fs = (int *) my_malloc(c->capf*sizeof(int)) ;
+	c->fn = (int *) my_malloc(c->capf*sizeof(int)) ;
+	c->v = (double *) my_malloc(3*c->capv*sizeof(double)) ;
+	c->cap = (double *) my_malloc(4*2*c->capf*sizeof(double)) ;
+	c->nf = c->nv = 0 ;
+	c->radius = 0.0 ;
+}
+
+static void free_pcell(s_pcell *c)
+{
+	my_free(c->pl) ;
+	my_free(c->fs) ;
+	my_free(c->fn) ;
+	my_free(c->v) ;
+	my_free(c->cap) ;
+}
+
+static void set_pcell_cube(s_pcell *c, double l)
+{
+	int a, s, k, f = 0 ;
+	double q[4][2] = {{-1.0, -1.0}, {1.0, -1.0}, {1.0, 1.0}, {-1.0, 1.0}} ;
+
+	c->nv = 0 ;
+	for(a = 0 ; a < 3 ; a++) {
+		for(s = 1 ; s >= -1 ; s -= 2, f++) {
+			c->pl[4*f] = c->pl[4*f+1] = c->pl[4*f+2] = 0.0 ;
+			c->pl[4*f+a] = s ;
+			c->pl[4*f+3] = l ;
+			c->fs[f] = c->nv ;
+			c->fn[f] = 4 ;
+
+			/* (a+1, a+2) is direct around axis a: reversed for the face -a */
+			for(k = 0 ; k < 4 ; k++) {
+				double *p = c->v + 3*c->nv++,
+					   *qk = q[(s > 0) ? k : 3 - k] ;
+				p[a] = s*l ;
+				p[(a+1)%3] = qk[0]*l ;
+				p[(a+2)%3] = qk[1]*l ;
+			}
+		}
+	}
+	c->nf = 6 ;
+	c->radius = sqrt(3.0)*l ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	clip_pcell
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Clip a convex cell by the half space m.x <= h: each face is clipped
+	(vertices closer than eps from the plane are kept as they are), and the
+	points of the faces lying on the plane close the cell with a new face,
+	sorted counterclockwise around m. The radius of the cell (largest
+	distance of a vertex from the origin) is updated.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pcell *c   : The cell (updated)
+	@ s_pcell *tmp : Working cell (swapped with c)
+	@ double *m    : Unit normal and offset of the plane
+	@ double eps   : Tolerance
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 0 if the cell is empty, 1 else
+   -----------------------------------------------------------------------------
+*/
+static int clip_pcell(s_pcell *c, s_pcell *tmp, double *m, double eps)
+{
+	int f, k, kn, nout = 0, nin = 0, ncap, nf, ia, ib ;
+	double sa, sb, t, *a, *b, *p, r2 ;
+
+	for(k = 0 ; k < c->nv ; k++) {
+		sa = m[0]*c->v[3*k] + m[1]*c->v[3*k+1] + m[2]*c->v[3*k+2] - m[3] ;
+		if(sa > eps) nout++ ;
+		else if(sa < -eps) nin++ ;
+	}
+	if(nout == 0) return 1 ;
+	if(nin == 0) return 0 ;
+
+	/* Each face gets at most one more vertex, the new face one per face */
+	set_pcell_capacity(tmp, c->nf + 1, c->nv + 3*c->nf + 4) ;
+	tmp->nf = tmp->nv = 0 ;
+	ncap = 0 ;
+	double *cap = tmp->cap ;
+
+	for(f = 0 ; f < c->nf ; f++) {
+		tmp->fs[tmp->nf] = tmp->nv ;
+		for(k = 0 ; k < c->fn[f] ; k++) {
+			kn = (k + 1 == c->fn[f]) ? 0 : k + 1 ;
+			a = c->v + 3*(c->fs[f] + k) ;
+			b = c->v + 3*(c->fs[f] + kn) ;
+			sa = m[0]*a[0] + m[1]*a[1] + m[2]*a[2] - m[3] ;
+			sb = m[0]*b[0] + m[1]*b[1] + m[2]*b[2] - m[3] ;
+			ia = (sa > eps) ? 1 : ((sa < -eps) ? -1 : 0) ;
+			ib = (sb > eps) ? 1 : ((sb < -eps) ? -1 : 0) ;
+
+			if(ia <= 0) {
+				p = tmp->v + 3*tmp->nv++ ;
+				p[0] = a[0] ; p[1] = a[1] ; p[2] = a[2] ;
+				if(ia == 0 && ncap < 2*(c->nf + 1)) {
+					memcpy(cap + 3*ncap++, p, 3*sizeof(double)) ;
+				}
+			}
+			if(ia*ib < 0) {
+				t = sa / (sa - sb) ;
+				p = tmp->v + 3*tmp->nv++ ;
+				p[0] = a[0] + t*(b[0] - a[0]) ;
+				p[1] = a[1] + t*(b[1] - a[1]) ;
+				p[2] = a[2] + t*(b[2] - a[2]) ;
+				if(ncap < 2*(c->nf + 1)) memcpy(cap + 3*ncap++, p, 3*sizeof(double)) ;
+			}
+		}
+		tmp->fn[tmp->nf] = tmp->nv - tmp->fs[tmp->nf] ;
+		if(tmp->fn[tmp->nf] >= 3) {
+			memcpy(tmp->pl + 4*tmp->nf, c->pl + 4*f, 4*sizeof(double)) ;
+			tmp->nf++ ;
+		}
+		else tmp->nv = tmp->fs[tmp->nf] ;
+	}
+
+	nf = tmp->nf ;
+	ncap = sort_pcell_cap(cap, cap + 3*2*tmp->capf, ncap, m, eps) ;
+	if(ncap >= 3) {
+		tmp->fs[nf] = tmp->nv ;
+		tmp->fn[nf] = ncap ;
+		memcpy(tmp->pl + 4*nf, m, 4*sizeof(double)) ;
+		memcpy(tmp->v + 3*tmp->nv, cap, 3*ncap*sizeof(double)) ;
+		tmp->nv += ncap ;
+		tmp->nf++ ;
+	}
+
+	tmp->radius = 0.0 ;
+	for(k = 0 ; k < tmp->nv ; k++) {
+		r2 = tmp->v[3*k]*tmp->v[3*k] + tmp->v[3*k+1]*tmp->v[3*k+1]
+			 + tmp->v[3*k+2]*tmp->v[3*k+2] ;
+		if(r2 > tmp->radius) tmp->radius = r2 ;
+	}
+	tmp->radius = sqrt(tmp->radius) ;
+
+	s_pcell swap = *c ;
+	*c = *tmp ;
+	*tmp = swap ;
+
+	return c->nf >= 4 ;
+}
+
+static void set_pcell_capacity(s_pcell *c, int nf, int nv)
+{
+	if(nf > c->capf) {
+		c->capf = 2*nf ;
+		c->pl = (double *) my_realloc(c->pl, 4*c->capf*sizeof(double)) ;
+		c->fs = (int *) my_realloc(c->fs, c->capf*sizeof(int)) ;
+		c->fn = (int *) my_realloc(c->fn, c->capf*sizeof(int)) ;
+		c->cap = (double *) my_realloc(c->cap, 4*2*c->capf*sizeof(double)) ;
+	}
+	if(nv > c->capv) {
+		c->capv = 2*nv ;
+		c->v = (double *) my_realloc(c->v, 3*c->capv*sizeof(double)) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	sort_pcell_cap
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Sort points of a plane of normal m counterclockwise around their center,
+	and remove duplicates (points closer than eps). ang is a buffer of n
+	angles.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: Number of points left
+   -----------------------------------------------------------------------------
+*/
+static int sort_pcell_cap(double *pts, double *ang, int n, double *m, double eps)
+{
+	int i, j, k ;
+	double c[3] = {0.0, 0.0, 0.0}, u[3], w[3], x[3], len, tmp[4] ;
+
+	if(n < 3) return n ;
+
+	for(i = 0 ; i < n ; i++) for(k = 0 ; k < 3 ; k++) c[k] += pts[3*i+k] / n ;
+
+	/* Basis (u, w) of the plane, with u x w = m */
+	if(fabs(m[0]) < 0.6) { u[0] = 0.0 ; u[1] = m[2] ; u[2] = -m[1] ; }
+	else { u[0] = m[1] ; u[1] = -m[0] ; u[2] = 0.0 ; }
+	len = sqrt(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]) ;
+	for(k = 0 ; k < 3 ; k++) u[k] /= len ;
+	w[0] = m[1]*u[2] - m[2]*u[1] ;
+	w[1] = m[2]*u[0] - m[0]*u[2] ;
+	w[2] = m[0]*u[1] - m[1]*u[0] ;
+
+	for(i = 0 ; i < n ; i++) {
+		for(k = 0 ; k < 3 ; k++) x[k] = pts[3*i+k] - c[k] ;
+		ang[i] = atan2(x[0]*w[0] + x[1]*w[1] + x[2]*w[2],
+					   x[0]*u[0] + x[1]*u[1] + x[2]*u[2]) ;
+	}
+
+	/* Insertion sort: a few points only */
+	for(i = 1 ; i < n ; i++) {
+		tmp[0] = ang[i] ;
+		memcpy(tmp + 1, pts + 3*i, 3*sizeof(double)) ;
+		for(j = i - 1 ; j >= 0 && ang[j] > tmp[0] ; j--) {
+			ang[j+1] = ang[j] ;
+			memcpy(pts + 3*(j+1), pts + 3*j, 3*sizeof(double)) ;
+		}
+		ang[j+1] = tmp[0] ;
+		memcpy(pts + 3*(j+1), tmp + 1, 3*sizeof(double)) ;
+	}
+
+	for(i = 1, j = 0 ; i < n ; i++) {
+		for(k = 0, len = 0.0 ; k < 3 ; k++) {
+			len += (pts[3*i+k] - pts[3*j+k])*(pts[3*i+k] - pts[3*j+k]) ;
+		}
+		if(len > eps*eps) {
+			j++ ;
+			if(j != i) memcpy(pts + 3*j, pts + 3*i, 3*sizeof(double)) ;
+		}
+	}
+	n = j + 1 ;
+	while(n > 1) {
+		for(k = 0, len = 0.0 ; k < 3 ; k++) {
+			len += (pts[3*(n-1)+k] - pts[k])*(pts[3*(n-1)+k] - pts[k]) ;
+		}
+		if(len > eps*eps) break ;
+		n-- ;
+	}
+
+	return n ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_pcell_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Volume of the part of a convex cell inside the sphere of radius r
+	centered on the origin. The cell is the signed sum of the cones joining
+	the origin to its faces (negative for faces seen from inside), and each
+	face is the signed sum of the right triangles joining the projection F
+	of the origin on its plane, the projection E of F on an edge line, and
+	a point of the edge. Inside the sphere, a cone is the spherical sector
+	over the same solid angle, plus what the part of the triangle inside
+	the disk of radius sqrt(r^2 - h^2) around F adds to it (see
+	get_cone_volume). The solid angles of the faces sum to 4 pi if the
+	origin is in the cell, 0 if not, so faces not cutting the sphere add
+	nothing to the sectors and are skipped.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pcell *c : The cell
+	@ double r   : Radius of the sphere
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	double: The volume
+   -----------------------------------------------------------------------------
+*/
+static double get_pcell_volume(s_pcell *c, double r)
+{
+	int f, k, kn, inside = 1 ;
+	double *n, *a, *b, h, e[3], w[3], fp[3], len, d, ta, tb, vf, vol = 0.0 ;
+
+	for(f = 0 ; f < c->nf ; f++) {
+		n = c->pl + 4*f ;
+		h = n[3] ;
+		if(h <= 0.0) inside = 0 ;
+		if(h == 0.0 || h >= r) continue ;
+
+		fp[0] = h*n[0] ; fp[1] = h*n[1] ; fp[2] = h*n[2] ;
+		vf = 0.0 ;
+		for(k = 0 ; k < c->fn[f] ; k++) {
+			kn = (k + 1 == c->fn[f]) ? 0 : k + 1 ;
+			a = c->v + 3*(c->fs[f] + k) ;
+			b = c->v + 3*(c->fs[f] + kn) ;
+			e[0] = b[0] - a[0] ; e[1] = b[1] - a[1] ; e[2] = b[2] - a[2] ;
+			len = sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]) ;
+			if(len <= 0.0) continue ;
+			e[0] /= len ; e[1] /= len ; e[2] /= len ;
+
+			/* Inner normal of the edge in the plane */
+			w[0] = n[1]*e[2] - n[2]*e[1] ;
+			w[1] = n[2]*e[0] - n[0]*e[2] ;
+			w[2] = n[0]*e[1] - n[1]*e[0] ;
+
+			d = (fp[0] - a[0])*w[0] + (fp[1] - a[1])*w[1] + (fp[2] - a[2])*w[2] ;
+			ta = (a[0] - fp[0])*e[0] + (a[1] - fp[1])*e[1] + (a[2] - fp[2])*e[2] ;
+			tb = ta + len ;
+
+			vf += (d < 0.0 ? -1.0 : 1.0)
+				  * ((tb < 0.0 ? -1.0 : 1.0)*get_cone_volume(fabs(h), fabs(d), fabs(tb), r)
+					 - (ta < 0.0 ? -1.0 : 1.0)*get_cone_volume(fabs(h), fabs(d), fabs(ta), r)) ;
+		}
+		vol += (h < 0.0) ? -vf : vf ;
+	}
+	if(inside) vol += 4.0/3.0*M_PI*r*r*r ;
+
+	return vol ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_cone_volume
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Right triangle F (at distance h < r from O, OF normal to the triangle),
+	E (at distance d from F) and X (at distance t from E, EX normal to FE):
+	volume of the cone joining O to the triangle inside the sphere of
+	radius r centered on O, minus the spherical sector over the same solid
+	angle. Directions hitting the triangle outside the disk of radius
+	sqrt(r^2 - h^2) around F leave the sphere before the triangle, and
+	cancel out. Inside the disk, the cone is h/3 per unit of area and the
+	sector r^3/3 per unit of solid angle. The part of the triangle inside
+	the disk is a sector of the disk (the sector of the sphere then loses a
+	spherical cap), the triangle itself, or a right triangle and a sector.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ double h, d, t : Sides of the triangle (see above), >= 0
+	@ double r       : Radius of the sphere
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	double: The volume
+   -----------------------------------------------------------------------------
+*/
+static double get_cone_volume(double h, double d, double t, double r)
+{
+	double rho2, ts, phi, phis, vcap ;
+
+	if(h <= 0.0 || d <= 0.0 || t <= 0.0) return 0.0 ;
+
+	rho2 = r*r - h*h ;
+	vcap = (r - h)*(r - h)*(2.0*r + h)/6.0 ;
+	if(d*d >= rho2) return -atan2(t, d)*vcap ;
+
+	ts = sqrt(rho2 - d*d) ;
+	if(t <= ts) return h*d*t/6.0 - r*r*r/3.0*get_triangle_solid_angle(h, d, t) ;
+
+	phi = atan2(t, d) ;
+	phis = atan2(ts, d) ;
+
+	return h*d*ts/6.0 - r*r*r/3.0*get_triangle_solid_angle(h, d, ts) - (phi - phis)*vcap ;
+}
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_triangle_solid_angle
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Solid angle of the right triangle F, E, X of get_cone_volume seen from
+	O (Van Oosterom and Strackee formula).
+   -----------------------------------------------------------------------------
+*/
+static double get_triangle_solid_angle(double h, double d, double t)
+{
+	double lb = sqrt(d*d + h*h),
+		   lc = sqrt(d*d + t*t + h*h) ;
+
+	return 2.0*atan2(h*d*t, h*lb*lc + h*h*lc + h*h*lb + (d*d + h*h)*h) ;
+}
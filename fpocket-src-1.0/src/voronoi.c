@@ -18,6 +18,27 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     update_vvertices: atoms whose element changed are
+##					 tesselated again
+##	17-11-15	     load_vvertices keeps the qhull order; load_vvertices_part
+##					 and update_vvertices give vertices in canonical order
+##					 (sort_vvertices), whatever the number of threads
+##	17-11-07	     get_verts_volume_ptr: exact engine (see volume.c)
+##	17-11-06	     get_verts_volume_ptr: grid engine (see volume.c)
+##	17-10-31	     Memory of the tesselation can be kept between structures
+##					 (set_vvertices_keep_mem)
+##	17-10-30	     Native Delaunay engine (delaunay.c) can be used instead of
+##					 qhull, see set_delaunay_engine
+##	17-10-29	     Vertices given by qhull are tested by batches (vtest_batch)
+##	17-10-28	     Only vertices passing testVvertice are stored, in a growing
+##					 array; dense qhull id translation table (tr) replaced by a
+##					 binary search on qhull ids (get_vert_idx)
+##	17-10-28	     load_vvertices_part: tesselation of overlapping boxes
+##					 in parallel threads
+##	17-10-27	     update_vvertices: local re-tesselation after a structure
+##					 modification
+##	17-10-26	     Voronoi vertices are read directly from qhull memory,
+##					 no more temporary files
 ##	02-12-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
 ##	21-02-08	(p)	 Adding support for proteins with hydrogens
@@ -25,8 +46,6 @@
 ##
 ## ----- TODO or SUGGESTIONS
 ##
-##  (v) Improve the reading of vertices. Better: include qhull algorithm in our
-##		source code.
 ##  (v) Handle errors when reading/filling vertices..........
 
 */
@@ -62,8 +81,204 @@
 
 **/
 
-static void fill_vvertices(s_lst_vvertice *lvvert, const char fpath[], s_atm *atoms, int natoms,
-						   int min_apol_neigh, float asph_min_size, float asph_max_size) ;
+/* Data needed while qhull hands over the voronoi vertices */
+typedef struct s_vvert_fill
+{
+	s_lst_vvertice *lvvert ;
+	s_atm *atoms ;
+
+	int natoms,
+		min_apol_neigh,
+		vInMem,				/* Saved vertices counter */
+		nalloc ;			/* Number of vertices allocated */
+
+	/* Vertices waiting to be tested: qhull index, atoms and neighbours */
+	s_vtest_batch *batch ;
+	int bqid[M_VTEST_BATCH],
+		bnb[M_VTEST_BATCH][4],
+		bvnb[M_VTEST_BATCH][4] ;
+
+	float asph_min_size,
+		  asph_max_size ;
+
+} s_vvert_fill ;
+
+/* A triangular face of a Delaunay tetrahedron, used to link vertices */
+typedef struct s_vface
+{
+	int a, b, c,	/* Atom indexes, sorted */
+		vert,		/* Vertice index */
+		slot ;		/* Index of the opposite atom in the vertice */
+
+} s_vface ;
+
+/* Data shared by the threads of a partitioned tesselation */
+typedef struct s_vpart
+{
+	s_pdb *pdb ;
+	s_lst_vvertice *lvvert ;	/* Global list (heavy atoms only are used) */
+
+	int min_apol_neigh,
+		nbox[3],			/* Number of boxes along x, y and z */
+		next ;				/* Next box to tesselate */
+
+	float asph_min_size,
+		  asph_max_size,
+		  halo,				/* Width of the halo around each box core */
+		  min[3],			/* Lower corner of the grid of boxes */
+		  width[3] ;		/* Size of a box core */
+
+	int *status,			/* qhull status of each box */
+		*nres ;				/* Number of vertices owned by each box */
+	s_vvertice **res ;		/* Vertices owned by each box */
+
+} s_vpart ;
+
+static s_lst_vvertice* alloc_lst_vvertices(s_pdb *pdb) ;
+static void* run_vpart_thread(void *data) ;
+static void tesselate_box(s_vpart *part, int b) ;
+static int get_vert_box(s_vpart *part, s_vvertice *v) ;
+static int cmp_vvertices_atoms(const void *a, const void *b) ;
+static void get_sorted_atoms(s_vvertice *v, s_atm **sorted) ;
+static void init_vvertices(void *data, int nvert) ;
+static void fill_vvertice(void *data, int i, double *center, int *curNbIdx,
+						  int *curVnbIdx) ;
+static void flush_vvertices(s_vvert_fill *fill) ;
+static void end_vvertices(s_vvert_fill *fill) ;
+static void shrink_vvertices(s_lst_vvertice *lvvert, int nvert) ;
+static int is_vert_touching(s_vvertice *v, float *xyz, int n) ;
+static void set_vvertices_links(s_lst_vvertice *lvvert, s_pdb *pdb) ;
+static void sort_vvertices(s_lst_vvertice *lvvert, s_pdb *pdb) ;
+static int cmp_atm_coord(const void *a, const void *b) ;
+static int cmp_vface(const void *a, const void *b) ;
+static int run_delaunay(double *xyz, int n, void *fill) ;
+static void* get_vscratch(size_t size) ;
+static void free_vscratch(void *ptr) ;
+
+/* Engine used to compute the Delaunay tetrahedra (voronoi vertices) */
+static int ST_delaunay_engine = M_DELAUNAY_QHULL ;
+
+/* Scratch buffer kept between structures (see set_vvertices_keep_mem) */
+static int ST_keep_mem = 0 ;
+static void *ST_scratch = NULL ;
+static size_t ST_scratch_size = 0 ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_delaunay_engine
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Choose the engine computing Delaunay tetrahedra for all following
+	tesselations: qhull, or the native one (see delaunay.c). Both give the
+	same alpha spheres, but not in the same order.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int engine : M_DELAUNAY_QHULL or M_DELAUNAY_NATIVE
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_delaunay_engine(int engine)
+{
+	ST_delaunay_engine = (engine == M_DELAUNAY_NATIVE) ?
+						 M_DELAUNAY_NATIVE : M_DELAUNAY_QHULL ;
+}
+
+int get_delaunay_engine(void)
+{
+	return ST_delaunay_engine ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_vvertices_keep_mem
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	If keep is 1, the memory used by the tesselations of the calling thread
+	is kept for the next structures instead of being freed and allocated
+	again: qhull memory buffers and point array (see qvoronoi_keep_mem), and
+	the scratch buffer of load_vvertices and set_vvertices_links. Used to
+	handle a list of structures. If keep is 0, this memory is freed.
+	The scratch buffer is only used from the thread calling load_vvertices,
+	load_vvertices_part or update_vvertices.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int keep : 1 to keep the memory, 0 to free it
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void set_vvertices_keep_mem(int keep)
+{
+	ST_keep_mem = keep ;
+	qvoronoi_keep_mem(keep) ;
+	if(!keep && ST_scratch) {
+		my_free(ST_scratch) ;
+		ST_scratch = NULL ;
+		ST_scratch_size = 0 ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vscratch, free_vscratch
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Temporary buffer of the given size: the kept scratch buffer (grown if
+	needed) if set_vvertices_keep_mem(1) was called, a new bloc otherwise.
+	free_vscratch releases it.
+   -----------------------------------------------------------------------------
+*/
+static void* get_vscratch(size_t size)
+{
+	if(!ST_keep_mem) return my_malloc(size) ;
+
+	if(size > ST_scratch_size) {
+		if(ST_scratch) my_free(ST_scratch) ;
+		ST_scratch = my_malloc(size) ;
+		ST_scratch_size = size ;
+	}
+
+	return ST_scratch ;
+}
+
+static void free_vscratch(void *ptr)
+{
+	if(ptr != ST_scratch) my_free(ptr) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	run_delaunay
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Tesselate a set of points with the current engine, each voronoi vertex
+	being given to fill_vvertice.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ double *xyz : Coordinates of the points
+	@ int n       : Number of points
+	@ void *fill  : The s_vvert_fill structure of the tesselation
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: M_VORONOI_SUCCESS, or the error code of the engine
+   -----------------------------------------------------------------------------
+*/
+static int run_delaunay(double *xyz, int n, void *fill)
+{
+	int status ;
+
+	if(ST_delaunay_engine == M_DELAUNAY_NATIVE) {
+		status = run_delaunay_mem(xyz, n, init_vvertices, fill_vvertice, fill) ;
+	}
+	else status = run_qvoronoi_mem(xyz, n, init_vvertices, fill_vvertice, fill) ;
+
+	end_vvertices((s_vvert_fill *) fill) ;
+
+	return status ;
+}
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
@@ -71,10 +286,10 @@ static void fill_vvertices(s_lst_vvertice *lvvert, const char fpath[], s_atm *at
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
 	Calculate voronoi vertices using an ensemble of atoms, and then load resulting
-	vertices into a s_lst_vvertice structure. The function call an external
-	programm qvoronoi, part of qhull programme which can be download at:
-		http://www.qhull.org/download/
-	or installed with apt-get install qhull-bin
+	vertices into a s_lst_vvertice structure. Heavy atom coordinates are given
+	directly to the qhull library (see run_qvoronoi_mem) or to the native
+	engine (see run_delaunay), and each voronoi vertex is tested and stored
+	as soon as it is given back, so no temporary file is written or parsed.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_pdb *pdb          : PDB informations
@@ -89,212 +304,1020 @@ static void fill_vvertices(s_lst_vvertice *lvvert, const char fpath[], s_atm *at
 */
 s_lst_vvertice* load_vvertices(s_pdb *pdb, int min_apol_neigh, float asph_min_size, float asph_max_size)
 {
-	int i, nb_h=0;
+	int i, status ;
 	s_atm *ca = NULL ;
-	s_lst_vvertice *lvvert = NULL ;
-    FILE *ftmp=fopen("/tmp/fpocket_qvor.dat","w");
-	FILE *fvoro = fopen("/tmp/qvoro_tmp.dat", "w+");
-/* 	lvvert->h_tr=(int *)my_malloc(sizeof(int));*/
-
-
-
-	if(fvoro != NULL) {
-		lvvert = (s_lst_vvertice *)my_malloc(sizeof(s_lst_vvertice)) ;
-		lvvert->h_tr=NULL;
-		/* Loop a first time to get out how many heavy atoms are in the file */
-		for(i = 0; i <  pdb->natoms ; i++){
-			ca = (pdb->latoms)+i ;
-			if(strcmp(ca->symbol,"H")) {
-				lvvert->h_tr=(int *)my_realloc(lvvert->h_tr,sizeof(int)*(i-nb_h+1)) ;
-				lvvert->h_tr[i-nb_h]=i ;
+	double *xyz = NULL ;
+	s_vvert_fill fill ;
+
+	s_lst_vvertice *lvvert = alloc_lst_vvertices(pdb) ;
+
+	/* Coordinates are rounded to 6 decimals, as they were when written in the
+	 * qvoronoi input file, so the tesselation remains the same. */
+	xyz = (double *)get_vscratch(sizeof(double)*3*(lvvert->n_h_tr > 0 ? lvvert->n_h_tr : 1)) ;
+	for(i = 0; i < lvvert->n_h_tr ; i++){
+		ca = (pdb->latoms) + lvvert->h_tr[i] ;
+		xyz[3*i]   = rint((double)ca->x * 1e6) / 1e6 ;
+		xyz[3*i+1] = rint((double)ca->y * 1e6) / 1e6 ;
+		xyz[3*i+2] = rint((double)ca->z * 1e6) / 1e6 ;
+	}
+
+	fill.lvvert = lvvert ;
+	fill.atoms = pdb->latoms ;
+	fill.natoms = pdb->natoms ;
+	fill.min_apol_neigh = min_apol_neigh ;
+	fill.asph_min_size = asph_min_size ;
+	fill.asph_max_size = asph_max_size ;
+	fill.vInMem = 0 ;
+	fill.batch = NULL ;
+
+	status = run_delaunay(xyz, lvvert->n_h_tr, &fill) ;
+	free_vscratch(xyz) ;
+
+	if(status == M_VORONOI_SUCCESS && lvvert->vertices != NULL) {
+		shrink_vvertices(lvvert, fill.vInMem) ;
+	}
+	else {
+		free_vert_lst(lvvert) ;
+		lvvert = NULL ;
+		fprintf(stderr, "! Voronoi command failed with status %d...\n", status) ;
+	}
+
+	return lvvert ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	load_vvertices_part
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Same as load_vvertices, but space is split into a grid of boxes that are
+	tesselated separately, by nthreads threads. This reduces the memory
+	needed by each qhull run on very large structures.
+	
+	Each box has a core, and the atoms tesselated for this box are the ones
+	of the core plus a halo of 2*asph_max_size + a margin. An alpha sphere
+	belongs to the box whose core contains the barycenter of its 4 atoms:
+	its center is then at most asph_max_size away from the core, and all
+	atoms that could lie inside the sphere are in the halo, so the sphere is
+	the same as in a single tesselation. Spheres are finally put in
+	canonical order (see sort_vvertices), so the result does not depend on
+	the number of boxes or threads.
+	
+	The set of alpha spheres is the same as with load_vvertices, but not
+	their order: the clustering walks them in another order, and fpocket
+	with -t > 1 may thus give other pockets than with a single thread.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb          : PDB informations
+	@ int min_apol_neigh  : Number of apolar neighbor of a vertice to be
+							considered as apolar
+	@ float asph_min_size : Minimum size of voronoi vertices to retain
+	@ float asph_max_size : Maximum size of voronoi vertices to retain
+	@ int nthreads        : Number of threads to use
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_lst_vvertice * :The structure containing the list of vertices.
+   -----------------------------------------------------------------------------
+*/
+s_lst_vvertice* load_vvertices_part(s_pdb *pdb, int min_apol_neigh,
+									float asph_min_size, float asph_max_size,
+									int nthreads)
+{
+	int i, j, b, nbox, nvert = 0 ;
+	float max[3], ext[3], vol = 1.0, g ;
+	s_atm *ca = NULL ;
+	s_vpart part ;
+
+	s_lst_vvertice *lvvert = alloc_lst_vvertices(pdb) ;
+	if(lvvert->n_h_tr < M_VUPDATE_MIN_ATOMS || nthreads < 1) {
+		free_vert_lst(lvvert) ;
+		return load_vvertices(pdb, min_apol_neigh, asph_min_size, asph_max_size) ;
+	}
+
+	part.pdb = pdb ;
+	part.lvvert = lvvert ;
+	part.min_apol_neigh = min_apol_neigh ;
+	part.asph_min_size = asph_min_size ;
+	part.asph_max_size = asph_max_size ;
+	part.halo = 2.0*asph_max_size + M_VPART_MARGIN ;
+	part.next = 0 ;
+
+	/* Grid of about M_VPART_BOX_PER_THREAD boxes per thread, with cores
+	 * not thinner than the halo */
+	for(i = 0 ; i < lvvert->n_h_tr ; i++) {
+		ca = pdb->latoms + lvvert->h_tr[i] ;
+		float c[3] = {ca->x, ca->y, ca->z} ;
+		for(j = 0 ; j < 3 ; j++) {
+			if(i == 0 || c[j] < part.min[j]) part.min[j] = c[j] ;
+			if(i == 0 || c[j] > max[j]) max[j] = c[j] ;
+		}
+	}
+	for(j = 0 ; j < 3 ; j++) {
+		ext[j] = max[j] - part.min[j] ;
+		vol *= (ext[j] > 1.0) ? ext[j] : 1.0 ;
+	}
+	g = cbrt((float)(M_VPART_BOX_PER_THREAD*nthreads) / vol) ;
+	for(j = 0, nbox = 1 ; j < 3 ; j++) {
+		part.nbox[j] = (int) (ext[j]*g + 0.5) ;
+		if(part.nbox[j] > (int) (ext[j]/part.halo)) part.nbox[j] = (int) (ext[j]/part.halo) ;
+		if(part.nbox[j] < 1) part.nbox[j] = 1 ;
+		part.width[j] = (ext[j] > 0.0) ? ext[j] / part.nbox[j] : 1.0 ;
+		nbox *= part.nbox[j] ;
+	}
+
+	part.status = (int *) my_calloc(nbox, sizeof(int)) ;
+	part.nres = (int *) my_calloc(nbox, sizeof(int)) ;
+	part.res = (s_vvertice **) my_calloc(nbox, sizeof(s_vvertice*)) ;
+
+	if(nthreads > nbox) nthreads = nbox ;
+	pthread_t *threads = (pthread_t *) my_malloc(nthreads*sizeof(pthread_t)) ;
+	for(i = 1 ; i < nthreads ; i++) {
+		if(pthread_create(threads + i, NULL, run_vpart_thread, &part) != 0) break ;
+	}
+	run_vpart_thread(&part) ;
+	for(j = 1 ; j < i ; j++) pthread_join(threads[j], NULL) ;
+	my_free(threads) ;
+
+	/* Stitch boxes together */
+	for(b = 0 ; b < nbox ; b++) {
+		if(part.status[b] != M_VORONOI_SUCCESS) break ;
+		nvert += part.nres[b] ;
+	}
+
+	if(b == nbox) {
+		lvvert->vertices = (s_vvertice *) my_calloc(nvert > 0 ? nvert : 1, sizeof(s_vvertice)) ;
+		lvvert->pvertices = (s_vvertice **) my_calloc(nvert > 0 ? nvert : 1, sizeof(s_vvertice*)) ;
+		for(b = 0, nvert = 0 ; b < nbox ; b++) {
+			if(part.nres[b] > 0) {
+				memcpy(lvvert->vertices + nvert, part.res[b], part.nres[b]*sizeof(s_vvertice)) ;
+				nvert += part.nres[b] ;
 			}
-			else nb_h++;
 		}
-		lvvert->n_h_tr=i-nb_h;
-
-		/* Write the header for qvoronoi */
-		fprintf(fvoro,"3 rbox D3\n%d\n", lvvert->n_h_tr);
-		/* Loop a second time for the qvoronoi input coordinates */
-		for(i = 0; i <  pdb->natoms ; i++){
-			ca = (pdb->latoms)+i ;
-			if(strcmp(ca->symbol,"H")) {
-			/* Only if this is a heavy atom export it for voronoi tesselation,
-			 * else discard it */
-				fprintf(fvoro,"%f %f %f \n", ca->x, ca->y, ca->z);
+		lvvert->nvert = nvert ;
+		sort_vvertices(lvvert, pdb) ;
+	}
+	else {
+		fprintf(stderr, "! Voronoi command failed with status %d...\n", part.status[b]) ;
+		free_vert_lst(lvvert) ;
+		lvvert = NULL ;
+	}
+
+	for(b = 0 ; b < nbox ; b++) if(part.res[b]) my_free(part.res[b]) ;
+	my_free(part.res) ;
+	my_free(part.nres) ;
+	my_free(part.status) ;
+
+	return lvvert ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	run_vpart_thread
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Thread of a partitioned tesselation: tesselate boxes until there is no
+	box left.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ void *data : The s_vpart structure of the tesselation
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void *: NULL
+   -----------------------------------------------------------------------------
+*/
+static void* run_vpart_thread(void *data)
+{
+	int b ;
+	s_vpart *part = (s_vpart *) data ;
+	int nbox = part->nbox[0]*part->nbox[1]*part->nbox[2] ;
+
+	while((b = __sync_fetch_and_add(&(part->next), 1)) < nbox) {
+		tesselate_box(part, b) ;
+	}
+
+	return NULL ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	tesselate_box
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Tesselate the atoms of a box and its halo, and keep the alpha spheres
+	that belong to the box.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vpart *part : The partitioned tesselation
+	@ int b         : Index of the box
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void tesselate_box(s_vpart *part, int b)
+{
+	int i, j, nlocal = 0,
+		cell[3] ;
+	float lo[3], hi[3] ;
+	s_atm *ca = NULL ;
+	s_vvert_fill fill ;
+	s_lst_vvertice local ;
+
+	cell[0] = b % part->nbox[0] ;
+	cell[1] = (b / part->nbox[0]) % part->nbox[1] ;
+	cell[2] = b / (part->nbox[0]*part->nbox[1]) ;
+	for(j = 0 ; j < 3 ; j++) {
+		lo[j] = part->min[j] + cell[j]*part->width[j] - part->halo ;
+		hi[j] = part->min[j] + (cell[j] + 1)*part->width[j] + part->halo ;
+	}
+
+	int *hlocal = (int *) my_malloc(part->lvvert->n_h_tr*sizeof(int)) ;
+	for(i = 0 ; i < part->lvvert->n_h_tr ; i++) {
+		ca = part->pdb->latoms + part->lvvert->h_tr[i] ;
+		if(ca->x >= lo[0] && ca->x <= hi[0] && ca->y >= lo[1] && ca->y <= hi[1]
+		   && ca->z >= lo[2] && ca->z <= hi[2]) {
+			hlocal[nlocal++] = part->lvvert->h_tr[i] ;
+		}
+	}
+	if(nlocal < M_VUPDATE_MIN_ATOMS) {
+		my_free(hlocal) ;
+		return ;
+	}
+
+	local.vertices = NULL ;
+	local.pvertices = NULL ;
+	local.h_tr = hlocal ;
+	local.n_h_tr = nlocal ;
+	local.nvert = 0 ;
+	local.qhullSize = 0 ;
+
+	fill.lvvert = &local ;
+	fill.atoms = part->pdb->latoms ;
+	fill.natoms = part->pdb->natoms ;
+	fill.min_apol_neigh = part->min_apol_neigh ;
+	fill.asph_min_size = part->asph_min_size ;
+	fill.asph_max_size = part->asph_max_size ;
+	fill.vInMem = 0 ;
+	fill.batch = NULL ;
+
+	double *xyz = (double *) my_malloc(3*nlocal*sizeof(double)) ;
+	for(i = 0 ; i < nlocal ; i++) {
+		ca = part->pdb->latoms + hlocal[i] ;
+		xyz[3*i]   = rint((double)ca->x * 1e6) / 1e6 ;
+		xyz[3*i+1] = rint((double)ca->y * 1e6) / 1e6 ;
+		xyz[3*i+2] = rint((double)ca->z * 1e6) / 1e6 ;
+	}
+	part->status[b] = run_delaunay(xyz, nlocal, &fill) ;
+	my_free(xyz) ;
+
+	/* Keep vertices owned by this box, in place */
+	if(part->status[b] == M_VORONOI_SUCCESS && local.vertices != NULL) {
+		for(i = 0, j = 0 ; i < fill.vInMem ; i++) {
+			if(get_vert_box(part, local.vertices + i) == b) {
+				local.vertices[j++] = local.vertices[i] ;
 			}
 		}
+		part->nres[b] = j ;
+		part->res[b] = local.vertices ;
+	}
+	else if(local.vertices) my_free(local.vertices) ;
+
+	my_free(hlocal) ;
+}
 
-		fflush(fvoro) ;
-		rewind(fvoro);
-		
-		//int status = system("qvoronoi p i Pp Fn < voro_tmp.dat > voro.tmp") ;
-        run_qvoronoi(fvoro,ftmp);
-        int status=M_VORONOI_SUCCESS;
-		
-		fclose(fvoro) ;
-        fclose(ftmp);
-		
-        remove("/tmp/qvoro_tmp.dat");
-		if(status == M_VORONOI_SUCCESS) {
-			fill_vvertices(lvvert, "/tmp/fpocket_qvor.dat", pdb->latoms, pdb->natoms,
-							min_apol_neigh, asph_min_size, asph_max_size);
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vert_box
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the box owning a vertice: the one whose core contains the barycenter
+	of its 4 atoms. The barycenter is calculated in a fixed order of atoms,
+	so all boxes get exactly the same value for a given sphere.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vpart *part : The partitioned tesselation
+	@ s_vvertice *v : The vertice
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: index of the box
+   -----------------------------------------------------------------------------
+*/
+static int get_vert_box(s_vpart *part, s_vvertice *v)
+{
+	int i, j, cell[3] ;
+	double c[3] = {0.0, 0.0, 0.0} ;
+	s_atm *sorted[4] ;
+
+	get_sorted_atoms(v, sorted) ;
+	for(i = 0 ; i < 4 ; i++) {
+		c[0] += sorted[i]->x ;
+		c[1] += sorted[i]->y ;
+		c[2] += sorted[i]->z ;
+	}
+	for(j = 0 ; j < 3 ; j++) {
+		cell[j] = (int) floor((c[j]*0.25 - part->min[j]) / part->width[j]) ;
+		if(cell[j] < 0) cell[j] = 0 ;
+		if(cell[j] >= part->nbox[j]) cell[j] = part->nbox[j] - 1 ;
+	}
+
+	return cell[0] + part->nbox[0]*(cell[1] + part->nbox[1]*cell[2]) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_sorted_atoms
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the 4 atoms of a vertice, sorted by position in the atom list.
+   -----------------------------------------------------------------------------
+*/
+static void get_sorted_atoms(s_vvertice *v, s_atm **sorted)
+{
+	int i, j ;
+	s_atm *tmp = NULL ;
+
+	for(i = 0 ; i < 4 ; i++) sorted[i] = v->neigh[i] ;
+	for(i = 1 ; i < 4 ; i++) {
+		for(j = i ; j > 0 && sorted[j-1] > sorted[j] ; j--) {
+			tmp = sorted[j] ; sorted[j] = sorted[j-1] ; sorted[j-1] = tmp ;
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	cmp_vvertices_atoms
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	qsort comparison of two vertices, using their atoms, already sorted
+	(see sort_vvertices).
+   -----------------------------------------------------------------------------
+*/
+static int cmp_vvertices_atoms(const void *a, const void *b)
+{
+	int i ;
+	const s_vvertice *va = (const s_vvertice *) a,
+					 *vb = (const s_vvertice *) b ;
+
+	for(i = 0 ; i < 4 ; i++) {
+		if(va->neigh[i] != vb->neigh[i]) return (va->neigh[i] < vb->neigh[i]) ? -1 : 1 ;
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	update_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the vertices of a modified structure (pdb) using the ones previously
+	calculated for the original structure (old), without doing the whole
+	tesselation again. Heavy atoms of both structures are matched using their
+	coordinates and element; atoms that moved, appeared, disappeared or
+	changed of element are the changed atoms.
+	
+	A vertice whose sphere doesn't reach any changed atom stays valid and is
+	kept. Any new alpha sphere reaches at least one changed atom: its center
+	is then at most asph_max_size away from this atom, and the atoms it
+	contacts at most 2*asph_max_size away. These spheres are thus found by
+	tesselating only the atoms close to the changed ones. Vertices are then
+	put in canonical order (see sort_vvertices), so the result is the same
+	as load_vvertices_part on the modified structure.
+	
+	The old list is not modified, and must still be freed by the caller.
+	If the local tesselation fails, a full tesselation is done.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvvert : Vertices of the original structure
+	@ s_pdb *old             : The original structure
+	@ s_pdb *pdb             : The modified structure
+	@ int min_apol_neigh     : Number of apolar neighbor of a vertice to be
+							   considered as apolar
+	@ float asph_min_size    : Minimum size of voronoi vertices to retain
+	@ float asph_max_size    : Maximum size of voronoi vertices to retain
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_lst_vvertice * : Vertices of the modified structure
+   -----------------------------------------------------------------------------
+*/
+s_lst_vvertice* update_vvertices(s_lst_vvertice *lvvert, s_pdb *old, s_pdb *pdb,
+								 int min_apol_neigh, float asph_min_size,
+								 float asph_max_size)
+{
+	int i, j, k, status,
+		nold = lvvert->n_h_tr,
+		nchanged = 0,
+		nlocal = 0,
+		nkept = 0 ;
+	float d, dmax ;
+	s_atm *ca = NULL ;
+	s_vvertice *v = NULL ;
+	s_vvert_fill fill ;
+	s_lst_vvertice local ;
+
+	s_lst_vvertice *nlvvert = alloc_lst_vvertices(pdb) ;
+	int nnew = nlvvert->n_h_tr ;
+
+	/* Match heavy atoms of both structures using their coordinates and
+	 * element */
+	s_atm **aold = (s_atm **) my_malloc((nold > 0 ? nold : 1)*sizeof(s_atm*)) ;
+	s_atm **anew = (s_atm **) my_malloc((nnew > 0 ? nnew : 1)*sizeof(s_atm*)) ;
+	int *o2n = (int *) my_malloc((old->natoms > 0 ? old->natoms : 1)*sizeof(int)) ;
+	float *changed = (float *) my_malloc(3*(nold+nnew > 0 ? nold+nnew : 1)*sizeof(float)) ;
+
+	for(i = 0 ; i < old->natoms ; i++) o2n[i] = -1 ;
+	for(i = 0 ; i < nold ; i++) aold[i] = old->latoms + lvvert->h_tr[i] ;
+	for(i = 0 ; i < nnew ; i++) anew[i] = pdb->latoms + nlvvert->h_tr[i] ;
+	qsort(aold, nold, sizeof(s_atm*), cmp_atm_coord) ;
+	qsort(anew, nnew, sizeof(s_atm*), cmp_atm_coord) ;
+
+	i = 0 ; j = 0 ;
+	while(i < nold || j < nnew) {
+		if(j >= nnew) k = -1 ;
+		else if(i >= nold) k = 1 ;
+		else k = cmp_atm_coord(aold+i, anew+j) ;
+
+		if(k == 0) {
+			o2n[aold[i] - old->latoms] = anew[j] - pdb->latoms ;
+			i++ ; j++ ;
 		}
 		else {
-			my_free(lvvert);
-			lvvert = NULL ;
-			fprintf(stderr, "! Voronoi command failed with status %d...\n", status) ;
+			ca = (k < 0) ? aold[i++] : anew[j++] ;
+			changed[3*nchanged] = ca->x ;
+			changed[3*nchanged+1] = ca->y ;
+			changed[3*nchanged+2] = ca->z ;
+			nchanged++ ;
 		}
-        remove("/tmp/fpocket_qvor.dat");
 	}
-	else {
-		fprintf(stderr, "! File for Voronoi vertices calculation couldn't be opened...\n") ;
+	my_free(aold) ;
+
+	/* Atoms that have to be tesselated again */
+	dmax = 2.0*asph_max_size + M_VUPDATE_MARGIN ;
+	int *hlocal = (int *) my_malloc((nnew > 0 ? nnew : 1)*sizeof(int)) ;
+	for(i = 0 ; i < nnew ; i++) {
+		ca = pdb->latoms + nlvvert->h_tr[i] ;
+		for(j = 0 ; j < nchanged ; j++) {
+			d = dist(ca->x, ca->y, ca->z, changed[3*j], changed[3*j+1],
+					 changed[3*j+2]) ;
+			if(d <= dmax) {
+				hlocal[nlocal++] = nlvvert->h_tr[i] ;
+				break ;
+			}
+		}
+	}
+	my_free(anew) ;
+
+	/* Local tesselation */
+	local.vertices = NULL ;
+	local.pvertices = NULL ;
+	local.h_tr = hlocal ;
+	local.n_h_tr = nlocal ;
+	local.nvert = 0 ;
+	local.qhullSize = 0 ;
+
+	fill.lvvert = &local ;
+	fill.atoms = pdb->latoms ;
+	fill.natoms = pdb->natoms ;
+	fill.min_apol_neigh = min_apol_neigh ;
+	fill.asph_min_size = asph_min_size ;
+	fill.asph_max_size = asph_max_size ;
+	fill.vInMem = 0 ;
+	fill.batch = NULL ;
+
+	status = M_VORONOI_SUCCESS ;
+	if(nlocal >= M_VUPDATE_MIN_ATOMS) {
+		double *xyz = (double *) my_malloc(3*nlocal*sizeof(double)) ;
+		for(i = 0 ; i < nlocal ; i++) {
+			ca = pdb->latoms + hlocal[i] ;
+			xyz[3*i]   = rint((double)ca->x * 1e6) / 1e6 ;
+			xyz[3*i+1] = rint((double)ca->y * 1e6) / 1e6 ;
+			xyz[3*i+2] = rint((double)ca->z * 1e6) / 1e6 ;
+		}
+		status = run_delaunay(xyz, nlocal, &fill) ;
+		my_free(xyz) ;
+	}
+	else if(nlocal > 0) status = -1 ;
+
+	if(status != M_VORONOI_SUCCESS) {
+		if(local.vertices) my_free(local.vertices) ;
+		my_free(hlocal) ;
+		my_free(changed) ;
+		my_free(o2n) ;
+		free_vert_lst(nlvvert) ;
+
+		return load_vvertices(pdb, min_apol_neigh, asph_min_size, asph_max_size) ;
+	}
+
+	/* Keep old vertices that are not affected by the modification, and new
+	 * ones that are */
+	int nmax = lvvert->nvert + fill.vInMem ;
+	nlvvert->vertices = (s_vvertice *) my_calloc(nmax > 0 ? nmax : 1, sizeof(s_vvertice)) ;
+	nlvvert->pvertices = (s_vvertice **) my_calloc(nmax > 0 ? nmax : 1, sizeof(s_vvertice*)) ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		v = lvvert->vertices + i ;
+		for(j = 0 ; j < 4 ; j++) if(o2n[v->neigh[j] - old->latoms] < 0) break ;
+		if(j < 4 || is_vert_touching(v, changed, nchanged)) continue ;
+
+		nlvvert->vertices[nkept] = *v ;
+		for(j = 0 ; j < 4 ; j++) {
+			nlvvert->vertices[nkept].neigh[j] = pdb->latoms
+											  + o2n[v->neigh[j] - old->latoms] ;
+		}
+		nkept++ ;
+	}
+	for(i = 0 ; i < fill.vInMem ; i++) {
+		v = local.vertices + i ;
+		if(is_vert_touching(v, changed, nchanged)) {
+			nlvvert->vertices[nkept++] = *v ;
+		}
+	}
+
+	nlvvert->nvert = nkept ;
+	for(i = 0 ; i < nkept ; i++) {
+		v = nlvvert->vertices + i ;
+		v->seen = 0 ;
+		v->sort_x = -1 ;
+		v->apol_neighbours = 0 ;
+		v->resid = -1 ;
+	}
+	sort_vvertices(nlvvert, pdb) ;
+
+	if(local.vertices) my_free(local.vertices) ;
+	my_free(hlocal) ;
+	my_free(changed) ;
+	my_free(o2n) ;
+
+	return nlvvert ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	alloc_lst_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Allocate an empty list of vertices for the given structure, and store the
+	index of its heavy atoms (the only ones used for the tesselation).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_pdb *pdb : PDB informations
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	s_lst_vvertice * : The allocated structure
+   -----------------------------------------------------------------------------
+*/
+static s_lst_vvertice* alloc_lst_vvertices(s_pdb *pdb)
+{
+	int i ;
+
+	s_lst_vvertice *lvvert = (s_lst_vvertice *)my_malloc(sizeof(s_lst_vvertice)) ;
+	lvvert->vertices = NULL ;
+	lvvert->pvertices = NULL ;
+	lvvert->nvert = 0 ;
+	lvvert->qhullSize = 0 ;
+	lvvert->h_tr = (int *)my_malloc(sizeof(int)*(pdb->natoms > 0 ? pdb->natoms : 1)) ;
+	lvvert->n_h_tr = 0 ;
+
+	for(i = 0; i <  pdb->natoms ; i++){
+		if(strcmp(pdb->latoms[i].symbol,"H")) lvvert->h_tr[lvvert->n_h_tr++] = i ;
 	}
-        
+
 	return lvvert ;
 }
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
-	fill_vertices
+	is_vert_touching
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Say if one of the given points lies inside or on the surface of the alpha
+	sphere of a vertice.
    -----------------------------------------------------------------------------
    ## PARAMETRES:
-	@ s_lst_vvertice *lvvert : The structure to fill
-	@ const char fpath[]     : File containing vertices
-	@ s_atm *atoms           : List of atoms
-	@ int natoms             : Number of atoms
-	@ int min_apol_neigh  : Number of apolar neighbor of a vertice to be
-							considered as apolar
-	@ float asph_min_size : Minimum size of voronoi vertices to retain
-	@ float asph_max_size : Maximum size of voronoi vertices to retain
+	@ s_vvertice *v : The vertice
+	@ float *xyz    : Coordinates of the points
+	@ int n         : Number of points
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 1 if at least one point touches the sphere, 0 if not
+   -----------------------------------------------------------------------------
+*/
+static int is_vert_touching(s_vvertice *v, float *xyz, int n)
+{
+	int i ;
+	float r = v->ray + M_VUPDATE_TOLERANCE ;
+
+	for(i = 0 ; i < n ; i++) {
+		if(ddist(v->x, v->y, v->z, xyz[3*i], xyz[3*i+1], xyz[3*i+2]) <= r*r) {
+			return 1 ;
+		}
+	}
+
+	return 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	sort_vvertices
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
-	Fill structure given in argument (must have been allocated) using a file
-	containing vertice coordinates and neighbours using p i options of qhull.
+	Put a list of vertices in canonical form: the 4 atoms of each vertice
+	are sorted, its center is calculated again from these atoms (the one
+	given by a qhull run depends on the other points of the run, in the last
+	bits), vertices are sorted according to their atoms (see
+	cmp_vvertices_atoms) and numbered in this order, and their links
+	(vneigh) and qhull ids are set by set_vvertices_links. The result then
+	only depends on the set of alpha spheres, and not on the way they were
+	found (any number of boxes and threads, or local re-tesselation), so
+	the pockets are the same. Not used by load_vvertices, whose vertices
+	stay in qhull order.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvvert : The list of vertices
+	@ s_pdb *pdb             : The structure the vertices belong to
    -----------------------------------------------------------------------------
    ## RETURN:
 	void
    -----------------------------------------------------------------------------
 */
-static void fill_vvertices(s_lst_vvertice *lvvert, const char fpath[], s_atm *atoms, int natoms,
-						   int min_apol_neigh, float asph_min_size, float asph_max_size)
+static void sort_vvertices(s_lst_vvertice *lvvert, s_pdb *pdb)
 {
-	FILE *f = NULL ;	/* File handler for vertices coordinates */
-	FILE *fNb = NULL ;	/* File handler for vertices atomic neighbours */
-	FILE *fvNb = NULL;	/* File handler for vertices vertice neighbours */
+	int i, j ;
+	double p[4][3], c[3] ;
+	float dx, dy, dz ;
+	s_vvertice *v = NULL ;
+	s_atm *sorted[4] ;
+
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		v = lvvert->vertices + i ;
+		get_sorted_atoms(v, sorted) ;
+		for(j = 0 ; j < 4 ; j++) {
+			v->neigh[j] = sorted[j] ;
+			p[j][0] = rint((double)sorted[j]->x * 1e6) / 1e6 ;
+			p[j][1] = rint((double)sorted[j]->y * 1e6) / 1e6 ;
+			p[j][2] = rint((double)sorted[j]->z * 1e6) / 1e6 ;
+		}
+		get_dt_center(p[0], p[1], p[2], p[3], c) ;
+		if(isfinite(c[0]) && isfinite(c[1]) && isfinite(c[2])) {
+			v->x = (float) c[0] ; v->y = (float) c[1] ; v->z = (float) c[2] ;
+			dx = v->x - sorted[0]->x ;
+			dy = v->y - sorted[0]->y ;
+			dz = v->z - sorted[0]->z ;
+			v->ray = sqrtf((dx*dx) + (dy*dy) + (dz*dz)) ;
+		}
+		set_barycenter(v) ;
+	}
 
+	qsort(lvvert->vertices, lvvert->nvert, sizeof(s_vvertice), cmp_vvertices_atoms) ;
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		lvvert->vertices[i].id = pdb->natoms + i + 1 ;
+		lvvert->pvertices[i] = lvvert->vertices + i ;
+	}
+	set_vvertices_links(lvvert, pdb) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	set_vvertices_links
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Set neighbouring vertices (vneigh) and qhull ids of a sorted list of
+	vertices (see sort_vvertices). Two vertices are neighbours if their
+	Delaunay tetrahedra share a face. As qhull ids are meaningless once
+	sorted, each vertice gets its list index + 1 as qhullId, as 0 is not
+	considered as a valid neighbour by the clustering.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvvert : The list of vertices
+	@ s_pdb *pdb             : The structure the vertices belong to
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void set_vvertices_links(s_lst_vvertice *lvvert, s_pdb *pdb)
+{
+	int i, j, k, l, tmp, at[3],
+		nfaces = 0 ;
 	s_vvertice *v = NULL ;
 
-	float tmpRay;	/* Temporary Ray of voronoi vertice (ray of alpha sphere) */
-	float xyz[3] = {0,0,0};
-
-	int i, j,nchar_max = 255,
-		vInMem = 0,				/* Saved vertices counter */
-		curLineNb = 0,			/* Current line number */
-		trash = 0,
-		tmpApolar=0,
-		curVnbIdx[4],			/* Current vertice neighbours */
-		curNbIdx[4];			/* Current atomic neighbours */
-
-	char cline[nchar_max],
-		 nbline[nchar_max],
-		 vNbline[nchar_max],
-		 *s_nvert = (char *) my_malloc(sizeof(char)*nchar_max) ;
-
-/* Once we have the number of lines, lets allocate memory and get the lines */
-       
-	f = fopen(fpath,"r") ;
-	fNb = fopen(fpath,"r") ;
-	fvNb = fopen(fpath,"r") ;
-
-	char *status = NULL ;
-
-	status = fgets(cline, nchar_max, f) ;		/* Skip fir=st line */
-	status = fgets(cline, nchar_max, f) ;		/* Load 2nd line containing nbr of coors. */
-	status = fgets(nbline, nchar_max, fNb) ;	/* Skip first line */
-	status = fgets(nbline, nchar_max, fNb) ;	/* Load 2nd line containing nbr of coors. */
-	status = fgets(vNbline, nchar_max, fvNb) ;	/* Skip first line */
-	status = fgets(vNbline, nchar_max, fvNb) ;	/* Load 2nd line containing nbr of coors. */
-
- 	sscanf(cline,"%d",&(lvvert->nvert)) ;
-	lvvert->qhullSize = lvvert->nvert ;
-	lvvert->tr = (int *) my_malloc(lvvert->nvert*sizeof(int));
-	for(i = 0 ; i < lvvert->nvert ; i++) lvvert->tr[i] = -1;
-
- 	lvvert->vertices = (s_vvertice *) my_calloc(lvvert->nvert, sizeof(s_vvertice)) ;
-	lvvert->pvertices= (s_vvertice **) my_calloc(lvvert->nvert, sizeof(s_vvertice*)) ;
-	
-	/* Get the string of number of vertices to read, to look up the neighbour
-	 * list from qhull */
-	sprintf(s_nvert,"%d",lvvert->nvert);
-	strcat(s_nvert,"\n");
-
-	/* Advance cursor to neighbour list */
-	while(fgets(nbline, nchar_max, fNb) != NULL && strcmp(s_nvert, nbline) != 0) ;
-	/* Advance cursor to the vertice neighbour list */
-	while(fgets(vNbline,nchar_max,fvNb) != NULL && curLineNb++ < lvvert->nvert*2+1) ;
-
-	i = 0 ;
-	while(fgets(cline, nchar_max, f) != NULL) {
-	/* Read vertice positions */
- 		if(fgets(nbline, nchar_max,fNb)!=NULL){
-		/* Read neighbours */
-			if(fgets(vNbline, nchar_max,fvNb)!=NULL){
-			/* Read vertice neighbour vertices */
-				if(strcmp("\n", cline) != 0 && strcmp("\n", nbline) != 0
-				   && strcmp("\n", vNbline) != 0) {
-
-					sscanf(cline,"%f %f %f",&xyz[0], &xyz[1], &xyz[2]);
-					sscanf(nbline,"%d %d %d %d",&curNbIdx[0],&curNbIdx[1],
-												&curNbIdx[2],&curNbIdx[3]);
- 					sscanf(vNbline,"%d %d %d %d %d", &trash, &curVnbIdx[0],
-													 &curVnbIdx[1],
-													 &curVnbIdx[2], &curVnbIdx[3]);
-				/* Test voro. vert. for alpha sphere cond. and returns ray if
-				 * cond. are ok, -1 else */
-					tmpRay = testVvertice(xyz, curNbIdx, atoms, asph_min_size,
-										  asph_max_size,lvvert);
-					if(tmpRay > 0){
-						v = (lvvert->vertices + vInMem) ;
-						v->x = xyz[0]; v->y = xyz[1]; v->z = xyz[2];
-						v->ray = tmpRay;
-						v->sort_x = -1 ;
-						v->seen = 0 ;
-						
-						tmpApolar=0;
-
-						for(j = 0 ; j < 4 ; j++) {
-							v->neigh[j] = &(atoms[lvvert->h_tr[curNbIdx[j]]]);
-
-							if(atoms[lvvert->h_tr[curNbIdx[j]]].electroneg<2.8) tmpApolar++ ;
-							if(curVnbIdx[j]>0) v->vneigh[j] = curVnbIdx[j];
-						}
-
-						v->apol_neighbours = 0 ;
-						lvvert->tr[i] = vInMem ;
-
-						lvvert->pvertices[vInMem] = v ;
-
-						vInMem++ ;		/* Vertices actually read */
-						v->id = natoms+i+1-vInMem ;
-
-						if(tmpApolar >= min_apol_neigh) v->type = M_APOLAR_AS;
-						else v->type = M_POLAR_AS;
-
-						v->qhullId = i;		/* Set index in the qhull file */
-						v->resid = -1;		/* Initialize internal index */
-						set_barycenter(v) ;	/* Set barycentre */
-					}
-					i++ ;
-				}
+	lvvert->qhullSize = lvvert->nvert + 1 ;
+
+	s_vface *faces = (s_vface *) get_vscratch((4*lvvert->nvert > 0 ? 4*lvvert->nvert : 1)
+											  *sizeof(s_vface)) ;
+	for(i = 0 ; i < lvvert->nvert ; i++) {
+		v = lvvert->vertices + i ;
+		v->qhullId = i + 1 ;
+
+		for(j = 0 ; j < 4 ; j++) {
+			v->vneigh[j] = 0 ;
+			for(k = 0, l = 0 ; k < 4 ; k++) {
+				if(k != j) at[l++] = v->neigh[k] - pdb->latoms ;
 			}
- 		}
+			if(at[0] > at[1]) { tmp = at[0] ; at[0] = at[1] ; at[1] = tmp ; }
+			if(at[1] > at[2]) { tmp = at[1] ; at[1] = at[2] ; at[2] = tmp ; }
+			if(at[0] > at[1]) { tmp = at[0] ; at[0] = at[1] ; at[1] = tmp ; }
+
+			faces[nfaces].a = at[0] ;
+			faces[nfaces].b = at[1] ;
+			faces[nfaces].c = at[2] ;
+			faces[nfaces].vert = i ;
+			faces[nfaces].slot = j ;
+			nfaces++ ;
+		}
+	}
+
+	qsort(faces, nfaces, sizeof(s_vface), cmp_vface) ;
+	for(i = 1 ; i < nfaces ; i++) {
+		if(cmp_vface(faces+i-1, faces+i) == 0) {
+			lvvert->vertices[faces[i-1].vert].vneigh[faces[i-1].slot] = faces[i].vert + 1 ;
+			lvvert->vertices[faces[i].vert].vneigh[faces[i].slot] = faces[i-1].vert + 1 ;
+		}
+	}
+
+	free_vscratch(faces) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	cmp_atm_coord
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	qsort comparison of two atom pointers, using x, y and z coordinates,
+	then the element (symbol and electronegativity, which gives the type of
+	the vertices), so an atom whose element changed is not matched.
+   -----------------------------------------------------------------------------
+*/
+static int cmp_atm_coord(const void *a, const void *b)
+{
+	const s_atm *aa = *((s_atm * const *) a),
+				*ab = *((s_atm * const *) b) ;
+
+	if(aa->x != ab->x) return (aa->x < ab->x) ? -1 : 1 ;
+	if(aa->y != ab->y) return (aa->y < ab->y) ? -1 : 1 ;
+	if(aa->z != ab->z) return (aa->z < ab->z) ? -1 : 1 ;
+	if(aa->electroneg != ab->electroneg) {
+		return (aa->electroneg < ab->electroneg) ? -1 : 1 ;
+	}
+
+	return strcmp(aa->symbol, ab->symbol) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	cmp_vface
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	qsort comparison of two faces, using their sorted atom indexes.
+   -----------------------------------------------------------------------------
+*/
+static int cmp_vface(const void *a, const void *b)
+{
+	const s_vface *fa = (const s_vface *) a,
+				  *fb = (const s_vface *) b ;
+
+	if(fa->a != fb->a) return fa->a - fb->a ;
+	if(fa->b != fb->b) return fa->b - fb->b ;
+
+	return fa->c - fb->c ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	init_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Allocate the vertices of the structure once qhull knows how many voronoi
+	vertices it will give us. Only a fraction of them will pass testVvertice,
+	so the array starts smaller and grows when needed.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ void *data : The s_vvert_fill structure of the current tesselation
+	@ int nvert  : Number of voronoi vertices calculated by qhull
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void init_vvertices(void *data, int nvert)
+{
+	s_vvert_fill *fill = (s_vvert_fill *) data ;
+	s_lst_vvertice *lvvert = fill->lvvert ;
+
+	lvvert->nvert = 0 ;
+	lvvert->qhullSize = nvert ;
+
+	fill->batch = (s_vtest_batch *) my_malloc(sizeof(s_vtest_batch)) ;
+	fill->batch->n = 0 ;
+
+	fill->nalloc = nvert / M_VERT_ALLOC_RATIO ;
+	if(fill->nalloc < M_VERT_ALLOC_MIN) fill->nalloc = M_VERT_ALLOC_MIN ;
+ 	lvvert->vertices = (s_vvertice *) my_malloc(fill->nalloc*sizeof(s_vvertice)) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	fill_vvertice
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Add a voronoi vertex given by qhull to the batch of vertices to test, if
+	its distance to its first atom is in the alpha sphere size range.
+	The batch is tested (and vertices fulfilling the alpha sphere conditions
+	stored) when it is full, see flush_vvertices.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ void *data      : The s_vvert_fill structure of the current tesselation
+	@ int i           : Index of the vertex in the qhull output
+	@ double *center  : Coordinates of the vertex
+	@ int *curNbIdx   : Indexes of the 4 atomic neighbours (heavy atoms only)
+	@ int *curVnbIdx  : Indexes of the 4 neighbouring voronoi vertices
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void fill_vvertice(void *data, int i, double *center, int *curNbIdx,
+						  int *curVnbIdx)
+{
+	s_vvert_fill *fill = (s_vvert_fill *) data ;
+	s_vtest_batch *b = fill->batch ;
+	s_atm *ca = NULL ;
+	float d ;
+	int j, k = b->n ;
+
+	for(j = 0 ; j < 4 ; j++) if(curNbIdx[j] < 0) return ;
+
+	b->cx[k] = (float) center[0] ;
+	b->cy[k] = (float) center[1] ;
+	b->cz[k] = (float) center[2] ;
+
+	/* Most vertices are rejected by the size of the sphere: do this first test
+	 * right away (as testVvertice does), so only the remaining ones are
+	 * copied in the batch. */
+	ca = fill->atoms + fill->lvvert->h_tr[curNbIdx[0]] ;
+	d = dist(b->cx[k], b->cy[k], b->cz[k], ca->x, ca->y, ca->z) ;
+	if(d < fill->asph_min_size || d > fill->asph_max_size) return ;
+
+	for(j = 0 ; j < 4 ; j++) {
+		ca = fill->atoms + fill->lvvert->h_tr[curNbIdx[j]] ;
+		b->ax[j][k] = ca->x ;
+		b->ay[j][k] = ca->y ;
+		b->az[j][k] = ca->z ;
+		b->en[j][k] = ca->electroneg ;
+
+		fill->bnb[k][j] = curNbIdx[j] ;
+		fill->bvnb[k][j] = curVnbIdx[j] ;
 	}
+	fill->bqid[k] = i ;
 
-	lvvert->nvert=vInMem ;
-	fclose(f) ;
-	fclose(fNb) ;
-	fclose(fvNb);
-        remove("/tmp/fpocket_qvor.dat");
+	b->n++ ;
+	if(b->n == M_VTEST_BATCH) flush_vvertices(fill) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	flush_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the vertices of the current batch for alpha sphere conditions (same
+	test as testVvertice, see vtest.c), and store the ones fulfilling them.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvert_fill *fill : The current tesselation
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void flush_vvertices(s_vvert_fill *fill)
+{
+	s_lst_vvertice *lvvert = fill->lvvert ;
+	s_atm *atoms = fill->atoms ;
+	s_vtest_batch *b = fill->batch ;
+	s_vvertice *v = NULL ;
+	int j, k, i ;
+
+	vtest_batch(b, fill->asph_min_size, fill->asph_max_size) ;
+
+	for(k = 0 ; k < b->n ; k++) {
+		if(b->ray[k] <= 0) continue ;
+
+		if(fill->vInMem >= fill->nalloc) {
+			fill->nalloc *= 2 ;
+			lvvert->vertices = (s_vvertice *) my_realloc(lvvert->vertices,
+											fill->nalloc*sizeof(s_vvertice)) ;
+		}
+		i = fill->bqid[k] ;
+		v = (lvvert->vertices + fill->vInMem) ;
+		v->x = b->cx[k]; v->y = b->cy[k]; v->z = b->cz[k];
+		v->ray = b->ray[k];
+		v->sort_x = -1 ;
+		v->seen = 0 ;
+
+		for(j = 0 ; j < 4 ; j++) {
+			v->neigh[j] = &(atoms[lvvert->h_tr[fill->bnb[k][j]]]);
+			v->vneigh[j] = (fill->bvnb[k][j] > 0) ? fill->bvnb[k][j] : 0 ;
+		}
+
+		v->apol_neighbours = 0 ;
+
+		fill->vInMem++ ;		/* Vertices actually read */
+		v->id = fill->natoms+i+1-fill->vInMem ;
+
+		if(b->napol[k] >= fill->min_apol_neigh) v->type = M_APOLAR_AS;
+		else v->type = M_POLAR_AS;
+
+		v->qhullId = i;		/* Set index in the qhull output */
+		v->resid = -1;		/* Initialize internal index */
+		set_barycenter(v) ;	/* Set barycentre */
+	}
+
+	b->n = 0 ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	end_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test the last batch of vertices once qhull is done, and free the batch.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vvert_fill *fill : The current tesselation
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void end_vvertices(s_vvert_fill *fill)
+{
+	if(fill->batch) {
+		if(fill->batch->n > 0) flush_vvertices(fill) ;
+		my_free(fill->batch) ;
+		fill->batch = NULL ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	shrink_vvertices
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Once all vertices are read, resize the vertice array to the number of
+	vertices actually kept, and set the list of pointers to vertices.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvvert : The list of vertices
+	@ int nvert              : Number of vertices kept
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+static void shrink_vvertices(s_lst_vvertice *lvvert, int nvert)
+{
+	int i ;
+
+	lvvert->nvert = nvert ;
+	lvvert->vertices = (s_vvertice *) my_realloc(lvvert->vertices,
+								(nvert > 0 ? nvert : 1)*sizeof(s_vvertice)) ;
+	lvvert->pvertices = (s_vvertice **) my_malloc((nvert > 0 ? nvert : 1)
+												  *sizeof(s_vvertice*)) ;
+	for(i = 0 ; i < nvert ; i++) lvvert->pvertices[i] = lvvert->vertices + i ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_vert_idx
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Get the index in the list of the vertice having the given qhull id.
+	Vertices are stored by increasing qhull id, so a binary search is
+	used instead of a translation table as large as the qhull output.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_lst_vvertice *lvvert : The list of vertices
+	@ int qhullId            : The qhull id
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: index of the vertice, -1 if this vertice has not been kept
+   -----------------------------------------------------------------------------
+*/
+int get_vert_idx(s_lst_vvertice *lvvert, int qhullId)
+{
+	int lo = 0,
+		hi = lvvert->nvert - 1,
+		mid ;
+
+	while(lo <= hi) {
+		mid = (lo + hi) / 2 ;
+		if(lvvert->vertices[mid].qhullId == qhullId) return mid ;
+		else if(lvvert->vertices[mid].qhullId < qhullId) lo = mid + 1 ;
+		else hi = mid - 1 ;
+	}
+
+	return -1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -430,7 +1453,8 @@ void print_vvertices(FILE *f, s_lst_vvertice *lvvert)
    -----------------------------------------------------------------------------
    ## SPECIFICATION:
 	Get an monte carlo approximation of the volume occupied by the alpha spheres
-	given in argument (list of pointers)
+	given in argument (list of pointers), or its volume on a grid with the
+	corresponding precision (see set_volume_engine).
    -----------------------------------------------------------------------------
    ## PARAMETRES:
 	@ s_vvertice **verts: List of pointer to alpha spheres
@@ -446,6 +1470,18 @@ float get_verts_volume_ptr(s_vvertice **verts, int nvert, int niter)
 	int i = 0, j = 0,
 		nb_in = 0;
 
+	if(get_volume_engine() != M_VOLUME_MC) {
+		float vol, *xyzr = (float *) my_malloc((nvert > 0 ? 4*nvert : 1)*sizeof(float)) ;
+		for(i = 0 ; i < nvert ; i++) {
+			xyzr[4*i] = verts[i]->x ; xyzr[4*i+1] = verts[i]->y ;
+			xyzr[4*i+2] = verts[i]->z ; xyzr[4*i+3] = verts[i]->ray ;
+		}
+		vol = get_spheres_volume(xyzr, nvert, niter, 0) ;
+		my_free(xyzr) ;
+
+		return vol ;
+	}
+
 	float xmin = 0.0, xmax = 0.0,
 		  ymin = 0.0, ymax = 0.0,
 		  zmin = 0.0, zmax = 0.0,
@@ -528,10 +1564,6 @@ void free_vert_lst(s_lst_vvertice *lvvert)
 			my_free(lvvert->pvertices) ;
 			lvvert->pvertices = NULL ;
 		}
-		if(lvvert->tr) {
-			my_free(lvvert->tr) ;
-			lvvert->tr = NULL ;
-		}
 		if(lvvert->h_tr) {
 			my_free(lvvert->h_tr) ;
 			lvvert->h_tr = NULL ;
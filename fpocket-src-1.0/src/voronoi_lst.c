@@ -15,6 +15,8 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-08	     get_vert_contacted_atms: atoms kept in a set of ids (s_idset)
+##	17-10-31	     c_lst_vertices_free: no more message, NULL list accepted
 ##	02-12-08	(v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
 ##	01-01-08	(vp) Created (random date...)
@@ -187,7 +189,6 @@ node_vertice *c_lst_vertices_add_last(c_lst_vertices *lst,s_vvertice *vertice)
 */
 void c_lst_vertices_free(c_lst_vertices *lst) 
 {
-	fprintf(stdout, "Freeing list of vertices\n") ;
 	node_vertice *next = NULL ;
 	
 	if(lst) {
@@ -197,13 +198,13 @@ void c_lst_vertices_free(c_lst_vertices *lst)
 			my_free(lst->current) ;
 			lst->current = next ;
         }
-	}
 
-	lst->first = NULL ;
-	lst->last = NULL ;
-	lst->current = NULL ;
+		lst->first = NULL ;
+		lst->last = NULL ;
+		lst->current = NULL ;
 
-	my_free(lst) ;
+		my_free(lst) ;
+	}
 }
 
 /**-----------------------------------------------------------------------------
@@ -226,7 +227,7 @@ s_atm** get_vert_contacted_atms(c_lst_vertices *v_lst, int *nneigh)
 {
 	int i ;
 	int nb_neigh = 0 ;
-	int atm_seen[v_lst->n_vertices * 4] ;
+	s_idset *atm_seen = alloc_idset(v_lst->n_vertices) ;
 
 	s_atm **neigh = (s_atm **)my_malloc(sizeof(s_atm*)*v_lst->n_vertices * 4) ;
 	
@@ -237,15 +238,15 @@ s_atm** get_vert_contacted_atms(c_lst_vertices *v_lst, int *nneigh)
 		
 		for(i = 0 ; i < 4 ; i++) {
 		/* For each neighbor, if this atom has not been see yet, add it. */
-			if(!in_tab(atm_seen, nb_neigh, vcur->neigh[i]->id)) {
+			if(add_idset(atm_seen, vcur->neigh[i]->id)) {
 				neigh[nb_neigh] = vcur->neigh[i] ;
-				atm_seen[nb_neigh] = neigh[nb_neigh]->id ;
 				nb_neigh++ ;
 			}
 		}
 
 		cur = cur->next ;
 	}
+	free_idset(atm_seen) ;
 
 	*nneigh = nb_neigh ;
 
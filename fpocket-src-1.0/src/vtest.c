@@ -0,0 +1,324 @@
+#include "../headers/vtest.h"
+
+/**
+
+## ----- GENERAL INFORMATION
+##
+## FILE 					vtest.c
+## LAST MODIFIED			17-10-29
+##
+## ----- SPECIFICATIONS
+##
+##	Batch version of testVvertice: test a set of candidate alpha spheres
+##	stored in packed arrays, using SSE or AVX2 instructions when the CPU
+##	has them (chosen at run time), and a scalar loop otherwise.
+##
+##	All versions do exactly the same float operations as testVvertice
+##	(distance = sqrt of the sum of squared differences, in the same
+##	order), so they accept and reject the same vertices and give the same
+##	radius. Comparisons to double constants (tolerance, electronegativity)
+##	are done against the greatest float lower than the constant, which is
+##	the same test for float values.
+##
+## ----- MODIFICATIONS HISTORY
+##
+##	17-10-29	     Created
+##
+## ----- TODO or SUGGESTIONS
+##
+
+*/
+
+/**
+    COPYRIGHT DISCLAIMER
+
+    Vincent Le Guilloux, Peter Schmidtke and Pierre Tuffery, hereby
+	disclaim all copyright interest in the program “fpocket” (which
+	performs protein cavity detection) written by Vincent Le Guilloux and Peter
+	Schmidtke.
+
+    Vincent Le Guilloux  28 November 2008
+    Peter Schmidtke      28 November 2008
+    Pierre Tuffery       28 November 2008
+
+    GNU GPL
+
+    This file is part of the fpocket package.
+
+    fpocket is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    fpocket is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
+
+**/
+
+/* Same constants as testVvertice and fill_vvertice (voronoi.c) */
+#define M_VTEST_PREC_TOLERANCE 1e-4
+#define M_VTEST_APOL_ELECTRONEG 2.8
+
+static void vtest_scalar(s_vtest_batch *b, int from, float min, float max,
+						 float tol, float apol) ;
+#ifdef M_VTEST_X86
+static void vtest_sse(s_vtest_batch *b, int n, float min, float max,
+					  float tol, float apol) ;
+static void vtest_avx2(s_vtest_batch *b, int n, float min, float max,
+					   float tol, float apol) ;
+#endif
+static float get_float_below(double x) ;
+
+static int ST_vtest_impl = M_VTEST_AUTO ;
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_batch
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Test all candidates of a batch for the alpha sphere conditions (see
+	testVvertice), and count their apolar atoms.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_vtest_batch *b    : The batch, results are stored in b->ray and
+							b->napol
+	@ float min_asph_size : Minimum size of alpha spheres.
+	@ float max_asph_size : Maximum size of alpha spheres.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	void
+   -----------------------------------------------------------------------------
+*/
+void vtest_batch(s_vtest_batch *b, float min_asph_size, float max_asph_size)
+{
+	int done = 0 ;
+	float tol = get_float_below(M_VTEST_PREC_TOLERANCE),
+		  apol = get_float_below(M_VTEST_APOL_ELECTRONEG) ;
+
+	if(ST_vtest_impl == M_VTEST_AUTO) vtest_set_impl(M_VTEST_AUTO) ;
+
+#ifdef M_VTEST_X86
+	if(ST_vtest_impl == M_VTEST_AVX2) {
+		done = b->n - b->n % 8 ;
+		vtest_avx2(b, done, min_asph_size, max_asph_size, tol, apol) ;
+	}
+	else if(ST_vtest_impl == M_VTEST_SSE) {
+		done = b->n - b->n % 4 ;
+		vtest_sse(b, done, min_asph_size, max_asph_size, tol, apol) ;
+	}
+#endif
+	/* Remaining candidates */
+	vtest_scalar(b, done, min_asph_size, max_asph_size, tol, apol) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_set_impl
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Choose the implementation used by vtest_batch. M_VTEST_AUTO takes the best
+	one supported by the CPU. An implementation not supported is replaced by
+	the best supported one.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ int impl : M_VTEST_AUTO, M_VTEST_SCALAR, M_VTEST_SSE or M_VTEST_AVX2
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: the implementation actually used
+   -----------------------------------------------------------------------------
+*/
+int vtest_set_impl(int impl)
+{
+	int best = M_VTEST_SCALAR ;
+
+#ifdef M_VTEST_X86
+	__builtin_cpu_init() ;
+	if(__builtin_cpu_supports("avx2")) best = M_VTEST_AVX2 ;
+	else if(__builtin_cpu_supports("sse2")) best = M_VTEST_SSE ;
+#endif
+	if(impl == M_VTEST_AUTO || impl > best) impl = best ;
+	ST_vtest_impl = impl ;
+
+	return impl ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_get_impl_name
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Name of the implementation used by vtest_batch.
+   -----------------------------------------------------------------------------
+*/
+const char* vtest_get_impl_name(void)
+{
+	if(ST_vtest_impl == M_VTEST_AUTO) vtest_set_impl(M_VTEST_AUTO) ;
+
+	switch(ST_vtest_impl) {
+		case M_VTEST_AVX2 : return "avx2" ;
+		case M_VTEST_SSE : return "sse" ;
+		default : return "scalar" ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_scalar
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Scalar test of the candidates from index from to the end of the batch.
+   -----------------------------------------------------------------------------
+*/
+static void vtest_scalar(s_vtest_batch *b, int from, float min, float max,
+						 float tol, float apol)
+{
+	int i, k ;
+	float dx, dy, dz, d[4] ;
+
+	for(i = from ; i < b->n ; i++) {
+		b->napol[i] = 0 ;
+		for(k = 0 ; k < 4 ; k++) {
+			dx = b->cx[i] - b->ax[k][i] ;
+			dy = b->cy[i] - b->ay[k][i] ;
+			dz = b->cz[i] - b->az[k][i] ;
+			d[k] = sqrtf((dx*dx) + (dy*dy) + (dz*dz)) ;
+			if(b->en[k][i] <= apol) b->napol[i]++ ;
+		}
+
+		if(min <= d[0] && d[0] <= max && fabsf(d[0] - d[1]) <= tol
+		   && fabsf(d[0] - d[2]) <= tol && fabsf(d[0] - d[3]) <= tol) {
+			b->ray[i] = d[0] ;
+		}
+		else b->ray[i] = -1.0 ;
+	}
+}
+
+#ifdef M_VTEST_X86
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_sse
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	SSE test of the candidates 0 to n-1, 4 at a time (n multiple of 4).
+   -----------------------------------------------------------------------------
+*/
+__attribute__((target("sse2")))
+static void vtest_sse(s_vtest_batch *b, int n, float min, float max,
+					  float tol, float apol)
+{
+	int i, k ;
+	__m128 d[4], dx, dy, dz, ok, ad,
+		   vmin = _mm_set1_ps(min),
+		   vmax = _mm_set1_ps(max),
+		   vtol = _mm_set1_ps(tol),
+		   vapol = _mm_set1_ps(apol),
+		   vneg = _mm_set1_ps(-1.0f),
+		   vabs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)) ;
+	__m128i napol ;
+
+	for(i = 0 ; i < n ; i += 4) {
+		__m128 cx = _mm_loadu_ps(b->cx + i),
+			   cy = _mm_loadu_ps(b->cy + i),
+			   cz = _mm_loadu_ps(b->cz + i) ;
+		napol = _mm_setzero_si128() ;
+
+		for(k = 0 ; k < 4 ; k++) {
+			dx = _mm_sub_ps(cx, _mm_loadu_ps(b->ax[k] + i)) ;
+			dy = _mm_sub_ps(cy, _mm_loadu_ps(b->ay[k] + i)) ;
+			dz = _mm_sub_ps(cz, _mm_loadu_ps(b->az[k] + i)) ;
+			d[k] = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+													 _mm_mul_ps(dy, dy)),
+										  _mm_mul_ps(dz, dz))) ;
+			/* Comparison masks are -1 when true */
+			napol = _mm_sub_epi32(napol, _mm_castps_si128(
+						_mm_cmple_ps(_mm_loadu_ps(b->en[k] + i), vapol))) ;
+		}
+
+		ok = _mm_and_ps(_mm_cmple_ps(vmin, d[0]), _mm_cmple_ps(d[0], vmax)) ;
+		for(k = 1 ; k < 4 ; k++) {
+			ad = _mm_and_ps(_mm_sub_ps(d[0], d[k]), vabs) ;
+			ok = _mm_and_ps(ok, _mm_cmple_ps(ad, vtol)) ;
+		}
+
+		_mm_storeu_ps(b->ray + i, _mm_or_ps(_mm_and_ps(ok, d[0]),
+										   _mm_andnot_ps(ok, vneg))) ;
+		_mm_storeu_si128((__m128i *) (b->napol + i), napol) ;
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	vtest_avx2
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	AVX2 test of the candidates 0 to n-1, 8 at a time (n multiple of 8).
+	No FMA is used, so results are the same as the scalar version.
+   -----------------------------------------------------------------------------
+*/
+__attribute__((target("avx2")))
+static void vtest_avx2(s_vtest_batch *b, int n, float min, float max,
+					   float tol, float apol)
+{
+	int i, k ;
+	__m256 d[4], dx, dy, dz, ok, ad,
+		   vmin = _mm256_set1_ps(min),
+		   vmax = _mm256_set1_ps(max),
+		   vtol = _mm256_set1_ps(tol),
+		   vapol = _mm256_set1_ps(apol),
+		   vneg = _mm256_set1_ps(-1.0f),
+		   vabs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)) ;
+	__m256i napol ;
+
+	for(i = 0 ; i < n ; i += 8) {
+		__m256 cx = _mm256_loadu_ps(b->cx + i),
+			   cy = _mm256_loadu_ps(b->cy + i),
+			   cz = _mm256_loadu_ps(b->cz + i) ;
+		napol = _mm256_setzero_si256() ;
+
+		for(k = 0 ; k < 4 ; k++) {
+			dx = _mm256_sub_ps(cx, _mm256_loadu_ps(b->ax[k] + i)) ;
+			dy = _mm256_sub_ps(cy, _mm256_loadu_ps(b->ay[k] + i)) ;
+			dz = _mm256_sub_ps(cz, _mm256_loadu_ps(b->az[k] + i)) ;
+			d[k] = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx),
+															  _mm256_mul_ps(dy, dy)),
+												_mm256_mul_ps(dz, dz))) ;
+			napol = _mm256_sub_epi32(napol, _mm256_castps_si256(
+						_mm256_cmp_ps(_mm256_loadu_ps(b->en[k] + i), vapol, _CMP_LE_OQ))) ;
+		}
+
+		ok = _mm256_and_ps(_mm256_cmp_ps(vmin, d[0], _CMP_LE_OQ),
+						   _mm256_cmp_ps(d[0], vmax, _CMP_LE_OQ)) ;
+		for(k = 1 ; k < 4 ; k++) {
+			ad = _mm256_and_ps(_mm256_sub_ps(d[0], d[k]), vabs) ;
+			ok = _mm256_and_ps(ok, _mm256_cmp_ps(ad, vtol, _CMP_LE_OQ)) ;
+		}
+
+		_mm256_storeu_ps(b->ray + i, _mm256_blendv_ps(vneg, d[0], ok)) ;
+		_mm256_storeu_si256((__m256i *) (b->napol + i), napol) ;
+	}
+}
+
+#endif
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	get_float_below
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION:
+	Greatest float strictly lower than x: for a float f, f < x is then the
+	same as f <= get_float_below(x).
+   -----------------------------------------------------------------------------
+*/
+static float get_float_below(double x)
+{
+	float f = (float) x ;
+	if((double) f >= x) f = nextafterf(f, -INFINITY) ;
+
+	return f ;
+}
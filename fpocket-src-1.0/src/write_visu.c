@@ -6,7 +6,7 @@
 ##
 ## FILE 					write_visu.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			02-12-08
+## LAST MODIFIED			17-11-13
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -15,6 +15,7 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-13	     Scripts made executable with chmod(2), no more system()
 ##  02-12-08    (v)  Comments UTD
 ##  29-11-08    (p)  Enhanced VMD output, corrected bug in pymol output
 ##  20-11-08    (p)  Just got rid of a memory issue (fflush after fclose) 
@@ -23,8 +24,6 @@
 ##	
 ## ----- TODO or SUGGESTIONS
 ##
-## (v) Handle system command failure
-##
 */
 
  /**
@@ -57,6 +56,8 @@
     along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
 
 **/
+
+static void set_executable(const char *path) ;
  
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
@@ -99,9 +100,7 @@ void write_vmd(char *pdb_name,char *pdb_out_name)
 {
 	char fout[250] = "" ;
 	char fout2[250] = "" ;
-	char sys_cmd[250] ="";
 	char c_tmp[255];
-	int status ;
 	
 	strcpy(c_tmp,pdb_name);
 	remove_ext(c_tmp) ;
@@ -120,8 +119,7 @@ void write_vmd(char *pdb_name,char *pdb_out_name)
 			fclose(f);
 			
 			/* Make tcl script executable, and Write tcl script */
-			sprintf(sys_cmd,"chmod +x %s",fout);
-			status = system(sys_cmd);
+			set_executable(fout);
 
 			
 			fprintf(f_tcl,"proc highlighting { colorId representation id selection } {\n");
@@ -197,10 +195,8 @@ void write_pymol(char *pdb_name,char *pdb_out_name)
 {
 	char fout[250] = "" ;
 	char fout2[250] = "" ;
-	char sys_cmd[250] ="";
 	FILE *f,*f_pml;
 	char c_tmp[255];
-	int status ;
 	
 	strcpy(c_tmp,pdb_name);
 	remove_ext(c_tmp) ;
@@ -216,8 +212,7 @@ void write_pymol(char *pdb_name,char *pdb_out_name)
                         fflush(f);
 			fclose(f);
 			
-			sprintf(sys_cmd,"chmod +x %s",fout);
-			status = system(sys_cmd);
+			set_executable(fout);
 			/* Write pml script */
 			fprintf(f_pml,"from pymol import cmd,stored\n");
 			fprintf(f_pml,"load %s\n",pdb_out_name);
@@ -244,3 +239,26 @@ void write_pymol(char *pdb_name,char *pdb_out_name)
 		fprintf(stderr, "! The file %s could not be opened!\n", fout);
 	}
 }
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	set_executable
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Make a script executable by those who can read it (as chmod +x), 
+	without running a shell.
+   -----------------------------------------------------------------------------
+   ## PARAMETERS:
+	@ const char *path : The script
+   -----------------------------------------------------------------------------
+   ## RETURN: void
+   -----------------------------------------------------------------------------
+*/
+static void set_executable(const char *path)
+{
+	struct stat st ;
+
+	if(stat(path, &st) != 0 || chmod(path, st.st_mode | ((st.st_mode & 0444) >> 2)) != 0) {
+		fprintf(stderr, "! Cannot make %s executable (%s)\n", path, strerror(errno)) ;
+	}
+}
@@ -6,7 +6,7 @@
 ##
 ## FILE 					writepdb.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			02-12-08
+## LAST MODIFIED			17-11-13
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -14,6 +14,9 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-13	     Records formatted by hand (fixed width numbers) and
+##					 written with fwrite, large buffer for the output files
+##					 (fopen_out). The fprintf versions are kept as *_naive.
 ##  02-12-08    (v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
 ##	01-01-08	(vp) Created (random date...)
@@ -55,12 +58,28 @@
     along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
 
 **/
+
+/**
+	Buffer of the output file opened by fopen_out, used by one file at a time
+*/
+static char ST_out_buf[M_WPDB_BUF_LEN] ;
+static FILE *ST_out_buf_file = NULL ;
+static pthread_mutex_t ST_out_buf_lock = PTHREAD_MUTEX_INITIALIZER ;
+
+/* Powers of 10 of the decimals written */
+static const double ST_wpdb_pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 } ;
+
+static char* wpdb_str(char *p, const char *s, int width) ;
+static char* wpdb_int(char *p, int v, int width) ;
+static char* wpdb_hex(char *p, int v, int width) ;
+static char* wpdb_fixed(char *p, float v, int width, int ndec) ;
  
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	write_pdb_atom_line
+	write_pdb_atom_line_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
+	Reference version of write_pdb_atom_line, using fprintf.
 	Write an atom in the following pdb format 2.3.
 	
 	COLUMNS      DATA TYPE        FIELD      DEFINITION
@@ -90,7 +109,7 @@
    ## RETURN:
    -----------------------------------------------------------------------------
 */
-void write_pdb_atom_line(FILE *f, const char rec_name[], int id, const char atom_name[], 
+void write_pdb_atom_line_naive(FILE *f, const char rec_name[], int id, const char atom_name[], 
 						 char alt_loc, const char res_name[], const char chain[], 
 						 int res_id, const char insert, float x, float y, float z, float occ, 
 						 float bfactor,	const char *symbol, int charge) 
@@ -130,9 +149,10 @@ void write_pdb_atom_line(FILE *f, const char rec_name[], int id, const char atom
 
 /**-----------------------------------------------------------------------------
    ## FUNCTION: 
-	write_pqr_atom_line
+	write_pqr_atom_line_naive
    -----------------------------------------------------------------------------
    ## SPECIFICATION: 
+	Reference version of write_pqr_atom_line, using fprintf.
 	Write an atom in pqr format.
 	
 	COLUMNS      DATA TYPE        FIELD      DEFINITION
@@ -159,7 +179,7 @@ void write_pdb_atom_line(FILE *f, const char rec_name[], int id, const char atom
    ## RETURN:
    -----------------------------------------------------------------------------
 */
-void write_pqr_atom_line(FILE *f, const char *rec_name, int id, const char *atom_name, 
+void write_pqr_atom_line_naive(FILE *f, const char *rec_name, int id, const char *atom_name, 
 						 char alt_loc, const char *res_name, const char *chain, 
 						 int res_id, const char insert, float x, float y, float z, float charge, 
 						 float radius) 
@@ -183,6 +203,7 @@ void write_pqr_atom_line(FILE *f, const char *rec_name, int id, const char *atom
 
  	if (res_id < 10000) sprintf(res_id_buf, "%4d", res_id);
  	else if (res_id < 65536) sprintf(res_id_buf, "%04x", res_id);
+ 	else strcpy(res_id_buf, "****");
  	
  	alt_loc = (alt_loc == '\0')? ' ': alt_loc;
  	
@@ -197,3 +218,251 @@ void write_pqr_atom_line(FILE *f, const char *rec_name, int id, const char *atom
  						 res_id_buf, insert, x, y, z, charge,radius) ;
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fopen_out
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Open an output file for writing, with a large buffer (M_WPDB_BUF_LEN)
+	when it's not used by another file, so that a file is written with a
+	few system calls. The buffer is reused from one file to another. The
+	file must be closed by fclose_out.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char *path : The file path
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	FILE *: The file, NULL if it can't be opened
+   -----------------------------------------------------------------------------
+*/
+FILE* fopen_out(const char *path)
+{
+	FILE *f = fopen(path, "w") ;
+
+	if(f && pthread_mutex_trylock(&ST_out_buf_lock) == 0) {
+		if(setvbuf(f, ST_out_buf, _IOFBF, M_WPDB_BUF_LEN) == 0) ST_out_buf_file = f ;
+		else pthread_mutex_unlock(&ST_out_buf_lock) ;
+	}
+
+	return f ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	fclose_out
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Close a file opened by fopen_out, and release its buffer.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ FILE *f : The file
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: The value returned by fclose
+   -----------------------------------------------------------------------------
+*/
+int fclose_out(FILE *f)
+{
+	int status = fclose(f) ;
+
+	if(f == ST_out_buf_file) {
+		ST_out_buf_file = NULL ;
+		pthread_mutex_unlock(&ST_out_buf_lock) ;
+	}
+
+	return status ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	wpdb_str, wpdb_int, wpdb_hex, wpdb_fixed
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Fixed width fields of a record, written at p, as printf would write
+	them: string right justified (%*s) or left justified if width < 0 (%-*s),
+	integer (%*d), hexadecimal integer padded with zeros (%0*x), and real
+	with ndec decimals (%*.*f).
+	For a real, v*10^ndec is exact in double precision (24 bits of the float
+	and at most 20 bits for 10^6), so rounding it to the nearest integer,
+	ties to even as the default rounding mode, gives the digits of printf.
+	Values too large for this (or not finite) are given to sprintf.
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	char *: The end of the field
+   -----------------------------------------------------------------------------
+*/
+static char* wpdb_str(char *p, const char *s, int width)
+{
+	int len = strlen(s),
+		pad = (width < 0 ? -width : width) - len ;
+
+	if(width > 0) for( ; pad > 0 ; pad--) *(p++) = ' ' ;
+	memcpy(p, s, len) ;
+	p += len ;
+	for( ; pad > 0 ; pad--) *(p++) = ' ' ;
+
+	return p ;
+}
+
+static char* wpdb_int(char *p, int v, int width)
+{
+	char tmp[16] ;
+	int n = 0 ;
+	unsigned int u = (v < 0) ? - (unsigned int) v : (unsigned int) v ;
+
+	do {
+		tmp[n++] = '0' + u%10 ;
+		u /= 10 ;
+	} while(u > 0) ;
+	if(v < 0) tmp[n++] = '-' ;
+
+	for(width -= n ; width > 0 ; width--) *(p++) = ' ' ;
+	while(n > 0) *(p++) = tmp[--n] ;
+
+	return p ;
+}
+
+static char* wpdb_hex(char *p, int v, int width)
+{
+	char tmp[16] ;
+	int n = 0 ;
+	unsigned int u = (unsigned int) v ;
+
+	do {
+		tmp[n++] = "0123456789abcdef"[u & 15] ;
+		u >>= 4 ;
+	} while(u > 0) ;
+
+	for(width -= n ; width > 0 ; width--) *(p++) = '0' ;
+	while(n > 0) *(p++) = tmp[--n] ;
+
+	return p ;
+}
+
+static char* wpdb_fixed(char *p, float v, int width, int ndec)
+{
+	char tmp[32] ;
+	int n = 0 ;
+	double d = fabs((double) v)*ST_wpdb_pow10[ndec] ;
+	long long m ;
+
+	if(!(d < 1e15)) return p + sprintf(p, "%*.*f", width, ndec, (double) v) ;
+
+	m = (long long) nearbyint(d) ;
+	for( ; n < ndec ; n++) {
+		tmp[n] = '0' + m%10 ;
+		m /= 10 ;
+	}
+	if(ndec > 0) tmp[n++] = '.' ;
+	do {
+		tmp[n++] = '0' + m%10 ;
+		m /= 10 ;
+	} while(m > 0) ;
+	if(signbit(v)) tmp[n++] = '-' ;
+
+	for(width -= n ; width > 0 ; width--) *(p++) = ' ' ;
+	while(n > 0) *(p++) = tmp[--n] ;
+
+	return p ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	write_pdb_atom_line
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Write an atom in the pdb format 2.3 (see write_pdb_atom_line_naive for
+	the columns). The record is formatted by hand in a buffer and written
+	with a single fwrite: same output as write_pdb_atom_line_naive.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void write_pdb_atom_line(FILE *f, const char rec_name[], int id, const char atom_name[], 
+						 char alt_loc, const char res_name[], const char chain[], 
+						 int res_id, const char insert, float x, float y, float z, float occ, 
+						 float bfactor,	const char *symbol, int charge) 
+{
+	char line[M_WPDB_LINE_LEN],
+		 *p = line ;
+
+	p = wpdb_str(p, rec_name, -6) ;
+	if(id < 100000) p = wpdb_int(p, id, 5) ;
+	else p = wpdb_hex(p, id, 5) ;
+	*(p++) = ' ' ;
+	p = wpdb_str(p, atom_name, 4) ;
+	*(p++) = (alt_loc == '\0') ? ' ' : alt_loc ;
+	p = wpdb_str(p, res_name, -4) ;
+	*(p++) = chain[0] ;
+
+	if(res_id < 10000) p = wpdb_int(p, res_id, 4) ;
+	else if(res_id < 65536) p = wpdb_hex(p, res_id, 4) ;
+	else p = wpdb_str(p, "****", 4) ;
+	*(p++) = insert ;
+	p = wpdb_str(p, "", 3) ;
+
+	p = wpdb_fixed(p, x, 8, 3) ;
+	p = wpdb_fixed(p, y, 8, 3) ;
+	p = wpdb_fixed(p, z, 8, 3) ;
+	p = wpdb_fixed(p, occ, 6, 2) ;
+	p = wpdb_fixed(p, bfactor, 6, 2) ;
+	p = wpdb_str(p, "", 10) ;
+
+	p = wpdb_str(p, symbol, 2) ;
+	if(charge == -1) p = wpdb_str(p, "", 2) ;
+	else p = wpdb_int(p, charge, 2) ;
+	*(p++) = '\n' ;
+
+	fwrite(line, 1, p - line, f) ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION: 
+	write_pqr_atom_line
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Write an atom in pqr format (see write_pqr_atom_line_naive for the
+	columns). The record is formatted by hand in a buffer and written with a
+	single fwrite: same output as write_pqr_atom_line_naive.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void write_pqr_atom_line(FILE *f, const char *rec_name, int id, const char *atom_name, 
+						 char alt_loc, const char *res_name, const char *chain, 
+						 int res_id, const char insert, float x, float y, float z, float charge, 
+						 float radius) 
+{
+	char line[M_WPDB_LINE_LEN],
+		 *p = line ;
+
+	p = wpdb_str(p, rec_name, -6) ;
+	if(id < 100000) p = wpdb_int(p, id, 5) ;
+	else p = wpdb_hex(p, id, 5) ;
+	*(p++) = ' ' ;
+	p = wpdb_str(p, atom_name, 4) ;
+	*(p++) = (alt_loc == '\0') ? ' ' : alt_loc ;
+	p = wpdb_str(p, res_name, -4) ;
+	*(p++) = chain[0] ;
+
+	if(res_id < 10000) p = wpdb_int(p, res_id, 4) ;
+	else if(res_id < 65536) p = wpdb_hex(p, res_id, 4) ;
+	else p = wpdb_str(p, "****", 4) ;
+	*(p++) = insert ;
+	p = wpdb_str(p, "", 3) ;
+
+	p = wpdb_fixed(p, x, 8, 3) ;
+	p = wpdb_fixed(p, y, 8, 3) ;
+	p = wpdb_fixed(p, z, 8, 3) ;
+	p = wpdb_str(p, "", 2) ;
+	p = wpdb_fixed(p, charge, 6, 2) ;
+	p = wpdb_str(p, "", 3) ;
+	p = wpdb_fixed(p, radius, 6, 2) ;
+	*(p++) = '\n' ;
+
+	fwrite(line, 1, p - line, f) ;
+}
@@ -6,7 +6,7 @@
 ##
 ## FILE 					writepocket.c
 ## AUTHORS					P. Schmidtke and V. Le Guilloux
-## LAST MODIFIED			02-12-08
+## LAST MODIFIED			17-11-15
 ##
 ## ----- SPECIFICATIONS
 ##
@@ -14,6 +14,14 @@
 ##
 ## ----- MODIFICATIONS HISTORY
 ##
+##	17-11-15	     write_pockets_single_pdb/pqr return a status
+##	17-11-15	     Atom strings of the binary result copied with memcpy
+##	17-11-14	     Binary columnar result (write_pockets_bin)
+##	17-11-13	     Files opened with fopen_out (large buffer). Pockets
+##					 written in a FILE (print_pocket_pqr/pdb), and packed
+##					 in a single indexed file (write_pockets_pack)
+##	17-11-08	     Contacted atoms kept in a set of ids (s_idset)
+##	17-11-04	     Vertices read from the table of the pockets when built
 ##  02-12-08    (v)  Comments UTD
 ##	01-04-08	(v)  Added template for comments and creation of history
 ##	01-01-08	(vp) Created (random date...)
@@ -53,6 +61,50 @@
     along with fpocket.  If not, see <http://www.gnu.org/licenses/>.
 
 **/
+
+/**
+	Descriptors written in the binary result: column name and field of s_desc
+*/
+typedef struct s_fpb_desc
+{
+	const char *name ;
+	size_t offset ;
+	int type ;
+
+} s_fpb_desc ;
+
+static const s_fpb_desc ST_fpb_desc[] = {
+	{ "desc_hydrophobicity_score", offsetof(s_desc, hydrophobicity_score), M_FPB_F32 },
+	{ "desc_volume_score", offsetof(s_desc, volume_score), M_FPB_F32 },
+	{ "desc_volume", offsetof(s_desc, volume), M_FPB_F32 },
+	{ "desc_prop_polar_atm", offsetof(s_desc, prop_polar_atm), M_FPB_F32 },
+	{ "desc_mean_asph_ray", offsetof(s_desc, mean_asph_ray), M_FPB_F32 },
+	{ "desc_masph_sacc", offsetof(s_desc, masph_sacc), M_FPB_F32 },
+	{ "desc_apolar_asphere_prop", offsetof(s_desc, apolar_asphere_prop), M_FPB_F32 },
+	{ "desc_mean_loc_hyd_dens", offsetof(s_desc, mean_loc_hyd_dens), M_FPB_F32 },
+	{ "desc_as_density", offsetof(s_desc, as_density), M_FPB_F32 },
+	{ "desc_as_max_dst", offsetof(s_desc, as_max_dst), M_FPB_F32 },
+	{ "desc_flex", offsetof(s_desc, flex), M_FPB_F32 },
+	{ "desc_nas_norm", offsetof(s_desc, nas_norm), M_FPB_F32 },
+	{ "desc_polarity_score_norm", offsetof(s_desc, polarity_score_norm), M_FPB_F32 },
+	{ "desc_mean_loc_hyd_dens_norm", offsetof(s_desc, mean_loc_hyd_dens_norm), M_FPB_F32 },
+	{ "desc_prop_asapol_norm", offsetof(s_desc, prop_asapol_norm), M_FPB_F32 },
+	{ "desc_as_density_norm", offsetof(s_desc, as_density_norm), M_FPB_F32 },
+	{ "desc_as_max_dst_norm", offsetof(s_desc, as_max_dst_norm), M_FPB_F32 },
+	{ "desc_as_max_r", offsetof(s_desc, as_max_r), M_FPB_F32 },
+	{ "desc_nb_asph", offsetof(s_desc, nb_asph), M_FPB_I32 },
+	{ "desc_polarity_score", offsetof(s_desc, polarity_score), M_FPB_I32 },
+	{ "desc_charge_score", offsetof(s_desc, charge_score), M_FPB_I32 }
+} ;
+
+#define M_FPB_NDESC (int) (sizeof(ST_fpb_desc)/sizeof(ST_fpb_desc[0]))
+
+/* Columns of the binary result: descriptors and 22 other columns */
+#define M_FPB_MAX_COLS (M_FPB_NDESC + 22)
+
+static void fpb_add_col(s_fpb_col *cols, const void **data, int *ncols, 
+						const char *name, int type, int width, int nrows, 
+						const void *values) ;
  
 
 /**-----------------------------------------------------------------------------
@@ -70,13 +122,15 @@
 	@ c_lst_pockets *pockets : All pockets
    -----------------------------------------------------------------------------
    ## RETURN:
+	int: 0 if the file has been written, 1 if not
    -----------------------------------------------------------------------------
 */
-void write_pockets_single_pdb(const char out[],  s_pdb *pdb, c_lst_pockets *pockets) 
+int write_pockets_single_pdb(const char out[],  s_pdb *pdb, c_lst_pockets *pockets) 
 {
 	node_pocket *nextPocket ;
-	node_vertice *nextVertice ;
-	FILE *f = fopen(out, "w") ;
+	s_vvertice **verts = NULL ;
+	int k, nvert, tofree ;
+	FILE *f = fopen_out(out) ;
 	if(f) {
 		if(pdb) {
 			if(pdb->latoms) write_pdb_atoms(f, pdb->latoms, pdb->natoms ) ;
@@ -86,25 +140,20 @@ void write_pockets_single_pdb(const char out[],  s_pdb *pdb, c_lst_pockets *pock
 			pockets->current = pockets->first ;
 
 			while(pockets->current){
-				pockets->current->pocket->v_lst->current = pockets->current->pocket->v_lst->first ;
-
-				while(pockets->current->pocket->v_lst->current){
- 					write_pdb_vert(f, pockets->current->pocket->v_lst->current->vertice) ;
-
-					nextVertice = pockets->current->pocket->v_lst->current->next;
-					pockets->current->pocket->v_lst->current = nextVertice;
-				}
+				verts = get_pocket_vert_array(pockets->current->pocket, &nvert, &tofree) ;
+				for(k = 0 ; k < nvert ; k++) write_pdb_vert(f, verts[k]) ;
+				if(tofree) my_free(verts) ;
 
 				nextPocket=pockets->current->next;
 				pockets->current=nextPocket;
 			}
 		}
 
-		fclose(f) ;
-	}
-	else {
-		fprintf(stderr, "! The file %s could not be opened!\n", out);
+		return (fclose_out(f) != 0) ;
 	}
+
+	fprintf(stderr, "! The file %s could not be opened!\n", out);
+	return 1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -150,14 +199,16 @@ void write_pdb_atoms(FILE *f, s_atm *atoms, int natoms)
 	@ c_lst_pockets *pockets : List of pockets
    -----------------------------------------------------------------------------
    ## RETURN:
+	int: 0 if the file has been written, 1 if not
    -----------------------------------------------------------------------------
 */
-void write_pockets_single_pqr(const char out[], c_lst_pockets *pockets) 
+int write_pockets_single_pqr(const char out[], c_lst_pockets *pockets) 
 {
 	node_pocket *nextPocket ;
-	node_vertice *nextVertice ;
+	s_vvertice **verts = NULL ;
+	int k, nvert, tofree ;
 
-	FILE *f = fopen(out, "w") ;
+	FILE *f = fopen_out(out) ;
 	if(f) {
 
 		if(pockets){
@@ -167,14 +218,9 @@ void write_pockets_single_pqr(const char out[], c_lst_pockets *pockets)
 			pockets->current = pockets->first ;
 
 			while(pockets->current){
-				pockets->current->pocket->v_lst->current = pockets->current->pocket->v_lst->first ;
-
-				while(pockets->current->pocket->v_lst->current){
-					write_pqr_vert(f, pockets->current->pocket->v_lst->current->vertice) ;
-
-					nextVertice = pockets->current->pocket->v_lst->current->next;
-					pockets->current->pocket->v_lst->current = nextVertice;
-				}
+				verts = get_pocket_vert_array(pockets->current->pocket, &nvert, &tofree) ;
+				for(k = 0 ; k < nvert ; k++) write_pqr_vert(f, verts[k]) ;
+				if(tofree) my_free(verts) ;
 
 				nextPocket=pockets->current->next;
 				pockets->current=nextPocket;
@@ -182,11 +228,11 @@ void write_pockets_single_pqr(const char out[], c_lst_pockets *pockets)
 		}
 
 		fprintf(f, "TER\nEND\n") ;
-		fclose(f) ;
-	}
-	else {
-		fprintf(stderr, "! The file %s could not be opened!\n", out);
+		return (fclose_out(f) != 0) ;
 	}
+
+	fprintf(stderr, "! The file %s could not be opened!\n", out);
+	return 1 ;
 }
 
 /**-----------------------------------------------------------------------------
@@ -231,6 +277,317 @@ void write_each_pocket(const char out_path[], c_lst_pockets *pockets)
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	write_pockets_pack
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Write each pocket in a single packed file, instead of one pqr (vertices)
+	and one pdb (atoms) file per pocket (write_each_pocket). The content of
+	pocketN_vert.pqr and pocketN_atm.pdb is written as is, one after the
+	other, and followed by an index giving the offset (from the start of the
+	file), the size and the name of each of them:
+
+	FPOCKET_PACK 1
+	<pocket0_vert.pqr><pocket0_atm.pdb><pocket1_vert.pqr>...
+	INDEX <number of entries>
+	<offset> <size> pocket0_vert.pqr
+	...
+	END_INDEX <offset of the INDEX line>
+
+	A reader seeks to the last line to find the index. The pack is written
+	with a single buffered stream instead of creating 2 files per pocket.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char out[]       : Output file path
+	@ c_lst_pockets *pockets : List of pockets
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 0 if the file has been written, 1 if not
+   -----------------------------------------------------------------------------
+*/
+int write_pockets_pack(const char out[], c_lst_pockets *pockets)
+{
+	node_pocket *pcur ;
+	long *offsets = NULL,
+		 index_off ;
+	int i, n = 0, status = 0 ;
+
+	FILE *f = fopen_out(out) ;
+	if(!f) {
+		fprintf(stderr, "! The file %s could not be opened!\n", out);
+		return 1 ;
+	}
+
+	fprintf(f, "%s %d\n", M_PACK_MAGIC, M_PACK_VERSION) ;
+
+	if(pockets) {
+		for(pcur = pockets->first ; pcur ; pcur = pcur->next) n++ ;
+		offsets = (long*)my_malloc(sizeof(long)*(2*n + 1)) ;
+		n = 0 ;
+		for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+			offsets[n++] = ftell(f) ;
+			print_pocket_pqr(f, pcur->pocket) ;
+			offsets[n++] = ftell(f) ;
+			print_pocket_pdb(f, pcur->pocket) ;
+		}
+	}
+	index_off = ftell(f) ;
+
+	fprintf(f, "INDEX %d\n", n) ;
+	for(i = 0 ; i < n ; i++) {
+		fprintf(f, "%ld %ld pocket%d_%s\n", offsets[i], 
+				((i < n-1) ? offsets[i+1] : index_off) - offsets[i], 
+				i/2, (i%2 == 0) ? "vert.pqr" : "atm.pdb") ;
+	}
+	fprintf(f, "END_INDEX %ld\n", index_off) ;
+
+	if(ferror(f)) status = 1 ;
+	if(fclose_out(f) != 0) status = 1 ;
+	if(status) fprintf(stderr, "! Error while writing %s\n", out);
+	if(offsets) my_free(offsets) ;
+
+	return status ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	write_pockets_bin
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Write the pockets in the binary columnar format read by fpb_open (see
+	fpbin.h): table of the pockets (score, center, descriptors), table of the
+	alpha spheres and table of the atoms contacted, stored once, each pocket
+	giving its alpha spheres and atoms as a range of rows (CSR). Atoms of a
+	pocket are in the order of its pocketN_atm.pdb file.
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ const char out[]       : Output file path
+	@ s_pdb *pdb             : The structure (atoms contacted are in its list)
+	@ c_lst_pockets *pockets : List of pockets
+   -----------------------------------------------------------------------------
+   ## RETURN:
+	int: 0 if the file has been written, 1 if not
+   -----------------------------------------------------------------------------
+*/
+int write_pockets_bin(const char out[], s_pdb *pdb, c_lst_pockets *pockets)
+{
+	node_pocket *pcur ;
+	s_pocket *p ;
+	s_vvertice **verts ;
+	s_atm *a ;
+	s_fpb_header h ;
+	s_fpb_col cols[M_FPB_MAX_COLS] ;
+	const void *data[M_FPB_MAX_COLS] ;
+	static const char pad[M_FPB_ALIGN] = { 0 } ;
+	int i, j, k, nvert, tofree, row, ncols = 0, np = 0, nsph = 0, nmem = 0, 
+		natm = 0, status = 0 ;
+	uint64_t off, len ;
+	FILE *f ;
+
+	if(pockets) for(pcur = pockets->first ; pcur ; pcur = pcur->next) {
+		np++ ;
+		nsph += pcur->pocket->v_lst->n_vertices ;
+	}
+
+	/* Pockets, alpha spheres and atoms (at most 4 per alpha sphere) */
+	int *pid = (int *) my_malloc(sizeof(int)*(np + 1)),
+		*napol = (int *) my_malloc(sizeof(int)*(np + 1)),
+		*sph_ptr = (int *) my_malloc(sizeof(int)*(np + 1)),
+		*atm_ptr = (int *) my_malloc(sizeof(int)*(np + 1)),
+		*aa = (int *) my_malloc(sizeof(int)*(20*np + 1)),
+		*desc = (int *) my_malloc(sizeof(int)*(M_FPB_NDESC*np + 1)),
+		*sph_pol = (int *) my_malloc(sizeof(int)*(nsph + 1)),
+		*sph_atm = (int *) my_malloc(sizeof(int)*(4*nsph + 1)),
+		*mem = (int *) my_malloc(sizeof(int)*(4*nsph + 1)),
+		*atm_id = (int *) my_malloc(sizeof(int)*(4*nsph + 1)),
+		*atm_res_id = (int *) my_malloc(sizeof(int)*(4*nsph + 1)),
+		*atm_row = (int *) my_malloc(sizeof(int)*(pdb->natoms + 1)) ;
+	float *score = (float *) my_malloc(sizeof(float)*(np + 1)),
+		  *center = (float *) my_malloc(sizeof(float)*(3*np + 1)),
+		  *sph_c = (float *) my_malloc(sizeof(float)*(3*nsph + 1)),
+		  *sph_r = (float *) my_malloc(sizeof(float)*(nsph + 1)),
+		  *atm_c = (float *) my_malloc(sizeof(float)*(12*nsph + 1)) ;
+	char *atm_name = (char *) my_calloc(5*4*nsph + 1, sizeof(char)),
+		 *atm_res = (char *) my_calloc(8*4*nsph + 1, sizeof(char)),
+		 *atm_chain = (char *) my_calloc(5*4*nsph + 1, sizeof(char)),
+		 *atm_ins = (char *) my_calloc(4*nsph + 1, sizeof(char)),
+		 *atm_sym = (char *) my_calloc(3*4*nsph + 1, sizeof(char)) ;
+
+	/* Rows of the atoms of the structure in the atom table, -1 if none */
+	for(i = 0 ; i < pdb->natoms ; i++) atm_row[i] = -1 ;
+
+	nsph = 0 ;
+	for(i = 0, pcur = np ? pockets->first : NULL ; pcur && !status ; pcur = pcur->next, i++) {
+		p = pcur->pocket ;
+		pid[i] = p->v_lst->first->vertice->resid ;
+		score[i] = p->score ;
+		for(k = 0 ; k < 3 ; k++) center[3*i + k] = p->bary[k] ;
+		napol[i] = p->nAlphaApol ;
+		for(k = 0 ; k < 20 ; k++) aa[20*i + k] = p->pdesc->aa_compo[k] ;
+		for(k = 0 ; k < M_FPB_NDESC ; k++) {
+			memcpy(desc + k*np + i, (char *) p->pdesc + ST_fpb_desc[k].offset, 4) ;
+		}
+
+		sph_ptr[i] = nsph ;
+		atm_ptr[i] = nmem ;
+		verts = get_pocket_vert_array(p, &nvert, &tofree) ;
+		s_idset *atm_ids = alloc_idset(nvert) ;
+		for(k = 0 ; k < nvert && !status ; k++, nsph++) {
+			sph_c[3*nsph] = verts[k]->x ;
+			sph_c[3*nsph + 1] = verts[k]->y ;
+			sph_c[3*nsph + 2] = verts[k]->z ;
+			sph_r[nsph] = verts[k]->ray ;
+			sph_pol[nsph] = verts[k]->type ;
+
+			for(j = 0 ; j < 4 ; j++) {
+				a = verts[k]->neigh[j] ;
+				if(a < pdb->latoms || a >= pdb->latoms + pdb->natoms) {
+					status = 1 ;
+					break ;
+				}
+				row = atm_row[a - pdb->latoms] ;
+				if(row < 0) {
+					row = atm_row[a - pdb->latoms] = natm++ ;
+					atm_id[row] = a->id ;
+					atm_res_id[row] = a->res_id ;
+					atm_c[3*row] = a->x ;
+					atm_c[3*row + 1] = a->y ;
+					atm_c[3*row + 2] = a->z ;
+					memcpy(atm_name + 5*row, a->name, strnlen(a->name, 4)) ;
+					memcpy(atm_res + 8*row, a->res_name, strnlen(a->res_name, 7)) ;
+					memcpy(atm_chain + 5*row, a->chain, strnlen(a->chain, 4)) ;
+					atm_ins[row] = a->pdb_insert ;
+					memcpy(atm_sym + 3*row, a->symbol, strnlen(a->symbol, 2)) ;
+				}
+				sph_atm[4*nsph + j] = row ;
+
+				/* Atoms of the pocket, as in print_pocket_pdb */
+				if(add_idset(atm_ids, a->id)) mem[nmem++] = row ;
+			}
+		}
+		free_idset(atm_ids) ;
+		if(tofree) my_free(verts) ;
+	}
+	sph_ptr[np] = nsph ;
+	atm_ptr[np] = nmem ;
+
+	/* Columns */
+	memset(cols, 0, sizeof(cols)) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_ID, M_FPB_I32, 1, np, pid) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_SCORE, M_FPB_F32, 1, np, score) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_CENTER, M_FPB_F32, 3, np, center) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_NAPOL, M_FPB_I32, 1, np, napol) ;
+	for(k = 0 ; k < M_FPB_NDESC ; k++) {
+		fpb_add_col(cols, data, &ncols, ST_fpb_desc[k].name, ST_fpb_desc[k].type, 
+					1, np, desc + k*np) ;
+	}
+	fpb_add_col(cols, data, &ncols, "desc_aa_compo", M_FPB_I32, 20, np, aa) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_SPH_PTR, M_FPB_I32, 1, np + 1, sph_ptr) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_ATM_PTR, M_FPB_I32, 1, np + 1, atm_ptr) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_POCK_ATOMS, M_FPB_I32, 1, nmem, mem) ;
+
+	fpb_add_col(cols, data, &ncols, M_FPB_SPH_CENTER, M_FPB_F32, 3, nsph, sph_c) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_SPH_RADIUS, M_FPB_F32, 1, nsph, sph_r) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_SPH_POLAR, M_FPB_I32, 1, nsph, sph_pol) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_SPH_ATOMS, M_FPB_I32, 4, nsph, sph_atm) ;
+
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_ID, M_FPB_I32, 1, natm, atm_id) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_CENTER, M_FPB_F32, 3, natm, atm_c) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_NAME, M_FPB_CHAR, 5, natm, atm_name) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_RES_NAME, M_FPB_CHAR, 8, natm, atm_res) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_CHAIN, M_FPB_CHAR, 5, natm, atm_chain) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_RES_ID, M_FPB_I32, 1, natm, atm_res_id) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_INSERT, M_FPB_CHAR, 1, natm, atm_ins) ;
+	fpb_add_col(cols, data, &ncols, M_FPB_ATM_SYMBOL, M_FPB_CHAR, 3, natm, atm_sym) ;
+
+	/* Offsets, each column aligned */
+	off = sizeof(s_fpb_header) + ncols*sizeof(s_fpb_col) ;
+	for(i = 0 ; i < ncols ; i++) {
+		off = (off + M_FPB_ALIGN - 1)/M_FPB_ALIGN*M_FPB_ALIGN ;
+		cols[i].offset = off ;
+		off += cols[i].nrows*cols[i].width*((cols[i].type == M_FPB_CHAR) ? 1 : 4) ;
+	}
+
+	memset(&h, 0, sizeof(h)) ;
+	memcpy(h.magic, M_FPB_MAGIC, 8) ;
+	h.version = M_FPB_VERSION ;
+	h.byte_order = M_FPB_BYTE_ORDER ;
+	h.ncols = ncols ;
+	h.npockets = np ;
+	h.nspheres = nsph ;
+	h.natoms = natm ;
+	h.nmembers = nmem ;
+	h.size = off ;
+
+	/* Writing */
+	f = status ? NULL : fopen_out(out) ;
+	if(f) {
+		fwrite(&h, sizeof(h), 1, f) ;
+		fwrite(cols, sizeof(s_fpb_col), ncols, f) ;
+		off = sizeof(s_fpb_header) + ncols*sizeof(s_fpb_col) ;
+		for(i = 0 ; i < ncols ; i++) {
+			fwrite(pad, 1, cols[i].offset - off, f) ;
+			len = cols[i].nrows*cols[i].width*((cols[i].type == M_FPB_CHAR) ? 1 : 4) ;
+			fwrite(data[i], 1, len, f) ;
+			off = cols[i].offset + len ;
+		}
+		if(ferror(f)) status = 1 ;
+		if(fclose_out(f) != 0) status = 1 ;
+		if(status) fprintf(stderr, "! Error while writing %s\n", out);
+	}
+	else if(status) {
+		fprintf(stderr, "! Atoms of the pockets not in the structure, %s not written\n", out) ;
+	}
+	else {
+		fprintf(stderr, "! The file %s could not be opened!\n", out);
+		status = 1 ;
+	}
+
+	my_free(pid) ; my_free(napol) ; my_free(sph_ptr) ; my_free(atm_ptr) ;
+	my_free(aa) ; my_free(desc) ; my_free(sph_pol) ; my_free(sph_atm) ;
+	my_free(mem) ; my_free(atm_id) ; my_free(atm_res_id) ; my_free(atm_row) ;
+	my_free(score) ; my_free(center) ; my_free(sph_c) ; my_free(sph_r) ;
+	my_free(atm_c) ; my_free(atm_name) ; my_free(atm_res) ; my_free(atm_chain) ;
+	my_free(atm_ins) ; my_free(atm_sym) ;
+
+	return status ;
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	fpb_add_col
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Add a column to the directory of a binary result (its offset is set
+	when all columns are known).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ s_fpb_col *cols    : The directory
+	@ const void **data  : Values of each column
+	@ int *ncols         : Number of columns
+	@ const char *name   : Name of the column
+	@ int type           : M_FPB_F32, M_FPB_I32 or M_FPB_CHAR
+	@ int width          : Values per row
+	@ int nrows          : Number of rows
+	@ const void *values : The values
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+static void fpb_add_col(s_fpb_col *cols, const void **data, int *ncols, 
+						const char *name, int type, int width, int nrows, 
+						const void *values)
+{
+	s_fpb_col *c = cols + *ncols ;
+
+	strncpy(c->name, name, M_FPB_NAME_LEN - 1) ;
+	c->type = type ;
+	c->width = width ;
+	c->nrows = nrows ;
+	data[(*ncols)++] = values ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	void write_pocket_pqr
@@ -248,47 +605,67 @@ void write_each_pocket(const char out_path[], c_lst_pockets *pockets)
 */
 void write_pocket_pqr(const char out[], s_pocket *pocket) 
 {
-	node_vertice *vcur = NULL ;
-
-	FILE *f = fopen(out, "w") ;
+	FILE *f = fopen_out(out) ;
 	if(f && pocket) {
-		fprintf(f, "HEADER\n") ;
-		fprintf(f, "HEADER This is a pqr format file writen by the programm fpocket.                 \n") ;
-		fprintf(f, "HEADER It represent the voronoi vertices of a single pocket found by the         \n") ;
-		fprintf(f, "HEADER algorithm.                                                                \n") ;
-		fprintf(f, "HEADER                                                                           \n") ;
-		fprintf(f, "HEADER Information about the pocket %5d:\n", pocket->v_lst->first->vertice->resid) ;
-		fprintf(f, "HEADER 0  - Pocket Score                      : %.4f\n", pocket->score) ;
-		fprintf(f, "HEADER 1  - Number of V. Vertices             : %5d\n", pocket->pdesc->nb_asph) ;
-		fprintf(f, "HEADER 2  - Mean alpha-sphere radius          : %.4f\n", pocket->pdesc->mean_asph_ray) ;
-		fprintf(f, "HEADER 3  - Mean alpha-sphere SA              : %.4f\n", pocket->pdesc->masph_sacc) ;
-		fprintf(f, "HEADER 4  - Mean B-factor                     : %.4f\n", pocket->pdesc->flex) ;
-		fprintf(f, "HEADER 5  - Hydrophobicity Score              : %.4f\n", pocket->pdesc->hydrophobicity_score) ;
-		fprintf(f, "HEADER 6  - Polarity Score                    : %5d\n", pocket->pdesc->polarity_score) ;
-		fprintf(f, "HEADER 7  - Volume Score                      : %.4f\n", pocket->pdesc->volume_score) ;
-		fprintf(f, "HEADER 8  - Real volume (approximation)       : %.4f\n", pocket->pdesc->volume) ;
-		fprintf(f, "HEADER 9  - Charge Score                      : %5d\n", pocket->pdesc->charge_score) ;
-		fprintf(f, "HEADER 10 - Local hydrophobic density Score   : %.4f\n", pocket->pdesc->mean_loc_hyd_dens) ;
-		fprintf(f, "HEADER 11 - Number of apolar alpha sphere     : %5d\n", pocket->nAlphaApol) ;
-		fprintf(f, "HEADER 12 - Proportion of apolar alpha sphere : %.4f\n", pocket->pdesc->apolar_asphere_prop) ;
-
-		vcur = pocket->v_lst->first ;
-
-		while(vcur){
-			write_pqr_vert(f, vcur->vertice) ;
-
-			vcur = vcur->next ;
-		}
-
-		fprintf(f, "TER\nEND\n") ;
-		fclose(f) ;
+		print_pocket_pqr(f, pocket) ;
+		fclose_out(f) ;
 	}
 	else {
 		if(!f) fprintf(stderr, "! The file %s could not be opened!\n", out);
-		else fprintf(stderr, "! Invalid pocket to write in write_pocket_pqr !\n");
+		else {
+			fprintf(stderr, "! Invalid pocket to write in write_pocket_pqr !\n");
+			fclose_out(f) ;
+		}
 	}
 }
 
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	print_pocket_pqr
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Print vertices of the pocket given in argument in the pqr format, in the
+	given buffer (content of a pocketN_vert.pqr file).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ FILE *f          : Buffer to write in
+	@ s_pocket *pocket : The pocket to write
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void print_pocket_pqr(FILE *f, s_pocket *pocket) 
+{
+	s_vvertice **verts = NULL ;
+	int k, nvert, tofree ;
+
+	fprintf(f, "HEADER\n") ;
+	fprintf(f, "HEADER This is a pqr format file writen by the programm fpocket.                 \n") ;
+	fprintf(f, "HEADER It represent the voronoi vertices of a single pocket found by the         \n") ;
+	fprintf(f, "HEADER algorithm.                                                                \n") ;
+	fprintf(f, "HEADER                                                                           \n") ;
+	fprintf(f, "HEADER Information about the pocket %5d:\n", pocket->v_lst->first->vertice->resid) ;
+	fprintf(f, "HEADER 0  - Pocket Score                      : %.4f\n", pocket->score) ;
+	fprintf(f, "HEADER 1  - Number of V. Vertices             : %5d\n", pocket->pdesc->nb_asph) ;
+	fprintf(f, "HEADER 2  - Mean alpha-sphere radius          : %.4f\n", pocket->pdesc->mean_asph_ray) ;
+	fprintf(f, "HEADER 3  - Mean alpha-sphere SA              : %.4f\n", pocket->pdesc->masph_sacc) ;
+	fprintf(f, "HEADER 4  - Mean B-factor                     : %.4f\n", pocket->pdesc->flex) ;
+	fprintf(f, "HEADER 5  - Hydrophobicity Score              : %.4f\n", pocket->pdesc->hydrophobicity_score) ;
+	fprintf(f, "HEADER 6  - Polarity Score                    : %5d\n", pocket->pdesc->polarity_score) ;
+	fprintf(f, "HEADER 7  - Volume Score                      : %.4f\n", pocket->pdesc->volume_score) ;
+	fprintf(f, "HEADER 8  - Real volume (approximation)       : %.4f\n", pocket->pdesc->volume) ;
+	fprintf(f, "HEADER 9  - Charge Score                      : %5d\n", pocket->pdesc->charge_score) ;
+	fprintf(f, "HEADER 10 - Local hydrophobic density Score   : %.4f\n", pocket->pdesc->mean_loc_hyd_dens) ;
+	fprintf(f, "HEADER 11 - Number of apolar alpha sphere     : %5d\n", pocket->nAlphaApol) ;
+	fprintf(f, "HEADER 12 - Proportion of apolar alpha sphere : %.4f\n", pocket->pdesc->apolar_asphere_prop) ;
+
+	verts = get_pocket_vert_array(pocket, &nvert, &tofree) ;
+	for(k = 0 ; k < nvert ; k++) write_pqr_vert(f, verts[k]) ;
+	if(tofree) my_free(verts) ;
+
+	fprintf(f, "TER\nEND\n") ;
+}
+
 /**-----------------------------------------------------------------------------
    ## FUNCTION:
 	write_pocket_pdb
@@ -307,73 +684,98 @@ void write_pocket_pqr(const char out[], s_pocket *pocket)
 */
 void write_pocket_pdb(const char out[], s_pocket *pocket) 
 {
-	node_vertice *vcur = NULL ;
-	int i = 0 ;
+	FILE *f = fopen_out(out) ;
+	if(f && pocket) {
+		print_pocket_pdb(f, pocket) ;
+		fclose_out(f) ;
+	}
+	else {
+		if(!f) fprintf(stderr, "! The file %s could not be opened!\n", out);
+		else {
+			fprintf(stderr, "! Invalid pocket to write in write_pocket_pdb !\n");
+			fclose_out(f) ;
+		}
+	}
+}
+
+/**-----------------------------------------------------------------------------
+   ## FUNCTION:
+	print_pocket_pdb
+   -----------------------------------------------------------------------------
+   ## SPECIFICATION: 
+	Print atoms contacted by vertices of the pocket given in argument in 
+	the pdb format, in the given buffer (content of a pocketN_atm.pdb file).
+   -----------------------------------------------------------------------------
+   ## PARAMETRES:
+	@ FILE *f          : Buffer to write in
+	@ s_pocket *pocket : The pocket to write
+   -----------------------------------------------------------------------------
+   ## RETURN:
+   -----------------------------------------------------------------------------
+*/
+void print_pocket_pdb(FILE *f, s_pocket *pocket) 
+{
+	s_vvertice *vcur = NULL,
+			   **verts = NULL ;
+	int i = 0, k, nvert, tofree ;
 	int cur_size = 0,
 		cur_allocated = 10 ;
 
 	s_atm **atms = (s_atm**)my_malloc(sizeof(s_atm*)*10) ;
 	s_atm *atom = NULL ;
 
-	FILE *f = fopen(out, "w") ;
-	if(f && pocket) {
-
-		fprintf(f, "HEADER\n") ;
-		fprintf(f, "HEADER This is a pdb format file writen by the programm fpocket.                 \n") ;
-		fprintf(f, "HEADER It represents the atoms contacted by the voronoi vertices of the pocket.  \n") ;
-		fprintf(f, "HEADER                                                                           \n") ;
-		fprintf(f, "HEADER Information about the pocket %5d:\n", pocket->v_lst->first->vertice->resid) ;
-		fprintf(f, "HEADER 0  - Pocket Score                      : %.4f\n", pocket->score) ;
-		fprintf(f, "HEADER 1  - Number of V. Vertices             : %5d\n", pocket->pdesc->nb_asph) ;
-		fprintf(f, "HEADER 2  - Mean alpha-sphere radius          : %.4f\n", pocket->pdesc->mean_asph_ray) ;
-		fprintf(f, "HEADER 3  - Mean alpha-sphere SA              : %.4f\n", pocket->pdesc->masph_sacc) ;
-		fprintf(f, "HEADER 4  - Mean B-factor                     : %.4f\n", pocket->pdesc->flex) ;
-		fprintf(f, "HEADER 5  - Hydrophobicity Score              : %.4f\n", pocket->pdesc->hydrophobicity_score) ;
-		fprintf(f, "HEADER 6  - Polarity Score                    : %5d\n", pocket->pdesc->polarity_score) ;
-		fprintf(f, "HEADER 7  - Volume Score                      : %.4f\n", pocket->pdesc->volume_score) ;
-		fprintf(f, "HEADER 8  - Real volume (approximation)       : %.4f\n", pocket->pdesc->volume) ;
-		fprintf(f, "HEADER 9  - Charge Score                      : %5d\n", pocket->pdesc->charge_score) ;
-		fprintf(f, "HEADER 10 - Local hydrophobic density Score   : %.4f\n", pocket->pdesc->mean_loc_hyd_dens) ;
-		fprintf(f, "HEADER 11 - Number of apolar alpha sphere     : %5d\n", pocket->nAlphaApol) ;
-		fprintf(f, "HEADER 12 - Proportion of apolar alpha sphere : %.4f\n", pocket->pdesc->apolar_asphere_prop) ;
-
-	/* First get the list of atoms */
-		vcur = pocket->v_lst->first ;
-
-		while(vcur){
-			for(i = 0 ; i < 4 ; i++) {
-				if(!is_in_lst_atm(atms, cur_size, vcur->vertice->neigh[i]->id)) {
-					if(cur_size >= cur_allocated-1) {
-						cur_allocated *= 2 ;
-						atms = (s_atm**)my_realloc(atms, sizeof(s_atm)*cur_allocated) ;
-					}
-					atms[cur_size] = vcur->vertice->neigh[i] ;
-					cur_size ++ ;
+	fprintf(f, "HEADER\n") ;
+	fprintf(f, "HEADER This is a pdb format file writen by the programm fpocket.                 \n") ;
+	fprintf(f, "HEADER It represents the atoms contacted by the voronoi vertices of the pocket.  \n") ;
+	fprintf(f, "HEADER                                                                           \n") ;
+	fprintf(f, "HEADER Information about the pocket %5d:\n", pocket->v_lst->first->vertice->resid) ;
+	fprintf(f, "HEADER 0  - Pocket Score                      : %.4f\n", pocket->score) ;
+	fprintf(f, "HEADER 1  - Number of V. Vertices             : %5d\n", pocket->pdesc->nb_asph) ;
+	fprintf(f, "HEADER 2  - Mean alpha-sphere radius          : %.4f\n", pocket->pdesc->mean_asph_ray) ;
+	fprintf(f, "HEADER 3  - Mean alpha-sphere SA              : %.4f\n", pocket->pdesc->masph_sacc) ;
+	fprintf(f, "HEADER 4  - Mean B-factor                     : %.4f\n", pocket->pdesc->flex) ;
+	fprintf(f, "HEADER 5  - Hydrophobicity Score              : %.4f\n", pocket->pdesc->hydrophobicity_score) ;
+	fprintf(f, "HEADER 6  - Polarity Score                    : %5d\n", pocket->pdesc->polarity_score) ;
+	fprintf(f, "HEADER 7  - Volume Score                      : %.4f\n", pocket->pdesc->volume_score) ;
+	fprintf(f, "HEADER 8  - Real volume (approximation)       : %.4f\n", pocket->pdesc->volume) ;
+	fprintf(f, "HEADER 9  - Charge Score                      : %5d\n", pocket->pdesc->charge_score) ;
+	fprintf(f, "HEADER 10 - Local hydrophobic density Score   : %.4f\n", pocket->pdesc->mean_loc_hyd_dens) ;
+	fprintf(f, "HEADER 11 - Number of apolar alpha sphere     : %5d\n", pocket->nAlphaApol) ;
+	fprintf(f, "HEADER 12 - Proportion of apolar alpha sphere : %.4f\n", pocket->pdesc->apolar_asphere_prop) ;
+
+/* First get the list of atoms */
+	verts = get_pocket_vert_array(pocket, &nvert, &tofree) ;
+	s_idset *atm_ids = alloc_idset(nvert) ;
+	for(k = 0 ; k < nvert ; k++) {
+		vcur = verts[k] ;
+		for(i = 0 ; i < 4 ; i++) {
+			if(add_idset(atm_ids, vcur->neigh[i]->id)) {
+				if(cur_size >= cur_allocated-1) {
+					cur_allocated *= 2 ;
+					atms = (s_atm**)my_realloc(atms, sizeof(s_atm)*cur_allocated) ;
 				}
-
+				atms[cur_size] = vcur->neigh[i] ;
+				cur_size ++ ;
 			}
-			vcur = vcur->next ;
+
 		}
+	}
+	free_idset(atm_ids) ;
+	if(tofree) my_free(verts) ;
 
-	/* Then write atoms... */
+/* Then write atoms... */
 
-		for(i = 0 ; i < cur_size ; i++) {
-			atom = atms[i] ;
+	for(i = 0 ; i < cur_size ; i++) {
+		atom = atms[i] ;
 
-			write_pdb_atom_line(f, atom->type, atom->id, atom->name, atom->pdb_aloc, 
-									atom->res_name, atom->chain, atom->res_id, 
- 									atom->pdb_insert, atom->x, atom->y, atom->z,
- 									atom->occupancy, atom->bfactor, atom->symbol, 
- 									atom->charge);
-		}
-	
-		fprintf(f, "TER\nEND\n") ;
-		fclose(f) ;
-	}
-	else {
-		if(!f) fprintf(stderr, "! The file %s could not be opened!\n", out);
-		else fprintf(stderr, "! Invalid pocket to write in write_pocket_pqr !\n");
+		write_pdb_atom_line(f, atom->type, atom->id, atom->name, atom->pdb_aloc, 
+								atom->res_name, atom->chain, atom->res_id, 
+ 								atom->pdb_insert, atom->x, atom->y, atom->z,
+ 								atom->occupancy, atom->bfactor, atom->symbol, 
+ 								atom->charge);
 	}
 
+	fprintf(f, "TER\nEND\n") ;
+
 	my_free(atms) ;
 }